@@ -0,0 +1,70 @@
+#include "abort-controller.h"
+#include "abort-signal.h"
+
+namespace builtins::web::abort {
+
+bool AbortController::signal_get(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  args.rval().set(JS::GetReservedSlot(self, Slots::Signal));
+  return true;
+}
+
+// https://dom.spec.whatwg.org/#dom-abortcontroller-abort
+bool AbortController::abort(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  RootedObject signal(cx, &JS::GetReservedSlot(self, Slots::Signal).toObject());
+  if (!AbortSignal::abort(cx, signal, args.get(0))) {
+    return false;
+  }
+  args.rval().setUndefined();
+  return true;
+}
+
+const JSFunctionSpec AbortController::static_methods[] = {
+    JS_FS_END,
+};
+
+const JSPropertySpec AbortController::static_properties[] = {
+    JS_PS_END,
+};
+
+const JSFunctionSpec AbortController::methods[] = {
+    JS_FN("abort", abort, 0, JSPROP_ENUMERATE),
+    JS_FS_END,
+};
+
+const JSPropertySpec AbortController::properties[] = {
+    JS_PSG("signal", signal_get, JSPROP_ENUMERATE),
+    JS_STRING_SYM_PS(toStringTag, "AbortController", JSPROP_READONLY),
+    JS_PS_END,
+};
+
+bool AbortController::constructor(JSContext *cx, unsigned argc, JS::Value *vp) {
+  CTOR_HEADER("AbortController", 0);
+
+  RootedObject instance(cx, JS_NewObjectForConstructor(cx, &class_, args));
+  if (!instance) {
+    return false;
+  }
+  RootedObject signal(cx, AbortSignal::create(cx));
+  if (!signal) {
+    return false;
+  }
+  JS::SetReservedSlot(instance, Slots::Signal, ObjectValue(*signal));
+
+  args.rval().setObject(*instance);
+  return true;
+}
+
+bool AbortController::init_class(JSContext *cx, JS::HandleObject global) {
+  return init_class_impl(cx, global);
+}
+
+bool install(api::Engine *engine) {
+  if (!abort_signal::install(engine)) {
+    return false;
+  }
+  return AbortController::init_class(engine->cx(), engine->global());
+}
+
+} // namespace builtins::web::abort
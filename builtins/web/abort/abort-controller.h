@@ -0,0 +1,32 @@
+#ifndef BUILTINS_WEB_ABORT_CONTROLLER_H
+#define BUILTINS_WEB_ABORT_CONTROLLER_H
+
+#include "builtin.h"
+
+namespace builtins::web::abort {
+
+class AbortController final : public BuiltinImpl<AbortController> {
+  static bool signal_get(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool abort(JSContext *cx, unsigned argc, JS::Value *vp);
+
+public:
+  static constexpr const char *class_name = "AbortController";
+
+  enum Slots { Signal, Count };
+
+  static const JSFunctionSpec static_methods[];
+  static const JSPropertySpec static_properties[];
+  static const JSFunctionSpec methods[];
+  static const JSPropertySpec properties[];
+
+  static const unsigned ctor_length = 0;
+
+  static bool init_class(JSContext *cx, JS::HandleObject global);
+  static bool constructor(JSContext *cx, unsigned argc, JS::Value *vp);
+};
+
+bool install(api::Engine *engine);
+
+} // namespace builtins::web::abort
+
+#endif
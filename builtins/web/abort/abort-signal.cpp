@@ -0,0 +1,558 @@
+#include "abort-signal.h"
+#include "../dom-exception.h"
+#include "encode.h"
+#include "host_api.h"
+
+#include "js/Array.h"
+
+#include <cmath>
+
+namespace builtins::web::abort {
+
+using dom_exception::DOMException;
+
+static api::Engine *ENGINE;
+
+namespace {
+
+/// Append `item` to the array stored in `slot` of `signal`, creating the array if needed.
+bool list_append(JSContext *cx, HandleObject signal, AbortSignal::Slots slot, HandleObject item) {
+  RootedObject list(cx);
+  uint32_t length = 0;
+  RootedValue list_val(cx, JS::GetReservedSlot(signal, slot));
+  if (list_val.isObject()) {
+    list = &list_val.toObject();
+    if (!JS::GetArrayLength(cx, list, &length)) {
+      return false;
+    }
+  } else {
+    list = JS::NewArrayObject(cx, 0);
+    if (!list) {
+      return false;
+    }
+    JS::SetReservedSlot(signal, slot, ObjectValue(*list));
+  }
+
+  RootedValue item_val(cx, ObjectValue(*item));
+  return JS_SetElement(cx, list, length, item_val);
+}
+
+/// True if the array stored in `slot` of `signal` contains `item`.
+bool list_contains(JSContext *cx, HandleObject signal, AbortSignal::Slots slot, HandleObject item,
+                   bool *contains) {
+  *contains = false;
+  RootedValue list_val(cx, JS::GetReservedSlot(signal, slot));
+  if (!list_val.isObject()) {
+    return true;
+  }
+
+  RootedObject list(cx, &list_val.toObject());
+  uint32_t length;
+  if (!JS::GetArrayLength(cx, list, &length)) {
+    return false;
+  }
+  RootedValue entry(cx);
+  for (uint32_t i = 0; i < length; i++) {
+    if (!JS_GetElement(cx, list, i, &entry)) {
+      return false;
+    }
+    if (entry.isObject() && &entry.toObject() == item) {
+      *contains = true;
+      return true;
+    }
+  }
+  return true;
+}
+
+/// Replace the array stored in `slot` of `signal` with one that doesn't contain `item`.
+bool list_remove(JSContext *cx, HandleObject signal, AbortSignal::Slots slot, HandleObject item) {
+  RootedValue list_val(cx, JS::GetReservedSlot(signal, slot));
+  if (!list_val.isObject()) {
+    return true;
+  }
+
+  RootedObject list(cx, &list_val.toObject());
+  uint32_t length;
+  if (!JS::GetArrayLength(cx, list, &length)) {
+    return false;
+  }
+  RootedObject new_list(cx, JS::NewArrayObject(cx, 0));
+  if (!new_list) {
+    return false;
+  }
+  uint32_t new_length = 0;
+  RootedValue entry(cx);
+  for (uint32_t i = 0; i < length; i++) {
+    if (!JS_GetElement(cx, list, i, &entry)) {
+      return false;
+    }
+    if (entry.isObject() && &entry.toObject() == item) {
+      continue;
+    }
+    if (!JS_SetElement(cx, new_list, new_length++, entry)) {
+      return false;
+    }
+  }
+
+  JS::SetReservedSlot(signal, slot, ObjectValue(*new_list));
+  return true;
+}
+
+/// Remove the array stored in `slot` of `signal`, and return it, or null if there is none.
+JSObject *list_take(JSObject *signal, AbortSignal::Slots slot) {
+  auto list_val = JS::GetReservedSlot(signal, slot);
+  JS::SetReservedSlot(signal, slot, JS::UndefinedValue());
+  return list_val.isObject() ? &list_val.toObject() : nullptr;
+}
+
+/// Report the exception an abort algorithm or event listener threw, so that the remaining ones
+/// still run. Returns false if there's no exception to report, e.g. after running out of memory.
+bool report_exception(JSContext *cx, const char *description) {
+  if (!JS_IsExceptionPending(cx)) {
+    return false;
+  }
+  ENGINE->dump_pending_exception(description);
+  JS_ClearPendingException(cx);
+  return true;
+}
+
+/// Call `listener` with `event`, either directly or through its `handleEvent` method.
+bool call_listener(JSContext *cx, HandleObject signal, HandleObject listener, HandleObject event) {
+  RootedValueArray<1> args(cx);
+  args[0].setObject(*event);
+  RootedValue rval(cx);
+  if (JS::IsCallable(listener)) {
+    RootedValue this_val(cx, ObjectValue(*signal));
+    RootedValue listener_val(cx, ObjectValue(*listener));
+    return JS::Call(cx, this_val, listener_val, args, &rval);
+  }
+  return JS::Call(cx, listener, "handleEvent", args, &rval);
+}
+
+/// Dispatch the `abort` event on `signal`.
+///
+/// There's no EventTarget implementation, so the event is a plain object with just `type` and
+/// `target` properties.
+bool dispatch_abort_event(JSContext *cx, HandleObject signal) {
+  RootedObject on_abort(cx,
+                        JS::GetReservedSlot(signal, AbortSignal::Slots::OnAbort).toObjectOrNull());
+  RootedObject listeners(cx, list_take(signal, AbortSignal::Slots::Listeners));
+  if (!on_abort && !listeners) {
+    return true;
+  }
+
+  RootedObject event(cx, JS_NewPlainObject(cx));
+  if (!event) {
+    return false;
+  }
+  RootedString type_str(cx, JS_NewStringCopyZ(cx, "abort"));
+  if (!type_str) {
+    return false;
+  }
+  RootedValue type(cx, JS::StringValue(type_str));
+  RootedValue target(cx, ObjectValue(*signal));
+  if (!JS_DefineProperty(cx, event, "type", type, JSPROP_ENUMERATE) ||
+      !JS_DefineProperty(cx, event, "target", target, JSPROP_ENUMERATE) ||
+      !JS_DefineProperty(cx, event, "currentTarget", target, JSPROP_ENUMERATE)) {
+    return false;
+  }
+
+  if (on_abort && !call_listener(cx, signal, on_abort, event) &&
+      !report_exception(cx, "running the abort event handler")) {
+    return false;
+  }
+  if (!listeners) {
+    return true;
+  }
+
+  uint32_t length;
+  if (!JS::GetArrayLength(cx, listeners, &length)) {
+    return false;
+  }
+  RootedValue listener(cx);
+  RootedObject listener_obj(cx);
+  for (uint32_t i = 0; i < length; i++) {
+    if (!JS_GetElement(cx, listeners, i, &listener)) {
+      return false;
+    }
+    listener_obj = &listener.toObject();
+    if (!call_listener(cx, signal, listener_obj, event) &&
+        !report_exception(cx, "running an abort event listener")) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Aborts the dependent signal `receiver` with the reason its source signal was aborted with.
+bool follow_abort(JSContext *cx, HandleObject receiver, HandleValue extra, CallArgs args) {
+  args.rval().setUndefined();
+  return AbortSignal::abort(cx, receiver, args.get(0));
+}
+
+} // namespace
+
+class AbortSignalTimeoutTask final : public api::AsyncTask {
+  Heap<JSObject *> signal_;
+  uint64_t deadline_;
+
+public:
+  explicit AbortSignalTimeoutTask(const HandleObject signal, const uint64_t delay_ns)
+      : signal_(signal) {
+    deadline_ = host_api::MonotonicClock::now() + delay_ns;
+    handle_ = host_api::MonotonicClock::subscribe(deadline_, true);
+  }
+
+  [[nodiscard]] bool run(api::Engine *engine) override {
+    JSContext *cx = engine->cx();
+    RootedObject signal(cx, signal_);
+    // The task is done either way, so aborting the signal mustn't cancel it.
+    JS::SetReservedSlot(signal, AbortSignal::Slots::TimeoutTask, JS::UndefinedValue());
+    RootedObject reason(cx, DOMException::create(cx, "The operation timed out.", "TimeoutError"));
+    if (!reason) {
+      return false;
+    }
+    RootedValue reason_val(cx, ObjectValue(*reason));
+    if (!AbortSignal::abort(cx, signal, reason_val)) {
+      return false;
+    }
+
+    return cancel(engine);
+  }
+
+  [[nodiscard]] bool cancel(api::Engine *engine) override {
+    host_api::MonotonicClock::unsubscribe(id());
+    handle_ = -1;
+    return true;
+  }
+
+  bool ready() override { return host_api::MonotonicClock::now() >= deadline_; }
+
+  /// Nothing waits for the timeout itself, so it only fires if the loop is still running anyway.
+  bool keeps_event_loop_alive() override { return false; }
+
+  void trace(JSTracer *trc) override { TraceEdge(trc, &signal_, "Signal for abort timeout"); }
+};
+
+JSObject *AbortSignal::create(JSContext *cx) {
+  RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &class_, proto_obj));
+  if (!self) {
+    return nullptr;
+  }
+  JS::SetReservedSlot(self, Slots::Reason, JS::UndefinedValue());
+  JS::SetReservedSlot(self, Slots::Algorithms, JS::UndefinedValue());
+  JS::SetReservedSlot(self, Slots::Listeners, JS::UndefinedValue());
+  JS::SetReservedSlot(self, Slots::OnAbort, JS::NullValue());
+  JS::SetReservedSlot(self, Slots::TimeoutTask, JS::UndefinedValue());
+  return self;
+}
+
+bool AbortSignal::is_aborted(JSObject *self) {
+  MOZ_ASSERT(is_instance(self));
+  return !JS::GetReservedSlot(self, Slots::Reason).isUndefined();
+}
+
+JS::Value AbortSignal::reason(JSObject *self) {
+  MOZ_ASSERT(is_instance(self));
+  return JS::GetReservedSlot(self, Slots::Reason);
+}
+
+// https://dom.spec.whatwg.org/#create-a-dependent-abort-signal
+JSObject *AbortSignal::create_dependent(JSContext *cx, JS::HandleObjectVector sources) {
+  RootedObject signal(cx, create(cx));
+  if (!signal) {
+    return nullptr;
+  }
+
+  // If any of the sources is already aborted, the result is aborted with the same reason.
+  for (auto source : sources) {
+    if (is_aborted(source)) {
+      RootedValue reason_val(cx, reason(source));
+      return abort(cx, signal, reason_val) ? signal.get() : nullptr;
+    }
+  }
+
+  // Otherwise, make the result follow all the sources.
+  RootedObject algorithm(cx, create_internal_method<follow_abort>(cx, signal));
+  if (!algorithm) {
+    return nullptr;
+  }
+  RootedObject source(cx);
+  for (auto source_obj : sources) {
+    source = source_obj;
+    if (!add_algorithm(cx, source, algorithm)) {
+      return nullptr;
+    }
+  }
+  return signal;
+}
+
+bool AbortSignal::add_algorithm(JSContext *cx, HandleObject self, HandleObject algorithm) {
+  MOZ_ASSERT(!is_aborted(self));
+  return list_append(cx, self, Slots::Algorithms, algorithm);
+}
+
+bool AbortSignal::remove_algorithm(JSContext *cx, HandleObject self, HandleObject algorithm) {
+  return list_remove(cx, self, Slots::Algorithms, algorithm);
+}
+
+// https://dom.spec.whatwg.org/#abortsignal-signal-abort
+bool AbortSignal::abort(JSContext *cx, HandleObject self, HandleValue reason) {
+  // 1. If signal is aborted, then return.
+  if (is_aborted(self)) {
+    return true;
+  }
+
+  // 2. Set signal's abort reason to reason if it is given; otherwise to a new "AbortError"
+  // DOMException.
+  RootedValue reason_val(cx, reason);
+  if (reason_val.isUndefined()) {
+    RootedObject exception(
+        cx, DOMException::create(cx, "signal is aborted without reason", "AbortError"));
+    if (!exception) {
+      return false;
+    }
+    reason_val.setObject(*exception);
+  }
+  JS::SetReservedSlot(self, Slots::Reason, reason_val);
+
+  // A signal created by `AbortSignal.timeout` that's aborted some other way doesn't need its timer
+  // anymore.
+  auto timeout_task = JS::GetReservedSlot(self, Slots::TimeoutTask);
+  if (timeout_task.isInt32()) {
+    JS::SetReservedSlot(self, Slots::TimeoutTask, JS::UndefinedValue());
+    ENGINE->cancel_async_task(timeout_task.toInt32());
+  }
+
+  // 3. For each algorithm of signal's abort algorithms: run algorithm.
+  // 4. Empty signal's abort algorithms.
+  // Dependent signals created by `AbortSignal.any` are aborted by algorithms as well, which
+  // happens before the event is dispatched on this signal, unlike in the spec.
+  RootedObject algorithms(cx, list_take(self, Slots::Algorithms));
+  if (algorithms) {
+    uint32_t length;
+    if (!JS::GetArrayLength(cx, algorithms, &length)) {
+      return false;
+    }
+    RootedValueArray<1> args(cx);
+    args[0].set(reason_val);
+    RootedValue algorithm(cx);
+    RootedValue rval(cx);
+    for (uint32_t i = 0; i < length; i++) {
+      if (!JS_GetElement(cx, algorithms, i, &algorithm)) {
+        return false;
+      }
+      if (!JS::Call(cx, JS::UndefinedHandleValue, algorithm, args, &rval) &&
+          !report_exception(cx, "running an abort algorithm")) {
+        return false;
+      }
+    }
+  }
+
+  // 5. Fire an event named abort at signal.
+  return dispatch_abort_event(cx, self);
+}
+
+bool AbortSignal::aborted_get(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  args.rval().setBoolean(is_aborted(self));
+  return true;
+}
+
+bool AbortSignal::reason_get(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  args.rval().set(reason(self));
+  return true;
+}
+
+bool AbortSignal::onabort_get(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  args.rval().set(JS::GetReservedSlot(self, Slots::OnAbort));
+  return true;
+}
+
+bool AbortSignal::onabort_set(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(1)
+  // Like for all event handler attributes, anything that isn't a function is treated as null.
+  auto handler = args[0];
+  if (handler.isObject() && JS::IsCallable(&handler.toObject())) {
+    JS::SetReservedSlot(self, Slots::OnAbort, handler);
+  } else {
+    JS::SetReservedSlot(self, Slots::OnAbort, JS::NullValue());
+  }
+  args.rval().setUndefined();
+  return true;
+}
+
+// https://dom.spec.whatwg.org/#dom-abortsignal-throwifaborted
+bool AbortSignal::throwIfAborted(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  if (is_aborted(self)) {
+    RootedValue reason_val(cx, reason(self));
+    JS_SetPendingException(cx, reason_val);
+    return false;
+  }
+  args.rval().setUndefined();
+  return true;
+}
+
+/**
+ * Only `abort` events are ever dispatched on signals, so listeners for other types are ignored, as
+ * are all options: `once` makes no difference for an event that's only dispatched once.
+ */
+bool AbortSignal::addEventListener(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(2)
+  args.rval().setUndefined();
+
+  auto type = core::encode(cx, args[0]);
+  if (!type) {
+    return false;
+  }
+  if (!args[1].isObject() || std::string_view(type) != "abort" || is_aborted(self)) {
+    return true;
+  }
+
+  RootedObject listener(cx, &args[1].toObject());
+  bool contains;
+  if (!list_contains(cx, self, Slots::Listeners, listener, &contains)) {
+    return false;
+  }
+  return contains || list_append(cx, self, Slots::Listeners, listener);
+}
+
+bool AbortSignal::removeEventListener(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(2)
+  args.rval().setUndefined();
+
+  auto type = core::encode(cx, args[0]);
+  if (!type) {
+    return false;
+  }
+  if (!args[1].isObject() || std::string_view(type) != "abort") {
+    return true;
+  }
+
+  RootedObject listener(cx, &args[1].toObject());
+  return list_remove(cx, self, Slots::Listeners, listener);
+}
+
+// https://dom.spec.whatwg.org/#dom-abortsignal-abort
+bool AbortSignal::abort_static(JSContext *cx, unsigned argc, JS::Value *vp) {
+  CallArgs args = CallArgsFromVp(argc, vp);
+  RootedObject signal(cx, create(cx));
+  if (!signal || !abort(cx, signal, args.get(0))) {
+    return false;
+  }
+  args.rval().setObject(*signal);
+  return true;
+}
+
+// https://dom.spec.whatwg.org/#dom-abortsignal-timeout
+bool AbortSignal::timeout(JSContext *cx, unsigned argc, JS::Value *vp) {
+  CallArgs args = CallArgsFromVp(argc, vp);
+  REQUEST_HANDLER_ONLY("AbortSignal.timeout");
+  if (!args.requireAtLeast(cx, "AbortSignal.timeout", 1)) {
+    return false;
+  }
+
+  double ms;
+  if (!JS::ToNumber(cx, args[0], &ms)) {
+    return false;
+  }
+  if (!std::isfinite(ms) || ms < 0) {
+    JS_ReportErrorUTF8(cx, "AbortSignal.timeout: milliseconds must be a non-negative number");
+    return false;
+  }
+
+  RootedObject signal(cx, create(cx));
+  if (!signal) {
+    return false;
+  }
+  auto delay_ns = static_cast<uint64_t>(std::min(std::trunc(ms) * 1e6, 1.8e19));
+  auto *task = new AbortSignalTimeoutTask(signal, delay_ns);
+  JS::SetReservedSlot(signal, Slots::TimeoutTask, JS::Int32Value(task->id()));
+  ENGINE->queue_async_task(task);
+
+  args.rval().setObject(*signal);
+  return true;
+}
+
+// https://dom.spec.whatwg.org/#dom-abortsignal-any
+bool AbortSignal::any(JSContext *cx, unsigned argc, JS::Value *vp) {
+  CallArgs args = CallArgsFromVp(argc, vp);
+  if (!args.requireAtLeast(cx, "AbortSignal.any", 1)) {
+    return false;
+  }
+
+  JS::RootedObjectVector sources(cx);
+  JS::ForOfIterator it(cx);
+  if (!it.init(args[0])) {
+    return false;
+  }
+  RootedValue source_val(cx);
+  while (true) {
+    bool done;
+    if (!it.next(&source_val, &done)) {
+      return false;
+    }
+    if (done) {
+      break;
+    }
+    if (!is_instance(source_val)) {
+      JS_ReportErrorUTF8(cx, "AbortSignal.any: all entries must be AbortSignal instances");
+      return false;
+    }
+    if (!sources.append(&source_val.toObject())) {
+      JS_ReportOutOfMemory(cx);
+      return false;
+    }
+  }
+
+  RootedObject signal(cx, create_dependent(cx, sources));
+  if (!signal) {
+    return false;
+  }
+  args.rval().setObject(*signal);
+  return true;
+}
+
+const JSFunctionSpec AbortSignal::static_methods[] = {
+    JS_FN("abort", abort_static, 0, JSPROP_ENUMERATE),
+    JS_FN("timeout", timeout, 1, JSPROP_ENUMERATE),
+    JS_FN("any", any, 1, JSPROP_ENUMERATE),
+    JS_FS_END,
+};
+
+const JSPropertySpec AbortSignal::static_properties[] = {
+    JS_PS_END,
+};
+
+const JSFunctionSpec AbortSignal::methods[] = {
+    JS_FN("throwIfAborted", throwIfAborted, 0, JSPROP_ENUMERATE),
+    JS_FN("addEventListener", addEventListener, 2, JSPROP_ENUMERATE),
+    JS_FN("removeEventListener", removeEventListener, 2, JSPROP_ENUMERATE),
+    JS_FS_END,
+};
+
+const JSPropertySpec AbortSignal::properties[] = {
+    JS_PSG("aborted", aborted_get, JSPROP_ENUMERATE),
+    JS_PSG("reason", reason_get, JSPROP_ENUMERATE),
+    JS_PSGS("onabort", onabort_get, onabort_set, JSPROP_ENUMERATE),
+    JS_STRING_SYM_PS(toStringTag, "AbortSignal", JSPROP_READONLY),
+    JS_PS_END,
+};
+
+bool AbortSignal::init_class(JSContext *cx, JS::HandleObject global) {
+  return init_class_impl(cx, global);
+}
+
+namespace abort_signal {
+
+bool install(api::Engine *engine) {
+  ENGINE = engine;
+  return AbortSignal::init_class(engine->cx(), engine->global());
+}
+
+} // namespace abort_signal
+
+} // namespace builtins::web::abort
@@ -0,0 +1,81 @@
+#ifndef BUILTINS_WEB_ABORT_SIGNAL_H
+#define BUILTINS_WEB_ABORT_SIGNAL_H
+
+#include "builtin.h"
+
+namespace builtins::web::abort {
+
+namespace abort_signal {
+
+bool install(api::Engine *engine);
+
+}
+
+class AbortSignal final : public BuiltinNoConstructor<AbortSignal> {
+  static bool aborted_get(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool reason_get(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool onabort_get(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool onabort_set(JSContext *cx, unsigned argc, JS::Value *vp);
+
+  static bool throwIfAborted(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool addEventListener(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool removeEventListener(JSContext *cx, unsigned argc, JS::Value *vp);
+
+  static bool abort_static(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool timeout(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool any(JSContext *cx, unsigned argc, JS::Value *vp);
+
+public:
+  static constexpr const char *class_name = "AbortSignal";
+
+  enum Slots {
+    /// The abort reason, or undefined if the signal hasn't been aborted.
+    Reason,
+    /// An array of functions to call with the reason once the signal is aborted, or undefined.
+    Algorithms,
+    /// An array of the listeners for the `abort` event, or undefined.
+    Listeners,
+    OnAbort,
+    /// The id of the task that aborts a signal created by `AbortSignal.timeout`, or undefined.
+    TimeoutTask,
+    Count
+  };
+
+  static const JSFunctionSpec static_methods[];
+  static const JSPropertySpec static_properties[];
+  static const JSFunctionSpec methods[];
+  static const JSPropertySpec properties[];
+
+  /// Unlike for other builtins without a constructor, the `AbortSignal` global is kept around, as
+  /// content needs it for the static methods.
+  static bool init_class(JSContext *cx, JS::HandleObject global);
+
+  static JSObject *create(JSContext *cx);
+
+  /**
+   * Create a signal that's aborted along with the first of `sources` to be aborted, or right away
+   * if one of them already is.
+   */
+  static JSObject *create_dependent(JSContext *cx, JS::HandleObjectVector sources);
+
+  static bool is_aborted(JSObject *self);
+  static JS::Value reason(JSObject *self);
+
+  /**
+   * Call `algorithm` with the abort reason once `self` is aborted, before the `abort` event is
+   * dispatched. This is how builtins like `fetch` react to signals without running any content
+   * code.
+   */
+  static bool add_algorithm(JSContext *cx, JS::HandleObject self, JS::HandleObject algorithm);
+  static bool remove_algorithm(JSContext *cx, JS::HandleObject self, JS::HandleObject algorithm);
+
+  /**
+   * Abort `self` with `reason`, or with an "AbortError" DOMException if `reason` is undefined.
+   * Does nothing if `self` is already aborted.
+   */
+  static bool abort(JSContext *cx, JS::HandleObject self, JS::HandleValue reason);
+};
+
+} // namespace builtins::web::abort
+
+#endif
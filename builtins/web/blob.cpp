@@ -0,0 +1,664 @@
+#include "blob.h"
+#include "encode.h"
+#include "file.h"
+#include "streams/native-stream-source.h"
+
+#include "js/ArrayBuffer.h"
+#include "js/CharacterEncoding.h"
+#include "js/Conversions.h"
+#include "js/ForOfIterator.h"
+#include "js/Stream.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Winvalid-offsetof"
+#include "js/experimental/TypedData.h"
+#pragma clang diagnostic pop
+
+namespace builtins::web::blob {
+
+using streams::NativeStreamSource;
+
+BlobSegment::~BlobSegment() { JS_free(nullptr, data_); }
+
+namespace {
+
+/// The largest chunk a stream returned by `Blob#stream` enqueues at a time.
+constexpr size_t BLOB_STREAM_CHUNK_SIZE = 64 * 1024;
+
+/**
+ * Collects the bytes of consecutive strings and buffers passed to the Blob constructor, so that
+ * they end up in a single segment instead of one segment each.
+ */
+class SegmentBuilder final {
+  JSContext *cx_;
+  uint8_t *data_ = nullptr;
+  size_t len_ = 0;
+  size_t capacity_ = 0;
+
+public:
+  explicit SegmentBuilder(JSContext *cx) : cx_(cx) {}
+  ~SegmentBuilder() { JS_free(cx_, data_); }
+
+  SegmentBuilder(const SegmentBuilder &) = delete;
+  SegmentBuilder &operator=(const SegmentBuilder &) = delete;
+
+  /// Make room for `additional` more bytes, and return where they go.
+  uint8_t *reserve(size_t additional) {
+    if (capacity_ - len_ < additional) {
+      size_t capacity = std::max(len_ + additional, capacity_ * 2);
+      auto *data = static_cast<uint8_t *>(JS_realloc(cx_, data_, capacity_, capacity));
+      if (!data) {
+        JS_ReportOutOfMemory(cx_);
+        return nullptr;
+      }
+      data_ = data;
+      capacity_ = capacity;
+    }
+    return data_ + len_;
+  }
+
+  /// Account for `len` bytes written to the space returned by `reserve`.
+  void commit(size_t len) {
+    MOZ_ASSERT(capacity_ - len_ >= len);
+    len_ += len;
+  }
+
+  /// Append the UTF-8 encoded `str`. If nothing has been collected yet, `str`'s buffer is used
+  /// as is instead of being copied.
+  bool append(host_api::HostString str) {
+    if (len_ == 0) {
+      JS_free(cx_, data_);
+      data_ = reinterpret_cast<uint8_t *>(str.ptr.release());
+      len_ = capacity_ = str.len;
+      return true;
+    }
+    uint8_t *dest = reserve(str.len);
+    if (!dest) {
+      return false;
+    }
+    memcpy(dest, str.ptr.get(), str.len);
+    commit(str.len);
+    return true;
+  }
+
+  /// Add the bytes collected so far to `parts` as a new segment, and start over.
+  bool finish(BlobParts *parts) {
+    if (len_ == 0) {
+      return true;
+    }
+    if (capacity_ > len_) {
+      auto *data = static_cast<uint8_t *>(JS_realloc(cx_, data_, capacity_, len_));
+      if (data) {
+        data_ = data;
+      }
+    }
+    auto segment = std::make_shared<const BlobSegment>(data_, len_);
+    parts->push_back(BlobPart{std::move(segment), 0, len_});
+    data_ = nullptr;
+    len_ = capacity_ = 0;
+    return true;
+  }
+};
+
+/// Replace all line breaks in `str` with `\n` in place, as `endings: "native"` requires.
+void convert_line_endings(host_api::HostString &str) {
+  char *chars = str.ptr.get();
+  if (!memchr(chars, '\r', str.len)) {
+    return;
+  }
+  size_t out = 0;
+  for (size_t i = 0; i < str.len; i++) {
+    if (chars[i] == '\r') {
+      chars[out++] = '\n';
+      if (i + 1 < str.len && chars[i + 1] == '\n') {
+        i++;
+      }
+    } else {
+      chars[out++] = chars[i];
+    }
+  }
+  str.len = out;
+}
+
+/// https://w3c.github.io/FileAPI/#slice-blob steps 3 and 4, for the `[Clamp] long long` index.
+bool relative_index(JSContext *cx, JS::HandleValue val, size_t size, size_t default_index,
+                    size_t *index) {
+  if (val.isUndefined()) {
+    *index = default_index;
+    return true;
+  }
+  double n;
+  if (!JS::ToNumber(cx, val, &n)) {
+    return false;
+  }
+  n = std::isnan(n) ? 0 : std::nearbyint(n);
+  double size_d = static_cast<double>(size);
+  *index = static_cast<size_t>(n < 0 ? std::max(size_d + n, 0.0) : std::min(n, size_d));
+  return true;
+}
+
+/// Copy all of `parts`' bytes into a new buffer of exactly `len` bytes.
+uint8_t *copy_contents(JSContext *cx, const BlobParts &parts, size_t len) {
+  auto *data = static_cast<uint8_t *>(JS_malloc(cx, len));
+  if (!data) {
+    JS_ReportOutOfMemory(cx);
+    return nullptr;
+  }
+  size_t pos = 0;
+  for (const auto &part : parts) {
+    memcpy(data + pos, part.data(), part.length);
+    pos += part.length;
+  }
+  return data;
+}
+
+/// A new ArrayBuffer with a copy of `self`'s contents.
+JSObject *contents_to_array_buffer(JSContext *cx, JS::HandleObject self) {
+  size_t len = Blob::size(self);
+  if (len == 0) {
+    return JS::NewArrayBuffer(cx, 0);
+  }
+  uint8_t *data = copy_contents(cx, Blob::parts(self), len);
+  if (!data) {
+    return nullptr;
+  }
+  JSObject *buffer = JS::NewArrayBufferWithContents(cx, len, data);
+  if (!buffer) {
+    JS_free(cx, data);
+  }
+  return buffer;
+}
+
+/**
+ * https://w3c.github.io/FileAPI/#text-method-algo
+ *
+ * A Blob with a single part is decoded straight from its segment. Otherwise, the parts are joined
+ * first, because characters can span parts.
+ */
+JSString *contents_to_text(JSContext *cx, JS::HandleObject self) {
+  const BlobParts &parts = Blob::parts(self);
+  if (parts.empty()) {
+    return JS_GetEmptyString(cx);
+  }
+
+  UniqueChars joined;
+  const char *chars;
+  size_t len;
+  if (parts.size() == 1) {
+    chars = reinterpret_cast<const char *>(parts[0].data());
+    len = parts[0].length;
+  } else {
+    len = Blob::size(self);
+    joined.reset(reinterpret_cast<char *>(copy_contents(cx, parts, len)));
+    if (!joined) {
+      return nullptr;
+    }
+    chars = joined.get();
+  }
+
+  // UTF-8 decode skips a leading byte order mark.
+  if (len >= 3 && memcmp(chars, "\xEF\xBB\xBF", 3) == 0) {
+    chars += 3;
+    len -= 3;
+  }
+
+  // As for body text, ASCII needs neither decoding nor validation.
+  if (JS::StringIsASCII(mozilla::Span(chars, len))) {
+    return JS_NewStringCopyN(cx, chars, len);
+  }
+  return JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(chars, len));
+}
+
+bool return_promise(JSContext *cx, JS::CallArgs args, JS::HandleValue result) {
+  JSObject *promise = JS::CallOriginalPromiseResolve(cx, result);
+  if (!promise) {
+    return false;
+  }
+  args.rval().setObject(*promise);
+  return true;
+}
+
+} // namespace
+
+bool Blob::is_instance(const JSObject *obj) {
+  return obj != nullptr && (JS::GetClass(obj) == &class_ || file::File::is_instance(obj));
+}
+
+bool Blob::is_instance(const JS::Value val) {
+  return val.isObject() && is_instance(&val.toObject());
+}
+
+const BlobParts &Blob::parts(JSObject *self) {
+  MOZ_ASSERT(is_instance(self));
+  return *static_cast<BlobParts *>(JS::GetReservedSlot(self, Slots::Parts).toPrivate());
+}
+
+size_t Blob::size(JSObject *self) {
+  size_t size = 0;
+  for (const auto &part : parts(self)) {
+    size += part.length;
+  }
+  return size;
+}
+
+JSString *Blob::type(JSObject *self) {
+  MOZ_ASSERT(is_instance(self));
+  return JS::GetReservedSlot(self, Slots::Type).toString();
+}
+
+bool Blob::size_get(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  args.rval().setNumber(static_cast<double>(size(self)));
+  return true;
+}
+
+bool Blob::type_get(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  args.rval().setString(type(self));
+  return true;
+}
+
+// https://w3c.github.io/FileAPI/#dfn-slice
+bool Blob::slice(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  size_t size = Blob::size(self);
+  size_t start;
+  size_t end;
+  if (!relative_index(cx, args.get(0), size, 0, &start) ||
+      !relative_index(cx, args.get(1), size, size, &end)) {
+    return false;
+  }
+
+  JS::RootedString type(cx, JS_GetEmptyString(cx));
+  if (!args.get(2).isUndefined()) {
+    type = normalize_type(cx, args[2]);
+    if (!type) {
+      return false;
+    }
+  }
+
+  // The slice shares the segments of those parts that overlap the range.
+  BlobParts slice_parts;
+  size_t pos = 0;
+  for (const auto &part : parts(self)) {
+    if (pos >= end || start >= end) {
+      break;
+    }
+    size_t part_end = pos + part.length;
+    if (part_end > start) {
+      size_t from = std::max(start, pos) - pos;
+      size_t to = std::min(end, part_end) - pos;
+      slice_parts.push_back(BlobPart{part.segment, part.offset + from, to - from});
+    }
+    pos = part_end;
+  }
+
+  JSObject *blob = create(cx, std::move(slice_parts), type);
+  if (!blob) {
+    return false;
+  }
+  args.rval().setObject(*blob);
+  return true;
+}
+
+// https://w3c.github.io/FileAPI/#stream-method-algo
+bool Blob::stream(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  JSObject *stream = BlobReader::create_stream(cx, self);
+  if (!stream) {
+    return false;
+  }
+  args.rval().setObject(*stream);
+  return true;
+}
+
+// https://w3c.github.io/FileAPI/#text-method-algo
+bool Blob::text(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  JS::RootedString text(cx, contents_to_text(cx, self));
+  if (!text) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  JS::RootedValue result(cx, JS::StringValue(text));
+  return return_promise(cx, args, result);
+}
+
+// https://w3c.github.io/FileAPI/#arraybuffer-method-algo
+bool Blob::arrayBuffer(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  // Content can modify the buffer, so it has to be a copy, not a view of the shared segments.
+  JS::RootedObject buffer(cx, contents_to_array_buffer(cx, self));
+  if (!buffer) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  JS::RootedValue result(cx, JS::ObjectValue(*buffer));
+  return return_promise(cx, args, result);
+}
+
+// https://w3c.github.io/FileAPI/#bytes-method-algo
+bool Blob::bytes(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  JS::RootedObject buffer(cx, contents_to_array_buffer(cx, self));
+  if (!buffer) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  size_t len = JS::GetArrayBufferByteLength(buffer);
+  JS::RootedObject byte_array(cx, JS_NewUint8ArrayWithBuffer(cx, buffer, 0, len));
+  if (!byte_array) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  JS::RootedValue result(cx, JS::ObjectValue(*byte_array));
+  return return_promise(cx, args, result);
+}
+
+const JSFunctionSpec Blob::static_methods[] = {
+    JS_FS_END,
+};
+
+const JSPropertySpec Blob::static_properties[] = {
+    JS_PS_END,
+};
+
+const JSFunctionSpec Blob::methods[] = {
+    JS_FN("slice", slice, 0, JSPROP_ENUMERATE),
+    JS_FN("stream", stream, 0, JSPROP_ENUMERATE),
+    JS_FN("text", text, 0, JSPROP_ENUMERATE),
+    JS_FN("arrayBuffer", arrayBuffer, 0, JSPROP_ENUMERATE),
+    JS_FN("bytes", bytes, 0, JSPROP_ENUMERATE),
+    JS_FS_END,
+};
+
+const JSPropertySpec Blob::properties[] = {
+    JS_PSG("size", size_get, JSPROP_ENUMERATE),
+    JS_PSG("type", type_get, JSPROP_ENUMERATE),
+    JS_STRING_SYM_PS(toStringTag, "Blob", JSPROP_READONLY),
+    JS_PS_END,
+};
+
+/**
+ * https://w3c.github.io/FileAPI/#dom-blob-blob step 3, and https://w3c.github.io/FileAPI/#dfn-slice
+ * step 6: a type containing characters outside the range U+0020 to U+007E is replaced by the empty
+ * string, and all others are converted to ASCII lowercase.
+ */
+JSString *Blob::normalize_type(JSContext *cx, std::string_view type) {
+  std::string lower(type);
+  for (char &c : lower) {
+    auto byte = static_cast<unsigned char>(c);
+    if (byte < 0x20 || byte > 0x7E) {
+      return JS_GetEmptyString(cx);
+    }
+    if (byte >= 'A' && byte <= 'Z') {
+      c = static_cast<char>(byte + ('a' - 'A'));
+    }
+  }
+  return JS_NewStringCopyN(cx, lower.data(), lower.size());
+}
+
+JSString *Blob::normalize_type(JSContext *cx, JS::HandleValue type) {
+  auto chars = core::encode(cx, type);
+  if (!chars) {
+    return nullptr;
+  }
+  return normalize_type(cx, std::string_view(chars));
+}
+
+JSObject *Blob::create(JSContext *cx, BlobParts parts, JS::HandleString type) {
+  JS::RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &class_, proto_obj));
+  if (!self) {
+    return nullptr;
+  }
+  JS::SetReservedSlot(self, Slots::Parts, JS::PrivateValue(new BlobParts(std::move(parts))));
+  JS::SetReservedSlot(self, Slots::Type, JS::StringValue(type));
+  return self;
+}
+
+// https://w3c.github.io/FileAPI/#constructorBlob
+bool Blob::init(JSContext *cx, JS::HandleObject self, JS::HandleValue blob_parts,
+                JS::HandleValue options) {
+  const char *ctor_name = JS::GetClass(self)->name;
+
+  bool native_endings = false;
+  JS::RootedString type(cx, JS_GetEmptyString(cx));
+  if (!options.isNullOrUndefined()) {
+    if (!options.isObject()) {
+      JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_BLOB_OPTIONS_NOT_DICTIONARY,
+                                ctor_name);
+      return false;
+    }
+    JS::RootedObject options_obj(cx, &options.toObject());
+    JS::RootedValue val(cx);
+    if (!JS_GetProperty(cx, options_obj, "endings", &val)) {
+      return false;
+    }
+    if (!val.isUndefined()) {
+      auto endings = core::encode(cx, val);
+      if (!endings) {
+        return false;
+      }
+      std::string_view endings_str(endings.begin(), endings.len);
+      if (endings_str == "native") {
+        native_endings = true;
+      } else if (endings_str != "transparent") {
+        JS_ReportErrorNumberUTF8(cx, GetErrorMessage, nullptr, JSMSG_BLOB_INVALID_ENDINGS,
+                                 ctor_name, endings.begin());
+        return false;
+      }
+    }
+    if (!JS_GetProperty(cx, options_obj, "type", &val)) {
+      return false;
+    }
+    if (!val.isUndefined()) {
+      type = normalize_type(cx, val);
+      if (!type) {
+        return false;
+      }
+    }
+  }
+
+  BlobParts parts;
+  if (!blob_parts.isUndefined()) {
+    JS::ForOfIterator it(cx);
+    if (blob_parts.isObject() && !it.init(blob_parts, JS::ForOfIterator::AllowNonIterable)) {
+      return false;
+    }
+    if (!blob_parts.isObject() || !it.valueIsIterable()) {
+      JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_BLOB_PARTS_NOT_SEQUENCE,
+                                ctor_name);
+      return false;
+    }
+
+    SegmentBuilder builder(cx);
+    JS::RootedValue part_val(cx);
+    JS::RootedObject part_obj(cx);
+    while (true) {
+      bool done;
+      if (!it.next(&part_val, &done)) {
+        return false;
+      }
+      if (done) {
+        break;
+      }
+
+      part_obj = part_val.isObject() ? &part_val.toObject() : nullptr;
+      if (part_obj && Blob::is_instance(part_obj)) {
+        // Other Blobs' segments are shared, not copied.
+        if (!builder.finish(&parts)) {
+          return false;
+        }
+        const BlobParts &other = Blob::parts(part_obj);
+        parts.insert(parts.end(), other.begin(), other.end());
+      } else if (part_obj &&
+                 (JS_IsArrayBufferViewObject(part_obj) || JS::IsArrayBufferObject(part_obj))) {
+        bool is_view = JS_IsArrayBufferViewObject(part_obj);
+        size_t len = is_view ? JS_GetArrayBufferViewByteLength(part_obj)
+                             : JS::GetArrayBufferByteLength(part_obj);
+        uint8_t *dest = builder.reserve(len);
+        if (!dest) {
+          return false;
+        }
+        JS::AutoCheckCannotGC noGC(cx);
+        bool is_shared;
+        const uint8_t *src;
+        if (is_view) {
+          src = static_cast<uint8_t *>(JS_GetArrayBufferViewData(part_obj, &is_shared, noGC));
+        } else {
+          src = JS::GetArrayBufferData(part_obj, &is_shared, noGC);
+        }
+        if (len > 0) {
+          memcpy(dest, src, len);
+        }
+        builder.commit(len);
+      } else {
+        auto str = core::encode(cx, part_val);
+        if (!str) {
+          return false;
+        }
+        if (native_endings) {
+          convert_line_endings(str);
+        }
+        if (!builder.append(std::move(str))) {
+          return false;
+        }
+      }
+    }
+
+    if (!builder.finish(&parts)) {
+      return false;
+    }
+  }
+
+  JS::SetReservedSlot(self, Slots::Parts, JS::PrivateValue(new BlobParts(std::move(parts))));
+  JS::SetReservedSlot(self, Slots::Type, JS::StringValue(type));
+  return true;
+}
+
+bool Blob::constructor(JSContext *cx, unsigned argc, JS::Value *vp) {
+  CTOR_HEADER("Blob", 0);
+  JS::RootedObject self(cx, JS_NewObjectForConstructor(cx, &class_, args));
+  if (!self || !init(cx, self, args.get(0), args.get(1))) {
+    return false;
+  }
+  args.rval().setObject(*self);
+  return true;
+}
+
+void Blob::finalize(JS::GCContext *gcx, JSObject *self) {
+  // Construction might have failed before the parts were set.
+  JS::Value parts_val = JS::GetReservedSlot(self, Slots::Parts);
+  if (!parts_val.isUndefined()) {
+    delete static_cast<BlobParts *>(parts_val.toPrivate());
+  }
+}
+
+bool Blob::init_class(JSContext *cx, JS::HandleObject global) {
+  return init_class_impl(cx, global);
+}
+
+bool BlobReader::pull_algorithm(JSContext *cx, JS::CallArgs args, JS::HandleObject source,
+                                JS::HandleObject self, JS::HandleObject controller) {
+  args.rval().setUndefined();
+  JS::RootedObject blob(cx, &JS::GetReservedSlot(self, Slots::Target).toObject());
+  JS::RootedObject stream(cx, &JS::GetReservedSlot(self, Slots::Stream).toObject());
+  const BlobParts &parts = Blob::parts(blob);
+  auto index = static_cast<size_t>(JS::GetReservedSlot(self, Slots::PartIndex).toNumber());
+  auto offset = static_cast<size_t>(JS::GetReservedSlot(self, Slots::PartOffset).toNumber());
+
+  if (index == parts.size()) {
+    return JS::ReadableStreamClose(cx, stream);
+  }
+
+  // Chunks are copies, because content can modify them.
+  const BlobPart &part = parts[index];
+  size_t len = std::min(part.length - offset, BLOB_STREAM_CHUNK_SIZE);
+  auto *data = static_cast<uint8_t *>(JS_malloc(cx, len));
+  if (!data) {
+    JS_ReportOutOfMemory(cx);
+    return false;
+  }
+  memcpy(data, part.data() + offset, len);
+  JS::RootedObject buffer(cx, JS::NewArrayBufferWithContents(cx, len, data));
+  if (!buffer) {
+    JS_free(cx, data);
+    return false;
+  }
+  JS::RootedObject byte_array(cx, JS_NewUint8ArrayWithBuffer(cx, buffer, 0, len));
+  if (!byte_array) {
+    return false;
+  }
+
+  offset += len;
+  if (offset == part.length) {
+    index++;
+    offset = 0;
+  }
+  JS::SetReservedSlot(self, Slots::PartIndex, JS::NumberValue(static_cast<double>(index)));
+  JS::SetReservedSlot(self, Slots::PartOffset, JS::NumberValue(static_cast<double>(offset)));
+
+  JS::RootedValue chunk_val(cx, JS::ObjectValue(*byte_array));
+  if (!JS::ReadableStreamEnqueue(cx, stream, chunk_val)) {
+    return false;
+  }
+  // Closing right after the last chunk saves content a read.
+  if (index == parts.size()) {
+    return JS::ReadableStreamClose(cx, stream);
+  }
+  return true;
+}
+
+bool BlobReader::cancel_algorithm(JSContext *cx, JS::CallArgs args, JS::HandleObject source,
+                                  JS::HandleObject self, JS::HandleValue reason) {
+  args.rval().setUndefined();
+  return true;
+}
+
+const JSFunctionSpec BlobReader::static_methods[] = {
+    JS_FS_END,
+};
+
+const JSPropertySpec BlobReader::static_properties[] = {
+    JS_PS_END,
+};
+
+const JSFunctionSpec BlobReader::methods[] = {
+    JS_FS_END,
+};
+
+const JSPropertySpec BlobReader::properties[] = {
+    JS_PS_END,
+};
+
+JSObject *BlobReader::create_stream(JSContext *cx, JS::HandleObject blob) {
+  JS::RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &class_, proto_obj));
+  if (!self) {
+    return nullptr;
+  }
+  JS::SetReservedSlot(self, Slots::Target, JS::ObjectValue(*blob));
+  JS::SetReservedSlot(self, Slots::PartIndex, JS::NumberValue(0));
+  JS::SetReservedSlot(self, Slots::PartOffset, JS::NumberValue(0));
+
+  JS::RootedObject source(cx, NativeStreamSource::create(cx, self, JS::UndefinedHandleValue,
+                                                         pull_algorithm, cancel_algorithm));
+  if (!source) {
+    return nullptr;
+  }
+
+  // As for body streams, a highwater mark of 0 prevents reading eagerly.
+  JS::RootedObject stream(cx, JS::NewReadableDefaultStreamObject(cx, source, nullptr, 0.0));
+  if (!stream) {
+    return nullptr;
+  }
+  JS::SetReservedSlot(self, Slots::Stream, JS::ObjectValue(*stream));
+  return stream;
+}
+
+bool install(api::Engine *engine) {
+  return Blob::init_class(engine->cx(), engine->global()) &&
+         BlobReader::init_class(engine->cx(), engine->global());
+}
+
+} // namespace builtins::web::blob
@@ -0,0 +1,144 @@
+#ifndef BUILTINS_WEB_BLOB_H
+#define BUILTINS_WEB_BLOB_H
+
+#include "builtin.h"
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace builtins::web::blob {
+
+/**
+ * An immutable run of bytes, holding the contents of one or more Blobs.
+ *
+ * Segments are never changed after they have been created, so all Blobs containing some of a
+ * segment's bytes, e.g. because they're slices of each other, share it instead of copying it. The
+ * bytes are freed once the last of these Blobs has been collected.
+ */
+class BlobSegment final {
+  uint8_t *data_;
+  size_t len_;
+
+public:
+  /// Take ownership of `data`, which must have been allocated by SpiderMonkey.
+  BlobSegment(uint8_t *data, size_t len) : data_(data), len_(len) {}
+  ~BlobSegment();
+
+  BlobSegment(const BlobSegment &) = delete;
+  BlobSegment &operator=(const BlobSegment &) = delete;
+
+  const uint8_t *data() const { return data_; }
+  size_t len() const { return len_; }
+};
+
+/// A range of a segment's bytes, which is part of a Blob's contents.
+struct BlobPart {
+  std::shared_ptr<const BlobSegment> segment;
+  size_t offset;
+  size_t length;
+
+  const uint8_t *data() const { return segment->data() + offset; }
+};
+
+/// A Blob's contents, as the concatenation of its parts. Parts are never empty.
+using BlobParts = std::vector<BlobPart>;
+
+/**
+ * https://w3c.github.io/FileAPI/#blob-section
+ *
+ * Blobs are backed by shared, immutable segments, so slicing a Blob or creating a Blob from other
+ * Blobs never copies any bytes. Reading a Blob copies its bytes straight from the segments into
+ * the result, and Blobs used as Request or Response bodies are written to the host from them.
+ */
+class Blob final : public FinalizableBuiltinImpl<Blob> {
+  static bool size_get(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool type_get(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool slice(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool stream(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool text(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool arrayBuffer(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool bytes(JSContext *cx, unsigned argc, JS::Value *vp);
+
+  static JSString *normalize_type(JSContext *cx, JS::HandleValue type);
+
+public:
+  static constexpr const char *class_name = "Blob";
+
+  enum Slots {
+    /// The `BlobParts` holding the Blob's contents.
+    Parts,
+    /// The Blob's type, as a string.
+    Type,
+    Count
+  };
+
+  static const JSFunctionSpec static_methods[];
+  static const JSPropertySpec static_properties[];
+  static const JSFunctionSpec methods[];
+  static const JSPropertySpec properties[];
+
+  static const unsigned ctor_length = 0;
+
+  /// Files are Blobs, too, so all of Blob's methods and accessors work with them.
+  static bool is_instance(const JSObject *obj);
+  static bool is_instance(const JS::Value val);
+
+  static bool init_class(JSContext *cx, JS::HandleObject global);
+  static bool constructor(JSContext *cx, unsigned argc, JS::Value *vp);
+  static void finalize(JS::GCContext *gcx, JSObject *self);
+
+  static const BlobParts &parts(JSObject *self);
+  static size_t size(JSObject *self);
+  static JSString *type(JSObject *self);
+
+  /// Normalize a Blob's `type`, as given to the Blob constructor or `slice`.
+  static JSString *normalize_type(JSContext *cx, std::string_view type);
+
+  /// Create a Blob with the given contents and type, which must already be normalized.
+  static JSObject *create(JSContext *cx, BlobParts parts, JS::HandleString type);
+
+  /**
+   * Set the contents and type of `self`, a new Blob or File, from the `blobParts` and `options`
+   * arguments of the Blob or File constructor.
+   */
+  static bool init(JSContext *cx, JS::HandleObject self, JS::HandleValue blob_parts,
+                   JS::HandleValue options);
+};
+
+/// The state of a stream returned by `Blob#stream`, used as the owner of its native source.
+class BlobReader final : public BuiltinNoConstructor<BlobReader> {
+  static bool pull_algorithm(JSContext *cx, JS::CallArgs args, JS::HandleObject source,
+                             JS::HandleObject self, JS::HandleObject controller);
+  static bool cancel_algorithm(JSContext *cx, JS::CallArgs args, JS::HandleObject source,
+                               JS::HandleObject self, JS::HandleValue reason);
+
+public:
+  static constexpr const char *class_name = "BlobReader";
+
+  enum Slots {
+    /// The Blob being read.
+    Target,
+    /// The stream the Blob's bytes are enqueued into.
+    Stream,
+    /// The index of the part the next chunk starts in.
+    PartIndex,
+    /// The offset into that part the next chunk starts at.
+    PartOffset,
+    Count
+  };
+
+  static const JSFunctionSpec static_methods[];
+  static const JSPropertySpec static_properties[];
+  static const JSFunctionSpec methods[];
+  static const JSPropertySpec properties[];
+
+  /// Create a ReadableStream of `blob`'s bytes. Chunks are copied from the Blob as they're pulled.
+  static JSObject *create_stream(JSContext *cx, JS::HandleObject blob);
+};
+
+bool install(api::Engine *engine);
+
+} // namespace builtins::web::blob
+
+#endif
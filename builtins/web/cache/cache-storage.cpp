@@ -0,0 +1,238 @@
+#include "cache-storage.h"
+#include "cache-store.h"
+#include "cache.h"
+#include "encode.h"
+
+#include <cmath>
+
+namespace builtins::web::cache {
+
+namespace {
+
+JS::PersistentRooted<JSObject *> caches;
+
+bool return_promise(JSContext *cx, JS::CallArgs args, JS::HandleValue result) {
+  JSObject *promise = JS::CallOriginalPromiseResolve(cx, result);
+  if (!promise) {
+    return false;
+  }
+  args.rval().setObject(*promise);
+  return true;
+}
+
+bool get_limit(JSContext *cx, JS::HandleObject obj, const char *name, size_t *limit) {
+  JS::RootedValue val(cx);
+  if (!JS_GetProperty(cx, obj, name, &val)) {
+    return false;
+  }
+  if (val.isUndefined()) {
+    return true;
+  }
+  double n;
+  if (!JS::ToNumber(cx, val, &n)) {
+    return false;
+  }
+  if (!(n >= 1 && n <= static_cast<double>(SIZE_MAX)) || std::trunc(n) != n) {
+    JS_ReportErrorUTF8(cx, "caches.setLimits: %s must be a positive integer", name);
+    return false;
+  }
+  *limit = static_cast<size_t>(n);
+  return true;
+}
+
+/**
+ * The non-standard `caches.setLimits({maxBytes, maxEntries})` function, which changes how much
+ * memory all caches together may use, and how many entries they may hold. Omitted limits are left
+ * unchanged. If the new limits are exceeded, the least recently used entries are evicted right
+ * away.
+ */
+bool set_limits(JSContext *cx, unsigned argc, JS::Value *vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  if (!args.requireAtLeast(cx, "caches.setLimits", 1)) {
+    return false;
+  }
+  if (!args[0].isObject()) {
+    JS_ReportErrorUTF8(cx, "caches.setLimits: limits must be an object");
+    return false;
+  }
+
+  JS::RootedObject limits_obj(cx, &args[0].toObject());
+  size_t max_bytes = store().max_bytes();
+  size_t max_entries = store().max_entries();
+  if (!get_limit(cx, limits_obj, "maxBytes", &max_bytes) ||
+      !get_limit(cx, limits_obj, "maxEntries", &max_entries)) {
+    return false;
+  }
+  store().set_limits(max_bytes, max_entries);
+  args.rval().setUndefined();
+  return true;
+}
+
+const JSFunctionSpec caches_methods[] = {
+    JS_FN("setLimits", set_limits, 1, JSPROP_ENUMERATE),
+    JS_FS_END,
+};
+
+} // namespace
+
+// https://w3c.github.io/ServiceWorker/#cache-storage-match
+bool CacheStorage::match(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(1)
+  CacheQuery query;
+  if (!Cache::to_query(cx, args[0], args.get(1), &query)) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+
+  JS::RootedValue name_val(cx);
+  if (args.get(1).isObject()) {
+    JS::RootedObject options(cx, &args[1].toObject());
+    if (!JS_GetProperty(cx, options, "cacheName", &name_val)) {
+      return ReturnPromiseRejectedWithPendingError(cx, args);
+    }
+  }
+
+  const CachedResponse *found = nullptr;
+  if (name_val.isUndefined()) {
+    found = store().match_any(query);
+  } else {
+    auto name = core::encode(cx, name_val);
+    if (!name) {
+      return ReturnPromiseRejectedWithPendingError(cx, args);
+    }
+    if (store().has(name)) {
+      auto matches = store().match_all(store().open(name), query);
+      found = matches.empty() ? nullptr : matches.front();
+    }
+  }
+
+  JS::RootedValue result(cx);
+  if (found) {
+    JSObject *response = Cache::create_response(cx, *found);
+    if (!response) {
+      return ReturnPromiseRejectedWithPendingError(cx, args);
+    }
+    result.setObject(*response);
+  }
+  return return_promise(cx, args, result);
+}
+
+// https://w3c.github.io/ServiceWorker/#cache-storage-has
+bool CacheStorage::has(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(1)
+  auto name = core::encode(cx, args[0]);
+  if (!name) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  JS::RootedValue result(cx, JS::BooleanValue(store().has(name)));
+  return return_promise(cx, args, result);
+}
+
+// https://w3c.github.io/ServiceWorker/#cache-storage-open
+bool CacheStorage::open(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(1)
+  auto name = core::encode(cx, args[0]);
+  if (!name) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  JS::RootedObject cache(cx, Cache::create(cx, store().open(name)));
+  if (!cache) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  JS::RootedValue result(cx, JS::ObjectValue(*cache));
+  return return_promise(cx, args, result);
+}
+
+// https://w3c.github.io/ServiceWorker/#cache-storage-delete
+bool CacheStorage::delete_(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER_WITH_NAME(1, "delete")
+  auto name = core::encode(cx, args[0]);
+  if (!name) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  JS::RootedValue result(cx, JS::BooleanValue(store().remove(std::string_view(name))));
+  return return_promise(cx, args, result);
+}
+
+// https://w3c.github.io/ServiceWorker/#cache-storage-keys
+bool CacheStorage::keys(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  auto names = store().names();
+  JS::RootedObject keys(cx, JS::NewArrayObject(cx, names.size()));
+  if (!keys) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  JS::RootedString name(cx);
+  for (size_t i = 0; i < names.size(); i++) {
+    name = JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(names[i].data(), names[i].size()));
+    if (!name || !JS_SetElement(cx, keys, i, name)) {
+      return ReturnPromiseRejectedWithPendingError(cx, args);
+    }
+  }
+  JS::RootedValue result(cx, JS::ObjectValue(*keys));
+  return return_promise(cx, args, result);
+}
+
+const JSFunctionSpec CacheStorage::static_methods[] = {
+    JS_FS_END,
+};
+
+const JSPropertySpec CacheStorage::static_properties[] = {
+    JS_PS_END,
+};
+
+const JSFunctionSpec CacheStorage::methods[] = {
+    JS_FN("match", match, 1, JSPROP_ENUMERATE),
+    JS_FN("has", has, 1, JSPROP_ENUMERATE),
+    JS_FN("open", open, 1, JSPROP_ENUMERATE),
+    JS_FN("delete", delete_, 1, JSPROP_ENUMERATE),
+    JS_FN("keys", keys, 0, JSPROP_ENUMERATE),
+    JS_FS_END,
+};
+
+const JSPropertySpec CacheStorage::properties[] = {
+    JS_STRING_SYM_PS(toStringTag, "CacheStorage", JSPROP_READONLY),
+    JS_PS_END,
+};
+
+bool CacheStorage::constructor(JSContext *cx, unsigned argc, JS::Value *vp) {
+  JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_ILLEGAL_CTOR);
+  return false;
+}
+
+bool caches_get(JSContext *cx, unsigned argc, JS::Value *vp) {
+  JS::CallArgs args = CallArgsFromVp(argc, vp);
+  JS::RootedObject global(cx, JS::CurrentGlobalOrNull(cx));
+  auto thisv = args.thisv();
+  if (thisv != JS::UndefinedHandleValue && thisv != JS::ObjectValue(*global)) {
+    JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_INVALID_INTERFACE, "caches get",
+                              "Window");
+    return false;
+  }
+  args.rval().setObject(*caches);
+  return true;
+}
+
+bool CacheStorage::init_class(JSContext *cx, JS::HandleObject global) {
+  if (!init_class_impl(cx, global)) {
+    return false;
+  }
+
+  JS::RootedObject instance(cx, JS_NewObjectWithGivenProto(cx, &class_, proto_obj));
+  if (!instance) {
+    return false;
+  }
+  if (!JS_DefineFunctions(cx, instance, caches_methods)) {
+    return false;
+  }
+  caches.init(cx, instance);
+  return JS_DefineProperty(cx, global, "caches", caches_get, nullptr, JSPROP_ENUMERATE);
+}
+
+bool install(api::Engine *engine) {
+  if (!Cache::init_class(engine->cx(), engine->global())) {
+    return false;
+  }
+  return CacheStorage::init_class(engine->cx(), engine->global());
+}
+
+} // namespace builtins::web::cache
@@ -0,0 +1,42 @@
+#ifndef BUILTINS_WEB_CACHE_STORAGE_H
+#define BUILTINS_WEB_CACHE_STORAGE_H
+
+#include "builtin.h"
+
+namespace builtins::web::cache {
+
+/**
+ * The `caches` global, giving access to named in-memory caches.
+ *
+ * Caches and their contents persist for the lifetime of the instance, so responses cached while
+ * handling one request can be used for all later ones. Responses cached during initialization are
+ * part of the snapshot.
+ */
+class CacheStorage final : public BuiltinImpl<CacheStorage> {
+  static bool match(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool has(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool open(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool delete_(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool keys(JSContext *cx, unsigned argc, JS::Value *vp);
+
+public:
+  static constexpr const char *class_name = "CacheStorage";
+
+  enum Slots { Count };
+
+  static const JSFunctionSpec static_methods[];
+  static const JSPropertySpec static_properties[];
+  static const JSFunctionSpec methods[];
+  static const JSPropertySpec properties[];
+
+  static const unsigned ctor_length = 0;
+
+  static bool init_class(JSContext *cx, JS::HandleObject global);
+  static bool constructor(JSContext *cx, unsigned argc, JS::Value *vp);
+};
+
+bool install(api::Engine *engine);
+
+} // namespace builtins::web::cache
+
+#endif
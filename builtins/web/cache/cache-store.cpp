@@ -0,0 +1,249 @@
+#include "cache-store.h"
+#include "builtin.h"
+
+#include <algorithm>
+
+namespace builtins::web::cache {
+
+size_t CachedResponse::size() const {
+  size_t size = sizeof(CachedResponse) + url.size() + response_url.size() + status_text.size();
+  for (const auto &[name, value] : vary) {
+    size += name.size() + (value ? value->size() : 0);
+  }
+  for (const auto &str : headers) {
+    size += str.size();
+  }
+  if (body) {
+    size += body->len();
+  }
+  return size;
+}
+
+namespace {
+
+std::string_view without_fragment(std::string_view url) { return url.substr(0, url.find('#')); }
+
+std::string_view without_query(std::string_view url) { return url.substr(0, url.find('?')); }
+
+/// https://w3c.github.io/ServiceWorker/#request-matches-cached-item-algorithm
+bool matches(const CacheQuery &query, const CachedResponse &cached) {
+  if (!query.options.ignore_method && query.method != "GET") {
+    return false;
+  }
+
+  auto query_url = without_fragment(query.url);
+  auto cached_url = without_fragment(cached.url);
+  if (query.options.ignore_search) {
+    query_url = without_query(query_url);
+    cached_url = without_query(cached_url);
+  }
+  if (query_url != cached_url) {
+    return false;
+  }
+
+  if (query.options.ignore_vary) {
+    return true;
+  }
+  for (const auto &[name, value] : cached.vary) {
+    auto it = query.headers.find(name);
+    bool query_has_value = it != query.headers.end();
+    if (query_has_value != value.has_value() || (query_has_value && it->second != *value)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+uint64_t CacheStore::now() {
+  auto now = host_api::MonotonicClock::now();
+  // The monotonic clock of a running instance is unrelated to the one during initialization, so
+  // the lifetimes of entries stored during initialization start when the instance first uses them.
+  if (!rebased_ && hasWizeningFinished()) {
+    for (auto &entry : lru_) {
+      entry.response.stored_at = now;
+    }
+    rebased_ = true;
+  }
+  return now;
+}
+
+bool CacheStore::is_fresh(const CachedResponse &response, const uint64_t now) const {
+  return !response.lifetime || now - response.stored_at < *response.lifetime;
+}
+
+void CacheStore::erase(std::vector<Entries::iterator> &entries, const size_t index) {
+  auto it = entries[index];
+  bytes_ -= it->response.size();
+  lru_.erase(it);
+  entries.erase(entries.begin() + static_cast<ptrdiff_t>(index));
+}
+
+void CacheStore::evict() {
+  while (!lru_.empty() && (bytes_ > max_bytes_ || lru_.size() > max_entries_)) {
+    auto victim = std::prev(lru_.end());
+    auto &entries = caches_[victim->cache_id];
+    auto pos = std::find(entries.begin(), entries.end(), victim);
+    MOZ_ASSERT(pos != entries.end());
+    erase(entries, static_cast<size_t>(pos - entries.begin()));
+  }
+}
+
+uint32_t CacheStore::open(std::string_view name) {
+  for (const auto &[cache_name, id] : names_) {
+    if (cache_name == name) {
+      return id;
+    }
+  }
+  auto id = next_id_++;
+  names_.emplace_back(name, id);
+  caches_.emplace(id, std::vector<Entries::iterator>());
+  return id;
+}
+
+bool CacheStore::has(std::string_view name) const {
+  return std::any_of(names_.begin(), names_.end(),
+                     [name](const auto &entry) { return entry.first == name; });
+}
+
+bool CacheStore::remove(std::string_view name) {
+  auto it = std::find_if(names_.begin(), names_.end(),
+                         [name](const auto &entry) { return entry.first == name; });
+  if (it == names_.end()) {
+    return false;
+  }
+  auto cache = caches_.find(it->second);
+  for (auto entry : cache->second) {
+    bytes_ -= entry->response.size();
+    lru_.erase(entry);
+  }
+  caches_.erase(cache);
+  names_.erase(it);
+  return true;
+}
+
+std::vector<std::string> CacheStore::names() const {
+  std::vector<std::string> names;
+  names.reserve(names_.size());
+  for (const auto &[name, id] : names_) {
+    names.push_back(name);
+  }
+  return names;
+}
+
+std::vector<const CachedResponse *> CacheStore::match_all(const uint32_t cache_id,
+                                                          const CacheQuery &query) {
+  std::vector<const CachedResponse *> result;
+  auto cache = caches_.find(cache_id);
+  if (cache == caches_.end()) {
+    return result;
+  }
+
+  auto time = now();
+  auto &entries = cache->second;
+  for (size_t i = 0; i < entries.size();) {
+    auto it = entries[i];
+    if (!is_fresh(it->response, time)) {
+      erase(entries, i);
+      continue;
+    }
+    if (matches(query, it->response)) {
+      lru_.splice(lru_.begin(), lru_, it);
+      result.push_back(&it->response);
+    }
+    i++;
+  }
+  return result;
+}
+
+const CachedResponse *CacheStore::match_any(const CacheQuery &query) {
+  for (const auto &[name, id] : names_) {
+    auto found = match_all(id, query);
+    if (!found.empty()) {
+      return found.front();
+    }
+  }
+  return nullptr;
+}
+
+std::vector<const CachedResponse *> CacheStore::entries(const uint32_t cache_id) {
+  std::vector<const CachedResponse *> result;
+  auto cache = caches_.find(cache_id);
+  if (cache == caches_.end()) {
+    return result;
+  }
+
+  auto time = now();
+  auto &entries = cache->second;
+  for (size_t i = 0; i < entries.size();) {
+    if (!is_fresh(entries[i]->response, time)) {
+      erase(entries, i);
+      continue;
+    }
+    result.push_back(&entries[i]->response);
+    i++;
+  }
+  return result;
+}
+
+bool CacheStore::put(const uint32_t cache_id, const CacheQuery &query, CachedResponse response) {
+  auto size = response.size();
+  if (size > max_bytes_) {
+    return false;
+  }
+
+  auto cache = caches_.find(cache_id);
+  if (cache == caches_.end()) {
+    // The cache was deleted, so nothing can ever read the entry.
+    return true;
+  }
+
+  auto &entries = cache->second;
+  for (size_t i = 0; i < entries.size();) {
+    if (matches(query, entries[i]->response)) {
+      erase(entries, i);
+    } else {
+      i++;
+    }
+  }
+
+  response.stored_at = now();
+  lru_.push_front(Entry{cache_id, std::move(response)});
+  entries.push_back(lru_.begin());
+  bytes_ += size;
+  evict();
+  return true;
+}
+
+bool CacheStore::remove(const uint32_t cache_id, const CacheQuery &query) {
+  auto cache = caches_.find(cache_id);
+  if (cache == caches_.end()) {
+    return false;
+  }
+
+  bool removed = false;
+  auto &entries = cache->second;
+  for (size_t i = 0; i < entries.size();) {
+    if (matches(query, entries[i]->response)) {
+      erase(entries, i);
+      removed = true;
+    } else {
+      i++;
+    }
+  }
+  return removed;
+}
+
+void CacheStore::set_limits(const size_t max_bytes, const size_t max_entries) {
+  max_bytes_ = max_bytes;
+  max_entries_ = max_entries;
+  evict();
+}
+
+CacheStore &store() {
+  static CacheStore store;
+  return store;
+}
+
+} // namespace builtins::web::cache
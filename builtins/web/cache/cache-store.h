@@ -0,0 +1,138 @@
+#ifndef BUILTINS_WEB_CACHE_STORE_H
+#define BUILTINS_WEB_CACHE_STORE_H
+
+#include "../blob.h"
+#include "host_api.h"
+
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace builtins::web::cache {
+
+/// A request-response pair stored by `Cache.put`.
+struct CachedResponse {
+  /// The request's URL, without its fragment.
+  std::string url;
+  /// For each header name listed in the response's `Vary` header, the request's value for it, if
+  /// it had one.
+  std::vector<std::pair<std::string, std::optional<std::string>>> vary;
+
+  std::string response_url;
+  uint16_t status = 200;
+  std::string status_text;
+  /// The response's headers, as encoded by `Headers::encode_entries`.
+  std::vector<host_api::HostString> headers;
+  /// The response's body, or null if it had none. Responses served from the cache read it
+  /// through a Blob stream, so that content only ever gets copies of the stored bytes.
+  std::shared_ptr<const blob::BlobSegment> body;
+
+  /// The monotonic time at which the response was stored, and for how long it's fresh, if its
+  /// `Cache-Control` header limits that.
+  uint64_t stored_at = 0;
+  std::optional<uint64_t> lifetime;
+
+  /// The number of bytes the entry is accounted for.
+  size_t size() const;
+};
+
+/// The options shared by `Cache.match`, `Cache.delete` and `Cache.keys`.
+struct QueryOptions {
+  bool ignore_search = false;
+  bool ignore_method = false;
+  bool ignore_vary = false;
+};
+
+/// The request to look up cached responses for.
+struct CacheQuery {
+  std::string url;
+  std::string method = "GET";
+  /// The request's headers, by lower-case name. Empty if only a URL was given.
+  std::unordered_map<std::string, std::string> headers;
+  QueryOptions options;
+};
+
+/**
+ * The contents of all caches opened through `caches`, kept for the lifetime of the instance.
+ * Responses put into a cache during initialization are thus part of the snapshot, and available
+ * to all requests.
+ *
+ * Memory use is bounded by a maximum total size and number of entries across all caches. Putting
+ * a response evicts the least recently matched or stored entries until both bounds are met again.
+ * Entries whose `Cache-Control` lifetime has expired are dropped when they're looked up.
+ */
+class CacheStore final {
+  struct Entry {
+    uint32_t cache_id;
+    CachedResponse response;
+  };
+  using Entries = std::list<Entry>;
+
+  /// All entries, most recently used first.
+  Entries lru_;
+  /// The entries of each cache, in the order they were stored.
+  std::unordered_map<uint32_t, std::vector<Entries::iterator>> caches_;
+  /// The names of the caches, in the order they were created, with their ids.
+  std::vector<std::pair<std::string, uint32_t>> names_;
+  uint32_t next_id_ = 0;
+
+  size_t bytes_ = 0;
+  size_t max_bytes_ = 16 * 1024 * 1024;
+  size_t max_entries_ = 4096;
+
+  /// Whether entries stored during initialization have been given fresh timestamps.
+  bool rebased_ = false;
+
+  uint64_t now();
+  bool is_fresh(const CachedResponse &response, uint64_t now) const;
+  void erase(std::vector<Entries::iterator> &entries, size_t index);
+  void evict();
+
+public:
+  /// The id of the cache called `name`, which is created if it doesn't exist yet.
+  uint32_t open(std::string_view name);
+  bool has(std::string_view name) const;
+  /// Delete the cache called `name` along with its entries. Returns false if there was none.
+  bool remove(std::string_view name);
+  std::vector<std::string> names() const;
+
+  /**
+   * Find the entries of the cache `cache_id` matching `query`, in the order they were stored.
+   * Entries of deleted caches are gone, so nothing matches those.
+   *
+   * Marks the entries as recently used.
+   */
+  std::vector<const CachedResponse *> match_all(uint32_t cache_id, const CacheQuery &query);
+
+  /// Find the first entry matching `query`, searching all caches in the order they were created.
+  const CachedResponse *match_any(const CacheQuery &query);
+
+  /// All entries of the cache `cache_id`, in the order they were stored.
+  std::vector<const CachedResponse *> entries(uint32_t cache_id);
+
+  /**
+   * Store `response` for `query` in the cache `cache_id`, replacing the entries matching it.
+   *
+   * Returns false if the response is too large to ever fit into the store.
+   */
+  bool put(uint32_t cache_id, const CacheQuery &query, CachedResponse response);
+
+  /// Delete the entries of the cache `cache_id` matching `query`. Returns false if there were none.
+  bool remove(uint32_t cache_id, const CacheQuery &query);
+
+  size_t max_bytes() const { return max_bytes_; }
+  size_t max_entries() const { return max_entries_; }
+
+  /// Change the bounds of the store, evicting entries right away if they're exceeded.
+  void set_limits(size_t max_bytes, size_t max_entries);
+};
+
+CacheStore &store();
+
+} // namespace builtins::web::cache
+
+#endif
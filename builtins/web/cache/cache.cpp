@@ -0,0 +1,559 @@
+#include "cache.h"
+#include "../blob.h"
+#include "../dom-exception.h"
+#include "../fetch/headers.h"
+#include "../fetch/request-response.h"
+#include "../url.h"
+#include "../worker-location.h"
+#include "encode.h"
+
+#include <algorithm>
+#include <charconv>
+
+namespace builtins::web::cache {
+
+using dom_exception::DOMException;
+using fetch::Headers;
+using fetch::Request;
+using fetch::RequestOrResponse;
+using fetch::Response;
+
+namespace {
+
+/// The largest delta-seconds value, as recommended by RFC 9111, section 1.2.2.
+constexpr uint64_t MAX_DELTA_SECONDS = 2147483648;
+
+std::string_view trim(std::string_view str) {
+  auto start = str.find_first_not_of(" \t");
+  if (start == std::string_view::npos) {
+    return {};
+  }
+  auto end = str.find_last_not_of(" \t");
+  return str.substr(start, end - start + 1);
+}
+
+std::string to_lower(std::string_view str) {
+  std::string lower(str);
+  std::transform(lower.begin(), lower.end(), lower.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return lower;
+}
+
+/// The non-empty, trimmed elements of the comma-separated header value `list`.
+std::vector<std::string_view> split_list(std::string_view list) {
+  std::vector<std::string_view> elements;
+  while (true) {
+    auto comma = list.find(',');
+    auto element = trim(list.substr(0, comma));
+    if (!element.empty()) {
+      elements.push_back(element);
+    }
+    if (comma == std::string_view::npos) {
+      return elements;
+    }
+    list.remove_prefix(comma + 1);
+  }
+}
+
+std::optional<uint64_t> parse_delta_seconds(std::string_view str) {
+  str = trim(str);
+  if (str.size() >= 2 && str.front() == '"' && str.back() == '"') {
+    str = str.substr(1, str.size() - 2);
+  }
+  uint64_t seconds;
+  auto [end, err] = std::from_chars(str.data(), str.data() + str.size(), seconds);
+  if (err == std::errc::result_out_of_range) {
+    return MAX_DELTA_SECONDS;
+  }
+  if (err != std::errc() || end != str.data() + str.size()) {
+    return std::nullopt;
+  }
+  return std::min(seconds, MAX_DELTA_SECONDS);
+}
+
+/**
+ * Determine from the `Cache-Control` and `Age` headers in `headers` whether a response may be
+ * stored, and if so, for how many nanoseconds it stays fresh, if that's limited.
+ *
+ * Responses that must not be stored or that have to be revalidated before each use aren't stored,
+ * since the cache has no way to revalidate them.
+ */
+bool freshness(const std::vector<host_api::HostString> &headers,
+               std::optional<uint64_t> *lifetime) {
+  std::optional<uint64_t> max_age;
+  std::optional<uint64_t> s_maxage;
+  uint64_t age = 0;
+  for (size_t i = 0; i < headers.size(); i += 2) {
+    std::string_view name = headers[i];
+    std::string_view value = headers[i + 1];
+    if (name == "age") {
+      age = parse_delta_seconds(value).value_or(0);
+      continue;
+    }
+    if (name != "cache-control") {
+      continue;
+    }
+    for (auto directive : split_list(value)) {
+      auto eq = directive.find('=');
+      auto key = to_lower(trim(directive.substr(0, eq)));
+      if (key == "no-store" || key == "no-cache" || key == "private") {
+        return false;
+      }
+      // Invalid values make the response stale right away.
+      auto seconds = eq == std::string_view::npos
+                         ? std::optional<uint64_t>(0)
+                         : parse_delta_seconds(directive.substr(eq + 1)).value_or(0);
+      if (key == "max-age") {
+        max_age = seconds;
+      } else if (key == "s-maxage") {
+        s_maxage = seconds;
+      }
+    }
+  }
+
+  auto seconds = s_maxage ? s_maxage : max_age;
+  if (!seconds) {
+    lifetime->reset();
+    return true;
+  }
+  if (*seconds <= age) {
+    return false;
+  }
+  *lifetime = (*seconds - age) * 1000 * 1000 * 1000;
+  return true;
+}
+
+bool get_option(JSContext *cx, JS::HandleObject options, const char *name, bool *value) {
+  JS::RootedValue val(cx);
+  if (!JS_GetProperty(cx, options, name, &val)) {
+    return false;
+  }
+  *value = JS::ToBoolean(val);
+  return true;
+}
+
+uint32_t cache_id(JSObject *self) {
+  MOZ_ASSERT(Cache::is_instance(self));
+  return JS::GetReservedSlot(self, Cache::Slots::Id).toInt32();
+}
+
+/// Resolve `promise` with the outcome of storing `response`.
+bool store_response(JSContext *cx, JS::HandleObject promise, uint32_t id, const CacheQuery &query,
+                    CachedResponse response) {
+  if (!store().put(id, query, std::move(response))) {
+    JS::RootedObject error(cx, DOMException::create(cx, "Cache.put: response is too large to cache",
+                                                    "QuotaExceededError"));
+    if (!error) {
+      return false;
+    }
+    JS::RootedValue error_val(cx, JS::ObjectValue(*error));
+    return JS::RejectPromise(cx, promise, error_val);
+  }
+  return JS::ResolvePromise(cx, promise, JS::UndefinedHandleValue);
+}
+
+/// A `Cache.put` waiting for the response's body to be read.
+struct PendingPut {
+  uint32_t cache_id;
+  CacheQuery query;
+  CachedResponse response;
+};
+
+bool put_then_handler(JSContext *cx, JS::HandleObject promise, JS::HandleValue extra,
+                      JS::CallArgs args) {
+  std::unique_ptr<PendingPut> pending(static_cast<PendingPut *>(extra.toPrivate()));
+  JS::RootedObject buffer(cx, &args.get(0).toObject());
+
+  // The body's bytes are taken over from the buffer instead of being copied.
+  size_t len = JS::GetArrayBufferByteLength(buffer);
+  uint8_t *data = nullptr;
+  if (len > 0) {
+    data = static_cast<uint8_t *>(JS::StealArrayBufferContents(cx, buffer));
+    if (!data) {
+      return RejectPromiseWithPendingError(cx, promise);
+    }
+  }
+  pending->response.body = std::make_shared<const blob::BlobSegment>(data, len);
+
+  args.rval().setUndefined();
+  return store_response(cx, promise, pending->cache_id, pending->query,
+                        std::move(pending->response));
+}
+
+bool put_catch_handler(JSContext *cx, JS::HandleObject promise, JS::HandleValue extra,
+                       JS::CallArgs args) {
+  delete static_cast<PendingPut *>(extra.toPrivate());
+  args.rval().setUndefined();
+  return JS::RejectPromise(cx, promise, args.get(0));
+}
+
+JSObject *create_request(JSContext *cx, const std::string &url) {
+  JS::RootedObject request_instance(cx, Request::create_instance(cx));
+  if (!request_instance) {
+    return nullptr;
+  }
+  JS::RootedString url_str(cx, JS_NewStringCopyN(cx, url.data(), url.size()));
+  if (!url_str) {
+    return nullptr;
+  }
+  JS::RootedValue url_val(cx, JS::StringValue(url_str));
+  return Request::create(cx, request_instance, url_val, JS::UndefinedHandleValue);
+}
+
+bool return_promise(JSContext *cx, JS::CallArgs args, JS::HandleValue result) {
+  JSObject *promise = JS::CallOriginalPromiseResolve(cx, result);
+  if (!promise) {
+    return false;
+  }
+  args.rval().setObject(*promise);
+  return true;
+}
+
+} // namespace
+
+bool Cache::to_query(JSContext *cx, JS::HandleValue request, JS::HandleValue options,
+                     CacheQuery *query) {
+  JS::RootedValue url_val(cx);
+  if (request.isObject() && Request::is_instance(&request.toObject())) {
+    JS::RootedObject request_obj(cx, &request.toObject());
+    url_val = RequestOrResponse::url(request_obj);
+
+    JS::RootedString method_str(cx, Request::method(cx, request_obj));
+    auto method = core::encode(cx, method_str);
+    if (!method) {
+      return false;
+    }
+    query->method = std::string_view(method);
+
+    JS::RootedObject headers(cx, RequestOrResponse::headers(cx, request_obj));
+    std::vector<host_api::HostString> strings;
+    if (!headers || !Headers::delazify(cx, headers) ||
+        !Headers::encode_entries(cx, headers, &strings)) {
+      return false;
+    }
+    for (size_t i = 0; i < strings.size(); i += 2) {
+      query->headers.emplace(std::string_view(strings[i]), std::string_view(strings[i + 1]));
+    }
+  } else {
+    JS::RootedObject url_instance(
+        cx, JS_NewObjectWithGivenProto(cx, &url::URL::class_, url::URL::proto_obj));
+    if (!url_instance) {
+      return false;
+    }
+    JS::RootedObject url(cx, url::URL::create(cx, url_instance, request,
+                                              worker_location::WorkerLocation::url));
+    if (!url) {
+      return false;
+    }
+    url_val.setObject(*url);
+  }
+
+  auto url = core::encode(cx, url_val);
+  if (!url) {
+    return false;
+  }
+  std::string_view url_view = url;
+  query->url = url_view.substr(0, url_view.find('#'));
+
+  if (!options.isObject()) {
+    return true;
+  }
+  JS::RootedObject options_obj(cx, &options.toObject());
+  return get_option(cx, options_obj, "ignoreSearch", &query->options.ignore_search) &&
+         get_option(cx, options_obj, "ignoreMethod", &query->options.ignore_method) &&
+         get_option(cx, options_obj, "ignoreVary", &query->options.ignore_vary);
+}
+
+JSObject *Cache::create_response(JSContext *cx, const CachedResponse &cached) {
+  auto headers_res = host_api::HttpHeaders::from_list(Headers::to_entries(cached.headers));
+  if (auto *err = headers_res.to_err()) {
+    HANDLE_ERROR(cx, *err);
+    return nullptr;
+  }
+
+  JS::RootedObject body_stream(cx);
+  if (cached.body) {
+    // The body is read through a Blob sharing the stored segment, which copies each chunk as it's
+    // pulled, so content can't change the stored bytes.
+    blob::BlobParts parts;
+    if (cached.body->len() > 0) {
+      parts.push_back({cached.body, 0, cached.body->len()});
+    }
+    JS::RootedString type(cx, JS_GetEmptyString(cx));
+    JS::RootedObject body_blob(cx, blob::Blob::create(cx, std::move(parts), type));
+    if (!body_blob) {
+      return nullptr;
+    }
+    body_stream = blob::BlobReader::create_stream(cx, body_blob);
+    if (!body_stream) {
+      return nullptr;
+    }
+  }
+
+  JS::RootedObject response(
+      cx, Response::create_with_stream(cx, cached.status, headers_res.unwrap(), body_stream));
+  if (!response) {
+    return nullptr;
+  }
+
+  JS::RootedString status_text(
+      cx, JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(cached.status_text.data(),
+                                                  cached.status_text.size())));
+  JS::RootedString url(cx, JS_NewStringCopyN(cx, cached.response_url.data(),
+                                             cached.response_url.size()));
+  if (!status_text || !url) {
+    return nullptr;
+  }
+  JS::SetReservedSlot(response, static_cast<uint32_t>(Response::Slots::StatusMessage),
+                      JS::StringValue(status_text));
+  RequestOrResponse::set_url(response, JS::StringValue(url));
+  return response;
+}
+
+// https://w3c.github.io/ServiceWorker/#cache-match
+bool Cache::match(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(1)
+  CacheQuery query;
+  if (!to_query(cx, args[0], args.get(1), &query)) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+
+  JS::RootedValue result(cx);
+  auto found = store().match_all(cache_id(self), query);
+  if (!found.empty()) {
+    JSObject *response = create_response(cx, *found.front());
+    if (!response) {
+      return ReturnPromiseRejectedWithPendingError(cx, args);
+    }
+    result.setObject(*response);
+  }
+  return return_promise(cx, args, result);
+}
+
+// https://w3c.github.io/ServiceWorker/#cache-matchall
+bool Cache::matchAll(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  std::vector<const CachedResponse *> found;
+  if (args.get(0).isUndefined()) {
+    found = store().entries(cache_id(self));
+  } else {
+    CacheQuery query;
+    if (!to_query(cx, args[0], args.get(1), &query)) {
+      return ReturnPromiseRejectedWithPendingError(cx, args);
+    }
+    found = store().match_all(cache_id(self), query);
+  }
+
+  JS::RootedObject responses(cx, JS::NewArrayObject(cx, found.size()));
+  if (!responses) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  JS::RootedObject response(cx);
+  for (size_t i = 0; i < found.size(); i++) {
+    response = create_response(cx, *found[i]);
+    if (!response || !JS_SetElement(cx, responses, i, response)) {
+      return ReturnPromiseRejectedWithPendingError(cx, args);
+    }
+  }
+  JS::RootedValue result(cx, JS::ObjectValue(*responses));
+  return return_promise(cx, args, result);
+}
+
+// https://w3c.github.io/ServiceWorker/#cache-put
+bool Cache::put(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(2)
+  auto pending = std::make_unique<PendingPut>();
+  pending->cache_id = cache_id(self);
+  auto &query = pending->query;
+  auto &cached = pending->response;
+
+  if (!to_query(cx, args[0], JS::UndefinedHandleValue, &query)) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  if (query.method != "GET") {
+    JS_ReportErrorUTF8(cx, "Cache.put: only GET requests can be cached");
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  if (!query.url.starts_with("http:") && !query.url.starts_with("https:")) {
+    JS_ReportErrorUTF8(cx, "Cache.put: only http and https requests can be cached");
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+
+  if (!args[1].isObject() || !Response::is_instance(&args[1].toObject())) {
+    JS_ReportErrorUTF8(cx, "Cache.put: response must be a Response");
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  JS::RootedObject response(cx, &args[1].toObject());
+  cached.url = query.url;
+  cached.status = Response::status(response);
+  if (cached.status == 206) {
+    JS_ReportErrorUTF8(cx, "Cache.put: partial responses can't be cached");
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  if (RequestOrResponse::body_used(response)) {
+    JS_ReportErrorUTF8(cx, "Cache.put: response body has already been used");
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+
+  JS::RootedObject headers(cx, RequestOrResponse::headers(cx, response));
+  if (!headers || !Headers::delazify(cx, headers) ||
+      !Headers::encode_entries(cx, headers, &cached.headers)) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  for (size_t i = 0; i < cached.headers.size(); i += 2) {
+    if (std::string_view(cached.headers[i]) != "vary") {
+      continue;
+    }
+    for (auto name : split_list(cached.headers[i + 1])) {
+      if (name == "*") {
+        JS_ReportErrorUTF8(cx, "Cache.put: responses with \"Vary: *\" can't be cached");
+        return ReturnPromiseRejectedWithPendingError(cx, args);
+      }
+      auto lower_name = to_lower(name);
+      auto value = query.headers.find(lower_name);
+      cached.vary.emplace_back(std::move(lower_name),
+                               value == query.headers.end()
+                                   ? std::nullopt
+                                   : std::optional<std::string>(value->second));
+    }
+  }
+
+  JS::RootedValue result(cx);
+  if (!freshness(cached.headers, &cached.lifetime)) {
+    return return_promise(cx, args, result);
+  }
+
+  JS::RootedString status_text(cx, Response::status_message(response));
+  auto status_text_chars = core::encode(cx, status_text);
+  JS::RootedValue url_val(cx, RequestOrResponse::url(response));
+  auto url = core::encode(cx, url_val);
+  if (!status_text_chars || !url) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  cached.status_text = std::string_view(status_text_chars);
+  cached.response_url = std::string_view(url);
+
+  JS::RootedObject promise(cx, JS::NewPromiseObject(cx, nullptr));
+  if (!promise) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  args.rval().setObject(*promise);
+
+  if (!RequestOrResponse::has_body(response)) {
+    return store_response(cx, promise, pending->cache_id, query, std::move(cached));
+  }
+
+  // Bodies of Responses constructed from anything but a stream are written to the host right away,
+  // so they can't be read back.
+  if (!RequestOrResponse::is_incoming(response) && !RequestOrResponse::body_stream(response)) {
+    JS_ReportErrorUTF8(cx, "Cache.put: the response's body can't be read. Construct the Response "
+                           "with a ReadableStream body to cache it");
+    return RejectPromiseWithPendingError(cx, promise);
+  }
+
+  using BodyReadResult = RequestOrResponse::BodyReadResult;
+  JS::RootedObject body_promise(
+      cx, RequestOrResponse::read_all<BodyReadResult::ArrayBuffer>(cx, response));
+  if (!body_promise) {
+    return RejectPromiseWithPendingError(cx, promise);
+  }
+
+  JS::RootedValue extra(cx, JS::PrivateValue(pending.get()));
+  JS::RootedObject then_handler(cx, create_internal_method<put_then_handler>(cx, promise, extra));
+  if (!then_handler) {
+    return false;
+  }
+  JS::RootedObject catch_handler(cx, create_internal_method<put_catch_handler>(cx, promise, extra));
+  if (!catch_handler) {
+    return false;
+  }
+  if (!JS::AddPromiseReactions(cx, body_promise, then_handler, catch_handler)) {
+    return false;
+  }
+
+  // Freed by whichever of the handlers runs.
+  std::ignore = pending.release();
+  return true;
+}
+
+// https://w3c.github.io/ServiceWorker/#cache-delete
+bool Cache::delete_(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER_WITH_NAME(1, "delete")
+  CacheQuery query;
+  if (!to_query(cx, args[0], args.get(1), &query)) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  JS::RootedValue result(cx, JS::BooleanValue(store().remove(cache_id(self), query)));
+  return return_promise(cx, args, result);
+}
+
+// https://w3c.github.io/ServiceWorker/#cache-keys
+bool Cache::keys(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  std::vector<const CachedResponse *> found;
+  if (args.get(0).isUndefined()) {
+    found = store().entries(cache_id(self));
+  } else {
+    CacheQuery query;
+    if (!to_query(cx, args[0], args.get(1), &query)) {
+      return ReturnPromiseRejectedWithPendingError(cx, args);
+    }
+    found = store().match_all(cache_id(self), query);
+  }
+
+  JS::RootedObject requests(cx, JS::NewArrayObject(cx, found.size()));
+  if (!requests) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  JS::RootedObject request(cx);
+  for (size_t i = 0; i < found.size(); i++) {
+    request = create_request(cx, found[i]->url);
+    if (!request || !JS_SetElement(cx, requests, i, request)) {
+      return ReturnPromiseRejectedWithPendingError(cx, args);
+    }
+  }
+  JS::RootedValue result(cx, JS::ObjectValue(*requests));
+  return return_promise(cx, args, result);
+}
+
+const JSFunctionSpec Cache::static_methods[] = {
+    JS_FS_END,
+};
+
+const JSPropertySpec Cache::static_properties[] = {
+    JS_PS_END,
+};
+
+const JSFunctionSpec Cache::methods[] = {
+    JS_FN("match", match, 1, JSPROP_ENUMERATE),
+    JS_FN("matchAll", matchAll, 0, JSPROP_ENUMERATE),
+    JS_FN("put", put, 2, JSPROP_ENUMERATE),
+    JS_FN("delete", delete_, 1, JSPROP_ENUMERATE),
+    JS_FN("keys", keys, 0, JSPROP_ENUMERATE),
+    JS_FS_END,
+};
+
+const JSPropertySpec Cache::properties[] = {
+    JS_STRING_SYM_PS(toStringTag, "Cache", JSPROP_READONLY),
+    JS_PS_END,
+};
+
+bool Cache::constructor(JSContext *cx, unsigned argc, JS::Value *vp) {
+  JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_ILLEGAL_CTOR);
+  return false;
+}
+
+bool Cache::init_class(JSContext *cx, JS::HandleObject global) {
+  return init_class_impl(cx, global);
+}
+
+JSObject *Cache::create(JSContext *cx, const uint32_t id) {
+  JS::RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &class_, proto_obj));
+  if (!self) {
+    return nullptr;
+  }
+  JS::SetReservedSlot(self, Slots::Id, JS::Int32Value(static_cast<int32_t>(id)));
+  return self;
+}
+
+} // namespace builtins::web::cache
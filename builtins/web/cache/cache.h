@@ -0,0 +1,55 @@
+#ifndef BUILTINS_WEB_CACHE_H
+#define BUILTINS_WEB_CACHE_H
+
+#include "builtin.h"
+#include "cache-store.h"
+
+namespace builtins::web::cache {
+
+/**
+ * A named cache of request-response pairs, as returned by `caches.open`.
+ *
+ * The entries themselves live in the instance-wide `CacheStore`; a Cache object only holds the id
+ * of its cache there.
+ */
+class Cache final : public BuiltinImpl<Cache> {
+  static bool match(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool matchAll(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool put(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool delete_(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool keys(JSContext *cx, unsigned argc, JS::Value *vp);
+
+public:
+  static constexpr const char *class_name = "Cache";
+
+  enum Slots { Id, Count };
+
+  static const JSFunctionSpec static_methods[];
+  static const JSPropertySpec static_properties[];
+  static const JSFunctionSpec methods[];
+  static const JSPropertySpec properties[];
+
+  static const unsigned ctor_length = 0;
+
+  static bool init_class(JSContext *cx, JS::HandleObject global);
+  static bool constructor(JSContext *cx, unsigned argc, JS::Value *vp);
+
+  static JSObject *create(JSContext *cx, uint32_t id);
+
+  /**
+   * Fill in `query` from a `RequestInfo` and an optional `CacheQueryOptions` dictionary.
+   * Fragments are removed from the URL.
+   */
+  static bool to_query(JSContext *cx, JS::HandleValue request, JS::HandleValue options,
+                       CacheQuery *query);
+
+  /**
+   * Create a new Response for `cached`. The Response's body stream yields a single chunk whose
+   * buffer points directly at the cached bytes, so writing to it changes them for later matches.
+   */
+  static JSObject *create_response(JSContext *cx, const CachedResponse &cached);
+};
+
+} // namespace builtins::web::cache
+
+#endif
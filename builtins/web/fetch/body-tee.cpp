@@ -0,0 +1,394 @@
+#include "body-tee.h"
+#include "../streams/native-stream-source.h"
+#include "event_loop.h"
+#include "request-response.h"
+
+#include "js/Array.h"
+#include "js/Stream.h"
+
+namespace builtins::web::fetch {
+
+using streams::NativeStreamSource;
+
+static api::Engine *ENGINE;
+
+#ifndef BODY_TEE_BUFFER_LIMIT
+#define BODY_TEE_BUFFER_LIMIT (1024 * 1024)
+#endif
+
+namespace {
+
+/// The number of bytes a branch can have queued before reading pauses until content has read them.
+/// Can be changed by setting the `BODY_TEE_BUFFER_LIMIT` environment variable during build
+/// configuration.
+constexpr size_t MAX_TEE_BUFFERED_BYTES = BODY_TEE_BUFFER_LIMIT;
+
+/// Reads the next chunk of a `BodyTee`'s incoming body.
+class BodyTeeTask final : public api::AsyncTask {
+  Heap<JSObject *> tee_;
+
+public:
+  explicit BodyTeeTask(const HandleObject tee) : tee_(tee) {
+    auto *owner = &JS::GetReservedSlot(tee, BodyTee::Slots::Owner).toObject();
+    auto res = RequestOrResponse::incoming_body_handle(owner)->subscribe();
+    MOZ_ASSERT(!res.is_err(), "Subscribing to a future should never fail");
+    handle_ = res.unwrap();
+  }
+
+  [[nodiscard]] bool run(api::Engine *engine) override {
+    JSContext *cx = engine->cx();
+    RootedObject tee(cx, tee_);
+    return cancel(engine) && BodyTee::read_chunk(cx, tee);
+  }
+
+  [[nodiscard]] bool cancel(api::Engine *engine) override {
+    // Like for `BodyFutureTask`, the pollable belongs to the body.
+    handle_ = -1;
+    return true;
+  }
+
+  bool ready() override { return true; }
+
+  void trace(JSTracer *trc) override { TraceEdge(trc, &tee_, "Body tee for read task"); }
+};
+
+/// Collect those of `tee`'s branches that are still readable, i.e. neither cancelled nor errored.
+bool readable_branches(JSContext *cx, HandleObject tee, JS::MutableHandleObjectVector branches) {
+  RootedObject list(cx, &JS::GetReservedSlot(tee, BodyTee::Slots::Branches).toObject());
+  uint32_t length;
+  if (!JS::GetArrayLength(cx, list, &length)) {
+    return false;
+  }
+
+  RootedValue branch_val(cx);
+  RootedObject branch(cx);
+  for (uint32_t i = 0; i < length; i++) {
+    if (!JS_GetElement(cx, list, i, &branch_val)) {
+      return false;
+    }
+    branch = &branch_val.toObject();
+    bool readable;
+    if (!JS::ReadableStreamIsReadable(cx, branch, &readable)) {
+      return false;
+    }
+    if (readable && !branches.append(branch)) {
+      JS_ReportOutOfMemory(cx);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/// Whether any of `branches` has more than `MAX_TEE_BUFFERED_BYTES` queued.
+bool over_buffer_limit(JSContext *cx, JS::HandleObjectVector branches, bool *over) {
+  *over = false;
+  RootedObject stream(cx);
+  for (auto branch : branches) {
+    stream = branch;
+    bool has_value;
+    double desired_size;
+    if (!JS::ReadableStreamGetDesiredSize(cx, stream, &has_value, &desired_size)) {
+      return false;
+    }
+    // With a highwater mark of 0, the desired size is the negated number of queued bytes.
+    if (has_value && -desired_size > static_cast<double>(MAX_TEE_BUFFERED_BYTES)) {
+      *over = true;
+      return true;
+    }
+  }
+  return true;
+}
+
+/**
+ * Start reading the next chunk, unless a read is pending already, or some branch has too much
+ * queued. In the latter case, the read is started once that branch has caught up, and pulls again.
+ */
+bool maybe_read(JSContext *cx, HandleObject tee) {
+  if (JS::GetReservedSlot(tee, BodyTee::Slots::Reading).toBoolean()) {
+    return true;
+  }
+
+  JS::RootedObjectVector branches(cx);
+  if (!readable_branches(cx, tee, &branches)) {
+    return false;
+  }
+  bool over;
+  if (!over_buffer_limit(cx, branches, &over)) {
+    return false;
+  }
+  JS::SetReservedSlot(tee, BodyTee::Slots::Waiting, JS::BooleanValue(over));
+  if (over) {
+    return true;
+  }
+
+  JS::SetReservedSlot(tee, BodyTee::Slots::Reading, JS::TrueValue());
+  ENGINE->queue_async_task(new BodyTeeTask(tee));
+  return true;
+}
+
+/// Call `method` on the controller of the branch `stream` with `args`.
+bool call_controller(JSContext *cx, HandleObject stream, const char *method,
+                     const JS::HandleValueArray &args) {
+  RootedObject source(cx, NativeStreamSource::get_stream_source(cx, stream));
+  RootedObject controller(cx, NativeStreamSource::controller(source));
+  RootedValue r(cx);
+  return JS::Call(cx, controller, method, args, &r);
+}
+
+/// Close the branch `stream`. A pending BYOB read is completed by responding with 0 bytes.
+bool close_branch(JSContext *cx, HandleObject stream) {
+  if (!call_controller(cx, stream, "close", JS::HandleValueArray::empty())) {
+    return false;
+  }
+  RootedObject source(cx, NativeStreamSource::get_stream_source(cx, stream));
+  RootedObject controller(cx, NativeStreamSource::controller(source));
+  RootedValue byob_request(cx);
+  if (!JS_GetProperty(cx, controller, "byobRequest", &byob_request)) {
+    return false;
+  }
+  if (!byob_request.isObject()) {
+    return true;
+  }
+  RootedObject request(cx, &byob_request.toObject());
+  RootedValueArray<1> respond_args(cx);
+  respond_args[0].setInt32(0);
+  RootedValue r(cx);
+  return JS::Call(cx, request, "respond", respond_args, &r);
+}
+
+} // namespace
+
+bool BodyTee::pull_algorithm(JSContext *cx, JS::CallArgs args, JS::HandleObject source,
+                             JS::HandleObject self, JS::HandleObject controller) {
+  args.rval().setUndefined();
+  // A pending read's chunk will be enqueued into this branch, too.
+  return maybe_read(cx, self);
+}
+
+bool BodyTee::cancel_algorithm(JSContext *cx, JS::CallArgs args, JS::HandleObject source,
+                               JS::HandleObject self, JS::HandleValue reason) {
+  args.rval().setUndefined();
+  // The cancelled branch is already closed, so it isn't included here.
+  JS::RootedObjectVector branches(cx);
+  if (!readable_branches(cx, self, &branches)) {
+    return false;
+  }
+  if (branches.empty()) {
+    RootedObject owner(cx, &JS::GetReservedSlot(self, Slots::Owner).toObject());
+    RequestOrResponse::close_incoming_body(owner);
+    return RequestOrResponse::incoming_body_finished(cx, owner);
+  }
+
+  // The cancelled branch might have been the one the others were waiting for.
+  if (JS::GetReservedSlot(self, Slots::Waiting).toBoolean()) {
+    return maybe_read(cx, self);
+  }
+  return true;
+}
+
+bool BodyTee::read_chunk(JSContext *cx, JS::HandleObject self) {
+  JS::SetReservedSlot(self, Slots::Reading, JS::FalseValue());
+
+  RootedObject owner(cx, &JS::GetReservedSlot(self, Slots::Owner).toObject());
+  JS::RootedObjectVector branches(cx);
+  if (!readable_branches(cx, self, &branches)) {
+    return false;
+  }
+  if (branches.empty()) {
+    RequestOrResponse::close_incoming_body(owner);
+    return RequestOrResponse::incoming_body_finished(cx, owner);
+  }
+
+  auto *body = RequestOrResponse::incoming_body_handle(owner);
+  auto read_res = body->read(RequestOrResponse::next_read_size(owner));
+  if (auto *err = read_res.to_err()) {
+    HANDLE_ERROR(cx, *err);
+    RootedValue exn(cx);
+    if (!JS_GetPendingException(cx, &exn)) {
+      return false;
+    }
+    JS_ClearPendingException(cx);
+    return error(cx, self, exn);
+  }
+
+  auto &chunk = read_res.unwrap();
+  if (chunk.done) {
+    return close(cx, self);
+  }
+
+  // Byte streams don't accept empty chunks, so wait for the next one instead.
+  if (chunk.bytes.len == 0) {
+    return maybe_read(cx, self);
+  }
+
+  auto &bytes = chunk.bytes;
+  RootedObject buffer(cx, JS::NewArrayBufferWithContents(cx, bytes.len, bytes.ptr.get()));
+  if (!buffer) {
+    return false;
+  }
+
+  // At this point `buffer` has taken full ownership of the chunk's data.
+  std::ignore = bytes.ptr.release();
+
+  RootedObject byte_array(cx, JS_NewUint8ArrayWithBuffer(cx, buffer, 0, bytes.len));
+  if (!byte_array) {
+    return false;
+  }
+  return enqueue(cx, self, byte_array);
+}
+
+bool BodyTee::enqueue(JSContext *cx, JS::HandleObject self, JS::HandleObject chunk) {
+  JS::RootedObjectVector branches(cx);
+  if (!readable_branches(cx, self, &branches)) {
+    return false;
+  }
+
+  // Enqueueing into a byte stream transfers the chunk's buffer, so all branches but the last get a
+  // copy of it, made before the buffer is transferred.
+  size_t len = JS_GetTypedArrayByteLength(chunk);
+  RootedObject stream(cx);
+  RootedObject copy(cx);
+  RootedValueArray<1> enqueue_args(cx);
+  for (size_t i = 0; i < branches.length(); i++) {
+    stream = branches[i];
+    if (i + 1 == branches.length()) {
+      enqueue_args[0].setObject(*chunk);
+    } else {
+      copy = JS_NewUint8Array(cx, len);
+      if (!copy) {
+        return false;
+      }
+      JS::AutoCheckCannotGC nogc(cx);
+      bool is_shared;
+      memcpy(JS_GetUint8ArrayData(copy, &is_shared, nogc),
+             JS_GetUint8ArrayData(chunk, &is_shared, nogc), len);
+      enqueue_args[0].setObject(*copy);
+    }
+    if (!call_controller(cx, stream, "enqueue", enqueue_args)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BodyTee::close(JSContext *cx, JS::HandleObject self) {
+  JS::RootedObjectVector branches(cx);
+  if (!readable_branches(cx, self, &branches)) {
+    return false;
+  }
+  RootedObject stream(cx);
+  for (auto branch : branches) {
+    stream = branch;
+    if (!close_branch(cx, stream)) {
+      return false;
+    }
+  }
+  RootedObject owner(cx, &JS::GetReservedSlot(self, Slots::Owner).toObject());
+  return RequestOrResponse::incoming_body_finished(cx, owner);
+}
+
+bool BodyTee::error(JSContext *cx, JS::HandleObject self, JS::HandleValue reason) {
+  JS::RootedObjectVector branches(cx);
+  if (!readable_branches(cx, self, &branches)) {
+    return false;
+  }
+  RootedObject stream(cx);
+  RootedValueArray<1> error_args(cx);
+  error_args[0].set(reason);
+  for (auto branch : branches) {
+    stream = branch;
+    if (!call_controller(cx, stream, "error", error_args)) {
+      return false;
+    }
+  }
+  RootedObject owner(cx, &JS::GetReservedSlot(self, Slots::Owner).toObject());
+  RequestOrResponse::close_incoming_body(owner);
+  return true;
+}
+
+JSObject *BodyTee::from_branch(JSContext *cx, JS::HandleObject stream) {
+  JSObject *source = NativeStreamSource::get_stream_source(cx, stream);
+  if (!NativeStreamSource::is_instance(source)) {
+    return nullptr;
+  }
+  JSObject *owner = NativeStreamSource::owner(source);
+  return is_instance(owner) ? owner : nullptr;
+}
+
+const JSFunctionSpec BodyTee::static_methods[] = {
+    JS_FS_END,
+};
+
+const JSPropertySpec BodyTee::static_properties[] = {
+    JS_PS_END,
+};
+
+const JSFunctionSpec BodyTee::methods[] = {
+    JS_FS_END,
+};
+
+const JSPropertySpec BodyTee::properties[] = {
+    JS_PS_END,
+};
+
+JSObject *BodyTee::create(JSContext *cx, JS::HandleObject owner) {
+  MOZ_ASSERT(RequestOrResponse::is_incoming(owner));
+  MOZ_ASSERT(!RequestOrResponse::body_used(owner));
+
+  RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &class_, proto_obj));
+  if (!self) {
+    return nullptr;
+  }
+  RootedObject branches(cx, JS::NewArrayObject(cx, 0));
+  if (!branches) {
+    return nullptr;
+  }
+  JS::SetReservedSlot(self, Slots::Owner, ObjectValue(*owner));
+  JS::SetReservedSlot(self, Slots::Branches, ObjectValue(*branches));
+  JS::SetReservedSlot(self, Slots::Reading, JS::FalseValue());
+  JS::SetReservedSlot(self, Slots::Waiting, JS::FalseValue());
+
+  // Content can't get at the body through `owner` anymore.
+  if (!RequestOrResponse::mark_body_used(cx, owner)) {
+    return nullptr;
+  }
+  return self;
+}
+
+JSObject *BodyTee::create_branch(JSContext *cx, JS::HandleObject self) {
+  RootedObject source(cx, NativeStreamSource::create(cx, self, JS::UndefinedHandleValue,
+                                                     pull_algorithm, cancel_algorithm));
+  if (!source) {
+    return nullptr;
+  }
+
+  // Like incoming body streams, branches are byte streams, so content can read them with a BYOB
+  // reader. Their highwater mark of 0 prevents reading eagerly.
+  RootedObject stream(cx, RequestOrResponse::new_byte_stream(cx, source));
+  if (!stream) {
+    return nullptr;
+  }
+
+  RootedObject branches(cx, &JS::GetReservedSlot(self, Slots::Branches).toObject());
+  uint32_t length;
+  if (!JS::GetArrayLength(cx, branches, &length)) {
+    return nullptr;
+  }
+  RootedValue stream_val(cx, ObjectValue(*stream));
+  if (!JS_SetElement(cx, branches, length, stream_val)) {
+    return nullptr;
+  }
+  return stream;
+}
+
+namespace body_tee {
+
+bool install(api::Engine *engine) {
+  ENGINE = engine;
+  return BodyTee::init_class(engine->cx(), engine->global());
+}
+
+} // namespace body_tee
+
+} // namespace builtins::web::fetch
@@ -0,0 +1,77 @@
+#ifndef BUILTINS_WEB_FETCH_BODY_TEE_H
+#define BUILTINS_WEB_FETCH_BODY_TEE_H
+
+#include "builtin.h"
+
+namespace builtins::web::fetch {
+
+namespace body_tee {
+
+bool install(api::Engine *engine);
+
+}
+
+/**
+ * Reads an incoming body once, and enqueues each chunk into several readable byte streams, the
+ * branches.
+ *
+ * A chunk is read from the host whenever a branch pulls and no read is pending yet, and is then
+ * enqueued into all branches. Enqueueing transfers a chunk's buffer to the branch, so each branch
+ * gets its own copy. Once all branches are cancelled or errored, the incoming body is closed.
+ *
+ * Reading follows the slowest branch: while any branch has more than `MAX_TEE_BUFFERED_BYTES` bytes
+ * queued that content hasn't read yet, pulls from the other branches wait for it to catch up,
+ * instead of buffering an unbounded part of the body.
+ */
+class BodyTee final : public BuiltinNoConstructor<BodyTee> {
+  static bool pull_algorithm(JSContext *cx, JS::CallArgs args, JS::HandleObject source,
+                             JS::HandleObject self, JS::HandleObject controller);
+  static bool cancel_algorithm(JSContext *cx, JS::CallArgs args, JS::HandleObject source,
+                               JS::HandleObject self, JS::HandleValue reason);
+
+public:
+  static constexpr const char *class_name = "BodyTee";
+
+  enum Slots {
+    /// The Request or Response whose incoming body is read. It's never exposed to content.
+    Owner,
+    /// An array of the branches' streams.
+    Branches,
+    /// Whether a chunk is being read from the host.
+    Reading,
+    /// Whether a branch's pull is waiting for the slowest branch to catch up.
+    Waiting,
+    Count
+  };
+
+  static const JSFunctionSpec static_methods[];
+  static const JSPropertySpec static_properties[];
+  static const JSFunctionSpec methods[];
+  static const JSPropertySpec properties[];
+
+  /// Create a tee reading `owner`'s incoming body, which must not have been used yet.
+  static JSObject *create(JSContext *cx, JS::HandleObject owner);
+
+  /// Create a new branch, to be used as the body stream of a Request or Response.
+  static JSObject *create_branch(JSContext *cx, JS::HandleObject self);
+
+  /// Read the next chunk and enqueue it into all readable branches, once the host has it ready.
+  static bool read_chunk(JSContext *cx, JS::HandleObject self);
+
+  /// Enqueue the Uint8Array `chunk` into all readable branches. `chunk` must be owned by the
+  /// runtime, as its buffer is transferred to one of them.
+  static bool enqueue(JSContext *cx, JS::HandleObject self, JS::HandleObject chunk);
+
+  /// Close all readable branches, once the incoming body has ended.
+  static bool close(JSContext *cx, JS::HandleObject self);
+
+  /// Error all readable branches with `reason`, and close the incoming body.
+  static bool error(JSContext *cx, JS::HandleObject self, JS::HandleValue reason);
+
+  /// The tee `stream` is a branch of, or nullptr if it isn't one.
+  static JSObject *from_branch(JSContext *cx, JS::HandleObject stream);
+};
+
+} // namespace builtins::web::fetch
+
+#endif
@@ -1,74 +1,1263 @@
 #include "fetch-api.h"
+#include "../abort/abort-signal.h"
+#include "../dom-exception.h"
+#include "body-tee.h"
+#include "encode.h"
 #include "event_loop.h"
 #include "headers.h"
 #include "request-response.h"
+#include "response-template.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <deque>
+#include <unordered_map>
 
 namespace builtins::web::fetch {
 
-static api::Engine *ENGINE;
+using abort::AbortSignal;
+using dom_exception::DOMException;
+
+static api::Engine *ENGINE;
+
+/**
+ * Hedging and retry settings for a single `fetch`, read from the non-standard `hedge` and `retry`
+ * members of its init dictionary.
+ */
+struct AttemptPolicy {
+  /// Delay after which a hedged request is sent if no response has arrived yet.
+  std::optional<uint64_t> hedge_delay;
+  /// If set, and enough responses from the request's origin were observed, the percentile of their
+  /// latencies to use as the hedge delay instead of `hedge_delay`.
+  std::optional<double> hedge_percentile;
+  /// The maximum number of hedged requests sent in addition to the original one.
+  uint32_t hedges = 1;
+  /// The maximum number of times the request is retried after failing.
+  uint32_t retries = 0;
+  /// The delay before the first retry, doubled for each subsequent one.
+  uint64_t backoff = 100 * 1000 * 1000;
+
+  bool hedging() const { return hedges > 0 && (hedge_delay || hedge_percentile); }
+  bool enabled() const { return hedging() || retries > 0; }
+};
+
+/**
+ * The latencies of the most recent hedged or retried requests to an origin, measured from sending
+ * the request until its response headers arrived.
+ */
+class LatencySamples {
+  static constexpr size_t CAPACITY = 64;
+  std::array<uint64_t, CAPACITY> samples_ = {};
+  size_t count_ = 0;
+  size_t next_ = 0;
+
+public:
+  /// The number of samples needed before percentiles are reported.
+  static constexpr size_t MIN_SAMPLES = 8;
+
+  void record(const uint64_t latency) {
+    samples_[next_] = latency;
+    next_ = (next_ + 1) % CAPACITY;
+    count_ = std::min(count_ + 1, CAPACITY);
+  }
+
+  std::optional<uint64_t> percentile(const double p) const {
+    if (count_ < MIN_SAMPLES) {
+      return std::nullopt;
+    }
+    auto sorted = samples_;
+    auto rank = static_cast<size_t>(std::ceil(p / 100 * static_cast<double>(count_)));
+    rank = std::clamp<size_t>(rank, 1, count_) - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + count_);
+    return sorted[rank];
+  }
+};
+
+/// Observed latencies by origin. Only this many origins are tracked, so that fetching from
+/// arbitrarily many origins doesn't grow the table without bounds.
+static constexpr size_t MAX_LATENCY_ORIGINS = 128;
+static std::unordered_map<std::string, LatencySamples> latencies;
+
+/// The `scheme://authority` prefix of the serialized absolute URL `url`.
+static std::string_view url_origin(std::string_view url) {
+  auto scheme_end = url.find("://");
+  if (scheme_end == std::string_view::npos) {
+    return url;
+  }
+  return url.substr(0, url.find_first_of("/?#", scheme_end + 3));
+}
+
+/**
+ * Fetches with the non-standard `coalesce` option whose response hasn't arrived yet, by their
+ * coalescing key. Concurrent fetches with the same key share the response instead of sending
+ * their own requests.
+ */
+struct CoalescedFetches {
+  std::unordered_map<std::string, Heap<JSObject *>> requests;
+
+  void trace(JSTracer *trc) {
+    for (auto &[key, request] : requests) {
+      TraceEdge(trc, &request, "Coalesced fetch request");
+    }
+  }
+};
+
+static PersistentRooted<CoalescedFetches> coalesced_fetches;
+
+/**
+ * Check that `request` may be sent more than once, or share the response of another request,
+ * which only GET and HEAD requests without a body may. Stores the request's method in `method`.
+ */
+static bool check_repeatable(JSContext *cx, HandleObject request, const char *option,
+                             host_api::HostString *method) {
+  RootedString method_str(cx, Request::method(cx, request));
+  *method = core::encode(cx, method_str);
+  if (!*method) {
+    return false;
+  }
+  std::string_view method_view = *method;
+  if ((method_view != "GET" && method_view != "HEAD") || RequestOrResponse::has_body(request)) {
+    JS_ReportErrorUTF8(cx, "fetch: %s is only supported for GET and HEAD requests without a body",
+                       option);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Compute the key under which concurrent fetches of `request` share a response: its method, URL
+ * and headers, the latter sorted by name.
+ */
+static bool coalescing_key(JSContext *cx, HandleObject request, std::string *key) {
+  host_api::HostString method;
+  if (!check_repeatable(cx, request, "coalesce", &method)) {
+    return false;
+  }
+  RootedValue url_val(cx, RequestOrResponse::url(request));
+  auto url = core::encode(cx, url_val);
+  if (!url) {
+    return false;
+  }
+
+  // The host-side headers are kept in sync with the `Headers` object, if there is one, so they're
+  // read from the handle instead of reifying them in JS.
+  auto table_res = RequestOrResponse::headers_handle(request)->table();
+  if (auto *err = table_res.to_err()) {
+    HANDLE_ERROR(cx, *err);
+    return false;
+  }
+  // Sorting by name yields a canonical order, and keeping the order of values with the same name
+  // keeps them distinct from the same values in another order.
+  auto entries = table_res.unwrap()->entries();
+  std::stable_sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+    return std::get<0>(a) < std::get<0>(b);
+  });
+
+  // Neither names nor values can contain newlines, and names can't contain colons, so this is
+  // unambiguous.
+  key->append(method.begin(), method.size()).append("\n");
+  key->append(url.begin(), url.size()).append("\n");
+  for (const auto &[name, value] : entries) {
+    key->append(name).append(":").append(value).append("\n");
+  }
+  return true;
+}
+
+/// Make `request`'s fetch the one that later fetches with the same `key` share the response of.
+static bool start_coalescing(JSContext *cx, HandleObject request, const std::string &key) {
+  RootedObject list(cx, JS::NewArrayObject(cx, 0));
+  if (!list) {
+    return false;
+  }
+  JSString *key_str = JS_NewStringCopyN(cx, key.data(), key.size());
+  if (!key_str) {
+    return false;
+  }
+  RootedValue key_val(cx, JS::StringValue(key_str));
+  if (!JS_SetElement(cx, list, 0, key_val)) {
+    return false;
+  }
+  JS::SetReservedSlot(request, static_cast<uint32_t>(Request::Slots::Coalesced),
+                      JS::ObjectValue(*list));
+  coalesced_fetches.get().requests.emplace(key, request.get());
+  return true;
+}
+
+/// Let `request`'s fetch share the response of the pending fetch of `leader`.
+static bool join_coalesced_fetch(JSContext *cx, HandleObject request, HandleObject leader) {
+  RootedObject list(
+      cx, &JS::GetReservedSlot(leader, static_cast<uint32_t>(Request::Slots::Coalesced)).toObject());
+  uint32_t length;
+  if (!JS::GetArrayLength(cx, list, &length)) {
+    return false;
+  }
+  RootedValue request_val(cx, ObjectValue(*request));
+  return JS_SetElement(cx, list, length, request_val);
+}
+
+/**
+ * Collect the requests of the fetches waiting for `request`'s response into `requests`: just
+ * `request` itself, or, for a fetch with the `coalesce` option, all fetches sharing its response
+ * whose promises haven't been settled yet. The latter stops other fetches from joining.
+ */
+static bool take_waiting_requests(JSContext *cx, HandleObject request,
+                                  JS::MutableHandleObjectVector requests) {
+  RootedValue list_val(
+      cx, JS::GetReservedSlot(request, static_cast<uint32_t>(Request::Slots::Coalesced)));
+  if (!list_val.isObject()) {
+    if (!requests.append(request)) {
+      JS_ReportOutOfMemory(cx);
+      return false;
+    }
+    return true;
+  }
+
+  RootedObject list(cx, &list_val.toObject());
+  JS::SetReservedSlot(request, static_cast<uint32_t>(Request::Slots::Coalesced),
+                      JS::UndefinedValue());
+  uint32_t length;
+  if (!JS::GetArrayLength(cx, list, &length)) {
+    return false;
+  }
+
+  RootedValue val(cx);
+  if (!JS_GetElement(cx, list, 0, &val)) {
+    return false;
+  }
+  RootedString key_str(cx, val.toString());
+  auto key = core::encode(cx, key_str);
+  if (!key) {
+    return false;
+  }
+  coalesced_fetches.get().requests.erase(std::string(key.begin(), key.size()));
+
+  RootedObject waiting(cx, request);
+  for (uint32_t i = 0; i < length; i++) {
+    if (i > 0) {
+      if (!JS_GetElement(cx, list, i, &val)) {
+        return false;
+      }
+      waiting = &val.toObject();
+    }
+    if (JS::GetPromiseState(Request::response_promise(waiting)) != JS::PromiseState::Pending) {
+      continue;
+    }
+    if (!requests.append(waiting)) {
+      JS_ReportOutOfMemory(cx);
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Whether other fetches are still waiting for the response of `request`'s fetch.
+static bool has_waiting_followers(JSContext *cx, HandleObject request, bool *result) {
+  *result = false;
+  RootedValue list_val(
+      cx, JS::GetReservedSlot(request, static_cast<uint32_t>(Request::Slots::Coalesced)));
+  if (!list_val.isObject()) {
+    return true;
+  }
+
+  RootedObject list(cx, &list_val.toObject());
+  uint32_t length;
+  if (!JS::GetArrayLength(cx, list, &length)) {
+    return false;
+  }
+  RootedValue val(cx);
+  for (uint32_t i = 1; i < length; i++) {
+    if (!JS_GetElement(cx, list, i, &val)) {
+      return false;
+    }
+    if (JS::GetPromiseState(Request::response_promise(&val.toObject())) ==
+        JS::PromiseState::Pending) {
+      *result = true;
+      return true;
+    }
+  }
+  return true;
+}
+
+/**
+ * Resolve `request`'s response promise, and those of all fetches sharing its response, with
+ * Responses for `response`.
+ *
+ * If several fetches share the response, each gets its own Response, with the body read once and
+ * tee'd into all of them.
+ */
+static bool resolve_response_promise(JSContext *cx, HandleObject request,
+                                     host_api::HttpIncomingResponse *response) {
+  JS::RootedObjectVector requests(cx);
+  if (!take_waiting_requests(cx, request, &requests)) {
+    return false;
+  }
+
+  RootedObject response_obj(
+      cx, JS_NewObjectWithGivenProto(cx, &Response::class_, Response::proto_obj));
+  if (!response_obj) {
+    return false;
+  }
+
+  response_obj = Response::create(cx, response_obj, response);
+  if (!response_obj) {
+    return false;
+  }
+
+  // All fetches sharing the response were aborted.
+  if (requests.empty()) {
+    if (RequestOrResponse::has_body(response_obj)) {
+      RequestOrResponse::close_incoming_body(response_obj);
+    }
+    return true;
+  }
+
+  RootedObject waiting(cx);
+  RootedObject response_promise(cx);
+  RootedValue response_val(cx);
+  if (requests.length() == 1) {
+    waiting = requests[0];
+    response_promise = Request::response_promise(waiting);
+    RequestOrResponse::set_url(response_obj, RequestOrResponse::url(waiting));
+    // Aborting the fetch errors the response's body until it has been read, see
+    // `RequestOrResponse::incoming_body_finished`. Without a body, the fetch is done.
+    if (RequestOrResponse::has_body(response_obj)) {
+      JS::SetReservedSlot(response_obj, static_cast<uint32_t>(Response::Slots::FetchRequest),
+                          JS::ObjectValue(*waiting));
+    } else if (!Request::remove_abort_algorithm(cx, waiting)) {
+      return false;
+    }
+    response_val.setObject(*response_obj);
+    return ResolvePromise(cx, response_promise, response_val);
+  }
+
+  RootedObject tee(cx);
+  if (RequestOrResponse::has_body(response_obj)) {
+    tee = BodyTee::create(cx, response_obj);
+    if (!tee) {
+      return false;
+    }
+  }
+
+  RootedObject branch(cx);
+  RootedObject shared(cx);
+  for (size_t i = 0; i < requests.length(); i++) {
+    waiting = requests[i];
+    if (tee) {
+      branch = BodyTee::create_branch(cx, tee);
+      if (!branch) {
+        return false;
+      }
+    }
+    shared = Response::create_shared(cx, response, branch);
+    if (!shared) {
+      return false;
+    }
+    // Aborting one of the fetches can't stop the body the others are reading.
+    if (!Request::remove_abort_algorithm(cx, waiting)) {
+      return false;
+    }
+    RequestOrResponse::set_url(shared, RequestOrResponse::url(waiting));
+    response_promise = Request::response_promise(waiting);
+    response_val.setObject(*shared);
+    if (!ResolvePromise(cx, response_promise, response_val)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Reject `request`'s response promise, and those of all fetches sharing its response, with the
+ * error for a request that failed with `err`.
+ */
+static bool reject_response_promise(JSContext *cx, HandleObject request,
+                                    const host_api::APIError err) {
+  JS::RootedObjectVector requests(cx);
+  if (!take_waiting_requests(cx, request, &requests)) {
+    return false;
+  }
+
+  if (err == host_api::TIMEOUT_ERROR) {
+    DOMException::raise(cx, "The request timed out.", "TimeoutError");
+  } else {
+    JS_ReportErrorUTF8(cx, "NetworkError when attempting to fetch resource.");
+  }
+  RootedValue exn(cx);
+  if (!JS_GetPendingException(cx, &exn)) {
+    return false;
+  }
+  JS_ClearPendingException(cx);
+
+  RootedObject response_promise(cx);
+  RootedObject waiting(cx);
+  for (auto waiting_obj : requests) {
+    waiting = waiting_obj;
+    response_promise = Request::response_promise(waiting);
+    if (!JS::RejectPromise(cx, response_promise, exn) ||
+        !Request::remove_abort_algorithm(cx, waiting)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// The `authority` component of the serialized absolute URL `url`, including the port, if any.
+static std::string_view url_authority(std::string_view url) {
+  auto origin = url_origin(url);
+  auto scheme_end = origin.find("://");
+  return scheme_end == std::string_view::npos ? origin : origin.substr(scheme_end + 3);
+}
+
+/// The priority of a `fetch`, from the `priority` member of its init dictionary.
+enum class FetchPriority : uint8_t { High, Auto, Low, Count };
+
+class FetchAttempts;
+
+/**
+ * Limits the number of fetches in flight, both in total and per authority, and queues the excess
+ * ones by priority, and in FIFO order within a priority.
+ *
+ * A fetch is in flight from sending its request until its response headers arrive or it fails.
+ * All attempts of a hedged or retried fetch count as a single fetch. Queued fetches are sent from
+ * the tasks of the fetches they're waiting for once those complete, without running any JS.
+ *
+ * Fetches streaming their request body aren't tracked, as their responses aren't waited for here.
+ */
+class OutgoingRequestScheduler {
+public:
+  /// The maximum numbers of fetches in flight, with 0 meaning no limit.
+  struct Limits {
+    size_t total = 0;
+    size_t per_authority = 0;
+  };
+
+  /// Queueing metrics, accumulated since the instance was started.
+  struct Stats {
+    /// The number of fetches sent, whether they were queued or not.
+    uint64_t sent = 0;
+    /// The number of fetches that had to be queued.
+    uint64_t queued = 0;
+    /// The total and maximum time fetches spent in the queue before being sent.
+    uint64_t total_delay = 0;
+    uint64_t max_delay = 0;
+  };
+
+private:
+  struct QueuedFetch {
+    Heap<JSObject *> request;
+    /// Set if the fetch hedges or retries its request.
+    FetchAttempts *attempts;
+    host_api::OutgoingRequestOptions options;
+    std::string authority;
+    uint64_t queued_at;
+  };
+
+  Limits limits_;
+  Stats stats_;
+  size_t in_flight_ = 0;
+  std::unordered_map<std::string, size_t> in_flight_by_authority_;
+  std::array<std::deque<QueuedFetch>, static_cast<size_t>(FetchPriority::Count)> queues_;
+  bool pumping_ = false;
+
+  bool has_capacity(const std::string &authority) const;
+  bool dispatch(api::Engine *engine, QueuedFetch &fetch);
+
+public:
+  const Limits &limits() const { return limits_; }
+  const Stats &stats() const { return stats_; }
+  size_t in_flight() const { return in_flight_; }
+  size_t queued() const;
+
+  /// Change the limits. Raising them sends queued fetches right away.
+  bool set_limits(api::Engine *engine, const Limits &limits) {
+    limits_ = limits;
+    return pump(engine);
+  }
+
+  /**
+   * Send `request`, or queue it if too many fetches are in flight. If `attempts` is set, its first
+   * attempt is sent instead of `request`'s own handle.
+   */
+  bool submit(api::Engine *engine, HandleObject request, FetchAttempts *attempts,
+              const host_api::OutgoingRequestOptions &options, FetchPriority priority);
+
+  /// Remove `request`'s fetch from the queue, if it's still waiting there.
+  bool remove(JSObject *request);
+
+  /// Mark a fetch to `authority` as no longer in flight. The caller must `pump` afterwards.
+  void release(const std::string &authority) {
+    MOZ_ASSERT(in_flight_ > 0);
+    in_flight_--;
+    auto it = in_flight_by_authority_.find(authority);
+    MOZ_ASSERT(it != in_flight_by_authority_.end());
+    if (--it->second == 0) {
+      in_flight_by_authority_.erase(it);
+    }
+  }
+
+  /// Send as many queued fetches as the limits allow.
+  bool pump(api::Engine *engine);
+
+  void trace(JSTracer *trc) {
+    for (auto &queue : queues_) {
+      for (auto &fetch : queue) {
+        TraceEdge(trc, &fetch.request, "Queued fetch request");
+      }
+    }
+  }
+};
+
+static PersistentRooted<OutgoingRequestScheduler> scheduler;
+
+/**
+ * The state shared by all attempts of a `fetch` that hedges or retries its request.
+ *
+ * Each attempt is waited on by its own `ResponseFutureTask`, and the delay before the next hedge or
+ * retry by an `AttemptTimerTask`, so no JS timers or promises are involved. The first response to
+ * arrive wins, and all other attempts are cancelled. Once the response promise is settled, the
+ * state is deleted.
+ */
+class FetchAttempts final {
+  AttemptPolicy policy_;
+  host_api::OutgoingRequestOptions options_;
+  host_api::HostString method_;
+  host_api::HostString url_;
+  /// A copy of the request's headers, which each hedge or retry is sent with a copy of in turn.
+  std::unique_ptr<host_api::HttpHeaders> headers_;
+
+  /// The ids of the tasks waiting for the responses of attempts in flight.
+  std::vector<int32_t> pending_;
+  /// The id of the task waiting to send the next hedge or retry, or -1.
+  int32_t timer_ = -1;
+  bool timer_is_retry_ = false;
+  uint32_t hedges_ = 0;
+  uint32_t retries_ = 0;
+  /// Whether the first attempt was sent, and the fetch thus counts as in flight for the
+  /// `OutgoingRequestScheduler`.
+  bool started_ = false;
+
+  FetchAttempts(const AttemptPolicy &policy, const host_api::OutgoingRequestOptions &options)
+      : policy_(policy), options_(options) {}
+
+  std::optional<uint64_t> hedge_delay() const;
+  void arm_timer(api::Engine *engine, HandleObject request, uint64_t delay, bool retry);
+  void arm_hedge_timer(api::Engine *engine, HandleObject request);
+  bool send(api::Engine *engine, HandleObject request, host_api::HttpOutgoingRequest *handle);
+  bool attempt_failed(api::Engine *engine, HandleObject request, host_api::APIError err);
+  bool finish(api::Engine *engine);
+
+public:
+  /**
+   * Create the state for hedging or retrying `request` according to `policy`.
+   *
+   * Throws a TypeError if `request` isn't a GET or HEAD request without a body, as only those can
+   * safely be sent more than once.
+   */
+  static std::unique_ptr<FetchAttempts> create(JSContext *cx, HandleObject request,
+                                               const AttemptPolicy &policy,
+                                               const host_api::OutgoingRequestOptions &options);
+
+  /// Send the first attempt, using `request`'s own host handle.
+  bool start(api::Engine *engine, HandleObject request);
+
+  std::string authority() const { return std::string(url_authority(url_)); }
+
+  bool on_response(api::Engine *engine, HandleObject request, int32_t task_id, uint64_t latency,
+                   host_api::HttpIncomingResponse *response);
+  bool on_error(api::Engine *engine, HandleObject request, int32_t task_id,
+                host_api::APIError err);
+  bool on_timer(api::Engine *engine, HandleObject request);
+
+  /// Cancel all attempts of an aborted fetch, and delete the state.
+  bool abort(api::Engine *engine) { return finish(engine); }
+};
+
+class ResponseFutureTask final : public api::AsyncTask {
+  Heap<JSObject *> request_;
+  host_api::FutureHttpIncomingResponse *future_;
+  /// Set if this is one of the attempts of a hedged or retried fetch.
+  FetchAttempts *attempts_ = nullptr;
+  uint64_t sent_at_ = 0;
+  /// The authority the request was sent to, for releasing its place in the
+  /// `OutgoingRequestScheduler`. Only used if `attempts_` isn't set, as otherwise the attempts
+  /// count as in flight until all of them are done.
+  std::string authority_;
+
+  explicit ResponseFutureTask(const HandleObject request,
+                              host_api::FutureHttpIncomingResponse *future)
+      : request_(request), future_(future) {
+    auto res = future->subscribe();
+    MOZ_ASSERT(!res.is_err(), "Subscribing to a future should never fail");
+    handle_ = res.unwrap();
+  }
+
+public:
+  /// Wait for the response to `request`, which was sent to `authority`.
+  ResponseFutureTask(const HandleObject request, host_api::FutureHttpIncomingResponse *future,
+                     std::string authority)
+      : ResponseFutureTask(request, future) {
+    authority_ = std::move(authority);
+  }
+
+  /// Wait for the response to one of the attempts of a hedged or retried fetch.
+  ResponseFutureTask(const HandleObject request, host_api::FutureHttpIncomingResponse *future,
+                     FetchAttempts *attempts)
+      : ResponseFutureTask(request, future) {
+    attempts_ = attempts;
+    sent_at_ = host_api::MonotonicClock::now();
+  }
+
+  [[nodiscard]] bool run(api::Engine *engine) override {
+    // MOZ_ASSERT(ready());
+    JSContext *cx = engine->cx();
+
+    const RootedObject request(cx, request_);
+    auto res = future_->maybe_response();
+    const auto task_id = id();
+    if (!cancel(engine)) {
+      return false;
+    }
+
+    if (auto *err = res.to_err()) {
+      if (attempts_) {
+        return attempts_->on_error(engine, request, task_id, *err);
+      }
+      return reject_response_promise(cx, request, *err) && scheduler.get().pump(engine);
+    }
+
+    auto maybe_response = res.unwrap();
+    MOZ_ASSERT(maybe_response.has_value());
+    auto response = maybe_response.value();
+    if (attempts_) {
+      auto latency = host_api::MonotonicClock::now() - sent_at_;
+      return attempts_->on_response(engine, request, task_id, latency, response);
+    }
+    return resolve_response_promise(cx, request, response) && scheduler.get().pump(engine);
+  }
+
+  /// Drop the future once it has produced a result. The response it returned stays valid.
+  void release() {
+    future_->close();
+    delete future_;
+    future_ = nullptr;
+  }
+
+  [[nodiscard]] bool cancel(api::Engine *engine) override {
+    // If the fetch was aborted before the response arrived, drop the future right away instead of
+    // waiting for a response no one is interested in anymore.
+    if (future_) {
+      release();
+      if (!attempts_) {
+        // Queued fetches can't be sent from here, as the event loop might be iterating over its
+        // tasks. That happens in `run`, or after aborting the fetch.
+        scheduler.get().release(authority_);
+        JS::SetReservedSlot(request_, static_cast<uint32_t>(Request::Slots::ResponseTask),
+                            JS::UndefinedValue());
+      }
+    }
+    handle_ = -1;
+    return true;
+  }
+
+  bool ready() override {
+    // TODO(TS): implement
+    return true;
+  }
+
+  void trace(JSTracer *trc) override { TraceEdge(trc, &request_, "Request for response future"); }
+};
+
+/// Waits for the delay before a hedged fetch's next hedge or retry.
+class AttemptTimerTask final : public api::AsyncTask {
+  Heap<JSObject *> request_;
+  FetchAttempts *attempts_;
+  uint64_t deadline_;
+
+public:
+  explicit AttemptTimerTask(const HandleObject request, FetchAttempts *attempts,
+                            const uint64_t delay_ns)
+      : request_(request), attempts_(attempts) {
+    deadline_ = host_api::MonotonicClock::now() + delay_ns;
+    handle_ = host_api::MonotonicClock::subscribe(deadline_, true);
+  }
+
+  [[nodiscard]] bool run(api::Engine *engine) override {
+    JSContext *cx = engine->cx();
+    RootedObject request(cx, request_);
+    // Unsubscribe first, as `on_timer` might delete `attempts_` along with everything it knows
+    // about this task.
+    if (!cancel(engine)) {
+      return false;
+    }
+    return attempts_->on_timer(engine, request);
+  }
+
+  [[nodiscard]] bool cancel(api::Engine *engine) override {
+    if (handle_ != -1) {
+      host_api::MonotonicClock::unsubscribe(handle_);
+      handle_ = -1;
+    }
+    return true;
+  }
+
+  bool ready() override { return host_api::MonotonicClock::now() >= deadline_; }
+
+  void trace(JSTracer *trc) override { TraceEdge(trc, &request_, "Request for attempt timer"); }
+};
+
+std::unique_ptr<FetchAttempts>
+FetchAttempts::create(JSContext *cx, HandleObject request, const AttemptPolicy &policy,
+                      const host_api::OutgoingRequestOptions &options) {
+  std::unique_ptr<FetchAttempts> attempts(new FetchAttempts(policy, options));
+
+  if (!check_repeatable(cx, request, policy.hedging() ? "hedge" : "retry", &attempts->method_)) {
+    return nullptr;
+  }
+
+  RootedValue url(cx, RequestOrResponse::url(request));
+  attempts->url_ = core::encode(cx, url);
+  if (!attempts->url_) {
+    return nullptr;
+  }
+
+  // Copied from the handle so that headers the content never read aren't reified.
+  attempts->headers_ =
+      std::make_unique<host_api::HttpHeaders>(*RequestOrResponse::headers_handle(request));
+
+  return attempts;
+}
+
+std::optional<uint64_t> FetchAttempts::hedge_delay() const {
+  if (policy_.hedge_percentile) {
+    auto it = latencies.find(std::string(url_origin(url_)));
+    if (it != latencies.end()) {
+      if (auto delay = it->second.percentile(*policy_.hedge_percentile)) {
+        return delay;
+      }
+    }
+  }
+  return policy_.hedge_delay;
+}
+
+void FetchAttempts::arm_timer(api::Engine *engine, HandleObject request, const uint64_t delay,
+                              const bool retry) {
+  MOZ_ASSERT(timer_ == -1);
+  auto *task = new AttemptTimerTask(request, this, delay);
+  timer_ = task->id();
+  timer_is_retry_ = retry;
+  engine->queue_async_task(task);
+}
+
+void FetchAttempts::arm_hedge_timer(api::Engine *engine, HandleObject request) {
+  if (!policy_.hedging() || hedges_ >= policy_.hedges || pending_.empty() || timer_ != -1) {
+    return;
+  }
+  if (auto delay = hedge_delay()) {
+    arm_timer(engine, request, *delay, false);
+  }
+}
+
+bool FetchAttempts::start(api::Engine *engine, HandleObject request) {
+  started_ = true;
+  return send(engine, request, Request::outgoing_handle(request));
+}
+
+/**
+ * Send an attempt using `handle`, which is consumed in the process.
+ *
+ * If sending fails right away, this is treated like an attempt that failed later on, which might
+ * settle the fetch and delete `this`.
+ */
+bool FetchAttempts::send(api::Engine *engine, HandleObject request,
+                         host_api::HttpOutgoingRequest *handle) {
+  auto res = handle->send(options_);
+  if (auto *err = res.to_err()) {
+    return attempt_failed(engine, request, *err);
+  }
+
+  auto *task = new ResponseFutureTask(request, res.unwrap(), this);
+  pending_.push_back(task->id());
+  engine->queue_async_task(task);
+
+  arm_hedge_timer(engine, request);
+  return true;
+}
+
+bool FetchAttempts::attempt_failed(api::Engine *engine, HandleObject request,
+                                   const host_api::APIError err) {
+  // Other attempts might still succeed.
+  if (!pending_.empty()) {
+    return true;
+  }
+
+  if (retries_ < policy_.retries) {
+    // A pending hedge is superseded by the retry.
+    if (timer_ != -1) {
+      engine->cancel_async_task(timer_);
+      timer_ = -1;
+    }
+    auto backoff = std::ldexp(static_cast<double>(policy_.backoff), static_cast<int>(retries_));
+    arm_timer(engine, request, static_cast<uint64_t>(std::min(backoff, 1.8e19)), true);
+    retries_++;
+    return true;
+  }
+
+  if (timer_ != -1) {
+    // Wait for the pending hedge instead of giving up early.
+    return true;
+  }
+
+  if (!reject_response_promise(engine->cx(), request, err)) {
+    return false;
+  }
+  return finish(engine);
+}
+
+bool FetchAttempts::on_response(api::Engine *engine, HandleObject request, const int32_t task_id,
+                                const uint64_t latency, host_api::HttpIncomingResponse *response) {
+  std::erase(pending_, task_id);
+
+  std::string origin(url_origin(url_));
+  auto it = latencies.find(origin);
+  if (it == latencies.end() && latencies.size() < MAX_LATENCY_ORIGINS) {
+    it = latencies.emplace(std::move(origin), LatencySamples()).first;
+  }
+  if (it != latencies.end()) {
+    it->second.record(latency);
+  }
 
-class ResponseFutureTask final : public api::AsyncTask {
-  Heap<JSObject *> request_;
-  host_api::FutureHttpIncomingResponse *future_;
+  if (!resolve_response_promise(engine->cx(), request, response)) {
+    return false;
+  }
+  return finish(engine);
+}
 
-public:
-  explicit ResponseFutureTask(const HandleObject request,
-                              host_api::FutureHttpIncomingResponse *future)
-      : request_(request), future_(future) {
-    auto res = future->subscribe();
-    MOZ_ASSERT(!res.is_err(), "Subscribing to a future should never fail");
-    handle_ = res.unwrap();
+bool FetchAttempts::on_error(api::Engine *engine, HandleObject request, const int32_t task_id,
+                             const host_api::APIError err) {
+  std::erase(pending_, task_id);
+  return attempt_failed(engine, request, err);
+}
+
+bool FetchAttempts::on_timer(api::Engine *engine, HandleObject request) {
+  timer_ = -1;
+  if (timer_is_retry_) {
+    // Retries start a new round of hedging.
+    hedges_ = 0;
+  } else {
+    hedges_++;
   }
 
-  [[nodiscard]] bool run(api::Engine *engine) override {
-    // MOZ_ASSERT(ready());
-    JSContext *cx = engine->cx();
+  auto *headers = new host_api::HttpHeaders(*headers_);
+  auto *handle =
+      host_api::HttpOutgoingRequest::make(method_, host_api::HostString(url_.ptr.get()), headers);
+  // Unlike the original request's handle, this one isn't owned by a JS object.
+  bool ok = send(engine, request, handle);
+  delete handle;
+  delete headers;
+  return ok;
+}
 
-    const RootedObject request(cx, request_);
-    RootedObject response_promise(cx, Request::response_promise(request));
+/**
+ * Cancel all remaining attempts and the timer, and delete `this`. If the fetch was in flight, this
+ * makes room for the next queued one.
+ */
+bool FetchAttempts::finish(api::Engine *engine) {
+  for (auto task_id : pending_) {
+    engine->cancel_async_task(task_id);
+  }
+  if (timer_ != -1) {
+    engine->cancel_async_task(timer_);
+  }
+  bool started = started_;
+  if (started) {
+    scheduler.get().release(authority());
+  }
+  delete this;
+  return !started || scheduler.get().pump(engine);
+}
 
-    auto res = future_->maybe_response();
-    if (res.is_err()) {
-      JS_ReportErrorUTF8(cx, "NetworkError when attempting to fetch resource.");
-      return RejectPromiseWithPendingError(cx, response_promise);
+size_t OutgoingRequestScheduler::queued() const {
+  size_t count = 0;
+  for (const auto &queue : queues_) {
+    count += queue.size();
+  }
+  return count;
+}
+
+bool OutgoingRequestScheduler::has_capacity(const std::string &authority) const {
+  if (limits_.total && in_flight_ >= limits_.total) {
+    return false;
+  }
+  if (limits_.per_authority) {
+    auto it = in_flight_by_authority_.find(authority);
+    if (it != in_flight_by_authority_.end() && it->second >= limits_.per_authority) {
+      return false;
     }
+  }
+  return true;
+}
 
-    auto maybe_response = res.unwrap();
-    MOZ_ASSERT(maybe_response.has_value());
-    auto response = maybe_response.value();
-    RootedObject response_obj(
-        cx, JS_NewObjectWithGivenProto(cx, &Response::class_, Response::proto_obj));
-    if (!response_obj) {
+/**
+ * Send `fetch`, which has already been accounted for as in flight.
+ *
+ * If sending fails right away, the fetch's response promise is rejected, and it stops counting as
+ * in flight.
+ */
+bool OutgoingRequestScheduler::dispatch(api::Engine *engine, QueuedFetch &fetch) {
+  stats_.sent++;
+  JSContext *cx = engine->cx();
+  RootedObject request(cx, fetch.request);
+  if (fetch.attempts) {
+    return fetch.attempts->start(engine, request);
+  }
+
+  auto res = Request::outgoing_handle(request)->send(fetch.options);
+  if (auto *err = res.to_err()) {
+    release(fetch.authority);
+    return reject_response_promise(cx, request, *err);
+  }
+
+  auto *task = new ResponseFutureTask(request, res.unwrap(), std::move(fetch.authority));
+  JS::SetReservedSlot(request, static_cast<uint32_t>(Request::Slots::ResponseTask),
+                      JS::Int32Value(task->id()));
+  engine->queue_async_task(task);
+  return true;
+}
+
+bool OutgoingRequestScheduler::submit(api::Engine *engine, HandleObject request,
+                                      FetchAttempts *attempts,
+                                      const host_api::OutgoingRequestOptions &options,
+                                      const FetchPriority priority) {
+  std::string authority;
+  if (attempts) {
+    authority = attempts->authority();
+  } else {
+    RootedValue url_val(engine->cx(), RequestOrResponse::url(request));
+    auto url = core::encode(engine->cx(), url_val);
+    if (!url) {
+      return false;
+    }
+    authority = url_authority(url);
+  }
+
+  QueuedFetch fetch{Heap<JSObject *>(request), attempts, options, std::move(authority),
+                    host_api::MonotonicClock::now()};
+
+  // Fetches only skip the queue if no others are waiting, so that they can't overtake queued
+  // fetches of the same or a higher priority.
+  if (queued() == 0 && has_capacity(fetch.authority)) {
+    in_flight_++;
+    in_flight_by_authority_[fetch.authority]++;
+    return dispatch(engine, fetch);
+  }
+
+  stats_.queued++;
+  queues_[static_cast<size_t>(priority)].push_back(std::move(fetch));
+  return true;
+}
+
+bool OutgoingRequestScheduler::remove(JSObject *request) {
+  for (auto &queue : queues_) {
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+      if (it->request.get() == request) {
+        queue.erase(it);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool OutgoingRequestScheduler::pump(api::Engine *engine) {
+  // Sending a fetch can complete other fetches right away, which pump in turn. The outermost call
+  // takes care of those.
+  if (pumping_) {
+    return true;
+  }
+  pumping_ = true;
+
+  bool ok = true;
+  while (ok && (!limits_.total || in_flight_ < limits_.total)) {
+    // Find the oldest fetch of the highest priority whose authority isn't at its limit.
+    std::deque<QueuedFetch> *queue = nullptr;
+    size_t index = 0;
+    for (auto &candidates : queues_) {
+      for (size_t i = 0; i < candidates.size(); i++) {
+        if (has_capacity(candidates[i].authority)) {
+          queue = &candidates;
+          index = i;
+          break;
+        }
+      }
+      if (queue) {
+        break;
+      }
+    }
+    if (!queue) {
+      break;
+    }
+
+    QueuedFetch fetch = std::move((*queue)[index]);
+    queue->erase(queue->begin() + static_cast<ptrdiff_t>(index));
+
+    auto delay = host_api::MonotonicClock::now() - fetch.queued_at;
+    stats_.total_delay += delay;
+    stats_.max_delay = std::max(stats_.max_delay, delay);
+    in_flight_++;
+    in_flight_by_authority_[fetch.authority]++;
+    ok = dispatch(engine, fetch);
+  }
+
+  pumping_ = false;
+  return ok;
+}
+
+/**
+ * Read a non-negative duration given in milliseconds from the property `name` of `obj`, if it is
+ * present.
+ */
+static bool get_milliseconds(JSContext *cx, HandleObject obj, const char *name,
+                             std::optional<uint64_t> *ns) {
+  RootedValue val(cx);
+  if (!JS_GetProperty(cx, obj, name, &val)) {
+    return false;
+  }
+  if (val.isUndefined()) {
+    return true;
+  }
+  double ms;
+  if (!JS::ToNumber(cx, val, &ms)) {
+    return false;
+  }
+  if (!std::isfinite(ms) || ms < 0) {
+    JS_ReportErrorUTF8(cx, "fetch: %s must be a non-negative number of milliseconds", name);
+    return false;
+  }
+  *ns = static_cast<uint64_t>(std::min(ms * 1e6, 1.8e19));
+  return true;
+}
+
+/**
+ * Read the non-standard `connectTimeout`, `firstByteTimeout` and `betweenBytesTimeout` members of
+ * `fetch`'s init dictionary, given in milliseconds.
+ */
+static bool get_request_options(JSContext *cx, HandleValue init_val,
+                                host_api::OutgoingRequestOptions *options) {
+  if (!init_val.isObject()) {
+    return true;
+  }
+
+  RootedObject init(cx, &init_val.toObject());
+  const std::pair<const char *, std::optional<uint64_t> *> timeouts[] = {
+      {"connectTimeout", &options->connect_timeout},
+      {"firstByteTimeout", &options->first_byte_timeout},
+      {"betweenBytesTimeout", &options->between_bytes_timeout},
+  };
+  for (const auto &[name, timeout] : timeouts) {
+    if (!get_milliseconds(cx, init, name, timeout)) {
       return false;
     }
+  }
+  return true;
+}
+
+/// The maximum number of hedges or retries a single `fetch` can ask for.
+static constexpr uint32_t MAX_ATTEMPT_COUNT = 10;
+
+/// Read a count of at most `MAX_ATTEMPT_COUNT` from the property `name` of `obj`, if it is present.
+static bool get_count(JSContext *cx, HandleObject obj, const char *name, uint32_t *count) {
+  RootedValue val(cx);
+  if (!JS_GetProperty(cx, obj, name, &val)) {
+    return false;
+  }
+  if (val.isUndefined()) {
+    return true;
+  }
+  double n;
+  if (!JS::ToNumber(cx, val, &n)) {
+    return false;
+  }
+  if (!(n >= 0 && n <= MAX_ATTEMPT_COUNT) || std::trunc(n) != n) {
+    JS_ReportErrorUTF8(cx, "fetch: %s must be an integer between 0 and %u", name,
+                       MAX_ATTEMPT_COUNT);
+    return false;
+  }
+  *count = static_cast<uint32_t>(n);
+  return true;
+}
+
+/**
+ * Read the non-standard `hedge` and `retry` members of `fetch`'s init dictionary.
+ *
+ * `hedge: {delay, percentile, count}` sends up to `count` (default 1) additional requests while no
+ * response has arrived, the first one after `percentile` of the latencies recently observed for
+ * the request's origin, or after `delay` milliseconds if there aren't enough observations yet.
+ *
+ * `retry: {count, backoff}` resends a request that failed with a network error up to `count`
+ * (default 1) times, waiting `backoff` milliseconds (default 100) before the first retry and twice
+ * as long before each subsequent one.
+ */
+static bool get_attempt_policy(JSContext *cx, HandleValue init_val, AttemptPolicy *policy) {
+  if (!init_val.isObject()) {
+    return true;
+  }
 
-    response_obj = Response::create(cx, response_obj, response);
-    if (!response_obj) {
+  RootedObject init(cx, &init_val.toObject());
+  RootedValue val(cx);
+  if (!JS_GetProperty(cx, init, "hedge", &val)) {
+    return false;
+  }
+  if (!val.isUndefined()) {
+    if (!val.isObject()) {
+      JS_ReportErrorUTF8(cx, "fetch: hedge must be an object");
+      return false;
+    }
+    RootedObject hedge(cx, &val.toObject());
+    if (!get_milliseconds(cx, hedge, "delay", &policy->hedge_delay) ||
+        !get_count(cx, hedge, "count", &policy->hedges)) {
+      return false;
+    }
+    if (!JS_GetProperty(cx, hedge, "percentile", &val)) {
       return false;
     }
+    if (!val.isUndefined()) {
+      double percentile;
+      if (!JS::ToNumber(cx, val, &percentile)) {
+        return false;
+      }
+      if (!(percentile > 0 && percentile <= 100)) {
+        JS_ReportErrorUTF8(cx, "fetch: percentile must be a number greater than 0 and at most 100");
+        return false;
+      }
+      policy->hedge_percentile = percentile;
+    }
+    if (!policy->hedge_delay && !policy->hedge_percentile) {
+      JS_ReportErrorUTF8(cx, "fetch: hedge requires a delay or a percentile");
+      return false;
+    }
+  }
 
-    RequestOrResponse::set_url(response_obj, RequestOrResponse::url(request));
-    RootedValue response_val(cx, ObjectValue(*response_obj));
-    if (!ResolvePromise(cx, response_promise, response_val)) {
+  if (!JS_GetProperty(cx, init, "retry", &val)) {
+    return false;
+  }
+  if (!val.isUndefined()) {
+    if (!val.isObject()) {
+      JS_ReportErrorUTF8(cx, "fetch: retry must be an object");
+      return false;
+    }
+    RootedObject retry(cx, &val.toObject());
+    policy->retries = 1;
+    std::optional<uint64_t> backoff;
+    if (!get_count(cx, retry, "count", &policy->retries) ||
+        !get_milliseconds(cx, retry, "backoff", &backoff)) {
       return false;
     }
+    if (backoff) {
+      policy->backoff = *backoff;
+    }
+  }
+
+  return true;
+}
 
-    return cancel(engine);
+/**
+ * Read the `priority` member of `fetch`'s init dictionary, which determines the order in which
+ * fetches queued by the `OutgoingRequestScheduler` are sent.
+ * https://fetch.spec.whatwg.org/#dom-requestinit-priority
+ */
+static bool get_priority(JSContext *cx, HandleValue init_val, FetchPriority *priority) {
+  if (!init_val.isObject()) {
+    return true;
   }
 
-  [[nodiscard]] bool cancel(api::Engine *engine) override {
-    // TODO(TS): implement
-    handle_ = -1;
+  RootedObject init(cx, &init_val.toObject());
+  RootedValue val(cx);
+  if (!JS_GetProperty(cx, init, "priority", &val)) {
+    return false;
+  }
+  if (val.isUndefined()) {
     return true;
   }
 
-  bool ready() override {
-    // TODO(TS): implement
+  auto str = core::encode(cx, val);
+  if (!str) {
+    return false;
+  }
+  std::string_view name = str;
+  if (name == "high") {
+    *priority = FetchPriority::High;
+  } else if (name == "low") {
+    *priority = FetchPriority::Low;
+  } else if (name == "auto") {
+    *priority = FetchPriority::Auto;
+  } else {
+    JS_ReportErrorUTF8(cx, "fetch: priority must be \"high\", \"low\" or \"auto\"");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * The algorithm run when the signal of a request passed to `fetch` is aborted.
+ * https://fetch.spec.whatwg.org/#abort-fetch
+ *
+ * `extra` is the `FetchAttempts` of a hedged or retried fetch, or undefined. For other fetches, the
+ * task waiting for the response is found in the request's `ResponseTask` slot once it's been sent.
+ */
+static bool abort_fetch(JSContext *cx, HandleObject request, HandleValue extra, CallArgs args) {
+  args.rval().setUndefined();
+  RootedObject response_promise(cx, Request::response_promise(request));
+
+  switch (JS::GetPromiseState(response_promise)) {
+  case JS::PromiseState::Pending: {
+    // If other fetches share the response, the request has to keep going for them.
+    bool shared = false;
+    if (!has_waiting_followers(cx, request, &shared)) {
+      return false;
+    }
+    if (shared) {
+      return JS::RejectPromise(cx, response_promise, args.get(0));
+    }
+
+    // Stop later fetches from joining this one.
+    JS::RootedObjectVector waiting(cx);
+    if (!take_waiting_requests(cx, request, &waiting)) {
+      return false;
+    }
+
+    // A fetch still waiting to be sent just leaves the queue.
+    scheduler.get().remove(request);
+
+    if (!extra.isUndefined()) {
+      // The attempts are only deleted once the promise is settled, so they're still around.
+      if (!static_cast<FetchAttempts *>(extra.toPrivate())->abort(ENGINE)) {
+        return false;
+      }
+    } else {
+      // Cancelling the task drops the response future.
+      RootedValue task_id(
+          cx, JS::GetReservedSlot(request, static_cast<uint32_t>(Request::Slots::ResponseTask)));
+      if (task_id.isInt32()) {
+        ENGINE->cancel_async_task(task_id.toInt32());
+        if (!scheduler.get().pump(ENGINE)) {
+          return false;
+        }
+      }
+    }
+    return JS::RejectPromise(cx, response_promise, args.get(0));
+  }
+  case JS::PromiseState::Fulfilled: {
+    RootedObject response(cx, &JS::GetPromiseResult(response_promise).toObject());
+    return RequestOrResponse::abort_body(cx, response, args.get(0));
+  }
+  case JS::PromiseState::Rejected:
     return true;
   }
 
-  void trace(JSTracer *trc) override { TraceEdge(trc, &request_, "Request for response future"); }
-};
+  return true;
+}
 
 // TODO: throw in all Request methods/getters that rely on host calls once a
 // request has been sent. The host won't let us act on them anymore anyway.
@@ -95,53 +1284,254 @@ bool fetch(JSContext *cx, unsigned argc, Value *vp) {
     return ReturnPromiseRejectedWithPendingError(cx, args);
   }
 
-  RootedObject response_promise(cx, JS::NewPromiseObject(cx, nullptr));
-  if (!response_promise)
+  host_api::OutgoingRequestOptions options;
+  if (!get_request_options(cx, args.get(1), &options)) {
     return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
 
-  bool streaming = false;
-  if (!RequestOrResponse::maybe_stream_body(cx, request, &streaming)) {
-    return false;
+  AttemptPolicy policy;
+  if (!get_attempt_policy(cx, args.get(1), &policy)) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+
+  FetchPriority priority = FetchPriority::Auto;
+  if (!get_priority(cx, args.get(1), &priority)) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
   }
 
-  host_api::FutureHttpIncomingResponse *pending_handle;
-  {
-    auto request_handle = Request::outgoing_handle(request);
-    auto res = request_handle->send();
+  // If the request's signal is already aborted, don't even send the request.
+  RootedObject signal(cx, Request::signal(request));
+  if (signal && AbortSignal::is_aborted(signal)) {
+    RootedValue reason(cx, AbortSignal::reason(signal));
+    JS_SetPendingException(cx, reason);
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
 
-    if (auto *err = res.to_err()) {
-      HANDLE_ERROR(cx, *err);
+  std::string coalescing;
+  bool coalesce = false;
+  if (args.get(1).isObject()) {
+    RootedObject init(cx, &args[1].toObject());
+    RootedValue coalesce_val(cx);
+    if (!JS_GetProperty(cx, init, "coalesce", &coalesce_val)) {
       return ReturnPromiseRejectedWithPendingError(cx, args);
     }
+    coalesce = JS::ToBoolean(coalesce_val);
+  }
+  if (coalesce && !coalescing_key(cx, request, &coalescing)) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+
+  // If an identical fetch is already in flight, wait for its response instead of sending another
+  // request.
+  if (coalesce) {
+    auto &pending = coalesced_fetches.get().requests;
+    auto entry = pending.find(coalescing);
+    if (entry != pending.end()) {
+      RootedObject leader(cx, entry->second);
+      RootedObject response_promise(cx, JS::NewPromiseObject(cx, nullptr));
+      if (!response_promise) {
+        return ReturnPromiseRejectedWithPendingError(cx, args);
+      }
+      JS::SetReservedSlot(request, static_cast<uint32_t>(Request::Slots::ResponsePromise),
+                          JS::ObjectValue(*response_promise));
+      if (!join_coalesced_fetch(cx, request, leader)) {
+        return ReturnPromiseRejectedWithPendingError(cx, args);
+      }
+      if (signal) {
+        // Aborting only rejects this fetch's promise: the shared request keeps going.
+        RootedObject algorithm(
+            cx, create_internal_method<abort_fetch>(cx, request, JS::UndefinedHandleValue));
+        if (!algorithm || !Request::add_abort_algorithm(cx, request, algorithm)) {
+          return ReturnPromiseRejectedWithPendingError(cx, args);
+        }
+      }
+      args.rval().setObject(*response_promise);
+      return true;
+    }
+  }
 
-    pending_handle = res.unwrap();
+  std::unique_ptr<FetchAttempts> attempts;
+  if (policy.enabled()) {
+    attempts = FetchAttempts::create(cx, request, policy, options);
+    if (!attempts) {
+      return ReturnPromiseRejectedWithPendingError(cx, args);
+    }
   }
 
-  // If the request body is streamed, we need to wait for streaming to complete
-  // before marking the request as pending.
-  if (!streaming) {
-    ENGINE->queue_async_task(new ResponseFutureTask(request, pending_handle));
+  RootedObject response_promise(cx, JS::NewPromiseObject(cx, nullptr));
+  if (!response_promise)
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+
+  RootedValue attempts_val(cx);
+  bool streaming = false;
+  if (attempts) {
+    attempts_val = JS::PrivateValue(attempts.get());
+  } else {
+    if (!RequestOrResponse::maybe_stream_body(cx, request, &streaming)) {
+      return false;
+    }
+
+    // If the request body is streamed, we need to wait for streaming to complete
+    // before marking the request as pending. Such requests bypass the scheduler.
+    if (streaming) {
+      auto request_handle = Request::outgoing_handle(request);
+      auto res = request_handle->send(options);
+
+      if (auto *err = res.to_err()) {
+        if (*err == host_api::TIMEOUT_ERROR) {
+          DOMException::raise(cx, "The request timed out.", "TimeoutError");
+        } else {
+          HANDLE_ERROR(cx, *err);
+        }
+        return ReturnPromiseRejectedWithPendingError(cx, args);
+      }
+    }
   }
 
   JS::SetReservedSlot(request, static_cast<uint32_t>(Request::Slots::ResponsePromise),
                       JS::ObjectValue(*response_promise));
 
+  if (coalesce && !start_coalescing(cx, request, coalescing)) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+
+  // The abort algorithm refers to the attempts, so nothing may fail between adding it and handing
+  // the attempts over to the scheduler.
+  if (signal) {
+    RootedObject algorithm(cx, create_internal_method<abort_fetch>(cx, request, attempts_val));
+    if (!algorithm || !Request::add_abort_algorithm(cx, request, algorithm)) {
+      return ReturnPromiseRejectedWithPendingError(cx, args);
+    }
+  }
+
+  // The request is only sent (or queued) once the response promise is in place. If sending fails
+  // right away and no retries are left, this rejects the response promise. From here on, the
+  // attempts delete themselves once the fetch is settled.
+  if (!streaming &&
+      !scheduler.get().submit(ENGINE, request, attempts.release(), options, priority)) {
+    return false;
+  }
+
   args.rval().setObject(*response_promise);
   return true;
 }
 
+/// Read a limit from the property `name` of `obj`: a positive integer, or undefined for no limit.
+static bool get_limit(JSContext *cx, HandleObject obj, const char *name, size_t *limit) {
+  RootedValue val(cx);
+  if (!JS_GetProperty(cx, obj, name, &val)) {
+    return false;
+  }
+  if (val.isUndefined()) {
+    *limit = 0;
+    return true;
+  }
+  double n;
+  if (!JS::ToNumber(cx, val, &n)) {
+    return false;
+  }
+  if (!(n >= 1 && n <= UINT32_MAX) || std::trunc(n) != n) {
+    JS_ReportErrorUTF8(cx, "fetch.setConcurrencyLimits: %s must be a positive integer", name);
+    return false;
+  }
+  *limit = static_cast<size_t>(n);
+  return true;
+}
+
+/**
+ * The non-standard `fetch.setConcurrencyLimits({total, perAuthority})` function, which limits the
+ * number of fetches in flight at the same time, overall and for each authority. Fetches beyond the
+ * limits are queued by their `priority` until earlier ones complete. Omitted limits are lifted.
+ */
+static bool set_concurrency_limits(JSContext *cx, unsigned argc, Value *vp) {
+  CallArgs args = CallArgsFromVp(argc, vp);
+  if (!args.requireAtLeast(cx, "fetch.setConcurrencyLimits", 1)) {
+    return false;
+  }
+  if (!args[0].isObject()) {
+    JS_ReportErrorUTF8(cx, "fetch.setConcurrencyLimits: limits must be an object");
+    return false;
+  }
+
+  RootedObject limits_obj(cx, &args[0].toObject());
+  OutgoingRequestScheduler::Limits limits;
+  if (!get_limit(cx, limits_obj, "total", &limits.total) ||
+      !get_limit(cx, limits_obj, "perAuthority", &limits.per_authority)) {
+    return false;
+  }
+
+  args.rval().setUndefined();
+  return scheduler.get().set_limits(ENGINE, limits);
+}
+
+/**
+ * The non-standard `fetch.schedulerStats()` function, which returns the number of fetches in flight
+ * and queued, along with the number of fetches sent and queued so far, and the total and maximum
+ * time in milliseconds fetches spent in the queue.
+ */
+static bool scheduler_stats(JSContext *cx, unsigned argc, Value *vp) {
+  CallArgs args = CallArgsFromVp(argc, vp);
+  auto &sched = scheduler.get();
+  const auto &stats = sched.stats();
+
+  RootedObject result(cx, JS_NewPlainObject(cx));
+  if (!result) {
+    return false;
+  }
+  const std::pair<const char *, double> fields[] = {
+      {"inFlight", static_cast<double>(sched.in_flight())},
+      {"queued", static_cast<double>(sched.queued())},
+      {"totalSent", static_cast<double>(stats.sent)},
+      {"totalQueued", static_cast<double>(stats.queued)},
+      {"totalQueueDelay", static_cast<double>(stats.total_delay) / 1e6},
+      {"maxQueueDelay", static_cast<double>(stats.max_delay) / 1e6},
+  };
+  RootedValue val(cx);
+  for (const auto &[name, value] : fields) {
+    val.setNumber(value);
+    if (!JS_DefineProperty(cx, result, name, val, JSPROP_ENUMERATE)) {
+      return false;
+    }
+  }
+
+  args.rval().setObject(*result);
+  return true;
+}
+
 const JSFunctionSpec methods[] = {JS_FN("fetch", fetch, 2, JSPROP_ENUMERATE), JS_FS_END};
 
+const JSFunctionSpec fetch_static_methods[] = {
+    JS_FN("setConcurrencyLimits", set_concurrency_limits, 1, JSPROP_ENUMERATE),
+    JS_FN("schedulerStats", scheduler_stats, 0, JSPROP_ENUMERATE),
+    JS_FS_END,
+};
+
 bool install(api::Engine *engine) {
   ENGINE = engine;
+  coalesced_fetches.init(engine->cx());
+  scheduler.init(engine->cx());
 
   if (!JS_DefineFunctions(engine->cx(), engine->global(), methods))
     return false;
+  RootedValue fetch_val(engine->cx());
+  if (!JS_GetProperty(engine->cx(), engine->global(), "fetch", &fetch_val)) {
+    return false;
+  }
+  RootedObject fetch_fun(engine->cx(), &fetch_val.toObject());
+  if (!JS_DefineFunctions(engine->cx(), fetch_fun, fetch_static_methods)) {
+    return false;
+  }
   if (!request_response::install(engine)) {
     return false;
   }
   if (!Headers::init_class(engine->cx(), engine->global()))
     return false;
+  if (!body_tee::install(engine)) {
+    return false;
+  }
+  if (!response_template::install(engine)) {
+    return false;
+  }
   return true;
 }
 
@@ -1,14 +1,20 @@
 #include "fetch_event.h"
+#include "../streams/native-stream-source.h"
 #include "../url.h"
 #include "../worker-location.h"
 #include "encode.h"
 #include "exports.h"
 #include "request-response.h"
+#include "response-template.h"
 
 #include "bindings.h"
 #include <iostream>
 #include <memory>
 
+#ifdef HOST_CALL_PROFILING
+#include "host_call_profiler.h"
+#endif
+
 using namespace std::literals::string_view_literals;
 
 namespace builtins::web::fetch::fetch_event {
@@ -128,6 +134,10 @@ bool FetchEvent::init_incoming_request(JSContext *cx, JS::HandleObject self,
     return false;
   }
 
+  // Let small bodies arrive while the handler is being dispatched, instead of only once it asks
+  // for them.
+  RequestOrResponse::maybe_prefetch_body(cx, request);
+
   return true;
 }
 
@@ -187,6 +197,28 @@ bool start_response(JSContext *cx, JS::HandleObject response_obj, bool streaming
                                  : FetchEvent::State::responseDone);
 }
 
+/// Send a response created from `tmpl`, whose body has been written in full already.
+bool send_template(JSContext *cx, JS::HandleObject tmpl) {
+  auto *response = ResponseTemplate::make_response(cx, tmpl);
+  if (!response) {
+    return false;
+  }
+
+  if (!send_response(response, FetchEvent::instance(), FetchEvent::State::responseDone)) {
+    return false;
+  }
+
+  if (response->has_body()) {
+    auto res = response->body().unwrap()->close();
+    if (auto *err = res.to_err()) {
+      HANDLE_ERROR(cx, *err);
+      return false;
+    }
+  }
+
+  return true;
+}
+
 // Steps in this function refer to the spec at
 // https://w3c.github.io/ServiceWorker/#fetch-event-respondwith
 bool response_promise_then_handler(JSContext *cx, JS::HandleObject event, JS::HandleValue extra,
@@ -197,9 +229,16 @@ bool response_promise_then_handler(JSContext *cx, JS::HandleObject event, JS::Ha
   // means that at this point we're guaranteed to have the final value instead
   // of a Promise wrapping it, so either the value is a Response, or we have to
   // bail.
+  //
+  // Response templates are sent from their native representation, without creating a Response.
+  if (ResponseTemplate::is_instance(args.get(0))) {
+    JS::RootedObject tmpl(cx, &args[0].toObject());
+    return send_template(cx, tmpl);
+  }
+
   if (!Response::is_instance(args.get(0))) {
-    JS_ReportErrorUTF8(cx, "FetchEvent#respondWith must be called with a Response "
-                           "object or a Promise resolving to a Response object as "
+    JS_ReportErrorUTF8(cx, "FetchEvent#respondWith must be called with a Response or "
+                           "ResponseTemplate object or a Promise resolving to one as "
                            "the first argument");
     JS::RootedObject rejection(cx, PromiseRejectedWithPendingError(cx));
     if (!rejection)
@@ -223,6 +262,21 @@ bool response_promise_then_handler(JSContext *cx, JS::HandleObject event, JS::Ha
   //     return false;
   // }
 
+  // An incoming response's body can only be handed to the host wholesale if content hasn't replaced
+  // its body stream, e.g. by cloning the response. Otherwise, it's sent like the body of a Response
+  // constructed from that stream.
+  JS::RootedObject body_stream(cx, RequestOrResponse::body_stream(response_obj));
+  if (RequestOrResponse::is_incoming(response_obj) && body_stream &&
+      !RequestOrResponse::body_used(response_obj) &&
+      !streams::NativeStreamSource::stream_is_body(cx, body_stream)) {
+    auto *incoming =
+        static_cast<host_api::HttpIncomingResponse *>(Response::response_handle(response_obj));
+    response_obj = Response::create_shared(cx, incoming, body_stream);
+    if (!response_obj) {
+      return false;
+    }
+  }
+
   bool streaming = false;
   if (!RequestOrResponse::maybe_stream_body(cx, response_obj, &streaming)) {
     return false;
@@ -390,9 +444,12 @@ JSObject *FetchEvent::create(JSContext *cx) {
   JS::SetReservedSlot(self, static_cast<uint32_t>(Slots::DecPendingPromiseCountFunc),
                       JS::ObjectValue(*dec_count_handler));
 
-  INSTANCE.init(cx, self);
-  self = INSTANCE;
-  return self;
+  // Hosts that handle multiple requests with the same instance get a new FetchEvent for each.
+  if (!INSTANCE.initialized()) {
+    INSTANCE.init(cx);
+  }
+  INSTANCE = self;
+  return INSTANCE;
 }
 
 JS::HandleObject FetchEvent::instance() {
@@ -575,7 +632,24 @@ void exports_wasi_http_incoming_handler(exports_wasi_http_incoming_request reque
   //
   // return;
 
+#ifdef HOST_CALL_PROFILING
+  // Print a table of all host calls made while handling this request once it's done.
+  struct HostCallProfile {
+    HostCallProfile() { host_call_profiler::reset(); }
+    ~HostCallProfile() { host_call_profiler::dump(stderr); }
+  } host_call_profile;
+#endif
+
   RESPONSE_OUT = response_out.__handle;
+  STREAMING_BODY = nullptr;
+
+  // The native host handles multiple requests with the same instance, so the event for the previous
+  // request has to be replaced.
+  if (FetchEvent::state(FetchEvent::instance()) != FetchEvent::State::unhandled &&
+      !FetchEvent::create(ENGINE->cx())) {
+    ENGINE->dump_pending_exception("creation of FetchEvent");
+    return;
+  }
 
   auto *request = new host_api::HttpIncomingRequest(request_handle.__handle);
   HandleObject fetch_event = FetchEvent::instance();
@@ -234,24 +234,24 @@ bool append_header_value_to_map(JSContext *cx, JS::HandleObject self,
 }
 
 bool get_header_names_from_handle(JSContext *cx, Handle *handle, JS::HandleObject backing_map) {
-
-  auto names = handle->names();
-  if (auto *err = names.to_err()) {
+  auto table = handle->table();
+  if (auto *err = table.to_err()) {
     HANDLE_ERROR(cx, *err);
     return false;
   }
 
   JS::RootedString name(cx);
   JS::RootedValue name_val(cx);
-  for (auto &str : names.unwrap()) {
-    // TODO: can `name` take ownership of the buffer here instead?
-    name = JS_NewStringCopyN(cx, str.ptr.get(), str.len);
+  for (auto &[str, _] : table.unwrap()->entries()) {
+    name = JS_NewStringCopyN(cx, str.data(), str.size());
     if (!name) {
       return false;
     }
 
     name_val.setString(name);
-    JS::MapSet(cx, backing_map, name_val, JS::NullHandleValue);
+    if (!JS::MapSet(cx, backing_map, name_val, JS::NullHandleValue)) {
+      return false;
+    }
   }
 
   return true;
@@ -261,34 +261,35 @@ bool retrieve_value_for_header_from_handle(JSContext *cx, JS::HandleObject self,
                                            JS::HandleValue name, JS::MutableHandleValue value) {
   auto handle = get_handle(self);
 
+  auto table = handle->table();
+  if (auto *err = table.to_err()) {
+    HANDLE_ERROR(cx, *err);
+    return false;
+  }
+
   JS::RootedString name_str(cx, name.toString());
   auto name_chars = core::encode(cx, name_str);
-  auto ret = handle->get(name_chars);
-
-  if (auto *err = ret.to_err()) {
-    HANDLE_ERROR(cx, *err);
+  if (!name_chars) {
     return false;
   }
 
-  auto &values = ret.unwrap();
-  if (!values.has_value()) {
+  // The values are combined natively, so the map is only updated once, however many there are.
+  const auto &values = table.unwrap()->get(name_chars);
+  if (values.empty()) {
     return true;
   }
-
-  JS::RootedString val_str(cx);
-  for (auto &str : values.value()) {
-    val_str = JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(str.ptr.get(), str.len));
-    if (!val_str) {
-      return false;
-    }
-
-    value.setString(val_str);
-    if (!append_header_value_to_map(cx, self, name, value)) {
-      return false;
-    }
+  std::string combined(values[0]);
+  for (size_t i = 1; i < values.size(); i++) {
+    combined.append(", ").append(values[i]);
   }
 
-  return true;
+  JS::RootedString val_str(
+      cx, JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(combined.data(), combined.size())));
+  if (!val_str) {
+    return false;
+  }
+  value.setString(val_str);
+  return append_header_value_to_map(cx, self, name, value);
 }
 
 /**
@@ -395,26 +396,52 @@ bool ensure_all_header_values_from_handle(JSContext *cx, JS::HandleObject self,
   if (!lazy_values(self))
     return true;
 
-  JS::RootedValue iterable(cx);
-  if (!JS::MapKeys(cx, backing_map, &iterable))
-    return false;
-
-  JS::ForOfIterator it(cx);
-  if (!it.init(iterable))
+  auto table_res = get_handle(self)->table();
+  if (auto *err = table_res.to_err()) {
+    HANDLE_ERROR(cx, *err);
     return false;
+  }
+  auto &entries = table_res.unwrap()->entries();
 
-  JS::RootedValue name(cx);
-  JS::RootedValue v(cx);
-  while (true) {
-    bool done;
-    if (!it.next(&name, &done))
+  // Headers whose values haven't been retrieved yet have `null` as their value in the map. Those
+  // need to be identified before applying any values, because headers can have multiple entries.
+  JS::RootedVector<JS::Value> names(cx);
+  std::vector<bool> is_lazy;
+  JS::RootedString name_str(cx);
+  JS::RootedValue name_val(cx);
+  JS::RootedValue value(cx);
+  for (auto &[name, _] : entries) {
+    name_str = JS_NewStringCopyN(cx, name.data(), name.size());
+    if (!name_str) {
+      return false;
+    }
+    name_val.setString(name_str);
+    if (!names.append(name_val)) {
+      return false;
+    }
+    if (!JS::MapGet(cx, backing_map, name_val, &value)) {
       return false;
+    }
+    is_lazy.push_back(value.isNull());
+  }
 
-    if (done)
-      break;
+  JS::RootedString val_str(cx);
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (!is_lazy[i]) {
+      continue;
+    }
 
-    if (!ensure_value_for_header(cx, self, name, &v))
+    auto &str = std::get<1>(entries[i]);
+    val_str = JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(str.data(), str.size()));
+    if (!val_str) {
       return false;
+    }
+
+    name_val.set(names[i]);
+    value.setString(val_str);
+    if (!append_header_value_to_map(cx, self, name_val, &value)) {
+      return false;
+    }
   }
 
   JS_SetReservedSlot(self, static_cast<uint32_t>(Headers::Slots::HasLazyValues),
@@ -461,6 +488,94 @@ bool Headers::append_header_value(JSContext *cx, JS::HandleObject self, JS::Hand
   return append_header_value_to_map(cx, self, normalized_name, &normalized_value);
 }
 
+bool Headers::encode_entries(JSContext *cx, JS::HandleObject self,
+                             std::vector<host_api::HostString> *strings) {
+  MOZ_ASSERT(!lazy_values(self));
+
+  JS::RootedObject backing_map(cx, get_backing_map(self));
+  JS::RootedValue iterable(cx);
+  if (!JS::MapEntries(cx, backing_map, &iterable)) {
+    return false;
+  }
+
+  JS::ForOfIterator it(cx);
+  if (!it.init(iterable)) {
+    return false;
+  }
+
+  JS::RootedObject entry(cx);
+  JS::RootedValue entry_val(cx);
+  JS::RootedValue name_val(cx);
+  JS::RootedValue value_val(cx);
+  while (true) {
+    bool done;
+    if (!it.next(&entry_val, &done)) {
+      return false;
+    }
+
+    if (done) {
+      break;
+    }
+
+    entry = &entry_val.toObject();
+    if (!JS_GetElement(cx, entry, 0, &name_val) || !JS_GetElement(cx, entry, 1, &value_val)) {
+      return false;
+    }
+
+    auto name = core::encode(cx, name_val);
+    if (!name) {
+      return false;
+    }
+    auto value = core::encode(cx, value_val);
+    if (!value) {
+      return false;
+    }
+    strings->push_back(std::move(name));
+    strings->push_back(std::move(value));
+  }
+
+  return true;
+}
+
+std::vector<std::tuple<std::string_view, std::string_view>>
+Headers::to_entries(const std::vector<host_api::HostString> &strings) {
+  std::vector<std::tuple<std::string_view, std::string_view>> entries;
+  entries.reserve(strings.size() / 2);
+  for (size_t i = 0; i < strings.size(); i += 2) {
+    std::string_view name = strings[i];
+    std::string_view value = strings[i + 1];
+    if (name == "set-cookie") {
+      for (auto cookie : splitCookiesString(value)) {
+        entries.emplace_back(name, cookie);
+      }
+    } else {
+      entries.emplace_back(name, value);
+    }
+  }
+  return entries;
+}
+
+host_api::HttpHeaders *Headers::create_handle(JSContext *cx, JS::HandleObject self) {
+  MOZ_ASSERT(!get_handle(self));
+
+  // Names and values are encoded first, because `entries` below only holds views into them.
+  std::vector<host_api::HostString> strings;
+  if (!encode_entries(cx, self, &strings)) {
+    return nullptr;
+  }
+  auto entries = to_entries(strings);
+
+  auto res = host_api::HttpHeaders::from_list(entries);
+  if (auto *err = res.to_err()) {
+    HANDLE_ERROR(cx, *err);
+    return nullptr;
+  }
+
+  auto *handle = res.unwrap();
+  JS_SetReservedSlot(self, static_cast<uint32_t>(Slots::Handle), JS::PrivateValue(handle));
+  return handle;
+}
+
 bool Headers::delazify(JSContext *cx, JS::HandleObject headers) {
   JS::RootedObject backing_map(cx, get_backing_map(headers));
   return ensure_all_header_values_from_handle(cx, headers, backing_map);
@@ -625,6 +740,17 @@ bool Headers::maybe_add(JSContext *cx, JS::HandleObject self, const char *name,
   return Headers::append_header_value(cx, self, name_val, value_val, "internal_maybe_add");
 }
 
+bool Headers::get_value(JSContext *cx, JS::HandleObject self, const char *name,
+                        JS::MutableHandleValue rval) {
+  MOZ_ASSERT(Headers::is_instance(self));
+  JS::RootedString name_str(cx, JS_NewStringCopyN(cx, name, strlen(name)));
+  if (!name_str) {
+    return false;
+  }
+  JS::RootedValue name_val(cx, JS::StringValue(name_str));
+  return get_header_value_for_name(cx, self, name_val, rval, "internal_get_value");
+}
+
 bool Headers::delete_(JSContext *cx, unsigned argc, JS::Value *vp) {
   METHOD_HEADER_WITH_NAME(1, "delete")
 
@@ -41,6 +41,13 @@ public:
    */
   static bool maybe_add(JSContext *cx, JS::HandleObject self, const char *name, const char *value);
 
+  /**
+   * Sets `rval` to the combined value of the header `name`, or to null if `self` doesn't contain
+   * it. `name` must be normalized.
+   */
+  static bool get_value(JSContext *cx, JS::HandleObject self, const char *name,
+                        JS::MutableHandleValue rval);
+
   // Appends a non-normalized value for a non-normalized header name to both
   // the JS side Map and, in non-standalone mode, the host.
   //
@@ -63,6 +70,31 @@ public:
   static JSObject *create(JSContext *cx, JS::HandleObject headers, host_api::HttpHeaders *handle,
                           JS::HandleValue initv);
   static JSObject *create(JSContext *cx, JS::HandleObject self, host_api::HttpHeaders *handle);
+
+  /**
+   * Creates the host-side representation of `self`'s header list with a single
+   * host call, and associates it with `self`, so that later changes are
+   * forwarded to the host.
+   *
+   * Must only be called for Headers objects that were created without a handle.
+   */
+  static host_api::HttpHeaders *create_handle(JSContext *cx, JS::HandleObject self);
+
+  /**
+   * Encodes `self`'s header list into `strings`, as alternating names and values.
+   *
+   * Must only be called for Headers objects without lazy values.
+   */
+  static bool encode_entries(JSContext *cx, JS::HandleObject self,
+                             std::vector<host_api::HostString> *strings);
+
+  /**
+   * Turns the result of `encode_entries` into a list of entries for
+   * `host_api::HttpHeaders::from_list`, splitting `set-cookie` values. The entries are views into
+   * `strings`.
+   */
+  static std::vector<std::tuple<std::string_view, std::string_view>>
+  to_entries(const std::vector<host_api::HostString> &strings);
 };
 
 } // namespace fetch
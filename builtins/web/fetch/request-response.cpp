@@ -1,8 +1,12 @@
 #include "request-response.h"
 
+#include "../abort/abort-signal.h"
+#include "../blob.h"
+#include "../form-data/form-data.h"
 #include "../streams/native-stream-source.h"
 #include "../streams/transform-stream.h"
 #include "../url.h"
+#include "body-tee.h"
 #include "encode.h"
 #include "event_loop.h"
 #include "extension-api.h"
@@ -12,11 +16,15 @@
 
 #include "js/Array.h"
 #include "js/ArrayBuffer.h"
+#include "js/CharacterEncoding.h"
 #include "js/Conversions.h"
 #include "js/JSON.h"
 #include "js/Stream.h"
 #include <algorithm>
+#include <charconv>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <vector>
 
 #pragma clang diagnostic push
@@ -29,6 +37,10 @@ namespace builtins::web::fetch {
 
 static api::Engine *ENGINE;
 
+/// The ReadableStream constructor, captured before content runs. See
+/// `RequestOrResponse::new_byte_stream`.
+static PersistentRooted<JSObject *> READABLE_STREAM;
+
 bool error_stream_controller_with_pending_exception(JSContext *cx, HandleObject controller) {
   RootedValue exn(cx);
   if (!JS_GetPendingException(cx, &exn))
@@ -41,12 +53,56 @@ bool error_stream_controller_with_pending_exception(JSContext *cx, HandleObject
   return JS::Call(cx, controller, "error", args, &r);
 }
 
-constexpr size_t HANDLE_READ_CHUNK_SIZE = 8192;
-
 class BodyFutureTask final : public api::AsyncTask {
   Heap<JSObject *> body_source_;
   host_api::HttpIncomingBody *incoming_body_;
 
+  /// Read the next chunk of `body` straight into the view of the BYOB request `request`.
+  bool read_into_request(api::Engine *engine, JSContext *cx, host_api::HttpIncomingBody *body,
+                         HandleObject controller, HandleObject request) {
+    RootedValue view_val(cx);
+    if (!JS_GetProperty(cx, request, "view", &view_val)) {
+      return error_stream_controller_with_pending_exception(cx, controller);
+    }
+    RootedObject view(cx, &view_val.toObject());
+
+    host_api::Result<host_api::HttpIncomingBody::ReadIntoResult> read_res;
+    {
+      // The view's buffer can't move while the host writes into it, since nothing can GC.
+      JS::AutoCheckCannotGC noGC(cx);
+      bool is_shared;
+      auto *data = static_cast<uint8_t *>(JS_GetArrayBufferViewData(view, &is_shared, noGC));
+      read_res = body->read_into(std::span(data, JS_GetArrayBufferViewByteLength(view)));
+    }
+    if (auto *err = read_res.to_err()) {
+      HANDLE_ERROR(cx, *err);
+      return error_stream_controller_with_pending_exception(cx, controller);
+    }
+
+    auto &result = read_res.unwrap();
+    RootedValue r(cx);
+    if (result.done) {
+      // Closing leaves the pending read to be completed by responding with 0 bytes.
+      RootedObject owner(cx, streams::NativeStreamSource::owner(body_source_));
+      RootedValueArray<1> respond_args(cx);
+      respond_args[0].setInt32(0);
+      return Call(cx, controller, "close", HandleValueArray::empty(), &r) &&
+             Call(cx, request, "respond", respond_args, &r) &&
+             RequestOrResponse::incoming_body_finished(cx, owner);
+    }
+    if (result.len == 0) {
+      engine->queue_async_task(this);
+      return true;
+    }
+
+    RootedValueArray<1> respond_args(cx);
+    respond_args[0].setNumber(static_cast<double>(result.len));
+    if (!Call(cx, request, "respond", respond_args, &r)) {
+      return error_stream_controller_with_pending_exception(cx, controller);
+    }
+    return cancel(engine);
+  }
+
 public:
   explicit BodyFutureTask(const HandleObject body_source) : body_source_(body_source) {
     auto owner = streams::NativeStreamSource::owner(body_source_);
@@ -63,7 +119,18 @@ public:
     RootedObject controller(cx, streams::NativeStreamSource::controller(body_source_));
     auto body = RequestOrResponse::incoming_body_handle(owner);
 
-    auto read_res = body->read(HANDLE_READ_CHUNK_SIZE);
+    // Incoming bodies are byte streams, whose controller has a BYOB request while a BYOB reader
+    // is waiting for data. The host then writes straight into the reader's buffer.
+    RootedValue byob_request(cx);
+    if (!JS_GetProperty(cx, controller, "byobRequest", &byob_request)) {
+      return error_stream_controller_with_pending_exception(cx, controller);
+    }
+    if (byob_request.isObject()) {
+      RootedObject request(cx, &byob_request.toObject());
+      return read_into_request(engine, cx, body, controller, request);
+    }
+
+    auto read_res = body->read(RequestOrResponse::next_read_size(owner));
     if (auto *err = read_res.to_err()) {
       HANDLE_ERROR(cx, *err);
       return error_stream_controller_with_pending_exception(cx, controller);
@@ -72,7 +139,13 @@ public:
     auto &chunk = read_res.unwrap();
     if (chunk.done) {
       RootedValue r(cx);
-      return Call(cx, controller, "close", HandleValueArray::empty(), &r);
+      return Call(cx, controller, "close", HandleValueArray::empty(), &r) &&
+             RequestOrResponse::incoming_body_finished(cx, owner);
+    }
+    // Byte streams don't accept empty chunks, so wait for the next one instead.
+    if (chunk.bytes.len == 0) {
+      engine->queue_async_task(this);
+      return true;
     }
 
     // We don't release control of chunk's data until after we've checked that
@@ -103,7 +176,8 @@ public:
   }
 
   [[nodiscard]] bool cancel(api::Engine *engine) override {
-    // TODO(TS): implement
+    // The pollable belongs to the body, and is reused for reading the next chunk. It's dropped
+    // along with the body, see `close_incoming_body`.
     handle_ = -1;
     return true;
   }
@@ -116,60 +190,375 @@ public:
   void trace(JSTracer *trc) override { TraceEdge(trc, &body_source_, "body source for future"); }
 };
 
-class ResponseFutureTask final : public api::AsyncTask {
-  Heap<JSObject *> request_;
-  host_api::FutureHttpIncomingResponse *future_;
+/// The most memory reserved up front for a body based on its `Content-Length` header, which might
+/// be wrong.
+constexpr size_t MAX_BODY_PREALLOCATION = 16 * 1024 * 1024;
 
+#ifndef BODY_PREFETCH_LIMIT
+#define BODY_PREFETCH_LIMIT 0
+#endif
+
+/// The largest `Content-Length` of incoming requests whose bodies are read ahead of time, see
+/// `RequestOrResponse::maybe_prefetch_body`. Prefetching is disabled if this is 0.
+constexpr size_t MAX_PREFETCHED_BODY_SIZE = BODY_PREFETCH_LIMIT;
+
+/**
+ * Reads an incoming body in its entirety into a single buffer, without reifying a ReadableStream
+ * for it, and passes the result to the body parser of the pending `read_all` call.
+ *
+ * The buffer is sized from the `Content-Length` header if there is one, and the host writes the
+ * chunks straight into it, so reading a body of known size allocates exactly once. Otherwise, the
+ * buffer doubles in size whenever it's full, and is shrunk to the body's size at the end.
+ *
+ * When prefetching, the task doesn't have a body parser yet, and never grows its buffer. It stops
+ * once the buffer is full, or the body has ended, until the body is consumed. See
+ * `RequestOrResponse::maybe_prefetch_body`.
+ */
+class BodyDrainTask final : public api::AsyncTask {
 public:
-  explicit ResponseFutureTask(const HandleObject request,
-                              host_api::FutureHttpIncomingResponse *future)
-      : request_(request), future_(future) {
-    auto res = future->subscribe();
+  enum class State {
+    Reading,
+    /// The buffer is full, and the task is waiting for a body parser before growing it.
+    Paused,
+    Done,
+    Failed,
+  };
+
+private:
+  Heap<JSObject *> owner_;
+  RequestOrResponse::ParseBodyCB *parse_body_;
+  UniqueChars buffer_;
+  size_t capacity_;
+  size_t len_ = 0;
+  State state_ = State::Reading;
+  host_api::APIError error_ = 0;
+
+  void subscribe(HandleObject owner) {
+    auto res = RequestOrResponse::incoming_body_handle(owner)->subscribe();
     MOZ_ASSERT(!res.is_err(), "Subscribing to a future should never fail");
     handle_ = res.unwrap();
   }
 
-  ResponseFutureTask(const RootedObject &rooted);
+  bool reject(JSContext *cx, HandleObject owner) {
+    handle_ = -1;
+    buffer_.reset();
+    auto slot = static_cast<uint32_t>(RequestOrResponse::Slots::BodyAllPromise);
+    RootedObject promise(cx, &JS::GetReservedSlot(owner, slot).toObject());
+    JS::SetReservedSlot(owner, slot, JS::UndefinedValue());
+    return RejectPromiseWithPendingError(cx, promise);
+  }
 
-  [[nodiscard]] bool run(api::Engine *engine) override {
-    // MOZ_ASSERT(ready());
-    JSContext *cx = engine->cx();
+  /// Read everything that's available right away. Returns false with a pending exception if the
+  /// buffer couldn't be grown. Read errors are recorded in `state_` and `error_` instead.
+  bool read_available(JSContext *cx, HandleObject owner) {
+    auto body = RequestOrResponse::incoming_body_handle(owner);
+    while (true) {
+      if (len_ == capacity_) {
+        if (!parse_body_) {
+          state_ = State::Paused;
+          return true;
+        }
+        size_t capacity = std::max(capacity_ * 2, capacity_ + HANDLE_READ_CHUNK_SIZE);
+        auto *buffer = static_cast<char *>(JS_realloc(cx, buffer_.get(), capacity_, capacity));
+        if (!buffer) {
+          JS_ReportOutOfMemory(cx);
+          return false;
+        }
+        std::ignore = buffer_.release();
+        buffer_.reset(buffer);
+        capacity_ = capacity;
+      }
 
-    const RootedObject request(cx, request_);
-    RootedObject response_promise(cx, Request::response_promise(request));
+      auto res = body->read_into(
+          std::span(reinterpret_cast<uint8_t *>(buffer_.get()) + len_, capacity_ - len_));
+      if (auto *err = res.to_err()) {
+        state_ = State::Failed;
+        error_ = *err;
+        return true;
+      }
 
-    auto res = future_->maybe_response();
-    if (res.is_err()) {
-      JS_ReportErrorUTF8(cx, "NetworkError when attempting to fetch resource.");
-      return RejectPromiseWithPendingError(cx, response_promise);
+      auto &result = res.unwrap();
+      if (result.done) {
+        state_ = State::Done;
+        return true;
+      }
+      if (result.len == 0) {
+        return true;
+      }
+      len_ += result.len;
     }
+  }
 
-    auto maybe_response = res.unwrap();
-    MOZ_ASSERT(maybe_response.has_value());
-    auto response = maybe_response.value();
-    RootedObject response_obj(
-        cx, JS_NewObjectWithGivenProto(cx, &Response::class_, Response::proto_obj));
-    if (!response_obj) {
-      return false;
+  /// Mark the task as finished once it has passed the body to the body parser, or failed to.
+  /// Neither the event loop nor the owner refer to it anymore by then, so it's deleted by whoever
+  /// ran, cancelled or consumed it.
+  bool finish(bool ok) {
+    finished_ = true;
+    return ok;
+  }
+
+  /// Wait for more of the body, or pass it to the body parser once it's complete.
+  bool settle(api::Engine *engine, JSContext *cx, HandleObject owner) {
+    if (state_ == State::Reading) {
+      engine->queue_async_task(this);
+      return true;
     }
 
-    response_obj = Response::create(cx, response_obj, response);
-    if (!response_obj) {
-      return false;
+    handle_ = -1;
+    if (!parse_body_) {
+      // The owner is only traced while the task is queued.
+      owner_ = nullptr;
+      return true;
     }
 
-    RequestOrResponse::set_url(response_obj, RequestOrResponse::url(request));
-    RootedValue response_val(cx, ObjectValue(*response_obj));
-    if (!ResolvePromise(cx, response_promise, response_val)) {
-      return false;
+    if (!RequestOrResponse::incoming_body_finished(cx, owner)) {
+      return finish(reject(cx, owner));
     }
 
-    return cancel(engine);
+    if (state_ == State::Failed) {
+      HANDLE_ERROR(cx, error_);
+      return finish(reject(cx, owner));
+    }
+
+    MOZ_ASSERT(state_ == State::Done);
+    // Without an accurate `Content-Length`, the buffer is usually larger than the body. The
+    // buffer might be adopted by an ArrayBuffer, so give back what isn't needed. If that fails,
+    // the larger buffer is still fine to use.
+    if (len_ > 0 && len_ < capacity_) {
+      auto *buffer = static_cast<char *>(JS_realloc(cx, buffer_.get(), capacity_, len_));
+      if (buffer) {
+        std::ignore = buffer_.release();
+        buffer_.reset(buffer);
+        capacity_ = len_;
+      }
+    }
+    return finish(parse_body_(cx, owner, std::move(buffer_), len_));
+  }
+
+public:
+  /// Start reading `owner`'s body into `buffer`. If `parse_body` is null, the body is prefetched.
+  BodyDrainTask(const HandleObject owner, RequestOrResponse::ParseBodyCB *parse_body,
+                UniqueChars buffer, const size_t capacity)
+      : owner_(owner), parse_body_(parse_body), buffer_(std::move(buffer)), capacity_(capacity) {
+    subscribe(owner);
+  }
+
+  State state() const { return state_; }
+  host_api::APIError error() const { return error_; }
+
+  /// Read what's available of the body right away, then continue reading in the event loop.
+  bool start(api::Engine *engine, JSContext *cx, HandleObject owner) {
+    if (!read_available(cx, owner)) {
+      // Only happens while growing the buffer, which requires a body parser.
+      MOZ_ASSERT(parse_body_);
+      return finish(reject(cx, owner));
+    }
+    return settle(engine, cx, owner);
+  }
+
+  [[nodiscard]] bool run(api::Engine *engine) override {
+    JSContext *cx = engine->cx();
+    RootedObject owner(cx, owner_);
+    return start(engine, cx, owner);
+  }
+
+  /**
+   * Pass the prefetched body to `parse_body` once it has been read completely. If that has
+   * happened already, the body is parsed right away.
+   */
+  bool consume(api::Engine *engine, JSContext *cx, HandleObject owner,
+               RequestOrResponse::ParseBodyCB *parse_body) {
+    MOZ_ASSERT(!parse_body_);
+    parse_body_ = parse_body;
+    owner_ = owner;
+    if (state_ == State::Reading) {
+      return true;
+    }
+    if (state_ == State::Paused) {
+      state_ = State::Reading;
+      subscribe(owner);
+      return start(engine, cx, owner);
+    }
+    return settle(engine, cx, owner);
+  }
+
+  /**
+   * Stop prefetching, and hand over the part of the body read so far, setting `len` to its length.
+   * Reading the rest of the body, if there is any according to `state()`, is up to the caller.
+   */
+  UniqueChars take(api::Engine *engine, size_t *len) {
+    MOZ_ASSERT(!parse_body_);
+    UniqueChars buffer(std::move(buffer_));
+    *len = len_;
+    len_ = 0;
+    if (state_ == State::Reading) {
+      engine->cancel_async_task(handle_);
+      state_ = State::Paused;
+    }
+    return buffer;
   }
 
   [[nodiscard]] bool cancel(api::Engine *engine) override {
+    // Only happens when the body is closed, see `close_incoming_body`, or prefetching is stopped,
+    // see `take`. When reading the whole body, `abort_body` rejects the promise, and nothing refers
+    // to the task anymore. A stopped prefetch task is still owned by whoever took it.
+    if (parse_body_) {
+      return finish(true);
+    }
+    handle_ = -1;
+    owner_ = nullptr;
+    buffer_.reset();
+    return true;
+  }
+
+  bool ready() override {
     // TODO(TS): implement
+    return true;
+  }
+
+  void trace(JSTracer *trc) override { TraceEdge(trc, &owner_, "owner of drained body"); }
+};
+
+/// Start reading `owner`'s incoming body into a single buffer, to be passed to `parse_body`.
+static bool drain_incoming_body(JSContext *cx, HandleObject owner,
+                                RequestOrResponse::ParseBodyCB *parse_body) {
+  size_t capacity = HANDLE_READ_CHUNK_SIZE;
+  if (auto len = RequestOrResponse::content_length(owner)) {
+    // One byte more than the body's length is needed to learn that it has ended.
+    capacity = std::min(*len, MAX_BODY_PREALLOCATION) + 1;
+  }
+
+  UniqueChars buffer(static_cast<char *>(JS_malloc(cx, capacity)));
+  if (!buffer) {
+    JS_ReportOutOfMemory(cx);
+    return false;
+  }
+  ENGINE->queue_async_task(new BodyDrainTask(owner, parse_body, std::move(buffer), capacity));
+  return true;
+}
+
+/**
+ * Remove the task prefetching `owner`'s body from it, and return it, if there is one.
+ *
+ * The task is owned by `owner` until then, and by the caller afterwards. It can be destroyed once
+ * its buffer has been taken, or handed back to the event loop with `BodyDrainTask::consume`.
+ */
+static std::unique_ptr<BodyDrainTask> take_prefetch_task(JSObject *owner) {
+  auto slot = static_cast<uint32_t>(RequestOrResponse::Slots::Prefetch);
+  JS::Value task = JS::GetReservedSlot(owner, slot);
+  if (task.isUndefined()) {
+    return nullptr;
+  }
+  JS::SetReservedSlot(owner, slot, JS::UndefinedValue());
+  return std::unique_ptr<BodyDrainTask>(static_cast<BodyDrainTask *>(task.toPrivate()));
+}
+
+/**
+ * Parses an incoming `multipart/form-data` body for `formData()` while it's being read.
+ *
+ * Every read gets a buffer of its own, which becomes a segment shared by the Files whose contents
+ * it holds, so the body is never joined into a single buffer. Apart from the Files, only the part
+ * being parsed is kept in memory.
+ */
+class MultipartBodyTask final : public api::AsyncTask {
+  Heap<JSObject *> owner_;
+  form_data::MultipartParser parser_;
+  UniqueChars buffer_;
+  size_t capacity_ = 0;
+
+  bool reject(JSContext *cx, HandleObject owner) {
     handle_ = -1;
+    buffer_.reset();
+    auto slot = static_cast<uint32_t>(RequestOrResponse::Slots::BodyAllPromise);
+    RootedObject promise(cx, &JS::GetReservedSlot(owner, slot).toObject());
+    JS::SetReservedSlot(owner, slot, JS::UndefinedValue());
+    return RejectPromiseWithPendingError(cx, promise);
+  }
+
+  bool reject_malformed(JSContext *cx, HandleObject owner) {
+    JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_FORM_DATA_MALFORMED_BODY);
+    return reject(cx, owner);
+  }
+
+public:
+  MultipartBodyTask(const HandleObject owner, std::string_view boundary)
+      : owner_(owner), parser_(boundary) {
+    auto res = RequestOrResponse::incoming_body_handle(owner)->subscribe();
+    MOZ_ASSERT(!res.is_err(), "Subscribing to a future should never fail");
+    handle_ = res.unwrap();
+  }
+
+  [[nodiscard]] bool run(api::Engine *engine) override {
+    JSContext *cx = engine->cx();
+    RootedObject owner(cx, owner_);
+    auto body = RequestOrResponse::incoming_body_handle(owner);
+    while (true) {
+      // The buffer is kept while waiting for the body, and only replaced once it has been filled.
+      if (!buffer_) {
+        capacity_ = RequestOrResponse::next_read_size(owner);
+        buffer_.reset(static_cast<char *>(JS_malloc(cx, capacity_)));
+        if (!buffer_) {
+          JS_ReportOutOfMemory(cx);
+          return reject(cx, owner);
+        }
+      }
+
+      auto res = body->read_into(std::span(reinterpret_cast<uint8_t *>(buffer_.get()), capacity_));
+      if (auto *err = res.to_err()) {
+        HANDLE_ERROR(cx, *err);
+        return reject(cx, owner);
+      }
+
+      auto &result = res.unwrap();
+      if (result.done) {
+        break;
+      }
+      if (result.len == 0) {
+        engine->queue_async_task(this);
+        return true;
+      }
+
+      // The segment lives as long as the Files in it, so give back what the read didn't fill. If
+      // that fails, the larger buffer is still fine to use.
+      if (result.len < capacity_) {
+        auto *buffer = static_cast<char *>(JS_realloc(cx, buffer_.get(), capacity_, result.len));
+        if (buffer) {
+          std::ignore = buffer_.release();
+          buffer_.reset(buffer);
+        }
+      }
+      auto *data = reinterpret_cast<uint8_t *>(buffer_.release());
+      if (!parser_.feed(std::make_shared<const blob::BlobSegment>(data, result.len))) {
+        return reject_malformed(cx, owner);
+      }
+    }
+
+    handle_ = -1;
+    buffer_.reset();
+    if (!RequestOrResponse::incoming_body_finished(cx, owner)) {
+      return reject(cx, owner);
+    }
+    if (!parser_.finish()) {
+      return reject_malformed(cx, owner);
+    }
+
+    auto slot = static_cast<uint32_t>(RequestOrResponse::Slots::BodyAllPromise);
+    RootedObject promise(cx, &JS::GetReservedSlot(owner, slot).toObject());
+    JS::SetReservedSlot(owner, slot, JS::UndefinedValue());
+    RootedObject form_data(cx, form_data::FormData::create(cx, parser_.take_entries()));
+    if (!form_data) {
+      return RejectPromiseWithPendingError(cx, promise);
+    }
+    RootedValue result(cx, JS::ObjectValue(*form_data));
+    return JS::ResolvePromise(cx, promise, result);
+  }
+
+  [[nodiscard]] bool cancel(api::Engine *engine) override {
+    // Only happens when the body is closed, see `close_incoming_body`, in which case `abort_body`
+    // rejects the promise.
+    handle_ = -1;
+    owner_ = nullptr;
+    buffer_.reset();
     return true;
   }
 
@@ -178,7 +567,7 @@ public:
     return true;
   }
 
-  void trace(JSTracer *trc) override { TraceEdge(trc, &request_, "Request for response future"); }
+  void trace(JSTracer *trc) override { TraceEdge(trc, &owner_, "owner of multipart body"); }
 };
 
 namespace {
@@ -208,6 +597,306 @@ struct ReadResult {
   size_t length;
 };
 
+/**
+ * Encodes text to UTF-8 straight into an outgoing body, through a fixed-size buffer that's written
+ * out whenever it fills up. Serializing a string body this way never needs a UTF-8 copy of the
+ * entire text. Long ASCII runs of Latin-1 text are written without copying them at all.
+ *
+ * A writer created without a body instead collects the encoded bytes in chunks of the buffer's
+ * size, which `write_collected` writes to a body later on. That's how JSON is serialized before
+ * the response it's the body of exists, without ever holding the entire text in a single buffer.
+ *
+ * Unpaired surrogates are replaced with U+FFFD, as `JS_EncodeStringToUTF8` does. Surrogate pairs
+ * split across two calls to `write` are still encoded as a single code point.
+ *
+ * Writing doesn't GC or report errors, so it can be used while holding on to a string's chars, or
+ * from a `JSONWriteCallback`. If writing to the body fails, all further writes fail, too, and
+ * `report_error` reports the failure once it's safe to do so.
+ */
+class Utf8BodyWriter final {
+  static constexpr size_t CAPACITY = HANDLE_READ_CHUNK_SIZE;
+
+  host_api::HttpOutgoingBody *body_ = nullptr;
+  std::vector<std::vector<uint8_t>> collected_;
+  size_t written_ = 0;
+  uint8_t buffer_[CAPACITY];
+  size_t len_ = 0;
+  char16_t pending_lead_ = 0;
+  mozilla::Maybe<host_api::APIError> error_;
+
+  bool write_bytes(const uint8_t *bytes, size_t len) {
+    written_ += len;
+    if (!body_) {
+      collected_.emplace_back(bytes, bytes + len);
+      return true;
+    }
+    auto res = body_->write_all(bytes, len);
+    if (auto *err = res.to_err()) {
+      error_ = mozilla::Some(*err);
+      return false;
+    }
+    return true;
+  }
+
+  bool put_code_point(uint32_t c) {
+    if (CAPACITY - len_ < 4 && !flush()) {
+      return false;
+    }
+    if (c < 0x80) {
+      buffer_[len_++] = c;
+    } else if (c < 0x800) {
+      buffer_[len_++] = 0xC0 | (c >> 6);
+      buffer_[len_++] = 0x80 | (c & 0x3F);
+    } else if (c < 0x10000) {
+      buffer_[len_++] = 0xE0 | (c >> 12);
+      buffer_[len_++] = 0x80 | ((c >> 6) & 0x3F);
+      buffer_[len_++] = 0x80 | (c & 0x3F);
+    } else {
+      buffer_[len_++] = 0xF0 | (c >> 18);
+      buffer_[len_++] = 0x80 | ((c >> 12) & 0x3F);
+      buffer_[len_++] = 0x80 | ((c >> 6) & 0x3F);
+      buffer_[len_++] = 0x80 | (c & 0x3F);
+    }
+    return true;
+  }
+
+public:
+  Utf8BodyWriter() = default;
+  explicit Utf8BodyWriter(host_api::HttpOutgoingBody *body) : body_(body) {}
+
+  /// The number of encoded bytes written out so far, not counting those still buffered.
+  size_t written() const { return written_; }
+
+  bool write(const char16_t *chars, size_t len) {
+    if (error_) {
+      return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+      char16_t c = chars[i];
+      if (pending_lead_) {
+        uint32_t lead = pending_lead_;
+        pending_lead_ = 0;
+        if (c >= 0xDC00 && c <= 0xDFFF) {
+          if (!put_code_point(0x10000 + ((lead - 0xD800) << 10) + (c - 0xDC00))) {
+            return false;
+          }
+          continue;
+        }
+        if (!put_code_point(0xFFFD)) {
+          return false;
+        }
+      }
+
+      if (c < 0x80) {
+        if (len_ == CAPACITY && !flush()) {
+          return false;
+        }
+        buffer_[len_++] = c;
+      } else if (c >= 0xD800 && c <= 0xDBFF) {
+        pending_lead_ = c;
+      } else if (!put_code_point(c >= 0xDC00 && c <= 0xDFFF ? 0xFFFD : c)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool write(const JS::Latin1Char *chars, size_t len) {
+    if (error_) {
+      return false;
+    }
+    if (pending_lead_) {
+      pending_lead_ = 0;
+      if (!put_code_point(0xFFFD)) {
+        return false;
+      }
+    }
+    size_t i = 0;
+    while (i < len) {
+      size_t ascii_end = i;
+      while (ascii_end < len && chars[ascii_end] < 0x80) {
+        ascii_end++;
+      }
+
+      size_t run = ascii_end - i;
+      if (run >= CAPACITY) {
+        if (!flush() || !write_bytes(chars + i, run)) {
+          return false;
+        }
+      } else {
+        while (run > 0) {
+          if (len_ == CAPACITY && !flush()) {
+            return false;
+          }
+          size_t n = std::min(run, CAPACITY - len_);
+          memcpy(buffer_ + len_, chars + i, n);
+          len_ += n;
+          i += n;
+          run -= n;
+        }
+      }
+      i = ascii_end;
+
+      if (i < len) {
+        if (!put_code_point(chars[i])) {
+          return false;
+        }
+        i++;
+      }
+    }
+    return true;
+  }
+
+  /// Write out all buffered bytes.
+  bool flush() {
+    if (error_) {
+      return false;
+    }
+    if (len_ == 0) {
+      return true;
+    }
+    size_t len = len_;
+    len_ = 0;
+    return write_bytes(buffer_, len);
+  }
+
+  /// Encode a trailing unpaired surrogate, and write out all buffered bytes.
+  bool finish() {
+    if (pending_lead_) {
+      pending_lead_ = 0;
+      if (!put_code_point(0xFFFD)) {
+        return false;
+      }
+    }
+    return flush();
+  }
+
+  /// Write the bytes collected by a writer created without a body to `body`, once `finish` has been
+  /// called.
+  bool write_collected(host_api::HttpOutgoingBody *body) {
+    MOZ_ASSERT(!body_ && len_ == 0);
+    body_ = body;
+    written_ = 0;
+    for (const auto &chunk : collected_) {
+      if (!write_bytes(chunk.data(), chunk.size())) {
+        return false;
+      }
+    }
+    collected_.clear();
+    return true;
+  }
+
+  /// Report the error writing to the body failed with, if any. Returns `false` if it did.
+  bool report_error(JSContext *cx) {
+    if (error_) {
+      HANDLE_ERROR(cx, *error_);
+      return false;
+    }
+    return true;
+  }
+};
+
+/// A `JSONWriteCallback` encoding the serialized text with the `Utf8BodyWriter` passed as `data`.
+bool write_json_chars(const char16_t *chars, uint32_t len, void *data) {
+  return static_cast<Utf8BodyWriter *>(data)->write(chars, len);
+}
+
+/**
+ * Encode `str` to UTF-8 straight into `body`.
+ *
+ * Note: SpiderMonkey doesn't expose the segments of ropes, so those are flattened first. That
+ * happens in place, so the only copy of the text is the one the engine would create anyway.
+ */
+bool write_string_to_body(JSContext *cx, host_api::HttpOutgoingBody *body, JS::HandleString str) {
+  JSLinearString *linear = JS_EnsureLinearString(cx, str);
+  if (!linear) {
+    return false;
+  }
+
+  Utf8BodyWriter writer(body);
+  bool ok;
+  {
+    JS::AutoCheckCannotGC nogc(cx);
+    size_t len = JS::GetLinearStringLength(linear);
+    if (JS::LinearStringHasLatin1Chars(linear)) {
+      ok = writer.write(JS_GetLatin1LinearStringChars(nogc, linear), len);
+    } else {
+      ok = writer.write(JS_GetTwoByteLinearStringChars(nogc, linear), len);
+    }
+  }
+  if (!ok || !writer.finish()) {
+    return writer.report_error(cx);
+  }
+  return true;
+}
+
+/**
+ * Writes a Blob's contents to the outgoing body of `owner`, straight from the Blob's segments,
+ * whenever the body's stream has capacity for more of them. See `RequestOrResponse::extract_body`.
+ */
+class BlobBodyTask final : public api::AsyncTask {
+  Heap<JSObject *> owner_;
+  blob::BlobParts parts_;
+  /// The part to write next, and how much of it has been written already.
+  size_t part_ = 0;
+  size_t offset_ = 0;
+
+  bool fail(JSContext *cx, host_api::APIError err) {
+    finished_ = true;
+    HANDLE_ERROR(cx, err);
+    return false;
+  }
+
+public:
+  BlobBodyTask(const HandleObject owner, blob::BlobParts parts)
+      : owner_(owner), parts_(std::move(parts)) {
+    auto res = RequestOrResponse::outgoing_body_handle(owner)->subscribe();
+    MOZ_ASSERT(!res.is_err(), "Subscribing to a body should never fail");
+    handle_ = res.unwrap();
+  }
+
+  [[nodiscard]] bool run(api::Engine *engine) override {
+    JSContext *cx = engine->cx();
+    auto *body = RequestOrResponse::outgoing_body_handle(owner_);
+    while (part_ < parts_.size()) {
+      auto capacity_res = body->capacity();
+      if (auto *err = capacity_res.to_err()) {
+        return fail(cx, *err);
+      }
+      auto capacity = capacity_res.unwrap();
+      if (capacity == 0) {
+        engine->queue_async_task(this);
+        return true;
+      }
+
+      const auto &part = parts_[part_];
+      auto len = static_cast<size_t>(std::min<uint64_t>(capacity, part.length - offset_));
+      auto write_res = body->write(part.data() + offset_, len);
+      if (auto *err = write_res.to_err()) {
+        return fail(cx, *err);
+      }
+      offset_ += write_res.unwrap();
+      if (offset_ == part.length) {
+        part_++;
+        offset_ = 0;
+      }
+    }
+
+    finished_ = true;
+    return true;
+  }
+
+  [[nodiscard]] bool cancel(api::Engine *engine) override {
+    // Nothing cancels writing a body, but if it happens, the rest of the Blob is dropped.
+    finished_ = true;
+    return true;
+  }
+
+  bool ready() override { return true; }
+
+  void trace(JSTracer *trc) override { TraceEdge(trc, &owner_, "owner of Blob body"); }
+};
+
 } // namespace
 
 host_api::HttpRequestResponseBase *RequestOrResponse::handle(JSObject *obj) {
@@ -255,6 +944,40 @@ host_api::HttpOutgoingBody *RequestOrResponse::outgoing_body_handle(JSObject *ob
   return res.unwrap();
 }
 
+std::optional<size_t> RequestOrResponse::content_length(JSObject *obj) {
+  auto res = headers_handle(obj)->get("content-length");
+  if (res.is_err() || !res.unwrap()) {
+    return std::nullopt;
+  }
+  std::string_view value = res.unwrap()->front();
+  size_t len;
+  auto [end, err] = std::from_chars(value.data(), value.data() + value.size(), len);
+  if (err != std::errc() || end != value.data() + value.size()) {
+    return std::nullopt;
+  }
+  return len;
+}
+
+size_t RequestOrResponse::next_read_size(JSObject *obj) {
+  MOZ_ASSERT(is_incoming(obj));
+  auto slot = static_cast<uint32_t>(Slots::ReadSize);
+  JS::Value size_val = JS::GetReservedSlot(obj, slot);
+  size_t size;
+  if (size_val.isInt32()) {
+    size = size_val.toInt32();
+  } else if (auto len = content_length(obj)) {
+    size = std::clamp(*len, size_t(1), MAX_HANDLE_READ_CHUNK_SIZE);
+  } else {
+    size = HANDLE_READ_CHUNK_SIZE;
+  }
+
+  // Reads only allocate as much as they return, so growing them is cheap even if the
+  // `Content-Length` was wrong.
+  size_t next = std::min(size * 2, MAX_HANDLE_READ_CHUNK_SIZE);
+  JS::SetReservedSlot(obj, slot, JS::Int32Value(static_cast<int32_t>(next)));
+  return size;
+}
+
 JSObject *RequestOrResponse::body_stream(JSObject *obj) {
   MOZ_ASSERT(is_instance(obj));
   return JS::GetReservedSlot(obj, static_cast<uint32_t>(Slots::BodyStream)).toObjectOrNull();
@@ -339,10 +1062,14 @@ bool RequestOrResponse::extract_body(JSContext *cx, JS::HandleObject self,
   MOZ_ASSERT(!body_val.isNullOrUndefined());
 
   const char *content_type = nullptr;
+  host_api::HostString blob_type;
+  std::string form_data_type;
 
-  // We currently support five types of body inputs:
+  // We currently support seven types of body inputs:
   // - byte sequence
   // - buffer source
+  // - Blob
+  // - FormData
   // - USV strings
   // - URLSearchParams
   // - ReadableStream
@@ -371,9 +1098,45 @@ bool RequestOrResponse::extract_body(JSContext *cx, JS::HandleObject self,
         streams::TransformStream::set_readable_used_as_body(cx, body_obj, self);
       }
     }
+  } else if (body_obj && blob::Blob::is_instance(body_obj)) {
+    // Blobs are written straight from their segments, without joining them first, as the body
+    // has capacity for them. The task holds on to the segments, so the Blob can be collected.
+    const auto &parts = blob::Blob::parts(body_obj);
+    if (!parts.empty()) {
+      ENGINE->queue_async_task(new BlobBodyTask(self, parts));
+    }
+
+    JS::RootedString type(cx, blob::Blob::type(body_obj));
+    if (JS_GetStringLength(type) > 0) {
+      blob_type = core::encode(cx, type);
+      if (!blob_type) {
+        return false;
+      }
+      content_type = blob_type.begin();
+    }
+  } else if (body_obj && form_data::FormData::is_instance(body_obj)) {
+    std::string boundary;
+    if (!form_data::FormData::make_boundary(cx, &boundary) ||
+        !form_data::FormData::write_multipart(
+            cx, body_obj, RequestOrResponse::outgoing_body_handle(self), boundary)) {
+      return false;
+    }
+    form_data_type = "multipart/form-data; boundary=" + boundary;
+    content_type = form_data_type.c_str();
+  } else if (!body_obj ||
+             !(JS_IsArrayBufferViewObject(body_obj) || JS::IsArrayBufferObject(body_obj) ||
+               url::URLSearchParams::is_instance(body_obj))) {
+    // USV strings are encoded to UTF-8 straight into the body, without creating an encoded copy.
+    JS::RootedString str(cx, JS::ToString(cx, body_val));
+    if (!str) {
+      return false;
+    }
+    if (!write_string_to_body(cx, RequestOrResponse::outgoing_body_handle(self), str)) {
+      return false;
+    }
+    content_type = "text/plain;charset=UTF-8";
   } else {
     mozilla::Maybe<JS::AutoCheckCannotGC> maybeNoGC;
-    JS::UniqueChars text;
     char *buf;
     size_t length;
 
@@ -389,22 +1152,12 @@ bool RequestOrResponse::extract_body(JSContext *cx, JS::HandleObject self,
     } else if (body_obj && JS::IsArrayBufferObject(body_obj)) {
       bool is_shared;
       JS::GetArrayBufferLengthAndData(body_obj, &length, &is_shared, (uint8_t **)&buf);
-    } else if (body_obj && url::URLSearchParams::is_instance(body_obj)) {
+    } else {
+      MOZ_ASSERT(url::URLSearchParams::is_instance(body_obj));
       auto slice = url::URLSearchParams::serialize(cx, body_obj);
       buf = (char *)slice.data;
       length = slice.len;
       content_type = "application/x-www-form-urlencoded;charset=UTF-8";
-    } else {
-      {
-        auto str = core::encode(cx, body_val);
-        text = std::move(str.ptr);
-        length = str.len;
-      }
-
-      if (!text)
-        return false;
-      buf = text.get();
-      content_type = "text/plain;charset=UTF-8";
     }
 
     auto body = RequestOrResponse::outgoing_body_handle(self);
@@ -444,6 +1197,22 @@ bool RequestOrResponse::append_body(JSContext *cx, JS::HandleObject self, JS::Ha
   MOZ_ASSERT(!body_used(self));
   host_api::HttpIncomingBody *source_body = incoming_body_handle(source);
   host_api::HttpOutgoingBody *dest_body = outgoing_body_handle(self);
+
+  // The part of a prefetched body that has been read already has to be written out first.
+  if (auto task = take_prefetch_task(source)) {
+    size_t len;
+    UniqueChars prefetched = task->take(ENGINE, &len);
+    if (task->state() == BodyDrainTask::State::Failed) {
+      HANDLE_ERROR(cx, task->error());
+      return false;
+    }
+    auto res = dest_body->write_all(reinterpret_cast<uint8_t *>(prefetched.get()), len);
+    if (auto *err = res.to_err()) {
+      HANDLE_ERROR(cx, *err);
+      return false;
+    }
+  }
+
   auto res = dest_body->append(ENGINE, source_body);
   if (auto *err = res.to_err()) {
     HANDLE_ERROR(cx, *err);
@@ -486,6 +1255,24 @@ JSObject *RequestOrResponse::headers(JSContext *cx, JS::HandleObject obj) {
   return headers;
 }
 
+/// Get the value of `self`'s `Content-Type` header, leaving `content_type` empty if it has none.
+static bool body_content_type(JSContext *cx, JS::HandleObject self,
+                              host_api::HostString *content_type) {
+  JS::RootedObject headers(cx, RequestOrResponse::headers(cx, self));
+  if (!headers) {
+    return false;
+  }
+  JS::RootedValue value(cx);
+  if (!Headers::get_value(cx, headers, "content-type", &value)) {
+    return false;
+  }
+  if (value.isNull()) {
+    return true;
+  }
+  *content_type = core::encode(cx, value);
+  return static_cast<bool>(*content_type);
+}
+
 template <RequestOrResponse::BodyReadResult result_type>
 bool RequestOrResponse::parse_body(JSContext *cx, JS::HandleObject self, JS::UniqueChars buf,
                                    size_t len) {
@@ -501,8 +1288,36 @@ bool RequestOrResponse::parse_body(JSContext *cx, JS::HandleObject self, JS::Uni
     }
     static_cast<void>(buf.release());
     result.setObject(*array_buffer);
+  } else if constexpr (result_type == RequestOrResponse::BodyReadResult::FormData) {
+    host_api::HostString content_type;
+    if (!body_content_type(cx, self, &content_type)) {
+      return RejectPromiseWithPendingError(cx, result_promise);
+    }
+    JS::RootedObject form_data(cx,
+                               form_data::FormData::parse(cx, content_type, std::move(buf), len));
+    if (!form_data) {
+      return RejectPromiseWithPendingError(cx, result_promise);
+    }
+    result.setObject(*form_data);
   } else {
-    JS::RootedString text(cx, JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(buf.get(), len)));
+    // Most text and JSON bodies are pure ASCII, which is valid Latin1 as is, so they don't need to
+    // be decoded as UTF-8. The check is vectorized.
+    bool is_ascii = JS::StringIsASCII(mozilla::Span(buf.get(), len));
+
+    if constexpr (result_type == RequestOrResponse::BodyReadResult::JSON) {
+      // ASCII JSON is parsed straight from the body, without creating a string for it first.
+      if (is_ascii) {
+        auto chars = reinterpret_cast<const JS::Latin1Char *>(buf.get());
+        if (!JS_ParseJSON(cx, chars, static_cast<uint32_t>(len), &result)) {
+          return RejectPromiseWithPendingError(cx, result_promise);
+        }
+        return JS::ResolvePromise(cx, result_promise, result);
+      }
+    }
+
+    JS::RootedString text(cx, is_ascii
+                                  ? JS_NewStringCopyN(cx, buf.get(), len)
+                                  : JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(buf.get(), len)));
     if (!text) {
       return RejectPromiseWithPendingError(cx, result_promise);
     }
@@ -520,148 +1335,173 @@ bool RequestOrResponse::parse_body(JSContext *cx, JS::HandleObject self, JS::Uni
   return JS::ResolvePromise(cx, result_promise, result);
 }
 
-bool RequestOrResponse::content_stream_read_then_handler(JSContext *cx, JS::HandleObject self,
-                                                         JS::HandleValue extra, JS::CallArgs args) {
-  JS::RootedObject then_handler(cx, &args.callee());
-  // The reader is stored in the catch handler, which we need here as well.
-  // So we get that first, then the reader.
-  MOZ_ASSERT(extra.isObject());
-  JS::RootedObject catch_handler(cx, &extra.toObject());
-#ifdef DEBUG
-  bool foundContents;
-  if (!JS_HasElement(cx, catch_handler, 1, &foundContents)) {
-    return false;
-  }
-  MOZ_ASSERT(foundContents);
-#endif
-  JS::RootedValue contents_val(cx);
-  if (!JS_GetElement(cx, catch_handler, 1, &contents_val)) {
-    return false;
-  }
-  MOZ_ASSERT(contents_val.isObject());
-  JS::RootedObject contents(cx, &contents_val.toObject());
-  if (!contents) {
-    return false;
-  }
-#ifdef DEBUG
-  bool contentsIsArray;
-  if (!JS::IsArrayObject(cx, contents, &contentsIsArray)) {
-    return false;
-  }
-  MOZ_ASSERT(contentsIsArray);
-#endif
-
-  auto reader_val = js::GetFunctionNativeReserved(catch_handler, 1);
-  MOZ_ASSERT(reader_val.isObject());
-  JS::RootedObject reader(cx, &reader_val.toObject());
+namespace {
 
-  // We're guaranteed to work with a native ReadableStreamDefaultReader here as we used
-  // `JS::ReadableStreamDefaultReaderRead(cx, reader)`, which in turn is guaranteed to return {done:
-  // bool, value: any} objects to read promise then callbacks.
-  MOZ_ASSERT(args[0].isObject());
-  JS::RootedObject chunk_obj(cx, &args[0].toObject());
-  JS::RootedValue done_val(cx);
-  JS::RootedValue value(cx);
-#ifdef DEBUG
-  bool hasValue;
-  if (!JS_HasProperty(cx, chunk_obj, "value", &hasValue)) {
-    return false;
+/**
+ * The chunks of a body stream being read in its entirety by `read_all`. They're retained until the
+ * stream ends, so that they can be copied into a buffer of the exact size needed at once.
+ */
+struct BodyChunks {
+  std::vector<Heap<JSObject *>> chunks;
+  size_t total = 0;
+  RequestOrResponse::ParseBodyCB *parse_body = nullptr;
+  /// Whether the chunks were read from an incoming body's own stream, so that their buffers were
+  /// allocated by the runtime and never seen by content. Other streams' chunks might be shared with
+  /// content, or with the other branch of a tee.
+  bool runtime_allocated = false;
+
+  void trace(JSTracer *trc) {
+    for (auto &chunk : chunks) {
+      TraceEdge(trc, &chunk, "Body stream chunk");
+    }
   }
-  MOZ_ASSERT(hasValue);
-#endif
-  if (!JS_GetProperty(cx, chunk_obj, "value", &value)) {
-    return false;
+};
+
+/**
+ * Owns the `BodyChunks` of a body stream being read by `read_all`, along with the stream's reader.
+ *
+ * The holder is only referenced by the read handlers, so the chunks are freed along with it, even
+ * if the stream never settles.
+ */
+class BodyChunksHolder final
+    : public BuiltinImpl<BodyChunksHolder, TraceableClassOps<BodyChunksHolder>> {
+public:
+  static constexpr const char *class_name = "BodyChunks";
+
+  enum Slots {
+    /// The `BodyChunks`, as a private value.
+    Chunks,
+    /// The reader the chunks are read with.
+    Reader,
+    Count
+  };
+
+  static JSObject *create(JSContext *cx, JS::HandleObject reader) {
+    JS::RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &class_, nullptr));
+    if (!self) {
+      return nullptr;
+    }
+    JS::SetReservedSlot(self, Slots::Chunks, JS::PrivateValue(new BodyChunks()));
+    JS::SetReservedSlot(self, Slots::Reader, JS::ObjectValue(*reader));
+    return self;
   }
-#ifdef DEBUG
-  bool hasDone;
-  if (!JS_HasProperty(cx, chunk_obj, "done", &hasDone)) {
-    return false;
+
+  static BodyChunks &chunks(JSObject *self) {
+    MOZ_ASSERT(is_instance(self));
+    return *static_cast<BodyChunks *>(JS::GetReservedSlot(self, Slots::Chunks).toPrivate());
   }
-  MOZ_ASSERT(hasDone);
-#endif
-  if (!JS_GetProperty(cx, chunk_obj, "done", &done_val)) {
-    return false;
+
+  static JSObject *reader(JSObject *self) {
+    MOZ_ASSERT(is_instance(self));
+    return &JS::GetReservedSlot(self, Slots::Reader).toObject();
   }
-  MOZ_ASSERT(done_val.isBoolean());
-  if (done_val.toBoolean()) {
-    // We finished reading the stream
-    // Now we need to iterate/reduce `contents` JS Array into UniqueChars
-    uint32_t contentsLength;
-    if (!JS::GetArrayLength(cx, contents, &contentsLength)) {
-      return false;
+
+  static void trace(JSTracer *trc, JSObject *self) {
+    auto chunks_val = JS::GetReservedSlot(self, Slots::Chunks);
+    if (!chunks_val.isUndefined()) {
+      static_cast<BodyChunks *>(chunks_val.toPrivate())->trace(trc);
     }
-    // TODO(performance): investigate whether we can infer the size directly from `contents`
-    size_t buf_size = HANDLE_READ_CHUNK_SIZE;
-    // TODO(performance): make use of malloc slack.
-    // https://github.com/fastly/js-compute-runtime/issues/217
-    size_t offset = 0;
-    // In this loop we are finding the length of each entry in `contents` and resizing the `buf`
-    // until it is large enough to fit all the entries in `contents`
-    for (uint32_t index = 0; index < contentsLength; index++) {
-      JS::RootedValue val(cx);
-      if (!JS_GetElement(cx, contents, index, &val)) {
-        return false;
-      }
-      {
-        JS::AutoCheckCannotGC nogc;
-        MOZ_ASSERT(val.isObject());
-        JSObject *array = &val.toObject();
-        MOZ_ASSERT(JS_IsUint8Array(array));
-        size_t length = JS_GetTypedArrayByteLength(array);
-        if (length) {
-          offset += length;
-          // if buf is not big enough to fit the next uint8array's bytes then resize
-          if (offset > buf_size) {
-            buf_size =
-                buf_size + (HANDLE_READ_CHUNK_SIZE * ((length / HANDLE_READ_CHUNK_SIZE) + 1));
-          }
-        }
-      }
+  }
+
+  static void finalize(JS::GCContext *gcx, JSObject *self) {
+    auto chunks_val = JS::GetReservedSlot(self, Slots::Chunks);
+    if (!chunks_val.isUndefined()) {
+      delete static_cast<BodyChunks *>(chunks_val.toPrivate());
     }
+  }
+};
 
-    JS::UniqueChars buf{static_cast<char *>(JS_malloc(cx, buf_size + 1))};
-    if (!buf) {
-      JS_ReportOutOfMemory(cx);
+/**
+ * Concatenate `chunks` into a single buffer. A single chunk allocated by the runtime and spanning
+ * its entire buffer is adopted instead of being copied, detaching the buffer.
+ */
+bool concatenate_chunks(JSContext *cx, BodyChunks &chunks, UniqueChars *buf, size_t *len) {
+  if (chunks.runtime_allocated && chunks.chunks.size() == 1) {
+    RootedObject chunk(cx, chunks.chunks.front());
+    bool is_shared;
+    RootedObject buffer(cx, JS_GetArrayBufferViewBuffer(cx, chunk, &is_shared));
+    if (!buffer) {
       return false;
     }
-    // reset the offset for the next loop
-    offset = 0;
-    // In this loop we are inserting each entry in `contents` into `buf`
-    for (uint32_t index = 0; index < contentsLength; index++) {
-      JS::RootedValue val(cx);
-      if (!JS_GetElement(cx, contents, index, &val)) {
+    size_t length = JS_GetTypedArrayByteLength(chunk);
+    if (!is_shared && JS_GetTypedArrayByteOffset(chunk) == 0 && length > 0 &&
+        JS::GetArrayBufferByteLength(buffer) == length) {
+      buf->reset(static_cast<char *>(JS::StealArrayBufferContents(cx, buffer)));
+      if (!*buf) {
         return false;
       }
-      {
-        JS::AutoCheckCannotGC nogc;
-        MOZ_ASSERT(val.isObject());
-        JSObject *array = &val.toObject();
-        MOZ_ASSERT(JS_IsUint8Array(array));
-        bool is_shared;
-        size_t length = JS_GetTypedArrayByteLength(array);
-        if (length) {
-          static_assert(CHAR_BIT == 8, "Strange char");
-          auto bytes = reinterpret_cast<char *>(JS_GetUint8ArrayData(array, &is_shared, nogc));
-          memcpy(buf.get() + offset, bytes, length);
-          offset += length;
-        }
-      }
+      *len = length;
+      return true;
     }
-    buf[offset] = '\0';
-#ifdef DEBUG
-    bool foundBodyParser;
-    if (!JS_HasElement(cx, catch_handler, 2, &foundBodyParser)) {
-      return false;
+  }
+
+  *len = 0;
+  if (chunks.total == 0) {
+    return true;
+  }
+  buf->reset(static_cast<char *>(JS_malloc(cx, chunks.total)));
+  if (!*buf) {
+    JS_ReportOutOfMemory(cx);
+    return false;
+  }
+
+  JS::AutoCheckCannotGC nogc;
+  for (auto &chunk : chunks.chunks) {
+    // Content might have changed the chunk's length since it was read: detaching its buffer makes
+    // it shorter, but a length-tracking view of a resizable buffer can also grow. Only the bytes
+    // counted in `total` are copied.
+    size_t length = std::min(JS_GetTypedArrayByteLength(chunk), chunks.total - *len);
+    if (length) {
+      bool is_shared;
+      auto bytes = JS_GetUint8ArrayData(chunk, &is_shared, nogc);
+      memcpy(buf->get() + *len, bytes, length);
+      *len += length;
     }
-    MOZ_ASSERT(foundBodyParser);
-#endif
-    // Now we can call parse_body on the result
-    JS::RootedValue body_parser(cx);
-    if (!JS_GetElement(cx, catch_handler, 2, &body_parser)) {
-      return false;
+  }
+  return true;
+}
+
+bool reject_body_all(JSContext *cx, JS::HandleObject self) {
+  auto slot = static_cast<uint32_t>(RequestOrResponse::Slots::BodyAllPromise);
+  JS::RootedObject result_promise(cx, &JS::GetReservedSlot(self, slot).toObject());
+  JS::SetReservedSlot(self, slot, JS::UndefinedValue());
+  return RejectPromiseWithPendingError(cx, result_promise);
+}
+
+} // namespace
+
+bool RequestOrResponse::content_stream_read_then_handler(JSContext *cx, JS::HandleObject self,
+                                                         JS::HandleValue extra, JS::CallArgs args) {
+  JS::RootedObject then_handler(cx, &args.callee());
+  // The reader is stored in the catch handler, which we need here as well.
+  // So we get that first, then the reader.
+  MOZ_ASSERT(extra.isObject());
+  JS::RootedObject catch_handler(cx, &extra.toObject());
+  JS::RootedObject holder(cx, &js::GetFunctionNativeReserved(catch_handler, 1).toObject());
+  auto &chunks = BodyChunksHolder::chunks(holder);
+  JS::RootedObject reader(cx, BodyChunksHolder::reader(holder));
+
+  // We're guaranteed to work with a native ReadableStreamDefaultReader here as we used
+  // `JS::ReadableStreamDefaultReaderRead(cx, reader)`, which in turn is guaranteed to return {done:
+  // bool, value: any} objects to read promise then callbacks.
+  MOZ_ASSERT(args[0].isObject());
+  JS::RootedObject chunk_obj(cx, &args[0].toObject());
+  JS::RootedValue done_val(cx);
+  if (!JS_GetProperty(cx, chunk_obj, "done", &done_val)) {
+    return false;
+  }
+  MOZ_ASSERT(done_val.isBoolean());
+  if (done_val.toBoolean()) {
+    // We finished reading the stream, so the chunks can be concatenated and parsed. They aren't
+    // needed anymore afterwards, even though the holder is only collected later on.
+    JS::UniqueChars buf;
+    size_t len = 0;
+    bool ok = concatenate_chunks(cx, chunks, &buf, &len);
+    chunks.chunks.clear();
+    if (!ok) {
+      return reject_body_all(cx, self);
     }
-    auto parse_body = (ParseBodyCB *)body_parser.toPrivate();
-    return parse_body(cx, self, std::move(buf), offset);
+    return chunks.parse_body(cx, self, std::move(buf), len);
   }
 
   JS::RootedValue val(cx);
@@ -672,24 +1512,13 @@ bool RequestOrResponse::content_stream_read_then_handler(JSContext *cx, JS::Hand
   // The read operation can return anything since this stream comes from the guest
   // If it is not a UInt8Array -- reject with a TypeError
   if (!val.isObject() || !JS_IsUint8Array(&val.toObject())) {
+    chunks.chunks.clear();
     JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_RESPONSE_VALUE_NOT_UINT8ARRAY);
-    JS::RootedObject result_promise(cx);
-    result_promise =
-        &JS::GetReservedSlot(self, static_cast<uint32_t>(Slots::BodyAllPromise)).toObject();
-    JS::SetReservedSlot(self, static_cast<uint32_t>(Slots::BodyAllPromise), JS::UndefinedValue());
-
-    return RejectPromiseWithPendingError(cx, result_promise);
+    return reject_body_all(cx, self);
   }
 
-  {
-    uint32_t contentsLength;
-    if (!JS::GetArrayLength(cx, contents, &contentsLength)) {
-      return false;
-    }
-    if (!JS_SetElement(cx, contents, contentsLength, val)) {
-      return false;
-    }
-  }
+  chunks.total += JS_GetTypedArrayByteLength(&val.toObject());
+  chunks.chunks.emplace_back(&val.toObject());
 
   // Read the next chunk.
   JS::RootedObject promise(cx, JS::ReadableStreamDefaultReaderRead(cx, reader));
@@ -704,7 +1533,10 @@ bool RequestOrResponse::content_stream_read_catch_handler(JSContext *cx, JS::Han
   // The stream errored when being consumed
   // we need to propagate the stream error
   MOZ_ASSERT(extra.isObject());
-  JS::RootedObject reader(cx, &extra.toObject());
+  JS::RootedObject holder(cx, &extra.toObject());
+  BodyChunksHolder::chunks(holder).chunks.clear();
+
+  JS::RootedObject reader(cx, BodyChunksHolder::reader(holder));
   JS::RootedValue stream_val(cx);
   if (!JS_GetElement(cx, reader, 1, &stream_val)) {
     return false;
@@ -725,12 +1557,7 @@ bool RequestOrResponse::content_stream_read_catch_handler(JSContext *cx, JS::Han
   JS::RootedValue error(cx, JS::ReadableStreamGetStoredError(cx, stream));
   JS_ClearPendingException(cx);
   JS_SetPendingException(cx, error, JS::ExceptionStackBehavior::DoNotCapture);
-  JS::RootedObject result_promise(cx);
-  result_promise =
-      &JS::GetReservedSlot(self, static_cast<uint32_t>(Slots::BodyAllPromise)).toObject();
-  JS::SetReservedSlot(self, static_cast<uint32_t>(Slots::BodyAllPromise), JS::UndefinedValue());
-
-  return RejectPromiseWithPendingError(cx, result_promise);
+  return reject_body_all(cx, self);
 }
 
 bool RequestOrResponse::consume_content_stream_for_bodyAll(JSContext *cx, JS::HandleObject self,
@@ -746,11 +1573,7 @@ bool RequestOrResponse::consume_content_stream_for_bodyAll(JSContext *cx, JS::Ha
   if (RequestOrResponse::body_unusable(cx, stream)) {
     JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr,
                               JSMSG_RESPONSE_BODY_DISTURBED_OR_LOCKED);
-    JS::RootedObject result_promise(cx);
-    result_promise =
-        &JS::GetReservedSlot(self, static_cast<uint32_t>(Slots::BodyAllPromise)).toObject();
-    JS::SetReservedSlot(self, static_cast<uint32_t>(Slots::BodyAllPromise), JS::UndefinedValue());
-    return RejectPromiseWithPendingError(cx, result_promise);
+    return reject_body_all(cx, self);
   }
   JS::Rooted<JSObject *> unwrappedReader(
       cx, JS::ReadableStreamGetReader(cx, stream, JS::ReadableStreamReaderMode::Default));
@@ -758,18 +1581,20 @@ bool RequestOrResponse::consume_content_stream_for_bodyAll(JSContext *cx, JS::Ha
     return false;
   }
 
-  // contents is the JS Array we store the stream chunks within, to later convert to
-  // arrayBuffer/json/text
-  JS::Rooted<JSObject *> contents(cx, JS::NewArrayObject(cx, 0));
-  if (!contents) {
+  // TODO: confirm whether this is observable to the JS application
+  if (!JS_SetElement(cx, unwrappedReader, 1, stream)) {
     return false;
   }
 
-  JS::RootedValue extra(cx, JS::ObjectValue(*unwrappedReader));
-  // TODO: confirm whether this is observable to the JS application
-  if (!JS_SetElement(cx, unwrappedReader, 1, stream)) {
+  // The chunks are collected natively, in a holder that's freed along with the handlers.
+  JS::RootedObject holder(cx, BodyChunksHolder::create(cx, unwrappedReader));
+  if (!holder) {
     return false;
   }
+  auto &chunks = BodyChunksHolder::chunks(holder);
+  chunks.parse_body = static_cast<ParseBodyCB *>(body_parser.toPrivate());
+  chunks.runtime_allocated =
+      is_incoming(self) && streams::NativeStreamSource::stream_is_body(cx, stream);
 
   // Create handlers for both `then` and `catch`.
   // These are functions with two reserved slots, in which we store all
@@ -778,6 +1603,7 @@ bool RequestOrResponse::consume_content_stream_for_bodyAll(JSContext *cx, JS::Ha
   // then handler. This allows us to reuse these functions for the next read
   // operation in the then handler. The catch handler won't ever have a need to
   // perform another operation in this way.
+  JS::RootedValue extra(cx, JS::ObjectValue(*holder));
   JS::RootedObject catch_handler(
       cx, create_internal_method<content_stream_read_catch_handler>(cx, self, extra));
   if (!catch_handler) {
@@ -785,12 +1611,6 @@ bool RequestOrResponse::consume_content_stream_for_bodyAll(JSContext *cx, JS::Ha
   }
 
   extra.setObject(*catch_handler);
-  if (!JS_SetElement(cx, catch_handler, 1, contents)) {
-    return false;
-  }
-  if (!JS_SetElement(cx, catch_handler, 2, body_parser)) {
-    return false;
-  }
   JS::RootedObject then_handler(
       cx, create_internal_method<content_stream_read_then_handler>(cx, self, extra));
   if (!then_handler) {
@@ -806,16 +1626,16 @@ bool RequestOrResponse::consume_content_stream_for_bodyAll(JSContext *cx, JS::Ha
 }
 
 template <RequestOrResponse::BodyReadResult result_type>
-bool RequestOrResponse::bodyAll(JSContext *cx, JS::CallArgs args, JS::HandleObject self) {
+JSObject *RequestOrResponse::read_all(JSContext *cx, JS::HandleObject self) {
   // TODO: mark body as consumed when operating on stream, too.
   if (body_used(self)) {
     JS_ReportErrorASCII(cx, "Body has already been consumed");
-    return ReturnPromiseRejectedWithPendingError(cx, args);
+    return nullptr;
   }
 
   JS::RootedObject bodyAll_promise(cx, JS::NewPromiseObject(cx, nullptr));
   if (!bodyAll_promise) {
-    return ReturnPromiseRejectedWithPendingError(cx, args);
+    return nullptr;
   }
   JS::SetReservedSlot(self, static_cast<uint32_t>(Slots::BodyAllPromise),
                       JS::ObjectValue(*bodyAll_promise));
@@ -825,37 +1645,78 @@ bool RequestOrResponse::bodyAll(JSContext *cx, JS::CallArgs args, JS::HandleObje
   if (!has_body(self)) {
     JS::UniqueChars chars;
     if (!parse_body<result_type>(cx, self, std::move(chars), 0)) {
-      return ReturnPromiseRejectedWithPendingError(cx, args);
+      return nullptr;
     }
 
-    args.rval().setObject(*bodyAll_promise);
-    return true;
+    return bodyAll_promise;
   }
 
   if (!mark_body_used(cx, self)) {
-    return ReturnPromiseRejectedWithPendingError(cx, args);
+    return nullptr;
   }
 
-  JS::RootedValue body_parser(cx, JS::PrivateValue((void *)parse_body<result_type>));
-
-  // TODO(performance): don't reify a ReadableStream for body handles—use an AsyncTask instead
+  // Incoming bodies that content hasn't asked for as a stream are read natively.
   JS::RootedObject stream(cx, body_stream(self));
+  if (!stream && is_incoming(self)) {
+    if (auto task = take_prefetch_task(self)) {
+      bool ok = task->consume(ENGINE, cx, self, parse_body<result_type>);
+      // A task that's still reading is queued, and the event loop deletes it once it's done.
+      if (!task->finished()) {
+        std::ignore = task.release();
+      }
+      if (!ok) {
+        return nullptr;
+      }
+      return bodyAll_promise;
+    }
+    // Multipart bodies are parsed while they're read, so uploaded files aren't buffered twice.
+    if constexpr (result_type == BodyReadResult::FormData) {
+      host_api::HostString content_type;
+      if (!body_content_type(cx, self, &content_type)) {
+        return nullptr;
+      }
+      if (auto boundary = form_data::multipart_boundary(content_type)) {
+        ENGINE->queue_async_task(new MultipartBodyTask(self, *boundary));
+        return bodyAll_promise;
+      }
+    }
+    if (!drain_incoming_body(cx, self, parse_body<result_type>)) {
+      return nullptr;
+    }
+    return bodyAll_promise;
+  }
+
+  JS::RootedValue body_parser(cx, JS::PrivateValue((void *)parse_body<result_type>));
   if (!stream) {
     stream = create_body_stream(cx, self);
     if (!stream)
-      return false;
+      return nullptr;
   }
 
   if (!JS_SetElement(cx, stream, 1, body_parser)) {
-    return false;
+    return nullptr;
   }
 
   JS::RootedValue extra(cx, JS::ObjectValue(*stream));
   if (!enqueue_internal_method<consume_content_stream_for_bodyAll>(cx, self, extra)) {
-    return ReturnPromiseRejectedWithPendingError(cx, args);
+    return nullptr;
   }
 
-  args.rval().setObject(*bodyAll_promise);
+  return bodyAll_promise;
+}
+
+// Used by builtins that consume bodies natively, such as the Cache API.
+template JSObject *
+RequestOrResponse::read_all<RequestOrResponse::BodyReadResult::ArrayBuffer>(JSContext *cx,
+                                                                          JS::HandleObject self);
+
+template <RequestOrResponse::BodyReadResult result_type>
+bool RequestOrResponse::bodyAll(JSContext *cx, JS::CallArgs args, JS::HandleObject self) {
+  JSObject *promise = read_all<result_type>(cx, self);
+  if (!promise) {
+    return ReturnPromiseRejectedWithPendingError(cx, args);
+  }
+  args.rval().setObject(*promise);
   return true;
 }
 
@@ -872,17 +1733,19 @@ bool RequestOrResponse::body_source_pull_algorithm(JSContext *cx, CallArgs args,
   // source ReadableStream is closed/canceled, so only one stream can ever be
   // piped in at the same time.
   RootedObject pipe_dest(cx, streams::NativeStreamSource::piped_to_transform_stream(source));
-  if (pipe_dest) {
-    if (streams::TransformStream::readable_used_as_body(pipe_dest)) {
-      RootedObject dest_owner(cx, streams::TransformStream::owner(pipe_dest));
+  // Once the destination's body has been cloned, it's read through a tee of the TransformStream's
+  // readable end instead, so the shortcut doesn't apply anymore.
+  if (pipe_dest && streams::TransformStream::readable_used_as_body(pipe_dest)) {
+    RootedObject dest_owner(cx, streams::TransformStream::owner(pipe_dest));
+    if (body_stream(dest_owner) == streams::TransformStream::readable(pipe_dest)) {
       MOZ_ASSERT(!JS_IsExceptionPending(cx));
       if (!append_body(cx, dest_owner, body_owner)) {
         return false;
       }
 
       MOZ_ASSERT(!JS_IsExceptionPending(cx));
-      RootedObject stream(cx, streams::NativeStreamSource::stream(source));
-      bool success = ReadableStreamClose(cx, stream);
+      RootedValue r(cx);
+      bool success = JS::Call(cx, controller, "close", HandleValueArray::empty(), &r);
       MOZ_RELEASE_ASSERT(success);
 
       args.rval().setUndefined();
@@ -891,18 +1754,208 @@ bool RequestOrResponse::body_source_pull_algorithm(JSContext *cx, CallArgs args,
     }
   }
 
-  ENGINE->queue_async_task(new BodyFutureTask(source));
-
   args.rval().setUndefined();
+
+  // A prefetched body's stream starts with the part that has been read already.
+  if (auto task = take_prefetch_task(body_owner)) {
+    size_t len;
+    UniqueChars prefetched = task->take(ENGINE, &len);
+    if (len > 0) {
+      RootedObject buffer(cx, JS::NewArrayBufferWithContents(cx, len, prefetched.get()));
+      if (!buffer) {
+        return false;
+      }
+      std::ignore = prefetched.release();
+      RootedObject byte_array(cx, JS_NewUint8ArrayWithBuffer(cx, buffer, 0, len));
+      if (!byte_array) {
+        return false;
+      }
+      RootedValueArray<1> enqueue_args(cx);
+      enqueue_args[0].setObject(*byte_array);
+      RootedValue r(cx);
+      if (!JS::Call(cx, controller, "enqueue", enqueue_args, &r)) {
+        return false;
+      }
+    }
+
+    switch (task->state()) {
+    case BodyDrainTask::State::Done: {
+      RootedValue r(cx);
+      return JS::Call(cx, controller, "close", HandleValueArray::empty(), &r);
+    }
+    case BodyDrainTask::State::Failed:
+      HANDLE_ERROR(cx, task->error());
+      return error_stream_controller_with_pending_exception(cx, controller);
+    default:
+      if (len > 0) {
+        return true;
+      }
+    }
+  }
+
+  ENGINE->queue_async_task(new BodyFutureTask(source));
   return true;
 }
 
+/// Enqueue the part of `owner`'s body that was prefetched, if any, into the branches of `tee`,
+/// which reads the rest of the body.
+static bool tee_prefetched_body(JSContext *cx, JS::HandleObject owner, JS::HandleObject tee) {
+  auto task = take_prefetch_task(owner);
+  if (!task) {
+    return true;
+  }
+
+  size_t len;
+  UniqueChars prefetched = task->take(ENGINE, &len);
+  if (len > 0) {
+    RootedObject buffer(cx, JS::NewArrayBufferWithContents(cx, len, prefetched.get()));
+    if (!buffer) {
+      return false;
+    }
+    std::ignore = prefetched.release();
+    RootedObject byte_array(cx, JS_NewUint8ArrayWithBuffer(cx, buffer, 0, len));
+    if (!byte_array || !BodyTee::enqueue(cx, tee, byte_array)) {
+      return false;
+    }
+  }
+
+  switch (task->state()) {
+  case BodyDrainTask::State::Done:
+    return BodyTee::close(cx, tee);
+  case BodyDrainTask::State::Failed: {
+    HANDLE_ERROR(cx, task->error());
+    RootedValue exn(cx);
+    if (!JS_GetPendingException(cx, &exn)) {
+      return false;
+    }
+    JS_ClearPendingException(cx);
+    return BodyTee::error(cx, tee, exn);
+  }
+  default:
+    return true;
+  }
+}
+
+void RequestOrResponse::close_incoming_body(JSObject *owner) {
+  if (auto task = take_prefetch_task(owner)) {
+    size_t len;
+    std::ignore = task->take(ENGINE, &len);
+  }
+
+  auto body = incoming_body_handle(owner);
+  if (!body->valid()) {
+    return;
+  }
+  // A pending read of the next chunk is keyed by the body's pollable.
+  auto res = body->subscribe();
+  if (!res.is_err()) {
+    ENGINE->cancel_async_task(res.unwrap());
+  }
+  body->close();
+}
+
+bool RequestOrResponse::incoming_body_finished(JSContext *cx, JS::HandleObject owner) {
+  if (!Response::is_instance(owner)) {
+    return true;
+  }
+  auto slot = static_cast<uint32_t>(Response::Slots::FetchRequest);
+  JS::RootedValue request_val(cx, JS::GetReservedSlot(owner, slot));
+  if (!request_val.isObject()) {
+    return true;
+  }
+  JS::SetReservedSlot(owner, slot, JS::UndefinedValue());
+  JS::RootedObject request(cx, &request_val.toObject());
+  return Request::remove_abort_algorithm(cx, request);
+}
+
+void RequestOrResponse::maybe_prefetch_body(JSContext *cx, JS::HandleObject owner) {
+  if (MAX_PREFETCHED_BODY_SIZE == 0 || !has_body(owner)) {
+    return;
+  }
+  auto len = content_length(owner);
+  if (!len || *len > MAX_PREFETCHED_BODY_SIZE) {
+    return;
+  }
+
+  // One byte more than the body's length is needed to learn that it has ended. Prefetching is
+  // only an optimization, so it's just skipped if the buffer can't be allocated.
+  size_t capacity = *len + 1;
+  UniqueChars buffer(static_cast<char *>(JS_malloc(cx, capacity)));
+  if (!buffer) {
+    return;
+  }
+  auto *task = new BodyDrainTask(owner, nullptr, std::move(buffer), capacity);
+  JS::SetReservedSlot(owner, static_cast<uint32_t>(Slots::Prefetch), JS::PrivateValue(task));
+  bool ok = task->start(ENGINE, cx, owner);
+  MOZ_ASSERT(ok, "Prefetching never fails");
+  (void)ok;
+}
+
 bool RequestOrResponse::body_source_cancel_algorithm(JSContext *cx, JS::CallArgs args,
                                                      JS::HandleObject stream,
                                                      JS::HandleObject owner,
                                                      JS::HandleValue reason) {
-  // TODO: implement or add a comment explaining why no implementation is required.
+  // Content isn't interested in the rest of the body, so stop receiving it.
   args.rval().setUndefined();
+  if (is_incoming(owner)) {
+    close_incoming_body(owner);
+    return incoming_body_finished(cx, owner);
+  }
+  return true;
+}
+
+bool RequestOrResponse::abort_body(JSContext *cx, JS::HandleObject owner, JS::HandleValue reason) {
+  if (!has_body(owner)) {
+    return true;
+  }
+
+  JS::RootedObject stream(cx, body_stream(owner));
+  // A cloned body is read through a tee, all of whose branches are errored.
+  JS::RootedObject tee(cx, stream ? BodyTee::from_branch(cx, stream) : nullptr);
+  if (tee) {
+    return BodyTee::error(cx, tee, reason);
+  }
+
+  if (is_incoming(owner) && body_used(owner) &&
+      (!stream || !streams::NativeStreamSource::stream_is_body(cx, stream))) {
+    // The body was either handed to the host wholesale, or is being read without a stream by
+    // `read_all`, in which case that read is stopped, and its promise rejected.
+    JS::RootedValue promise_val(
+        cx, JS::GetReservedSlot(owner, static_cast<uint32_t>(Slots::BodyAllPromise)));
+    if (!promise_val.isObject()) {
+      return true;
+    }
+    close_incoming_body(owner);
+    JS::SetReservedSlot(owner, static_cast<uint32_t>(Slots::BodyAllPromise), JS::UndefinedValue());
+    JS::RootedObject promise(cx, &promise_val.toObject());
+    return JS::RejectPromise(cx, promise, reason);
+  }
+
+  if (!stream) {
+    // Without a stream, a used body was handed to the host wholesale, and can't be aborted anymore.
+    if (!is_incoming(owner) || body_used(owner)) {
+      return true;
+    }
+    stream = create_body_stream(cx, owner);
+    if (!stream) {
+      return false;
+    }
+  }
+
+  bool readable;
+  if (!JS::ReadableStreamIsReadable(cx, stream, &readable)) {
+    return false;
+  }
+  if (!readable) {
+    return true;
+  }
+  if (!JS::ReadableStreamError(cx, stream, reason)) {
+    return false;
+  }
+
+  if (is_incoming(owner)) {
+    close_incoming_body(owner);
+  }
   return true;
 }
 
@@ -1109,6 +2162,31 @@ bool RequestOrResponse::maybe_stream_body(JSContext *cx, JS::HandleObject body_o
   return true;
 }
 
+/**
+ * The JSAPI only creates default streams, so this goes through the ReadableStream constructor,
+ * with `source` marked as a byte source.
+ */
+JSObject *RequestOrResponse::new_byte_stream(JSContext *cx, JS::HandleObject source) {
+  JS::RootedString type(cx, JS_NewStringCopyZ(cx, "bytes"));
+  if (!type || !JS_DefineProperty(cx, source, "type", type, JSPROP_READONLY)) {
+    return nullptr;
+  }
+  JS::RootedObject strategy(cx, JS_NewPlainObject(cx));
+  if (!strategy || !JS_DefineProperty(cx, strategy, "highWaterMark", 0, JSPROP_ENUMERATE)) {
+    return nullptr;
+  }
+
+  JS::RootedValue ctor(cx, JS::ObjectValue(*READABLE_STREAM));
+  JS::RootedValueArray<2> args(cx);
+  args[0].setObject(*source);
+  args[1].setObject(*strategy);
+  JS::RootedObject stream(cx);
+  if (!JS::Construct(cx, ctor, args, &stream)) {
+    return nullptr;
+  }
+  return stream;
+}
+
 JSObject *RequestOrResponse::create_body_stream(JSContext *cx, JS::HandleObject owner) {
   MOZ_ASSERT(is_instance(owner));
   MOZ_ASSERT(!body_stream(owner));
@@ -1122,7 +2200,13 @@ JSObject *RequestOrResponse::create_body_stream(JSContext *cx, JS::HandleObject
   // pull. With the default HWM of 1.0, the streams implementation causes a
   // pull, which means we enqueue a read from the host handle, which we quite
   // often have no interest in at all.
-  JS::RootedObject body_stream(cx, JS::NewReadableDefaultStreamObject(cx, source, nullptr, 0.0));
+  //
+  // Incoming bodies are byte streams, so that content can read them into its own buffers with a
+  // BYOB reader, see `BodyFutureTask`.
+  JS::RootedObject body_stream(cx, is_incoming(owner)
+                                       ? new_byte_stream(cx, source)
+                                       : JS::NewReadableDefaultStreamObject(cx, source, nullptr,
+                                                                            0.0));
   if (!body_stream) {
     return nullptr;
   }
@@ -1143,7 +2227,17 @@ bool RequestOrResponse::body_get(JSContext *cx, JS::CallArgs args, JS::HandleObj
   }
 
   JS::RootedObject body_stream(cx, RequestOrResponse::body_stream(self));
-  if (!body_stream && create_if_undefined) {
+  if (!body_stream && create_if_undefined && body_used(self) && is_incoming(self)) {
+    // The body was read without a stream, see `read_all`. Content still gets one, locked as the
+    // body stream would be, but it mustn't read from the body itself.
+    body_stream = JS::NewReadableDefaultStreamObject(cx, nullptr, nullptr, 0.0);
+    if (!body_stream ||
+        !JS::ReadableStreamGetReader(cx, body_stream, JS::ReadableStreamReaderMode::Default)) {
+      return false;
+    }
+    JS_SetReservedSlot(self, static_cast<uint32_t>(Slots::BodyStream),
+                       JS::ObjectValue(*body_stream));
+  } else if (!body_stream && create_if_undefined) {
     body_stream = create_body_stream(cx, self);
     if (!body_stream)
       return false;
@@ -1153,6 +2247,57 @@ bool RequestOrResponse::body_get(JSContext *cx, JS::CallArgs args, JS::HandleObj
   return true;
 }
 
+bool RequestOrResponse::clone_body(JSContext *cx, JS::HandleObject self,
+                                   JS::MutableHandleObject clone_stream) {
+  MOZ_ASSERT(has_body(self));
+  JS::RootedObject stream(cx, body_stream(self));
+  const char *class_name = Request::is_instance(self) ? "Request" : "Response";
+
+  // 1.  Let « out1, out2 » be the result of teeing body’s stream.
+  if (body_used(self) || (stream && body_unusable(cx, stream))) {
+    JS_ReportErrorUTF8(cx, "%s.prototype.clone: the body has already been used", class_name);
+    return false;
+  }
+
+  // Bodies constructed from anything but a stream are written to the host right away, so they
+  // can't be read back.
+  if (!stream && !is_incoming(self)) {
+    JS_ReportErrorUTF8(cx,
+                       "%s.prototype.clone: the body can't be read. Construct the %s with a "
+                       "ReadableStream body to clone it",
+                       class_name, class_name);
+    return false;
+  }
+
+  JS::RootedObject out1(cx);
+  JS::RootedObject out2(cx);
+  if (is_incoming(self)) {
+    // The incoming body is read once, and each chunk enqueued into both bodies. Incoming body
+    // streams are byte streams, which `JS::ReadableStreamTee` can't handle, so this applies to
+    // bodies content has asked for as a stream already, too. Creating the tee locks that stream.
+    JS::RootedObject tee(cx, BodyTee::create(cx, self));
+    if (!tee) {
+      return false;
+    }
+    out1 = BodyTee::create_branch(cx, tee);
+    out2 = out1 ? BodyTee::create_branch(cx, tee) : nullptr;
+    if (!out2 || !tee_prefetched_body(cx, self, tee)) {
+      return false;
+    }
+    // Creating the tee marks the body as used, but content still reads it through `out1`.
+    JS::SetReservedSlot(self, static_cast<uint32_t>(Slots::BodyUsed), JS::FalseValue());
+  } else if (!JS::ReadableStreamTee(cx, stream, &out1, &out2)) {
+    return false;
+  }
+
+  // 2.  Set body’s stream to out1.
+  JS::SetReservedSlot(self, static_cast<uint32_t>(Slots::BodyStream), JS::ObjectValue(*out1));
+
+  // 3.  Return a body whose stream is out2 and other members are copied from body.
+  clone_stream.set(out2);
+  return true;
+}
+
 host_api::HttpRequest *Request::request_handle(JSObject *obj) {
   auto base = RequestOrResponse::handle(obj);
   return reinterpret_cast<host_api::HttpRequest *>(base);
@@ -1173,6 +2318,34 @@ JSObject *Request::response_promise(JSObject *obj) {
               .toObject();
 }
 
+JSObject *Request::signal(JSObject *obj) {
+  auto signal = JS::GetReservedSlot(obj, static_cast<uint32_t>(Slots::Signal));
+  return signal.isObject() ? &signal.toObject() : nullptr;
+}
+
+bool Request::add_abort_algorithm(JSContext *cx, JS::HandleObject self,
+                                  JS::HandleObject algorithm) {
+  JS::RootedObject signal(cx, Request::signal(self));
+  if (!abort::AbortSignal::add_algorithm(cx, signal, algorithm)) {
+    return false;
+  }
+  JS::SetReservedSlot(self, static_cast<uint32_t>(Slots::AbortAlgorithm),
+                      JS::ObjectValue(*algorithm));
+  return true;
+}
+
+bool Request::remove_abort_algorithm(JSContext *cx, JS::HandleObject self) {
+  auto slot = static_cast<uint32_t>(Slots::AbortAlgorithm);
+  JS::RootedValue algorithm_val(cx, JS::GetReservedSlot(self, slot));
+  if (!algorithm_val.isObject()) {
+    return true;
+  }
+  JS::SetReservedSlot(self, slot, JS::UndefinedValue());
+  JS::RootedObject signal(cx, Request::signal(self));
+  JS::RootedObject algorithm(cx, &algorithm_val.toObject());
+  return abort::AbortSignal::remove_algorithm(cx, signal, algorithm);
+}
+
 JSString *Request::method(JSContext *cx, JS::HandleObject obj) {
   return JS::GetReservedSlot(obj, static_cast<uint32_t>(Slots::Method)).toString();
 }
@@ -1195,6 +2368,23 @@ bool Request::url_get(JSContext *cx, unsigned argc, JS::Value *vp) {
   return true;
 }
 
+bool Request::signal_get(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+
+  // Requests created without a signal get one that's never aborted, created on first access.
+  JS::RootedObject signal(cx, Request::signal(self));
+  if (!signal) {
+    signal = abort::AbortSignal::create(cx);
+    if (!signal) {
+      return false;
+    }
+    JS::SetReservedSlot(self, static_cast<uint32_t>(Slots::Signal), JS::ObjectValue(*signal));
+  }
+
+  args.rval().setObject(*signal);
+  return true;
+}
+
 bool Request::headers_get(JSContext *cx, unsigned argc, JS::Value *vp) {
   METHOD_HEADER(0)
 
@@ -1225,131 +2415,78 @@ bool Request::bodyUsed_get(JSContext *cx, unsigned argc, JS::Value *vp) {
 
 JSString *GET_atom;
 
-// bool Request::clone(JSContext *cx, unsigned argc, JS::Value *vp) {
-//   METHOD_HEADER(0);
-
-//   auto hasBody = RequestOrResponse::has_body(self);
-
-//   if (hasBody) {
-//     if (RequestOrResponse::body_used(self)) {
-//       JS_ReportErrorLatin1(cx, "Request.prototype.clone: the request's body isn't usable.");
-//       return false;
-//     }
-
-//     // Here we get the current requests body stream and call ReadableStream.prototype.tee to
-//     return
-//     // two versions of the stream. Once we get the two streams, we create a new request handle
-//     and
-//     // attach one of the streams to the new handle and the other stream is attached to the
-//     request
-//     // handle that `clone()` was called upon.
-//     JS::RootedObject body_stream(cx, RequestOrResponse::body_stream(self));
-//     if (!body_stream) {
-//       body_stream = RequestOrResponse::create_body_stream(cx, self);
-//       if (!body_stream) {
-//         return false;
-//       }
-//     }
-//     JS::RootedValue tee_val(cx);
-//     if (!JS_GetProperty(cx, body_stream, "tee", &tee_val)) {
-//       return false;
-//     }
-//     JS::Rooted<JSFunction *> tee(cx, JS_GetObjectFunction(&tee_val.toObject()));
-//     if (!tee) {
-//       return false;
-//     }
-//     JS::RootedVector<JS::Value> argv(cx);
-//     JS::RootedValue rval(cx);
-//     if (!JS::Call(cx, body_stream, tee, argv, &rval)) {
-//       return false;
-//     }
-//     JS::RootedObject rval_array(cx, &rval.toObject());
-//     JS::RootedValue body1_val(cx);
-//     if (!JS_GetProperty(cx, rval_array, "0", &body1_val)) {
-//       return false;
-//     }
-//     JS::RootedValue body2_val(cx);
-//     if (!JS_GetProperty(cx, rval_array, "1", &body2_val)) {
-//       return false;
-//     }
-
-//     auto res = host_api::HttpBody::make(request_handle);
-//     if (auto *err = res.to_err()) {
-//       HANDLE_ERROR(cx, *err);
-//       return false;
-//     }
-
-//     auto body_handle = res.unwrap();
-//     if (!JS::IsReadableStream(&body1_val.toObject())) {
-//       return false;
-//     }
-//     body_stream.set(&body1_val.toObject());
-//     if (RequestOrResponse::body_unusable(cx, body_stream)) {
-//       JS_ReportErrorLatin1(cx, "Can't use a ReadableStream that's locked or has ever been "
-//                                "read from or canceled as a Request body.");
-//       return false;
-//     }
-
-//     JS::SetReservedSlot(requestInstance, static_cast<uint32_t>(Slots::Body),
-//                         JS::Int32Value(body_handle.handle));
-//     JS::SetReservedSlot(requestInstance, static_cast<uint32_t>(Slots::BodyStream), body1_val);
-
-//     JS::SetReservedSlot(self, static_cast<uint32_t>(Slots::BodyStream), body2_val);
-//     JS::SetReservedSlot(self, static_cast<uint32_t>(Slots::BodyUsed), JS::FalseValue());
-//     JS::SetReservedSlot(self, static_cast<uint32_t>(Slots::HasBody), JS::BooleanValue(true));
-//   }
-
-//   JS::RootedObject headers(cx);
-//   JS::RootedObject headers_obj(
-//       cx, RequestOrResponse::headers(cx, self));
-//   if (!headers_obj) {
-//     return false;
-//   }
-//   JS::RootedObject headersInstance(
-//       cx, JS_NewObjectWithGivenProto(cx, &Headers::class_, Headers::proto_obj));
-//   if (!headersInstance)
-//     return false;
-
-//   headers = Headers::create(cx, headersInstance, Headers::Mode::ProxyToRequest,
-//                                       requestInstance, headers_obj);
-
-//   if (!headers) {
-//     return false;
-//   }
+// https://fetch.spec.whatwg.org/#dom-request-clone
+bool Request::clone(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
 
-//   JS::SetReservedSlot(requestInstance, static_cast<uint32_t>(Slots::Headers),
-//                       JS::ObjectValue(*headers));
+  // 1.  If this is unusable, then throw a TypeError.
+  // 2.  Let clonedRequest be the result of cloning this’s request.
+  JS::RootedObject body_stream(cx);
+  if (RequestOrResponse::has_body(self) &&
+      !RequestOrResponse::clone_body(cx, self, &body_stream)) {
+    return false;
+  }
 
-//   JSString *method = Request::method(cx, self);
-//   if (!method) {
-//     return false;
-//   }
+  JS::RootedString method_str(cx, Request::method(cx, self));
+  bool is_get;
+  if (!JS_StringEqualsLiteral(cx, method_str, "GET", &is_get)) {
+    return false;
+  }
+  host_api::HostString method;
+  if (!is_get) {
+    method = core::encode(cx, method_str);
+    if (!method) {
+      return false;
+    }
+  }
+  JS::RootedValue url_val(cx, RequestOrResponse::url(self));
+  auto url = core::encode(cx, url_val);
+  if (!url) {
+    return false;
+  }
 
-//   JS::SetReservedSlot(requestInstance, static_cast<uint32_t>(Slots::Method),
-//                       JS::StringValue(method));
+  // The clone gets its own copy of the header list, whichever way the original's was created.
+  auto *headers = new host_api::HttpHeaders(*RequestOrResponse::headers_handle(self));
+  auto *request_handle = host_api::HttpOutgoingRequest::make(method, std::move(url), headers);
 
-//   auto *request_handle_res = new host_api::HttpOutgoingRequest()
-//   if (auto *err = request_handle_res.to_err()) {
-//     HANDLE_ERROR(cx, *err);
-//     return false;
-//   }
+  // 3.  Let clonedRequestObject be the result of creating a Request object, given clonedRequest,
+  //     this’s headers’s guard, and this’s relevant Realm.
+  JS::RootedObject instance(cx, create_instance(cx));
+  if (!instance) {
+    return false;
+  }
+  JS::RootedObject clone(cx, create(cx, instance, request_handle));
+  if (!clone) {
+    return false;
+  }
+  RequestOrResponse::set_url(clone, url_val);
+  JS::SetReservedSlot(clone, static_cast<uint32_t>(Slots::Method), JS::StringValue(method_str));
 
-//   auto request_handle = request_handle_res.unwrap();
+  // 4.  Make clonedRequestObject’s signal follow this’s signal.
+  JS::RootedObject signal(cx, Request::signal(self));
+  if (signal) {
+    JS::RootedObjectVector sources(cx);
+    if (!sources.append(signal)) {
+      JS_ReportOutOfMemory(cx);
+      return false;
+    }
+    signal = abort::AbortSignal::create_dependent(cx, sources);
+    if (!signal) {
+      return false;
+    }
+    JS::SetReservedSlot(clone, static_cast<uint32_t>(Slots::Signal), JS::ObjectValue(*signal));
+  }
 
-//   JS::RootedObject requestInstance(cx, Request::create_instance(cx));
-//   JS::SetReservedSlot(requestInstance, static_cast<uint32_t>(Slots::Request),
-//                       JS::Int32Value(request_handle.handle));
-//   JS::SetReservedSlot(requestInstance, static_cast<uint32_t>(Slots::BodyUsed),
-//                       JS::FalseValue());
-//   JS::SetReservedSlot(
-//       requestInstance, static_cast<uint32_t>(Slots::URL),
-//       JS::GetReservedSlot(self, static_cast<uint32_t>(Slots::URL)));
-//   JS::SetReservedSlot(requestInstance, static_cast<uint32_t>(Slots::HasBody),
-//                       JS::BooleanValue(hasBody));
+  if (body_stream) {
+    JS::SetReservedSlot(clone, static_cast<uint32_t>(Slots::BodyStream),
+                        JS::ObjectValue(*body_stream));
+    JS::SetReservedSlot(clone, static_cast<uint32_t>(Slots::HasBody), JS::TrueValue());
+  }
 
-//   args.rval().setObject(*requestInstance);
-//   return true;
-// }
+  // 5.  Return clonedRequestObject.
+  args.rval().setObject(*clone);
+  return true;
+}
 
 const JSFunctionSpec Request::static_methods[] = {
     JS_FS_END,
@@ -1364,7 +2501,9 @@ const JSFunctionSpec Request::methods[] = {
           JSPROP_ENUMERATE),
     JS_FN("json", Request::bodyAll<RequestOrResponse::BodyReadResult::JSON>, 0, JSPROP_ENUMERATE),
     JS_FN("text", Request::bodyAll<RequestOrResponse::BodyReadResult::Text>, 0, JSPROP_ENUMERATE),
-    // JS_FN("clone", Request::clone, 0, JSPROP_ENUMERATE),
+    JS_FN("formData", Request::bodyAll<RequestOrResponse::BodyReadResult::FormData>, 0,
+          JSPROP_ENUMERATE),
+    JS_FN("clone", Request::clone, 0, JSPROP_ENUMERATE),
     JS_FS_END,
 };
 
@@ -1372,12 +2511,19 @@ const JSPropertySpec Request::properties[] = {
     JS_PSG("method", Request::method_get, JSPROP_ENUMERATE),
     JS_PSG("url", Request::url_get, JSPROP_ENUMERATE),
     JS_PSG("headers", Request::headers_get, JSPROP_ENUMERATE),
+    JS_PSG("signal", Request::signal_get, JSPROP_ENUMERATE),
     JS_PSG("body", Request::body_get, JSPROP_ENUMERATE),
     JS_PSG("bodyUsed", Request::bodyUsed_get, JSPROP_ENUMERATE),
     JS_STRING_SYM_PS(toStringTag, "Request", JSPROP_READONLY),
     JS_PS_END,
 };
 
+void Request::finalize(JS::GCContext *gcx, JSObject *self) {
+  // A prefetch task that's still reading keeps its owner alive, so it's idle by now and can go if
+  // the body was never consumed.
+  std::ignore = take_prefetch_task(self);
+}
+
 bool Request::init_class(JSContext *cx, JS::HandleObject global) {
   if (!init_class_impl(cx, global)) {
     return false;
@@ -1417,7 +2563,7 @@ JSObject *Request::create(JSContext *cx, JS::HandleObject requestInstance, JS::H
   bool method_needs_normalization = false;
 
   JS::RootedObject input_request(cx);
-  JS::RootedObject input_headers(cx);
+  JS::RootedObject signal(cx);
   bool input_has_body = false;
 
   // 1.  Let `request` be null.
@@ -1442,7 +2588,7 @@ JSObject *Request::create(JSContext *cx, JS::HandleObject requestInstance, JS::H
     // (implicit)
 
     // 3.  Set `signal` to `input`’s signal.
-    // (signals not yet supported)
+    signal = Request::signal(input_request);
 
     // 12.  Set `request` to a new request with the following properties:
     // (moved into step 6 because we can leave everything at the default values
@@ -1464,7 +2610,6 @@ JSObject *Request::create(JSContext *cx, JS::HandleObject requestInstance, JS::H
 
     // header list: A copy of `request`’s header list.
     // Note: copying the headers is postponed, see step 32 below.
-    input_headers = RequestOrResponse::maybe_headers(input_request);
 
     // The following properties aren't applicable:
     // unsafe-request flag: Set.
@@ -1530,6 +2675,7 @@ JSObject *Request::create(JSContext *cx, JS::HandleObject requestInstance, JS::H
   JS::RootedValue method_val(cx);
   JS::RootedValue headers_val(cx);
   JS::RootedValue body_val(cx);
+  JS::RootedValue signal_val(cx);
 
   bool is_get = true;
   bool is_get_or_head = is_get;
@@ -1539,7 +2685,8 @@ JSObject *Request::create(JSContext *cx, JS::HandleObject requestInstance, JS::H
     JS::RootedObject init(cx, init_val.toObjectOrNull());
     if (!JS_GetProperty(cx, init, "method", &method_val) ||
         !JS_GetProperty(cx, init, "headers", &headers_val) ||
-        !JS_GetProperty(cx, init, "body", &body_val)) {
+        !JS_GetProperty(cx, init, "body", &body_val) ||
+        !JS_GetProperty(cx, init, "signal", &signal_val)) {
       return nullptr;
     }
   } else if (!init_val.isNullOrUndefined()) {
@@ -1649,7 +2796,16 @@ JSObject *Request::create(JSContext *cx, JS::HandleObject requestInstance, JS::H
   }
 
   // 26.  If `init["signal"]` exists, then set `signal` to it.
-  // (signals NYI)
+  if (!signal_val.isUndefined()) {
+    if (signal_val.isNull()) {
+      signal = nullptr;
+    } else if (abort::AbortSignal::is_instance(signal_val)) {
+      signal = &signal_val.toObject();
+    } else {
+      JS_ReportErrorLatin1(cx, "Request constructor: |signal| must be an AbortSignal");
+      return nullptr;
+    }
+  }
 
   // 27.  Set this’s request to `request`.
   // (implicit)
@@ -1657,7 +2813,18 @@ JSObject *Request::create(JSContext *cx, JS::HandleObject requestInstance, JS::H
   // 28.  Set this’s signal to a new `AbortSignal` object with this’s relevant
   // Realm.
   // 29.  If `signal` is not null, then make this’s signal follow `signal`.
-  // (signals NYI)
+  // Requests without a signal to follow only get one if content asks for it, see `signal_get`.
+  if (signal) {
+    JS::RootedObjectVector sources(cx);
+    if (!sources.append(signal)) {
+      JS_ReportOutOfMemory(cx);
+      return nullptr;
+    }
+    signal = abort::AbortSignal::create_dependent(cx, sources);
+    if (!signal) {
+      return nullptr;
+    }
+  }
 
   // 30.  Set this’s headers to a new `Headers` object with this’s relevant
   // Realm, whose header list is `request`’s header list and guard is
@@ -1685,22 +2852,33 @@ JSObject *Request::create(JSContext *cx, JS::HandleObject requestInstance, JS::H
   // `init["headers"]` exists, create the request's `headers` from that,
   // otherwise create it from the `init` object's `headers`, or create a new,
   // empty one.
-  auto *headers_handle = new host_api::HttpHeaders();
+  //
+  // The headers are first collected JS-side, and then passed to the host in a single call. If they
+  // come from an input Request, they're instead copied from its host-side header list, which always
+  // reflects changes made through its `headers` object. That takes a single host call, and leaves
+  // reifying the new request's `headers` until content asks for them. This makes forwarding a
+  // request, e.g. with `fetch(event.request)`, cheap.
+  host_api::HttpHeaders *headers_handle = nullptr;
   JS::RootedObject headers(cx);
 
-  if (headers_val.isUndefined() && input_headers) {
-    headers_val.setObject(*input_headers);
-  }
-  if (!headers_val.isUndefined()) {
+  if (headers_val.isUndefined() && input_request) {
+    headers_handle = new host_api::HttpHeaders(*RequestOrResponse::headers_handle(input_request));
+  } else if (!headers_val.isUndefined()) {
     JS::RootedObject headersInstance(
         cx, JS_NewObjectWithGivenProto(cx, &Headers::class_, Headers::proto_obj));
     if (!headersInstance)
       return nullptr;
 
-    headers = Headers::create(cx, headersInstance, headers_handle, headers_val);
+    headers = Headers::create(cx, headersInstance, nullptr, headers_val);
     if (!headers) {
       return nullptr;
     }
+    headers_handle = Headers::create_handle(cx, headers);
+    if (!headers_handle) {
+      return nullptr;
+    }
+  } else {
+    headers_handle = new host_api::HttpHeaders();
   }
 
   // 33.  Let `inputBody` be `input`’s requests body if `input` is a `Request`
@@ -1747,6 +2925,9 @@ JSObject *Request::create(JSContext *cx, JS::HandleObject requestInstance, JS::H
   }
   JS::SetReservedSlot(request, static_cast<uint32_t>(Slots::Headers),
                       JS::ObjectOrNullValue(headers));
+  if (signal) {
+    JS::SetReservedSlot(request, static_cast<uint32_t>(Slots::Signal), JS::ObjectValue(*signal));
+  }
 
   // 36.  If `init["body"]` exists and is non-null, then:
   if (!body_val.isNullOrUndefined()) {
@@ -1797,7 +2978,9 @@ JSObject *Request::create(JSContext *cx, JS::HandleObject requestInstance, JS::H
       // content can't have access to it. Instead of reifying it here to pass it
       // into a TransformStream, we just append the body on the host side and
       // mark it as used on the input Request.
-      RequestOrResponse::append_body(cx, request, input_request);
+      if (!RequestOrResponse::append_body(cx, request, input_request)) {
+        return nullptr;
+      }
     } else {
       inputBody = streams::TransformStream::create_rs_proxy(cx, inputBody);
       if (!inputBody) {
@@ -2247,166 +3430,115 @@ bool Response::bodyUsed_get(JSContext *cx, unsigned argc, JS::Value *vp) {
 //   return true;
 // }
 
-// namespace {
-// bool callbackCalled;
-// bool write_json_to_buf(const char16_t *str, uint32_t strlen, void *out) {
-//   callbackCalled = true;
-//   auto outstr = static_cast<std::u16string *>(out);
-//   outstr->append(str, strlen);
-
-//   return true;
-// }
-// } // namespace
-
-// bool Response::json(JSContext *cx, unsigned argc, JS::Value *vp) {
-//   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
-//   if (!args.requireAtLeast(cx, "json", 1)) {
-//     return false;
-//   }
-//   JS::RootedValue data(cx, args.get(0));
-//   JS::RootedValue init_val(cx, args.get(1));
-//   JS::RootedObject replacer(cx);
-//   JS::RootedValue space(cx);
-
-//   std::u16string out;
-//   // 1. Let bytes the result of running serialize a JavaScript value to JSON bytes on data.
-//   callbackCalled = false;
-//   if (!JS::ToJSON(cx, data, replacer, space, &write_json_to_buf, &out)) {
-//     return false;
-//   }
-//   if (!callbackCalled) {
-//     JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_RESPONSE_JSON_INVALID_VALUE);
-//     return false;
-//   }
-//   // 2. Let body be the result of extracting bytes.
-
-//   // 3. Let responseObject be the result of creating a Response object, given a new response,
-//   // "response", and this’s relevant Realm.
-//   JS::RootedValue status_val(cx);
-//   uint16_t status = 200;
-
-//   JS::RootedValue statusText_val(cx);
-//   JS::RootedString statusText(cx, JS_GetEmptyString(cx));
-//   JS::RootedValue headers_val(cx);
-
-//   if (init_val.isObject()) {
-//     JS::RootedObject init(cx, init_val.toObjectOrNull());
-//     if (!JS_GetProperty(cx, init, "status", &status_val) ||
-//         !JS_GetProperty(cx, init, "statusText", &statusText_val) ||
-//         !JS_GetProperty(cx, init, "headers", &headers_val)) {
-//       return false;
-//     }
-
-//     if (!status_val.isUndefined() && !JS::ToUint16(cx, status_val, &status)) {
-//       return false;
-//     }
-
-//     if (status == 204 || status == 205 || status == 304) {
-//       JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr,
-//                                 JSMSG_RESPONSE_NULL_BODY_STATUS_WITH_BODY);
-//       return false;
-//     }
-
-//     if (!statusText_val.isUndefined() && !(statusText = JS::ToString(cx, statusText_val))) {
-//       return false;
-//     }
+// https://fetch.spec.whatwg.org/#dom-response-json
+bool Response::json(JSContext *cx, unsigned argc, JS::Value *vp) {
+  REQUEST_HANDLER_ONLY("Response.json");
 
-//   } else if (!init_val.isNullOrUndefined()) {
-//     JS_ReportErrorLatin1(cx, "Response constructor: |init| parameter can't be converted to "
-//                              "a dictionary");
-//     return false;
-//   }
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  if (!args.requireAtLeast(cx, "Response.json", 1)) {
+    return false;
+  }
+  JS::RootedValue data(cx, args.get(0));
+  JS::RootedValue init_val(cx, args.get(1));
 
-//   auto response_handle_res = host_api::HttpResp::make();
-//   if (auto *err = response_handle_res.to_err()) {
-//     HANDLE_ERROR(cx, *err);
-//     return false;
-//   }
+  // 1. Let bytes the result of running serialize a JavaScript value to JSON bytes on data.
+  // The text is encoded to UTF-8 as it's serialized, and only written to the body once the
+  // response exists, so that serialization errors are reported before any of `init` is read, and
+  // no host response is created for them.
+  Utf8BodyWriter json;
+  JS::RootedObject replacer(cx);
+  JS::RootedValue space(cx);
+  if (!JS::ToJSON(cx, data, replacer, space, &write_json_chars, &json)) {
+    return false;
+  }
+  // Collecting the encoded text can't fail.
+  std::ignore = json.finish();
+  // JSON text is never empty, so nothing was written if `data` can't be serialized, e.g. because
+  // it's `undefined`.
+  if (json.written() == 0) {
+    JS_ReportErrorLatin1(cx, "Response.json: data can't be serialized to JSON");
+    return false;
+  }
 
-//   auto response_handle = response_handle_res.unwrap();
-//   if (!response_handle.is_valid()) {
-//     return false;
-//   }
+  // 3. Let responseObject be the result of creating a Response object, given a new response,
+  // "response", and this's relevant Realm.
+  // 4. Perform initialize a response given responseObject, init, and (body, "application/json").
+  JS::RootedObject instance(cx, JS_NewObjectWithGivenProto(cx, &class_, proto_obj));
+  if (!instance) {
+    return false;
+  }
+  JS::RootedObject response(cx, initialize(cx, instance, init_val, "Response.json"));
+  if (!response) {
+    return false;
+  }
+  auto status = Response::status(response);
+  if (status == 204 || status == 205 || status == 304) {
+    JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr,
+                              JSMSG_RESPONSE_NULL_BODY_STATUS_WITH_BODY);
+    return false;
+  }
 
-//   auto make_res = host_api::HttpBody::make(response_handle);
-//   if (auto *err = make_res.to_err()) {
-//     HANDLE_ERROR(cx, *err);
-//     return false;
-//   }
+  // 2. Let body be the result of extracting bytes.
+  if (!json.write_collected(RequestOrResponse::outgoing_body_handle(response))) {
+    return json.report_error(cx);
+  }
 
-//   auto body = make_res.unwrap();
-//   JS::RootedString string(cx, JS_NewUCStringCopyN(cx, out.c_str(), out.length()));
-//   auto stringChars = core::encode(cx, string);
+  JS::RootedObject headers(cx, RequestOrResponse::headers(cx, response));
+  if (!headers || !Headers::maybe_add(cx, headers, "content-type", "application/json")) {
+    return false;
+  }
+  JS::SetReservedSlot(response, static_cast<uint32_t>(Slots::HasBody), JS::TrueValue());
 
-//   auto write_res =
-//       body.write_all(reinterpret_cast<uint8_t *>(stringChars.begin()), stringChars.len);
-//   if (auto *err = write_res.to_err()) {
-//     HANDLE_ERROR(cx, *err);
-//     return false;
-//   }
-//   JS::RootedObject response_instance(cx, JS_NewObjectWithGivenProto(cx, &Response::class_,
-//                                                                     Response::proto_obj));
-//   if (!response_instance) {
-//     return false;
-//   }
-//   JS::RootedObject response(cx, create(cx, response_instance, response_handle,
-//                                        body, false));
-//   if (!response) {
-//     return false;
-//   }
+  // 5. Return responseObject.
+  args.rval().setObject(*response);
+  return true;
+}
 
-//   // Set `this`’s `response`’s `status` to `init`["status"].
-//   auto set_res = response_handle.set_status(status);
-//   if (auto *err = set_res.to_err()) {
-//     HANDLE_ERROR(cx, *err);
-//     return false;
-//   }
-//   // To ensure that we really have the same status value as the host,
-//   // we always read it back here.
-//   auto get_res = response_handle.get_status();
-//   if (auto *err = get_res.to_err()) {
-//     HANDLE_ERROR(cx, *err);
-//     return false;
-//   }
-//   status = get_res.unwrap();
+// https://fetch.spec.whatwg.org/#dom-response-clone
+bool Response::clone(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
 
-//   JS::SetReservedSlot(response, static_cast<uint32_t>(Slots::Status), JS::Int32Value(status));
+  // 1.  If this is unusable, then throw a TypeError.
+  // 2.  Let clonedResponse be the result of cloning this’s response.
+  JS::RootedObject body_stream(cx);
+  if (RequestOrResponse::has_body(self) &&
+      !RequestOrResponse::clone_body(cx, self, &body_stream)) {
+    return false;
+  }
 
-//   // Set `this`’s `response`’s `status message` to `init`["statusText"].
-//   JS::SetReservedSlot(response, static_cast<uint32_t>(Slots::StatusMessage),
-//                       JS::StringValue(statusText));
+  // The clone gets its own copy of the header list, whichever way the original's was created.
+  auto *headers = new host_api::HttpHeaders(*RequestOrResponse::headers_handle(self));
+  auto *response_handle = host_api::HttpOutgoingResponse::make(status(self), headers);
 
-//   // If `init`["headers"] `exists`, then `fill` `this`’s `headers` with
-//   // `init`["headers"].
-//   JS::RootedObject headers(cx);
-//   JS::RootedObject headersInstance(
-//       cx, JS_NewObjectWithGivenProto(cx, &Headers::class_, Headers::proto_obj));
-//   if (!headersInstance)
-//     return false;
+  // 3.  Return the result of creating a Response object, given clonedResponse, this’s headers’s
+  //     guard, and this’s relevant Realm.
+  JS::RootedObject instance(cx, JS_NewObjectWithGivenProto(cx, &class_, proto_obj));
+  if (!instance) {
+    return false;
+  }
+  JS::RootedObject clone(cx, create(cx, instance, response_handle));
+  if (!clone) {
+    return false;
+  }
+  RequestOrResponse::set_url(clone, RequestOrResponse::url(self));
+  for (auto slot : {Slots::Status, Slots::StatusMessage, Slots::Redirected}) {
+    JS::SetReservedSlot(clone, static_cast<uint32_t>(slot),
+                        JS::GetReservedSlot(self, static_cast<uint32_t>(slot)));
+  }
 
-//   headers = Headers::create(cx, headersInstance, Headers::Mode::ProxyToResponse,
-//                                       response, headers_val);
-//   if (!headers) {
-//     return false;
-//   }
-//   // 4. Perform initialize a response given responseObject, init, and (body, "application/json").
-//   if (!Headers::maybe_add(cx, headers, "content-type", "application/json")) {
-//     return false;
-//   }
-//   JS::SetReservedSlot(response, static_cast<uint32_t>(Slots::Headers),
-//   JS::ObjectValue(*headers)); JS::SetReservedSlot(response,
-//   static_cast<uint32_t>(Slots::Redirected), JS::FalseValue()); JS::SetReservedSlot(response,
-//   static_cast<uint32_t>(Slots::HasBody), JS::TrueValue()); RequestOrResponse::set_url(response,
-//   JS_GetEmptyStringValue(cx));
+  if (body_stream) {
+    JS::SetReservedSlot(clone, static_cast<uint32_t>(Slots::BodyStream),
+                        JS::ObjectValue(*body_stream));
+    JS::SetReservedSlot(clone, static_cast<uint32_t>(Slots::HasBody), JS::TrueValue());
+  }
 
-//   // 5. Return responseObject.
-//   args.rval().setObjectOrNull(response);
-//   return true;
-// }
+  args.rval().setObject(*clone);
+  return true;
+}
 
 const JSFunctionSpec Response::static_methods[] = {
     // JS_FN("redirect", redirect, 1, JSPROP_ENUMERATE),
-    // JS_FN("json", json, 1, JSPROP_ENUMERATE),
+    JS_FN("json", json, 1, JSPROP_ENUMERATE),
     JS_FS_END,
 };
 
@@ -2419,6 +3551,9 @@ const JSFunctionSpec Response::methods[] = {
           JSPROP_ENUMERATE),
     JS_FN("json", bodyAll<RequestOrResponse::BodyReadResult::JSON>, 0, JSPROP_ENUMERATE),
     JS_FN("text", bodyAll<RequestOrResponse::BodyReadResult::Text>, 0, JSPROP_ENUMERATE),
+    JS_FN("formData", bodyAll<RequestOrResponse::BodyReadResult::FormData>, 0,
+          JSPROP_ENUMERATE),
+    JS_FN("clone", clone, 0, JSPROP_ENUMERATE),
     JS_FS_END,
 };
 
@@ -2436,56 +3571,87 @@ const JSPropertySpec Response::properties[] = {
     JS_PS_END,
 };
 
-/**
- * The `Response` constructor https://fetch.spec.whatwg.org/#dom-response
- */
-bool Response::constructor(JSContext *cx, unsigned argc, JS::Value *vp) {
-  REQUEST_HANDLER_ONLY("The Response builtin");
-
-  CTOR_HEADER("Response", 0);
-
-  JS::RootedValue body_val(cx, args.get(0));
-  JS::RootedValue init_val(cx, args.get(1));
+/// Whether `linear` matches the `reason-phrase` production: *( HTAB / SP / VCHAR / obs-text ).
+static bool is_reason_phrase(JSLinearString *linear) {
+  size_t len = JS::GetLinearStringLength(linear);
+  for (size_t i = 0; i < len; i++) {
+    char16_t c = JS::GetLinearStringCharAt(linear, i);
+    if (c != '\t' && (c < 0x20 || c == 0x7F || c > 0xFF)) {
+      return false;
+    }
+  }
+  return true;
+}
 
+bool Response::read_init(JSContext *cx, JS::HandleValue init_val, const char *fun_name,
+                         uint16_t *status, JS::MutableHandleString status_text,
+                         JS::MutableHandleValue headers_val) {
   JS::RootedValue status_val(cx);
-  uint16_t status = 200;
-
-  JS::RootedValue statusText_val(cx);
-  JS::RootedString statusText(cx, JS_GetEmptyString(cx));
-  JS::RootedValue headers_val(cx);
+  JS::RootedValue status_text_val(cx);
+  *status = 200;
+  status_text.set(JS_GetEmptyString(cx));
+  headers_val.setUndefined();
 
   if (init_val.isObject()) {
-    JS::RootedObject init(cx, init_val.toObjectOrNull());
+    JS::RootedObject init(cx, &init_val.toObject());
     if (!JS_GetProperty(cx, init, "status", &status_val) ||
-        !JS_GetProperty(cx, init, "statusText", &statusText_val) ||
-        !JS_GetProperty(cx, init, "headers", &headers_val)) {
+        !JS_GetProperty(cx, init, "statusText", &status_text_val) ||
+        !JS_GetProperty(cx, init, "headers", headers_val)) {
       return false;
     }
 
-    if (!status_val.isUndefined() && !JS::ToUint16(cx, status_val, &status)) {
+    if (!status_val.isUndefined() && !JS::ToUint16(cx, status_val, status)) {
       return false;
     }
 
-    if (!statusText_val.isUndefined() && !(statusText = JS::ToString(cx, statusText_val))) {
-      return false;
+    if (!status_text_val.isUndefined()) {
+      status_text.set(JS::ToString(cx, status_text_val));
+      if (!status_text) {
+        return false;
+      }
     }
-
   } else if (!init_val.isNullOrUndefined()) {
-    JS_ReportErrorLatin1(cx, "Response constructor: |init| parameter can't be converted to "
-                             "a dictionary");
+    JS_ReportErrorUTF8(cx, "%s: |init| parameter can't be converted to a dictionary", fun_name);
     return false;
   }
 
   // 1.  If `init`["status"] is not in the range 200 to 599, inclusive, then
   // `throw` a ``RangeError``.
-  if (status < 200 || status > 599) {
-    JS_ReportErrorLatin1(cx, "Response constructor: invalid status %u", status);
+  if (*status < 200 || *status > 599) {
+    auto status_str = std::to_string(*status);
+    JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_RESPONSE_INVALID_STATUS,
+                              fun_name, status_str.c_str());
     return false;
   }
 
   // 2.  If `init`["statusText"] does not match the `reason-phrase` token
-  // production, then `throw` a ``TypeError``. Skipped: the statusText can only
-  // be consumed by the content creating it, so we're lenient about its format.
+  // production, then `throw` a ``TypeError``.
+  JSLinearString *linear = JS_EnsureLinearString(cx, status_text);
+  if (!linear) {
+    return false;
+  }
+  if (!is_reason_phrase(linear)) {
+    JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_RESPONSE_INVALID_STATUS_TEXT,
+                              fun_name);
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Steps 1-7 of the `Response` constructor https://fetch.spec.whatwg.org/#dom-response, which
+ * `Response.json` shares as the "initialize a response" algorithm.
+ */
+JSObject *Response::initialize(JSContext *cx, JS::HandleObject instance,
+                               JS::HandleValue init_val, const char *fun_name) {
+  uint16_t status;
+  JS::RootedString statusText(cx);
+  JS::RootedValue headers_val(cx);
+  // Steps 1 and 2 validate the status and statusText, which `read_init` does.
+  if (!read_init(cx, init_val, fun_name, &status, &statusText, &headers_val)) {
+    return nullptr;
+  }
 
   // 3.  Set `this`’s `response` to a new `response`.
   // TODO(performance): consider not creating a host-side representation for responses
@@ -2497,6 +3663,7 @@ bool Response::constructor(JSContext *cx, unsigned argc, JS::Value *vp) {
   // TODO(performance): enable creating Response objects during the init phase, and only
   // creating the host-side representation when processing requests.
   // https://github.com/fastly/js-compute-runtime/issues/220
+  // Static responses can be prepared during the init phase as `ResponseTemplate`s instead.
 
   // 5. (Reordered) Set `this`’s `response`’s `status` to `init`["status"].
 
@@ -2506,23 +3673,22 @@ bool Response::constructor(JSContext *cx, unsigned argc, JS::Value *vp) {
   JS::RootedObject headersInstance(
       cx, JS_NewObjectWithGivenProto(cx, &Headers::class_, Headers::proto_obj));
   if (!headersInstance)
-    return false;
+    return nullptr;
 
-  auto *headers_handle = new host_api::HttpHeaders();
-  headers = Headers::create(cx, headersInstance, headers_handle, headers_val);
+  headers = Headers::create(cx, headersInstance, nullptr, headers_val);
   if (!headers) {
-    return false;
+    return nullptr;
+  }
+  auto *headers_handle = Headers::create_handle(cx, headers);
+  if (!headers_handle) {
+    return nullptr;
   }
 
   auto *response_handle = host_api::HttpOutgoingResponse::make(status, headers_handle);
 
-  JS::RootedObject responseInstance(cx, JS_NewObjectForConstructor(cx, &class_, args));
-  if (!responseInstance) {
-    return false;
-  }
-  JS::RootedObject response(cx, create(cx, responseInstance, response_handle));
+  JS::RootedObject response(cx, create(cx, instance, response_handle));
   if (!response) {
-    return false;
+    return nullptr;
   }
 
   JS::SetReservedSlot(response, static_cast<uint32_t>(Slots::Headers), JS::ObjectValue(*headers));
@@ -2551,13 +3717,38 @@ bool Response::constructor(JSContext *cx, unsigned argc, JS::Value *vp) {
   JS::SetReservedSlot(response, static_cast<uint32_t>(Slots::StatusMessage),
                       JS::StringValue(statusText));
 
+  return response;
+}
+
+/**
+ * The `Response` constructor https://fetch.spec.whatwg.org/#dom-response
+ */
+bool Response::constructor(JSContext *cx, unsigned argc, JS::Value *vp) {
+  REQUEST_HANDLER_ONLY("The Response builtin");
+
+  CTOR_HEADER("Response", 0);
+
+  JS::RootedValue body_val(cx, args.get(0));
+  JS::RootedValue init_val(cx, args.get(1));
+
+  JS::RootedObject responseInstance(cx, JS_NewObjectForConstructor(cx, &class_, args));
+  if (!responseInstance) {
+    return false;
+  }
+  JS::RootedObject response(cx,
+                            initialize(cx, responseInstance, init_val, "Response constructor"));
+  if (!response) {
+    return false;
+  }
+  uint16_t status = Response::status(response);
+
   // 8.  If `body` is non-null, then:
   if ((!body_val.isNullOrUndefined())) {
     //     1.  If `init`["status"] is a `null body status`, then `throw` a
     //     ``TypeError``.
     if (status == 204 || status == 205 || status == 304) {
-      JS_ReportErrorLatin1(cx, "Response constructor: Response body is given "
-                               "with a null body status.");
+      JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr,
+                                JSMSG_RESPONSE_NULL_BODY_STATUS_WITH_BODY);
       return false;
     }
 
@@ -2574,6 +3765,8 @@ bool Response::constructor(JSContext *cx, unsigned argc, JS::Value *vp) {
       return false;
     }
     if (RequestOrResponse::has_body(response)) {
+      auto *response_handle =
+          static_cast<host_api::HttpOutgoingResponse *>(Response::response_handle(response));
       if (response_handle->body().is_err()) {
         auto err = response_handle->body().to_err();
         HANDLE_ERROR(cx, *err);
@@ -2626,11 +3819,73 @@ JSObject *Response::create(JSContext *cx, JS::HandleObject response,
   return response;
 }
 
+JSObject *Response::create_with_stream(JSContext *cx, const uint16_t status,
+                                      host_api::HttpHeaders *headers,
+                                      JS::HandleObject body_stream) {
+  // The host-side response is only used if the Response is passed to `respondWith`, so it gets its
+  // own copy of the headers. Content reads them from `headers`.
+  auto *response_handle =
+      host_api::HttpOutgoingResponse::make(status, new host_api::HttpHeaders(*headers));
+
+  JS::RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &class_, proto_obj));
+  if (!self) {
+    return nullptr;
+  }
+  self = create(cx, self, response_handle);
+  if (!self) {
+    return nullptr;
+  }
+
+  JS::RootedObject headers_instance(
+      cx, JS_NewObjectWithGivenProto(cx, &Headers::class_, Headers::proto_obj));
+  if (!headers_instance) {
+    return nullptr;
+  }
+  JS::RootedObject headers_obj(cx, Headers::create(cx, headers_instance, headers));
+  if (!headers_obj) {
+    return nullptr;
+  }
+  JS::SetReservedSlot(self, static_cast<uint32_t>(Slots::Headers), JS::ObjectValue(*headers_obj));
+
+  JS::SetReservedSlot(self, static_cast<uint32_t>(Slots::Status), JS::Int32Value(status));
+  set_status_message_from_code(cx, self, status);
+
+  if (body_stream) {
+    JS::SetReservedSlot(self, static_cast<uint32_t>(Slots::BodyStream),
+                        JS::ObjectValue(*body_stream));
+    JS::SetReservedSlot(self, static_cast<uint32_t>(Slots::HasBody), JS::TrueValue());
+  }
+
+  return self;
+}
+
+JSObject *Response::create_shared(JSContext *cx, host_api::HttpIncomingResponse *response,
+                                  JS::HandleObject body_stream) {
+  auto status_res = response->status();
+  MOZ_ASSERT(!status_res.is_err(), "TODO: proper error handling");
+  auto status = status_res.unwrap();
+
+  auto headers_res = response->headers();
+  if (auto *err = headers_res.to_err()) {
+    HANDLE_ERROR(cx, *err);
+    return nullptr;
+  }
+
+  // The incoming response's headers are immutable, so they can back all Responses sharing it.
+  return create_with_stream(cx, status, headers_res.unwrap(), body_stream);
+}
+
 namespace request_response {
 
 bool install(api::Engine *engine) {
   ENGINE = engine;
 
+  JS::RootedValue readable_stream(engine->cx());
+  if (!JS_GetProperty(engine->cx(), engine->global(), "ReadableStream", &readable_stream)) {
+    return false;
+  }
+  READABLE_STREAM.init(engine->cx(), &readable_stream.toObject());
+
   if (!Request::init_class(engine->cx(), engine->global()))
     return false;
   if (!Response::init_class(engine->cx(), engine->global()))
@@ -14,6 +14,19 @@ bool install(api::Engine *engine);
 
 }
 
+/// The number of bytes to read from an incoming body of unknown size at first.
+constexpr size_t HANDLE_READ_CHUNK_SIZE = 8192;
+
+#ifndef MAX_BODY_READ_CHUNK_SIZE
+#define MAX_BODY_READ_CHUNK_SIZE (1024 * 1024)
+#endif
+
+/// The largest number of bytes to read from an incoming body at a time. Can be changed by setting
+/// the `MAX_BODY_READ_CHUNK_SIZE` environment variable during build configuration.
+constexpr size_t MAX_HANDLE_READ_CHUNK_SIZE = MAX_BODY_READ_CHUNK_SIZE;
+static_assert(MAX_HANDLE_READ_CHUNK_SIZE >= HANDLE_READ_CHUNK_SIZE &&
+              MAX_HANDLE_READ_CHUNK_SIZE <= INT32_MAX);
+
 class RequestOrResponse final {
 
 public:
@@ -25,6 +38,10 @@ public:
     BodyUsed,
     Headers,
     URL,
+    /// The size of the next read from an incoming body, see `next_read_size`.
+    ReadSize,
+    /// The task reading an incoming body ahead of time, see `maybe_prefetch_body`.
+    Prefetch,
     Count,
   };
 
@@ -35,6 +52,17 @@ public:
   static bool has_body(JSObject *obj);
   static host_api::HttpIncomingBody *incoming_body_handle(JSObject *obj);
   static host_api::HttpOutgoingBody *outgoing_body_handle(JSObject *obj);
+
+  /// The length of the body according to the `Content-Length` header, if there's a valid one.
+  static std::optional<size_t> content_length(JSObject *obj);
+
+  /**
+   * The number of bytes to read from the incoming body next. If the body has a `Content-Length`,
+   * reads are sized to fit all of it. Otherwise, they start at `HANDLE_READ_CHUNK_SIZE`, and
+   * double with each read. Either way, they're capped at `MAX_HANDLE_READ_CHUNK_SIZE`.
+   */
+  static size_t next_read_size(JSObject *obj);
+
   static JSObject *body_stream(JSObject *obj);
   static JSObject *body_source(JSContext *cx, JS::HandleObject obj);
   static bool body_used(JSObject *obj);
@@ -63,6 +91,7 @@ public:
     ArrayBuffer,
     JSON,
     Text,
+    FormData,
   };
 
   template <BodyReadResult result_type>
@@ -74,8 +103,42 @@ public:
                                                 JS::HandleValue extra, JS::CallArgs args);
   static bool consume_content_stream_for_bodyAll(JSContext *cx, JS::HandleObject self,
                                                  JS::HandleValue stream_val, JS::CallArgs args);
+  /**
+   * Start reading `self`'s entire body, and return a promise for the result, parsed according to
+   * `result_type`. Returns nullptr with a pending exception if the body can't be read, e.g. because
+   * it has been used already.
+   */
+  template <RequestOrResponse::BodyReadResult result_type>
+  static JSObject *read_all(JSContext *cx, JS::HandleObject self);
   template <RequestOrResponse::BodyReadResult result_type>
   static bool bodyAll(JSContext *cx, JS::CallArgs args, JS::HandleObject self);
+  /**
+   * Error the body stream of `owner` with `reason`, unless it has been read completely already.
+   * For incoming requests and responses, also drop the body's host handles.
+   */
+  static bool abort_body(JSContext *cx, JS::HandleObject owner, JS::HandleValue reason);
+
+  /// Stop reading the incoming request or response `owner`'s body, and drop its host handles.
+  static void close_incoming_body(JSObject *owner);
+
+  /**
+   * Called once `owner`'s incoming body has been read completely or cancelled, so there's nothing
+   * left to abort. For a Response returned by `fetch`, this removes the fetch's abort algorithm
+   * from its request's signal.
+   */
+  static bool incoming_body_finished(JSContext *cx, JS::HandleObject owner);
+
+  /**
+   * Start reading the body of the incoming request `owner` right away, before content asks for it,
+   * if its `Content-Length` is small enough. Only enabled if the `BODY_PREFETCH_LIMIT` environment
+   * variable is set during build configuration.
+   *
+   * A prefetched body is handed to whatever consumes it: `read_all` parses it as soon as it's
+   * complete, which might be right away, and the body stream and `append_body` start with the part
+   * read so far.
+   */
+  static void maybe_prefetch_body(JSContext *cx, JS::HandleObject owner);
+
   static bool body_source_cancel_algorithm(JSContext *cx, JS::CallArgs args,
                                            JS::HandleObject stream, JS::HandleObject owner,
                                            JS::HandleValue reason);
@@ -100,14 +163,31 @@ public:
 
   static JSObject *create_body_stream(JSContext *cx, JS::HandleObject owner);
 
+  /// Create a byte stream with the native `source` as its underlying source, and a high water
+  /// mark of 0.
+  static JSObject *new_byte_stream(JSContext *cx, JS::HandleObject source);
+
   static bool body_get(JSContext *cx, JS::CallArgs args, JS::HandleObject self,
                        bool create_if_undefined);
+
+  /**
+   * Implementation of https://fetch.spec.whatwg.org/#concept-body-clone: tee `self`'s body, keep
+   * one branch as its body stream, and set `clone_stream` to the other. Throws if the body is
+   * unusable, or can't be read back because it was written to the host already.
+   *
+   * Incoming bodies are read through a `BodyTee`, which reads each chunk from the host once and
+   * enqueues it into both bodies, starting with the part that was prefetched, if any. Others are
+   * teed as ReadableStreams.
+   */
+  static bool clone_body(JSContext *cx, JS::HandleObject self,
+                         JS::MutableHandleObject clone_stream);
 };
 
-class Request final : public BuiltinImpl<Request> {
+class Request final : public FinalizableBuiltinImpl<Request> {
   static bool method_get(JSContext *cx, unsigned argc, JS::Value *vp);
   static bool headers_get(JSContext *cx, unsigned argc, JS::Value *vp);
   static bool url_get(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool signal_get(JSContext *cx, unsigned argc, JS::Value *vp);
 
   template <RequestOrResponse::BodyReadResult result_type>
   static bool bodyAll(JSContext *cx, unsigned argc, JS::Value *vp);
@@ -129,10 +209,28 @@ public:
     URL = static_cast<int>(RequestOrResponse::Slots::URL),
     Method = static_cast<int>(RequestOrResponse::Slots::Count),
     ResponsePromise,
+    Signal,
+    /// For a fetch with the non-standard `coalesce` option, an array of its coalescing key followed
+    /// by the requests of the fetches sharing its response.
+    Coalesced,
+    /// The id of the task waiting for the response to the request, while it's in flight. Unset for
+    /// fetches that hedge or retry their request, which have several such tasks.
+    ResponseTask,
+    /// The algorithm `fetch` added to the request's signal, until the fetch is done.
+    AbortAlgorithm,
     Count,
   };
 
   static JSObject *response_promise(JSObject *obj);
+  /// The request's `AbortSignal`, if it was created with one to follow.
+  static JSObject *signal(JSObject *obj);
+
+  /// Add `algorithm` to `self`'s signal, which must not be aborted, for as long as the fetch of
+  /// `self` is going on.
+  static bool add_abort_algorithm(JSContext *cx, JS::HandleObject self,
+                                  JS::HandleObject algorithm);
+  /// Remove the algorithm added by `add_abort_algorithm` from `self`'s signal, if there is one.
+  static bool remove_abort_algorithm(JSContext *cx, JS::HandleObject self);
   static JSString *method(JSContext *cx, JS::HandleObject obj);
   static host_api::HttpRequest *request_handle(JSObject *obj);
   static host_api::HttpOutgoingRequest *outgoing_handle(JSObject *obj);
@@ -147,6 +245,7 @@ public:
 
   static bool init_class(JSContext *cx, JS::HandleObject global);
   static bool constructor(JSContext *cx, unsigned argc, JS::Value *vp);
+  static void finalize(JS::GCContext *gcx, JSObject *self);
 
   static JSObject *create(JSContext *cx, JS::HandleObject requestInstance,
                           host_api::HttpRequest *request_handle);
@@ -171,10 +270,24 @@ class Response final : public BuiltinImpl<Response> {
   static bool body_get(JSContext *cx, unsigned argc, JS::Value *vp);
   static bool bodyUsed_get(JSContext *cx, unsigned argc, JS::Value *vp);
 
+  static bool clone(JSContext *cx, unsigned argc, JS::Value *vp);
+
   static bool redirect(JSContext *cx, unsigned argc, JS::Value *vp);
   static bool json(JSContext *cx, unsigned argc, JS::Value *vp);
 
+  static JSObject *initialize(JSContext *cx, JS::HandleObject instance, JS::HandleValue init_val,
+                              const char *fun_name);
+
 public:
+  /**
+   * Read the status, status message and headers from the `ResponseInit` dictionary `init_val`, and
+   * validate the status and status message, as the first steps of initializing a response do.
+   * `headers_val` is left undefined if the dictionary has no headers.
+   */
+  static bool read_init(JSContext *cx, JS::HandleValue init_val, const char *fun_name,
+                        uint16_t *status, JS::MutableHandleString status_text,
+                        JS::MutableHandleValue headers_val);
+
   static constexpr const char *class_name = "Response";
 
   enum class Slots {
@@ -186,6 +299,9 @@ public:
     Status = static_cast<int>(RequestOrResponse::Slots::Count),
     StatusMessage,
     Redirected,
+    /// The request of the `fetch` that returned the response, while aborting the request's signal
+    /// can still abort the response's body.
+    FetchRequest,
     Count,
   };
   static const JSFunctionSpec static_methods[];
@@ -201,6 +317,22 @@ public:
   static JSObject *create(JSContext *cx, JS::HandleObject response,
                           host_api::HttpResponse *response_handle);
 
+  /**
+   * Create a Response with `status`, `headers`, and `body_stream` as its body, or no body if that's
+   * null. `headers` back the Response's Headers object, and must outlive it. The host-side
+   * response gets a copy.
+   */
+  static JSObject *create_with_stream(JSContext *cx, uint16_t status,
+                                      host_api::HttpHeaders *headers, JS::HandleObject body_stream);
+
+  /**
+   * Create a Response with the status and headers of the incoming `response`, but with
+   * `body_stream` as its body, or no body if that's null. This way, several Responses can share a
+   * single incoming response, with their bodies read through a `BodyTee`.
+   */
+  static JSObject *create_shared(JSContext *cx, host_api::HttpIncomingResponse *response,
+                                 JS::HandleObject body_stream);
+
   static host_api::HttpResponse *response_handle(JSObject *obj);
   static uint16_t status(JSObject *obj);
   static JSString *status_message(JSObject *obj);
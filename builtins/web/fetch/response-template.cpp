@@ -0,0 +1,288 @@
+#include "response-template.h"
+#include "../blob.h"
+#include "../form-data/form-data.h"
+#include "../url.h"
+#include "encode.h"
+#include "headers.h"
+#include "request-response.h"
+
+#include "js/ArrayBuffer.h"
+#include "js/Conversions.h"
+#include "js/Stream.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace builtins::web::fetch {
+
+using blob::Blob;
+using url::URLSearchParams;
+
+namespace {
+
+/// The parts of a ResponseTemplate that are sent for each response created from it.
+struct ResponseTemplateData {
+  uint16_t status = 200;
+  /// The headers, as encoded by `Headers::encode_entries`.
+  std::vector<host_api::HostString> headers;
+  /// The body, or nothing if the template has none.
+  std::optional<std::string> body;
+  /// The host-side header list that is cloned for each response. Host resources can't be created
+  /// during initialization, so it's only created when the template is first sent.
+  host_api::HttpHeaders *fields = nullptr;
+
+  ~ResponseTemplateData() { delete fields; }
+};
+
+ResponseTemplateData *template_data(JSObject *self) {
+  MOZ_ASSERT(ResponseTemplate::is_instance(self));
+  return static_cast<ResponseTemplateData *>(
+      JS::GetReservedSlot(self, ResponseTemplate::Slots::Data).toPrivate());
+}
+
+/**
+ * Store the bytes of `body_val` in `body`, and set `content_type` to the type they imply, if any.
+ *
+ * Like `RequestOrResponse::extract_body`, but without support for bodies that can only be read
+ * once, or that differ each time they're serialized.
+ */
+bool extract_bytes(JSContext *cx, JS::HandleValue body_val, std::string *body,
+                   std::string *content_type) {
+  JS::RootedObject body_obj(cx, body_val.isObject() ? &body_val.toObject() : nullptr);
+
+  if (body_obj && (JS::IsReadableStream(body_obj) || form_data::FormData::is_instance(body_obj))) {
+    JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_RESPONSE_TEMPLATE_INVALID_BODY);
+    return false;
+  }
+
+  if (body_obj && Blob::is_instance(body_obj)) {
+    for (const auto &part : Blob::parts(body_obj)) {
+      body->append(reinterpret_cast<const char *>(part.data()), part.length);
+    }
+    JS::RootedString type(cx, Blob::type(body_obj));
+    if (JS_GetStringLength(type) > 0) {
+      auto type_chars = core::encode(cx, type);
+      if (!type_chars) {
+        return false;
+      }
+      content_type->assign(type_chars.begin(), type_chars.size());
+    }
+  } else if (body_obj && URLSearchParams::is_instance(body_obj)) {
+    auto slice = URLSearchParams::serialize(cx, body_obj);
+    body->assign(reinterpret_cast<const char *>(slice.data), slice.len);
+    *content_type = "application/x-www-form-urlencoded;charset=UTF-8";
+  } else if (body_obj && JS_IsArrayBufferViewObject(body_obj)) {
+    // Short typed arrays have inline data which can move on GC, so none must happen while copying.
+    JS::AutoCheckCannotGC nogc(cx);
+    bool is_shared;
+    auto *data = JS_GetArrayBufferViewData(body_obj, &is_shared, nogc);
+    body->assign(reinterpret_cast<const char *>(data), JS_GetArrayBufferViewByteLength(body_obj));
+  } else if (body_obj && JS::IsArrayBufferObject(body_obj)) {
+    bool is_shared;
+    size_t length;
+    uint8_t *data;
+    JS::GetArrayBufferLengthAndData(body_obj, &length, &is_shared, &data);
+    body->assign(reinterpret_cast<const char *>(data), length);
+  } else {
+    JS::RootedString str(cx, JS::ToString(cx, body_val));
+    if (!str) {
+      return false;
+    }
+    auto chars = core::encode(cx, str);
+    if (!chars) {
+      return false;
+    }
+    body->assign(chars.begin(), chars.size());
+    *content_type = "text/plain;charset=UTF-8";
+  }
+
+  return true;
+}
+
+} // namespace
+
+const JSFunctionSpec ResponseTemplate::static_methods[] = {
+    JS_FS_END,
+};
+
+const JSPropertySpec ResponseTemplate::static_properties[] = {
+    JS_PS_END,
+};
+
+const JSFunctionSpec ResponseTemplate::methods[] = {
+    JS_FN("response", response, 0, JSPROP_ENUMERATE),
+    JS_FS_END,
+};
+
+const JSPropertySpec ResponseTemplate::properties[] = {
+    JS_PSG("status", status_get, JSPROP_ENUMERATE),
+    JS_PSG("statusText", statusText_get, JSPROP_ENUMERATE),
+    JS_STRING_SYM_PS(toStringTag, "ResponseTemplate", JSPROP_READONLY),
+    JS_PS_END,
+};
+
+bool ResponseTemplate::status_get(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+
+  args.rval().setInt32(template_data(self)->status);
+  return true;
+}
+
+bool ResponseTemplate::statusText_get(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+
+  args.rval().set(JS::GetReservedSlot(self, Slots::StatusText));
+  return true;
+}
+
+/// Create a Response from the template, for content that needs one, e.g. to store it in a cache.
+bool ResponseTemplate::response(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  REQUEST_HANDLER_ONLY("ResponseTemplate#response")
+
+  JS::RootedObject response(
+      cx, JS_NewObjectWithGivenProto(cx, &Response::class_, Response::proto_obj));
+  if (!response) {
+    return false;
+  }
+
+  auto *response_handle = make_response(cx, self);
+  if (!response_handle) {
+    return false;
+  }
+  response = Response::create(cx, response, response_handle);
+  if (!response) {
+    return false;
+  }
+
+  auto *data = template_data(self);
+  RequestOrResponse::set_url(response, JS_GetEmptyStringValue(cx));
+  JS::SetReservedSlot(response, static_cast<uint32_t>(Response::Slots::Status),
+                      JS::Int32Value(data->status));
+  JS::SetReservedSlot(response, static_cast<uint32_t>(Response::Slots::StatusMessage),
+                      JS::GetReservedSlot(self, Slots::StatusText));
+  JS::SetReservedSlot(response, static_cast<uint32_t>(Response::Slots::HasBody),
+                      JS::BooleanValue(data->body.has_value()));
+
+  args.rval().setObject(*response);
+  return true;
+}
+
+host_api::HttpOutgoingResponse *ResponseTemplate::make_response(JSContext *cx,
+                                                                JS::HandleObject self) {
+  auto *data = template_data(self);
+  if (!data->fields) {
+    auto res = host_api::HttpHeaders::from_list(Headers::to_entries(data->headers));
+    if (auto *err = res.to_err()) {
+      HANDLE_ERROR(cx, *err);
+      return nullptr;
+    }
+    data->fields = res.unwrap();
+  }
+
+  auto *response =
+      host_api::HttpOutgoingResponse::make(data->status, new host_api::HttpHeaders(*data->fields));
+  if (!data->body) {
+    return response;
+  }
+
+  auto body_res = response->body();
+  if (auto *err = body_res.to_err()) {
+    HANDLE_ERROR(cx, *err);
+    return nullptr;
+  }
+  auto res = body_res.unwrap()->write_all(reinterpret_cast<const uint8_t *>(data->body->data()),
+                                          data->body->size());
+  if (auto *err = res.to_err()) {
+    HANDLE_ERROR(cx, *err);
+    return nullptr;
+  }
+  return response;
+}
+
+/**
+ * The `ResponseTemplate` constructor, which follows the `Response` constructor
+ * https://fetch.spec.whatwg.org/#dom-response
+ */
+bool ResponseTemplate::constructor(JSContext *cx, unsigned argc, JS::Value *vp) {
+  CTOR_HEADER("ResponseTemplate", 0);
+
+  JS::RootedValue body_val(cx, args.get(0));
+  JS::RootedValue init_val(cx, args.get(1));
+
+  JS::RootedObject self(cx, JS_NewObjectForConstructor(cx, &class_, args));
+  if (!self) {
+    return false;
+  }
+
+  auto data = std::make_unique<ResponseTemplateData>();
+  JS::RootedString status_text(cx);
+  JS::RootedValue headers_val(cx);
+  if (!Response::read_init(cx, init_val, "ResponseTemplate constructor", &data->status,
+                           &status_text, &headers_val)) {
+    return false;
+  }
+
+  // The headers are validated and normalized once, here, and only their encoded form is kept.
+  JS::RootedObject headers_instance(
+      cx, JS_NewObjectWithGivenProto(cx, &Headers::class_, Headers::proto_obj));
+  if (!headers_instance) {
+    return false;
+  }
+  JS::RootedObject headers(cx, Headers::create(cx, headers_instance, nullptr, headers_val));
+  if (!headers) {
+    return false;
+  }
+
+  if (!body_val.isNullOrUndefined()) {
+    if (data->status == 204 || data->status == 205 || data->status == 304) {
+      JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr,
+                                JSMSG_RESPONSE_NULL_BODY_STATUS_WITH_BODY);
+      return false;
+    }
+
+    std::string content_type;
+    data->body.emplace();
+    if (!extract_bytes(cx, body_val, &*data->body, &content_type)) {
+      return false;
+    }
+    if (!content_type.empty() &&
+        !Headers::maybe_add(cx, headers, "content-type", content_type.c_str())) {
+      return false;
+    }
+  }
+
+  if (!Headers::encode_entries(cx, headers, &data->headers)) {
+    return false;
+  }
+
+  JS::SetReservedSlot(self, Slots::Data, JS::PrivateValue(data.release()));
+  JS::SetReservedSlot(self, Slots::StatusText, JS::StringValue(status_text));
+
+  args.rval().setObject(*self);
+  return true;
+}
+
+void ResponseTemplate::finalize(JS::GCContext *gcx, JSObject *self) {
+  // Construction might have failed before the data was set.
+  JS::Value data_val = JS::GetReservedSlot(self, Slots::Data);
+  if (!data_val.isUndefined()) {
+    delete static_cast<ResponseTemplateData *>(data_val.toPrivate());
+  }
+}
+
+bool ResponseTemplate::init_class(JSContext *cx, JS::HandleObject global) {
+  return init_class_impl(cx, global);
+}
+
+namespace response_template {
+
+bool install(api::Engine *engine) {
+  return ResponseTemplate::init_class(engine->cx(), engine->global());
+}
+
+} // namespace response_template
+
+} // namespace builtins::web::fetch
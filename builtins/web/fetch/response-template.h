@@ -0,0 +1,62 @@
+#ifndef BUILTINS_WEB_FETCH_RESPONSE_TEMPLATE_H
+#define BUILTINS_WEB_FETCH_RESPONSE_TEMPLATE_H
+
+#include "builtin.h"
+#include "host_api.h"
+
+namespace builtins::web::fetch {
+
+namespace response_template {
+
+bool install(api::Engine *engine);
+
+}
+
+/**
+ * An immutable description of a response, which can be sent any number of times.
+ *
+ * Templates take the same arguments as the Response constructor, but only support bodies that can
+ * be stored as bytes: strings, buffer sources and Blobs. Unlike Responses, they can be created
+ * during initialization, so that static responses are prepared once and captured in the snapshot.
+ *
+ * The status, headers, and body are stored natively. Passing a template to `respondWith` sends it
+ * without creating any JS objects: the header list is created on the host the first time the
+ * template is sent, and each response gets a clone of it and a single write of the body.
+ */
+class ResponseTemplate final : public FinalizableBuiltinImpl<ResponseTemplate> {
+  static bool status_get(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool statusText_get(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool response(JSContext *cx, unsigned argc, JS::Value *vp);
+
+public:
+  static constexpr const char *class_name = "ResponseTemplate";
+
+  enum Slots {
+    /// The template's native `ResponseTemplateData`.
+    Data,
+    /// The status message, as a string.
+    StatusText,
+    Count
+  };
+
+  static const JSFunctionSpec static_methods[];
+  static const JSPropertySpec static_properties[];
+  static const JSFunctionSpec methods[];
+  static const JSPropertySpec properties[];
+
+  static const unsigned ctor_length = 0;
+
+  static bool init_class(JSContext *cx, JS::HandleObject global);
+  static bool constructor(JSContext *cx, unsigned argc, JS::Value *vp);
+  static void finalize(JS::GCContext *gcx, JSObject *self);
+
+  /**
+   * Create the host-side response for sending `self`, with the body already written to it. The
+   * body, if any, still has to be closed once the response has been sent.
+   */
+  static host_api::HttpOutgoingResponse *make_response(JSContext *cx, JS::HandleObject self);
+};
+
+} // namespace builtins::web::fetch
+
+#endif
@@ -0,0 +1,125 @@
+#include "file.h"
+
+#include "js/Conversions.h"
+
+#include <chrono>
+#include <cmath>
+
+namespace builtins::web::file {
+
+using blob::Blob;
+
+namespace {
+
+/// The current time in milliseconds since the epoch, the default modification time of Files.
+double now_ms() {
+  auto now = std::chrono::system_clock::now().time_since_epoch();
+  return static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+}
+
+} // namespace
+
+bool File::name_get(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  args.rval().set(JS::GetReservedSlot(self, Slots::Name));
+  return true;
+}
+
+bool File::lastModified_get(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  args.rval().set(JS::GetReservedSlot(self, Slots::LastModified));
+  return true;
+}
+
+const JSFunctionSpec File::static_methods[] = {
+    JS_FS_END,
+};
+
+const JSPropertySpec File::static_properties[] = {
+    JS_PS_END,
+};
+
+const JSFunctionSpec File::methods[] = {
+    JS_FS_END,
+};
+
+const JSPropertySpec File::properties[] = {
+    JS_PSG("name", name_get, JSPROP_ENUMERATE),
+    JS_PSG("lastModified", lastModified_get, JSPROP_ENUMERATE),
+    JS_STRING_SYM_PS(toStringTag, "File", JSPROP_READONLY),
+    JS_PS_END,
+};
+
+// https://w3c.github.io/FileAPI/#file-constructor
+bool File::constructor(JSContext *cx, unsigned argc, JS::Value *vp) {
+  CTOR_HEADER("File", 2);
+  if (args[0].isUndefined()) {
+    JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_BLOB_PARTS_NOT_SEQUENCE, "File");
+    return false;
+  }
+
+  JS::RootedObject self(cx, JS_NewObjectForConstructor(cx, &class_, args));
+  if (!self || !Blob::init(cx, self, args[0], args.get(2))) {
+    return false;
+  }
+
+  JS::RootedString name(cx, JS::ToString(cx, args[1]));
+  if (!name) {
+    return false;
+  }
+
+  double last_modified = now_ms();
+  if (args.get(2).isObject()) {
+    JS::RootedObject options(cx, &args[2].toObject());
+    JS::RootedValue val(cx);
+    if (!JS_GetProperty(cx, options, "lastModified", &val)) {
+      return false;
+    }
+    if (!val.isUndefined()) {
+      if (!JS::ToNumber(cx, val, &last_modified)) {
+        return false;
+      }
+      last_modified = std::isfinite(last_modified) ? std::trunc(last_modified) : 0;
+    }
+  }
+
+  JS::SetReservedSlot(self, Slots::Name, JS::StringValue(name));
+  JS::SetReservedSlot(self, Slots::LastModified, JS::NumberValue(last_modified));
+  args.rval().setObject(*self);
+  return true;
+}
+
+JSString *File::name(JSObject *self) {
+  MOZ_ASSERT(is_instance(self));
+  return JS::GetReservedSlot(self, Slots::Name).toString();
+}
+
+double File::last_modified(JSObject *self) {
+  MOZ_ASSERT(is_instance(self));
+  return JS::GetReservedSlot(self, Slots::LastModified).toNumber();
+}
+
+JSObject *File::create(JSContext *cx, blob::BlobParts parts, JS::HandleString type,
+                       JS::HandleString name, std::optional<double> last_modified) {
+  JS::RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &class_, proto_obj));
+  if (!self) {
+    return nullptr;
+  }
+  JS::SetReservedSlot(self, Slots::Parts,
+                      JS::PrivateValue(new blob::BlobParts(std::move(parts))));
+  JS::SetReservedSlot(self, Slots::Type, JS::StringValue(type));
+  JS::SetReservedSlot(self, Slots::Name, JS::StringValue(name));
+  JS::SetReservedSlot(self, Slots::LastModified,
+                      JS::NumberValue(last_modified.value_or(now_ms())));
+  return self;
+}
+
+void File::finalize(JS::GCContext *gcx, JSObject *self) { Blob::finalize(gcx, self); }
+
+bool File::init_class(JSContext *cx, JS::HandleObject global) {
+  return init_class_impl(cx, global, Blob::proto_obj);
+}
+
+bool install(api::Engine *engine) { return File::init_class(engine->cx(), engine->global()); }
+
+} // namespace builtins::web::file
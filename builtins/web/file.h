@@ -0,0 +1,60 @@
+#ifndef BUILTINS_WEB_FILE_H
+#define BUILTINS_WEB_FILE_H
+
+#include "blob.h"
+#include "builtin.h"
+
+#include <optional>
+
+namespace builtins::web::file {
+
+/**
+ * https://w3c.github.io/FileAPI/#file-section
+ *
+ * Files are Blobs with a name and a modification time. Their contents are held just like a Blob's,
+ * in the same slots, so all of Blob's methods work with them unchanged.
+ */
+class File final : public FinalizableBuiltinImpl<File> {
+  static bool name_get(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool lastModified_get(JSContext *cx, unsigned argc, JS::Value *vp);
+
+public:
+  static constexpr const char *class_name = "File";
+
+  enum Slots {
+    Parts = blob::Blob::Slots::Parts,
+    Type = blob::Blob::Slots::Type,
+    /// The File's name, as a string.
+    Name,
+    /// The File's modification time, in milliseconds since the epoch.
+    LastModified,
+    Count
+  };
+
+  static const JSFunctionSpec static_methods[];
+  static const JSPropertySpec static_properties[];
+  static const JSFunctionSpec methods[];
+  static const JSPropertySpec properties[];
+
+  static const unsigned ctor_length = 2;
+
+  static bool init_class(JSContext *cx, JS::HandleObject global);
+  static bool constructor(JSContext *cx, unsigned argc, JS::Value *vp);
+  static void finalize(JS::GCContext *gcx, JSObject *self);
+
+  static JSString *name(JSObject *self);
+  static double last_modified(JSObject *self);
+
+  /**
+   * Create a File with the given contents, type, which must already be normalized, and name. If
+   * `last_modified` isn't given, the current time is used.
+   */
+  static JSObject *create(JSContext *cx, blob::BlobParts parts, JS::HandleString type,
+                          JS::HandleString name, std::optional<double> last_modified = {});
+};
+
+bool install(api::Engine *engine);
+
+} // namespace builtins::web::file
+
+#endif
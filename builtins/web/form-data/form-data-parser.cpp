@@ -0,0 +1,403 @@
+#include "form-data-parser.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace builtins::web::form_data {
+
+using blob::BlobPart;
+using blob::BlobParts;
+using blob::BlobSegment;
+
+namespace {
+
+/// The largest header block of a part, and the largest delimiter line, that are accepted.
+constexpr size_t MAX_HEADER_BYTES = 16 * 1024;
+constexpr size_t MAX_DELIMITER_LINE_BYTES = 1024;
+
+std::string_view trim(std::string_view str) {
+  size_t start = str.find_first_not_of(" \t");
+  if (start == std::string_view::npos) {
+    return {};
+  }
+  size_t end = str.find_last_not_of(" \t");
+  return str.substr(start, end - start + 1);
+}
+
+std::string to_lower(std::string_view str) {
+  std::string lower(str);
+  for (char &c : lower) {
+    if (c >= 'A' && c <= 'Z') {
+      c = static_cast<char>(c + ('a' - 'A'));
+    }
+  }
+  return lower;
+}
+
+using Parameters = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * Split a header value like `type; a=1; b="two"` into its leading token, which is returned
+ * lowercased, and its parameters. Parameter names are lowercased, and quoted values unquoted. In
+ * quoted values, a backslash only escapes a following quote or backslash, so that Windows paths
+ * sent as filenames stay intact.
+ */
+std::string parse_parameters(std::string_view value, Parameters *params) {
+  size_t i = std::min(value.find(';'), value.size());
+  std::string token = to_lower(trim(value.substr(0, i)));
+  while (i < value.size()) {
+    i++;
+    size_t eq = value.find_first_of("=;", i);
+    if (eq == std::string_view::npos) {
+      break;
+    }
+    if (value[eq] == ';') {
+      i = eq;
+      continue;
+    }
+
+    std::string name = to_lower(trim(value.substr(i, eq - i)));
+    i = eq + 1;
+    while (i < value.size() && (value[i] == ' ' || value[i] == '\t')) {
+      i++;
+    }
+
+    std::string param_value;
+    if (i < value.size() && value[i] == '"') {
+      for (i++; i < value.size() && value[i] != '"'; i++) {
+        if (value[i] == '\\' && i + 1 < value.size() &&
+            (value[i + 1] == '"' || value[i + 1] == '\\')) {
+          i++;
+        }
+        param_value.push_back(value[i]);
+      }
+      i = std::min(value.find(';', i), value.size());
+    } else {
+      size_t end = std::min(value.find(';', i), value.size());
+      param_value = trim(value.substr(i, end - i));
+      i = end;
+    }
+    params->emplace_back(std::move(name), std::move(param_value));
+  }
+  return token;
+}
+
+const std::string *find_parameter(const Parameters &params, std::string_view name) {
+  for (const auto &[param_name, value] : params) {
+    if (param_name == name) {
+      return &value;
+    }
+  }
+  return nullptr;
+}
+
+int hex_value(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+/// https://url.spec.whatwg.org/#percent-decode, after replacing `+` with a space.
+std::string form_decode(std::string_view str) {
+  std::string decoded;
+  decoded.reserve(str.size());
+  for (size_t i = 0; i < str.size(); i++) {
+    char c = str[i];
+    if (c == '+') {
+      decoded.push_back(' ');
+    } else if (c == '%' && i + 2 < str.size() && hex_value(str[i + 1]) >= 0 &&
+               hex_value(str[i + 2]) >= 0) {
+      decoded.push_back(static_cast<char>(hex_value(str[i + 1]) * 16 + hex_value(str[i + 2])));
+      i += 2;
+    } else {
+      decoded.push_back(c);
+    }
+  }
+  return decoded;
+}
+
+} // namespace
+
+MultipartParser::MultipartParser(std::string_view boundary) : delimiter_("\r\n--") {
+  delimiter_.append(boundary);
+  // The first delimiter may start the body, so parsing starts as though it were preceded by a
+  // line break. Nothing before the first delimiter is kept, so these bytes never need to exist.
+  pending_len_ = 2;
+}
+
+void MultipartParser::append_contents(const BlobPart &range) {
+  if (state_ != State::Body) {
+    return;
+  }
+  if (!part_.filename) {
+    part_.value.append(reinterpret_cast<const char *>(range.data()), range.length);
+    return;
+  }
+
+  // Ranges of the same chunk that turned out not to be a delimiter after all are merged again.
+  auto &contents = part_.contents;
+  if (!contents.empty() && contents.back().segment == range.segment &&
+      contents.back().offset + contents.back().length == range.offset) {
+    contents.back().length += range.length;
+  } else {
+    contents.push_back(range);
+  }
+}
+
+void MultipartParser::append_pending() {
+  for (const auto &range : pending_) {
+    append_contents(range);
+  }
+  pending_.clear();
+  pending_len_ = 0;
+}
+
+bool MultipartParser::parse_headers() {
+  std::string_view block(line_);
+  // Skip the line break that was prepended to find empty header blocks, see `read_delimiter_line`.
+  block.remove_prefix(2);
+
+  bool has_disposition = false;
+  while (!block.empty()) {
+    size_t end = block.find("\r\n");
+    std::string_view line = block.substr(0, end);
+    block.remove_prefix(end == std::string_view::npos ? block.size() : end + 2);
+
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos) {
+      return false;
+    }
+    std::string name = to_lower(trim(line.substr(0, colon)));
+    std::string_view value = trim(line.substr(colon + 1));
+
+    if (name == "content-disposition") {
+      Parameters params;
+      if (parse_parameters(value, &params) != "form-data") {
+        return false;
+      }
+      auto *entry_name = find_parameter(params, "name");
+      if (!entry_name) {
+        return false;
+      }
+      part_.name = *entry_name;
+      if (auto *filename = find_parameter(params, "filename")) {
+        part_.filename = *filename;
+      }
+      has_disposition = true;
+    } else if (name == "content-type") {
+      part_.type = value;
+    }
+  }
+
+  if (!has_disposition) {
+    return false;
+  }
+  if (part_.filename && part_.type.empty()) {
+    part_.type = "text/plain";
+  }
+  return true;
+}
+
+void MultipartParser::finish_part() {
+  if (!part_.filename) {
+    part_.type.clear();
+  }
+  entries_.push_back(std::move(part_));
+  part_ = ParsedEntry();
+}
+
+size_t MultipartParser::scan_contents(const BlobPart &chunk, size_t pos) {
+  const auto *data = reinterpret_cast<const char *>(chunk.data());
+  const size_t len = chunk.length;
+  const size_t delimiter_len = delimiter_.size();
+
+  auto found_delimiter = [&](size_t end) {
+    if (state_ == State::Body) {
+      finish_part();
+    }
+    state_ = State::DelimiterLine;
+    line_.clear();
+    return end;
+  };
+
+  // Complete a delimiter that started at the end of the previous chunks.
+  if (pending_len_ > 0) {
+    size_t n = std::min(delimiter_len - pending_len_, len - pos);
+    if (memcmp(data + pos, delimiter_.data() + pending_len_, n) == 0) {
+      if (pending_len_ + n < delimiter_len) {
+        pending_.push_back(BlobPart{chunk.segment, chunk.offset + pos, n});
+        pending_len_ += n;
+        return len;
+      }
+      pending_.clear();
+      pending_len_ = 0;
+      return found_delimiter(pos + n);
+    }
+    // The delimiter only starts with a CR, so none can start in the pending bytes after their
+    // first one, and they're all contents.
+    append_pending();
+  }
+
+  size_t start = pos;
+  while (pos < len) {
+    const void *cr = memchr(data + pos, '\r', len - pos);
+    if (!cr) {
+      break;
+    }
+    size_t at = static_cast<const char *>(cr) - data;
+    size_t n = std::min(delimiter_len, len - at);
+    if (memcmp(data + at, delimiter_.data(), n) == 0) {
+      if (at > start) {
+        append_contents(BlobPart{chunk.segment, chunk.offset + start, at - start});
+      }
+      if (n == delimiter_len) {
+        return found_delimiter(at + n);
+      }
+      pending_.push_back(BlobPart{chunk.segment, chunk.offset + at, n});
+      pending_len_ = n;
+      return len;
+    }
+    pos = at + 1;
+  }
+
+  if (len > start) {
+    append_contents(BlobPart{chunk.segment, chunk.offset + start, len - start});
+  }
+  return len;
+}
+
+size_t MultipartParser::read_delimiter_line(const BlobPart &chunk, size_t pos) {
+  const auto *data = reinterpret_cast<const char *>(chunk.data());
+  const size_t len = chunk.length;
+  const void *nl = memchr(data + pos, '\n', len - pos);
+  size_t end = nl ? static_cast<const char *>(nl) - data : len;
+  line_.append(data + pos, end - pos);
+
+  // The final delimiter is followed by `--`, and everything after it is ignored.
+  if (line_.size() >= 2 && line_.compare(0, 2, "--") == 0) {
+    state_ = State::Epilogue;
+    return len;
+  }
+  if (line_.size() > MAX_DELIMITER_LINE_BYTES) {
+    fail();
+    return len;
+  }
+  if (!nl) {
+    return len;
+  }
+
+  // Other delimiters may only be followed by whitespace before the line break.
+  if (!line_.empty() && line_.back() == '\r') {
+    line_.pop_back();
+  }
+  if (line_.find_first_not_of(" \t") != std::string::npos) {
+    fail();
+    return len;
+  }
+
+  // The header block ends with an empty line. Starting with a line break finds it even if the
+  // block is empty.
+  state_ = State::Headers;
+  line_ = "\r\n";
+  return end + 1;
+}
+
+size_t MultipartParser::read_headers(const BlobPart &chunk, size_t pos) {
+  const auto *data = reinterpret_cast<const char *>(chunk.data());
+  size_t old_len = line_.size();
+  // The block has to end within this many bytes anyway, so there's no need to look further.
+  size_t n = std::min(chunk.length - pos, MAX_HEADER_BYTES + 4);
+  line_.append(data + pos, n);
+
+  size_t found = line_.find("\r\n\r\n", old_len >= 3 ? old_len - 3 : 0);
+  if (found == std::string::npos) {
+    if (line_.size() > MAX_HEADER_BYTES) {
+      fail();
+      return chunk.length;
+    }
+    return pos + n;
+  }
+
+  // Only the header block itself is kept, with the line break ending its last line.
+  line_.resize(found + 2);
+  if (!parse_headers()) {
+    fail();
+    return chunk.length;
+  }
+  line_.clear();
+  state_ = State::Body;
+  return pos + (found + 4 - old_len);
+}
+
+bool MultipartParser::feed(std::shared_ptr<const BlobSegment> chunk) {
+  BlobPart whole{std::move(chunk), 0, 0};
+  whole.length = whole.segment->len();
+  size_t pos = 0;
+  while (pos < whole.length && state_ != State::Failed) {
+    switch (state_) {
+    case State::Preamble:
+    case State::Body:
+      pos = scan_contents(whole, pos);
+      break;
+    case State::DelimiterLine:
+      pos = read_delimiter_line(whole, pos);
+      break;
+    case State::Headers:
+      pos = read_headers(whole, pos);
+      break;
+    case State::Epilogue:
+      pos = whole.length;
+      break;
+    case State::Failed:
+      break;
+    }
+  }
+  return state_ != State::Failed;
+}
+
+bool MultipartParser::finish() { return state_ == State::Epilogue; }
+
+std::optional<std::string> multipart_boundary(std::string_view content_type) {
+  Parameters params;
+  if (parse_parameters(content_type, &params) != "multipart/form-data") {
+    return std::nullopt;
+  }
+  auto *boundary = find_parameter(params, "boundary");
+  if (!boundary || boundary->empty()) {
+    return std::nullopt;
+  }
+  return *boundary;
+}
+
+bool is_urlencoded(std::string_view content_type) {
+  Parameters params;
+  return parse_parameters(content_type, &params) == "application/x-www-form-urlencoded";
+}
+
+std::vector<ParsedEntry> parse_urlencoded(std::string_view body) {
+  std::vector<ParsedEntry> entries;
+  while (!body.empty()) {
+    size_t end = std::min(body.find('&'), body.size());
+    std::string_view sequence = body.substr(0, end);
+    body.remove_prefix(std::min(end + 1, body.size()));
+    if (sequence.empty()) {
+      continue;
+    }
+
+    size_t eq = std::min(sequence.find('='), sequence.size());
+    ParsedEntry entry;
+    entry.name = form_decode(sequence.substr(0, eq));
+    entry.value = form_decode(sequence.substr(std::min(eq + 1, sequence.size())));
+    entries.push_back(std::move(entry));
+  }
+  return entries;
+}
+
+} // namespace builtins::web::form_data
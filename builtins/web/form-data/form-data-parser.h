@@ -0,0 +1,116 @@
+#ifndef BUILTINS_WEB_FORM_DATA_PARSER_H
+#define BUILTINS_WEB_FORM_DATA_PARSER_H
+
+#include "../blob.h"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace builtins::web::form_data {
+
+/// A FormData entry parsed from a body, before it has been turned into JS values.
+struct ParsedEntry {
+  /// The entry's name, as UTF-8.
+  std::string name;
+  /// For text entries, the value, as UTF-8.
+  std::string value;
+  /// For file entries, the file's name, as UTF-8.
+  std::optional<std::string> filename;
+  /// For file entries, the file's type.
+  std::string type;
+  /// For file entries, the file's contents.
+  blob::BlobParts contents;
+};
+
+/**
+ * Parses a `multipart/form-data` body incrementally, as its chunks come in.
+ *
+ * The contents of file parts aren't copied: they're ranges of the chunks they were read from,
+ * which become the segments of the resulting Files. Apart from those, only the headers and values
+ * of the part being parsed are buffered, so the memory needed for parsing doesn't grow with the
+ * size of the body.
+ *
+ * Delimiters are found by scanning for the CR they start with using `memchr`, which the C library
+ * vectorizes, and only then comparing the rest. Delimiters split across chunks are recognized,
+ * too.
+ */
+class MultipartParser final {
+  enum class State {
+    /// Before the first delimiter. Everything here is ignored.
+    Preamble,
+    /// On the line of a delimiter, after the boundary.
+    DelimiterLine,
+    /// In the header block of a part.
+    Headers,
+    /// In the contents of a part.
+    Body,
+    /// After the final delimiter. Everything here is ignored.
+    Epilogue,
+    /// The body is malformed.
+    Failed,
+  };
+
+  /// `\r\n--` followed by the boundary. The delimiter preceding the first part doesn't have to be
+  /// preceded by a line break, see the constructor.
+  std::string delimiter_;
+  State state_ = State::Preamble;
+
+  /// The number of bytes at the end of the data read so far that match the start of the
+  /// delimiter, and `pending_` the chunk ranges they're in. They're contents of the current part
+  /// unless the delimiter is completed by the next chunk.
+  size_t pending_len_ = 0;
+  blob::BlobParts pending_;
+
+  /// The delimiter line or header block read so far.
+  std::string line_;
+
+  /// The part being parsed, once its headers have been read.
+  ParsedEntry part_;
+
+  std::vector<ParsedEntry> entries_;
+
+  void fail() { state_ = State::Failed; }
+  void append_contents(const blob::BlobPart &range);
+  void append_pending();
+  bool parse_headers();
+  void finish_part();
+
+  /// Scan `chunk` from `pos` for the delimiter, appending everything before it to the current
+  /// part. Returns the position after the delimiter, or the chunk's length if it doesn't contain
+  /// one.
+  size_t scan_contents(const blob::BlobPart &chunk, size_t pos);
+  /// Consume the rest of the delimiter line, or the header block, starting at `pos`. Returns the
+  /// position after what was consumed.
+  size_t read_delimiter_line(const blob::BlobPart &chunk, size_t pos);
+  size_t read_headers(const blob::BlobPart &chunk, size_t pos);
+
+public:
+  explicit MultipartParser(std::string_view boundary);
+
+  /// Parse the next chunk of the body. Returns false once the body turned out to be malformed.
+  bool feed(std::shared_ptr<const blob::BlobSegment> chunk);
+
+  /// Finish parsing once the body has ended. Returns false if it didn't end with a final delimiter.
+  bool finish();
+
+  /// The entries parsed so far.
+  std::vector<ParsedEntry> take_entries() { return std::move(entries_); }
+};
+
+/**
+ * If `content_type` is a valid `multipart/form-data` MIME type, returns its `boundary` parameter.
+ * Returns an empty optional otherwise, including if the boundary is missing or empty.
+ */
+std::optional<std::string> multipart_boundary(std::string_view content_type);
+
+/// Whether the essence of the MIME type `content_type` is `application/x-www-form-urlencoded`.
+bool is_urlencoded(std::string_view content_type);
+
+/// https://url.spec.whatwg.org/#concept-urlencoded-parser
+std::vector<ParsedEntry> parse_urlencoded(std::string_view body);
+
+} // namespace builtins::web::form_data
+
+#endif
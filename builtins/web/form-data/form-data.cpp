@@ -0,0 +1,775 @@
+#include "form-data.h"
+#include "../file.h"
+#include "encode.h"
+
+#include "js/Array.h"
+#include "js/CharacterEncoding.h"
+#include "js/Conversions.h"
+
+#include <cstdio>
+
+namespace builtins::web::form_data {
+
+using blob::Blob;
+using file::File;
+
+namespace {
+
+constexpr int ITERTYPE_ENTRIES = 0;
+constexpr int ITERTYPE_KEYS = 1;
+constexpr int ITERTYPE_VALUES = 2;
+
+JSObject *new_entry(JSContext *cx, JS::HandleString name, JS::HandleValue value) {
+  JS::RootedValueArray<2> pair(cx);
+  pair[0].setString(name);
+  pair[1].set(value);
+  return JS::NewArrayObject(cx, pair);
+}
+
+/// Get the name and value of the entry at `index` of the entry list `list`.
+bool get_entry(JSContext *cx, JS::HandleObject list, uint32_t index, JS::MutableHandleString name,
+               JS::MutableHandleValue value) {
+  JS::RootedValue entry_val(cx);
+  if (!JS_GetElement(cx, list, index, &entry_val)) {
+    return false;
+  }
+  JS::RootedObject entry(cx, &entry_val.toObject());
+  JS::RootedValue name_val(cx);
+  if (!JS_GetElement(cx, entry, 0, &name_val) || !JS_GetElement(cx, entry, 1, value)) {
+    return false;
+  }
+  name.set(name_val.toString());
+  return true;
+}
+
+bool names_equal(JSContext *cx, JS::HandleString a, JS::HandleString b, bool *equal) {
+  int32_t result;
+  if (!JS_CompareStrings(cx, a, b, &result)) {
+    return false;
+  }
+  *equal = result == 0;
+  return true;
+}
+
+/**
+ * https://xhr.spec.whatwg.org/#create-an-entry
+ *
+ * Blobs that aren't Files, and Files given a filename, are replaced by new Files sharing their
+ * contents.
+ */
+JSObject *create_entry(JSContext *cx, const JS::CallArgs &args, const char *method) {
+  JS::RootedString name(cx, JS::ToString(cx, args[0]));
+  if (!name) {
+    return nullptr;
+  }
+
+  JS::RootedValue value(cx);
+  if (Blob::is_instance(args[1])) {
+    JS::RootedObject blob(cx, &args[1].toObject());
+    bool is_file = File::is_instance(blob);
+    bool has_filename = args.length() > 2 && !args[2].isUndefined();
+    if (is_file && !has_filename) {
+      value.setObject(*blob);
+    } else {
+      JS::RootedString filename(cx, has_filename ? JS::ToString(cx, args[2])
+                                                 : JS_NewStringCopyZ(cx, "blob"));
+      if (!filename) {
+        return nullptr;
+      }
+      JS::RootedString type(cx, Blob::type(blob));
+      std::optional<double> last_modified;
+      if (is_file) {
+        last_modified = File::last_modified(blob);
+      }
+      JSObject *file = File::create(cx, Blob::parts(blob), type, filename, last_modified);
+      if (!file) {
+        return nullptr;
+      }
+      value.setObject(*file);
+    }
+  } else {
+    // Only the overload taking a Blob accepts a filename.
+    if (args.length() > 2) {
+      JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_FORM_DATA_VALUE_NOT_BLOB,
+                                method);
+      return nullptr;
+    }
+    JSString *str = JS::ToString(cx, args[1]);
+    if (!str) {
+      return nullptr;
+    }
+    value.setString(str);
+  }
+
+  return new_entry(cx, name, value);
+}
+
+/**
+ * Append `str` to `out`. If `normalize` is set, CR and LF not part of a CRLF pair are converted
+ * to CRLF pairs. If `escape` is set, CR, LF, and `"` are percent-encoded, as required for names in
+ * `Content-Disposition` headers.
+ */
+void append_field(std::string *out, std::string_view str, bool normalize, bool escape) {
+  for (size_t i = 0; i < str.size(); i++) {
+    char c = str[i];
+    if (normalize && (c == '\r' || c == '\n')) {
+      if (c == '\r' && i + 1 < str.size() && str[i + 1] == '\n') {
+        i++;
+      }
+      out->append(escape ? "%0D%0A" : "\r\n");
+    } else if (escape && c == '\r') {
+      out->append("%0D");
+    } else if (escape && c == '\n') {
+      out->append("%0A");
+    } else if (escape && c == '"') {
+      out->append("%22");
+    } else {
+      out->push_back(c);
+    }
+  }
+}
+
+} // namespace
+
+bool FormDataIterator::next(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(0)
+  JS::RootedObject form(cx, &JS::GetReservedSlot(self, Slots::Form).toObject());
+  JS::RootedObject list(cx, FormData::entry_list(form));
+  uint32_t index = JS::GetReservedSlot(self, Slots::Index).toInt32();
+  uint8_t type = JS::GetReservedSlot(self, Slots::Type).toInt32();
+
+  JS::RootedObject result(cx, JS_NewPlainObject(cx));
+  if (!result)
+    return false;
+
+  // The entry list is live, so entries appended while iterating are visited, too.
+  uint32_t length;
+  if (!JS::GetArrayLength(cx, list, &length))
+    return false;
+
+  if (index >= length) {
+    JS_DefineProperty(cx, result, "done", true, JSPROP_ENUMERATE);
+    JS_DefineProperty(cx, result, "value", JS::UndefinedHandleValue, JSPROP_ENUMERATE);
+
+    args.rval().setObject(*result);
+    return true;
+  }
+
+  JS_DefineProperty(cx, result, "done", false, JSPROP_ENUMERATE);
+
+  JS::RootedString name(cx);
+  JS::RootedValue value(cx);
+  if (!get_entry(cx, list, index, &name, &value))
+    return false;
+
+  JS::RootedValue result_val(cx);
+
+  switch (type) {
+  case ITERTYPE_ENTRIES: {
+    // Entries are copied, so that changing them doesn't change the FormData.
+    JSObject *pair = new_entry(cx, name, value);
+    if (!pair)
+      return false;
+    result_val = JS::ObjectValue(*pair);
+    break;
+  }
+  case ITERTYPE_KEYS: {
+    result_val = JS::StringValue(name);
+    break;
+  }
+  case ITERTYPE_VALUES: {
+    result_val = value;
+    break;
+  }
+  default:
+    MOZ_RELEASE_ASSERT(false, "Invalid iter type");
+  }
+
+  JS_DefineProperty(cx, result, "value", result_val, JSPROP_ENUMERATE);
+
+  JS::SetReservedSlot(self, Slots::Index, JS::Int32Value(index + 1));
+  args.rval().setObject(*result);
+  return true;
+}
+
+const JSFunctionSpec FormDataIterator::static_methods[] = {
+    JS_FS_END,
+};
+
+const JSPropertySpec FormDataIterator::static_properties[] = {
+    JS_PS_END,
+};
+
+const JSFunctionSpec FormDataIterator::methods[] = {
+    JS_FN("next", FormDataIterator::next, 0, JSPROP_ENUMERATE),
+    JS_FS_END,
+};
+
+const JSPropertySpec FormDataIterator::properties[] = {
+    JS_PS_END,
+};
+
+// This constructor will be deleted from the class prototype right after class
+// initialization.
+bool FormDataIterator::constructor(JSContext *cx, unsigned argc, JS::Value *vp) {
+  MOZ_RELEASE_ASSERT(false, "Should be deleted");
+  return false;
+}
+
+bool FormDataIterator::init_class(JSContext *cx, JS::HandleObject global) {
+  JS::RootedObject iterator_proto(cx, JS::GetRealmIteratorPrototype(cx));
+  if (!iterator_proto)
+    return false;
+
+  if (!init_class_impl(cx, global, iterator_proto))
+    return false;
+
+  // Delete both the `FormDataIterator` global property and the `constructor` property on
+  // `FormDataIterator.prototype`. The latter because Iterators don't have their own constructor on
+  // the prototype.
+  return JS_DeleteProperty(cx, global, class_.name) &&
+         JS_DeleteProperty(cx, proto_obj, "constructor");
+}
+
+JSObject *FormDataIterator::create(JSContext *cx, JS::HandleObject form, uint8_t type) {
+  MOZ_RELEASE_ASSERT(type <= ITERTYPE_VALUES);
+
+  JS::RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &class_, proto_obj));
+  if (!self)
+    return nullptr;
+
+  JS::SetReservedSlot(self, Slots::Form, JS::ObjectValue(*form));
+  JS::SetReservedSlot(self, Slots::Type, JS::Int32Value(type));
+  JS::SetReservedSlot(self, Slots::Index, JS::Int32Value(0));
+
+  return self;
+}
+
+JSObject *FormData::entry_list(JSObject *self) {
+  MOZ_ASSERT(is_instance(self));
+  return &JS::GetReservedSlot(self, Slots::Entries).toObject();
+}
+
+// https://xhr.spec.whatwg.org/#dom-formdata-append
+bool FormData::append(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(2)
+  JS::RootedObject entry(cx, create_entry(cx, args, "FormData.append"));
+  if (!entry) {
+    return false;
+  }
+
+  JS::RootedObject list(cx, entry_list(self));
+  uint32_t length;
+  if (!JS::GetArrayLength(cx, list, &length) || !JS_SetElement(cx, list, length, entry)) {
+    return false;
+  }
+
+  args.rval().setUndefined();
+  return true;
+}
+
+// https://xhr.spec.whatwg.org/#dom-formdata-delete
+bool FormData::delete_(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER_WITH_NAME(1, "delete")
+  JS::RootedString name(cx, JS::ToString(cx, args[0]));
+  if (!name) {
+    return false;
+  }
+
+  JS::RootedObject list(cx, entry_list(self));
+  uint32_t length;
+  if (!JS::GetArrayLength(cx, list, &length)) {
+    return false;
+  }
+
+  // The remaining entries are moved to the front of the list, keeping their order.
+  JS::RootedString entry_name(cx);
+  JS::RootedValue entry_value(cx);
+  JS::RootedValue entry(cx);
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < length; i++) {
+    bool equal;
+    if (!get_entry(cx, list, i, &entry_name, &entry_value) ||
+        !names_equal(cx, entry_name, name, &equal)) {
+      return false;
+    }
+    if (equal) {
+      continue;
+    }
+    if (kept != i) {
+      if (!JS_GetElement(cx, list, i, &entry) || !JS_SetElement(cx, list, kept, entry)) {
+        return false;
+      }
+    }
+    kept++;
+  }
+
+  if (kept != length && !JS::SetArrayLength(cx, list, kept)) {
+    return false;
+  }
+
+  args.rval().setUndefined();
+  return true;
+}
+
+// https://xhr.spec.whatwg.org/#dom-formdata-get
+bool FormData::get(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(1)
+  JS::RootedString name(cx, JS::ToString(cx, args[0]));
+  if (!name) {
+    return false;
+  }
+
+  JS::RootedObject list(cx, entry_list(self));
+  uint32_t length;
+  if (!JS::GetArrayLength(cx, list, &length)) {
+    return false;
+  }
+
+  JS::RootedString entry_name(cx);
+  for (uint32_t i = 0; i < length; i++) {
+    bool equal;
+    if (!get_entry(cx, list, i, &entry_name, args.rval()) ||
+        !names_equal(cx, entry_name, name, &equal)) {
+      return false;
+    }
+    if (equal) {
+      return true;
+    }
+  }
+
+  args.rval().setNull();
+  return true;
+}
+
+// https://xhr.spec.whatwg.org/#dom-formdata-getall
+bool FormData::getAll(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(1)
+  JS::RootedString name(cx, JS::ToString(cx, args[0]));
+  if (!name) {
+    return false;
+  }
+
+  JS::RootedObject list(cx, entry_list(self));
+  uint32_t length;
+  if (!JS::GetArrayLength(cx, list, &length)) {
+    return false;
+  }
+
+  JS::RootedObject result(cx, JS::NewArrayObject(cx, 0));
+  if (!result) {
+    return false;
+  }
+
+  JS::RootedString entry_name(cx);
+  JS::RootedValue entry_value(cx);
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < length; i++) {
+    bool equal;
+    if (!get_entry(cx, list, i, &entry_name, &entry_value) ||
+        !names_equal(cx, entry_name, name, &equal)) {
+      return false;
+    }
+    if (equal && !JS_SetElement(cx, result, count++, entry_value)) {
+      return false;
+    }
+  }
+
+  args.rval().setObject(*result);
+  return true;
+}
+
+// https://xhr.spec.whatwg.org/#dom-formdata-has
+bool FormData::has(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(1)
+  JS::RootedString name(cx, JS::ToString(cx, args[0]));
+  if (!name) {
+    return false;
+  }
+
+  JS::RootedObject list(cx, entry_list(self));
+  uint32_t length;
+  if (!JS::GetArrayLength(cx, list, &length)) {
+    return false;
+  }
+
+  JS::RootedString entry_name(cx);
+  JS::RootedValue entry_value(cx);
+  for (uint32_t i = 0; i < length; i++) {
+    bool equal;
+    if (!get_entry(cx, list, i, &entry_name, &entry_value) ||
+        !names_equal(cx, entry_name, name, &equal)) {
+      return false;
+    }
+    if (equal) {
+      args.rval().setBoolean(true);
+      return true;
+    }
+  }
+
+  args.rval().setBoolean(false);
+  return true;
+}
+
+// https://xhr.spec.whatwg.org/#dom-formdata-set
+bool FormData::set(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(2)
+  JS::RootedObject replacement(cx, create_entry(cx, args, "FormData.set"));
+  if (!replacement) {
+    return false;
+  }
+  JS::RootedString name(cx, JS::ToString(cx, args[0]));
+  if (!name) {
+    return false;
+  }
+
+  JS::RootedObject list(cx, entry_list(self));
+  uint32_t length;
+  if (!JS::GetArrayLength(cx, list, &length)) {
+    return false;
+  }
+
+  // The first entry with the same name is replaced, and all others removed.
+  JS::RootedString entry_name(cx);
+  JS::RootedValue entry_value(cx);
+  JS::RootedValue entry(cx);
+  bool replaced = false;
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < length; i++) {
+    bool equal;
+    if (!get_entry(cx, list, i, &entry_name, &entry_value) ||
+        !names_equal(cx, entry_name, name, &equal)) {
+      return false;
+    }
+    if (equal) {
+      if (replaced) {
+        continue;
+      }
+      replaced = true;
+      entry.setObject(*replacement);
+    } else if (!JS_GetElement(cx, list, i, &entry)) {
+      return false;
+    }
+    if (!JS_SetElement(cx, list, kept++, entry)) {
+      return false;
+    }
+  }
+
+  if (!replaced) {
+    if (!JS_SetElement(cx, list, length, replacement)) {
+      return false;
+    }
+  } else if (kept != length && !JS::SetArrayLength(cx, list, kept)) {
+    return false;
+  }
+
+  args.rval().setUndefined();
+  return true;
+}
+
+bool FormData::forEach(JSContext *cx, unsigned argc, JS::Value *vp) {
+  METHOD_HEADER(1)
+
+  if (!args[0].isObject() || !JS::IsCallable(&args[0].toObject())) {
+    JS_ReportErrorASCII(cx, "Failed to execute 'forEach' on 'FormData': "
+                            "parameter 1 is not of type 'Function'");
+    return false;
+  }
+
+  JS::HandleValue callback = args[0];
+  JS::HandleValue thisv = args.get(1);
+
+  JS::RootedValueArray<3> newArgs(cx);
+  newArgs[2].setObject(*self);
+  JS::RootedValue rval(cx);
+  JS::RootedString name(cx);
+
+  // The entry list is read again on every iteration, since the callback can change it.
+  JS::RootedObject list(cx);
+  uint32_t index = 0;
+  while (true) {
+    list = entry_list(self);
+    uint32_t length;
+    if (!JS::GetArrayLength(cx, list, &length))
+      return false;
+    if (index >= length)
+      break;
+
+    if (!get_entry(cx, list, index, &name, newArgs[0]))
+      return false;
+    newArgs[1].setString(name);
+    if (!JS::Call(cx, thisv, callback, newArgs, &rval))
+      return false;
+
+    index++;
+  }
+
+  args.rval().setUndefined();
+  return true;
+}
+
+#define ITERATOR_METHOD(name, type)                                                                \
+  bool FormData::name(JSContext *cx, unsigned argc, JS::Value *vp) {                               \
+    METHOD_HEADER(0)                                                                               \
+                                                                                                   \
+    JS::RootedObject iter(cx, FormDataIterator::create(cx, self, type));                           \
+    if (!iter)                                                                                     \
+      return false;                                                                                \
+    args.rval().setObject(*iter);                                                                  \
+    return true;                                                                                   \
+  }
+
+ITERATOR_METHOD(entries, ITERTYPE_ENTRIES);
+ITERATOR_METHOD(keys, ITERTYPE_KEYS);
+ITERATOR_METHOD(values, ITERTYPE_VALUES);
+
+#undef ITERATOR_METHOD
+
+const JSFunctionSpec FormData::static_methods[] = {
+    JS_FS_END,
+};
+
+const JSPropertySpec FormData::static_properties[] = {
+    JS_PS_END,
+};
+
+const JSFunctionSpec FormData::methods[] = {
+    JS_FN("append", FormData::append, 2, JSPROP_ENUMERATE),
+    JS_FN("delete", FormData::delete_, 1, JSPROP_ENUMERATE),
+    JS_FN("get", FormData::get, 1, JSPROP_ENUMERATE),
+    JS_FN("getAll", FormData::getAll, 1, JSPROP_ENUMERATE),
+    JS_FN("has", FormData::has, 1, JSPROP_ENUMERATE),
+    JS_FN("set", FormData::set, 2, JSPROP_ENUMERATE),
+    JS_FN("forEach", FormData::forEach, 1, JSPROP_ENUMERATE),
+    JS_FN("entries", FormData::entries, 0, JSPROP_ENUMERATE),
+    JS_FN("keys", FormData::keys, 0, JSPROP_ENUMERATE),
+    JS_FN("values", FormData::values, 0, JSPROP_ENUMERATE),
+    // [Symbol.iterator] added in init_class.
+    JS_FS_END,
+};
+
+const JSPropertySpec FormData::properties[] = {
+    JS_STRING_SYM_PS(toStringTag, "FormData", JSPROP_READONLY),
+    JS_PS_END,
+};
+
+// https://xhr.spec.whatwg.org/#dom-formdata
+bool FormData::constructor(JSContext *cx, unsigned argc, JS::Value *vp) {
+  CTOR_HEADER("FormData", 0);
+
+  // There are no form elements to read entries from.
+  if (!args.get(0).isUndefined()) {
+    JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_FORM_DATA_FORM_UNSUPPORTED);
+    return false;
+  }
+
+  JS::RootedObject self(cx, JS_NewObjectForConstructor(cx, &class_, args));
+  if (!self) {
+    return false;
+  }
+  JS::RootedObject list(cx, JS::NewArrayObject(cx, 0));
+  if (!list) {
+    return false;
+  }
+  JS::SetReservedSlot(self, Slots::Entries, JS::ObjectValue(*list));
+
+  args.rval().setObject(*self);
+  return true;
+}
+
+bool FormData::init_class(JSContext *cx, JS::HandleObject global) {
+  if (!init_class_impl(cx, global))
+    return false;
+
+  JS::RootedValue entries(cx);
+  if (!JS_GetProperty(cx, proto_obj, "entries", &entries))
+    return false;
+
+  JS::SymbolCode code = JS::SymbolCode::iterator;
+  JS::RootedId iteratorId(cx, JS::GetWellKnownSymbolKey(cx, code));
+  return JS_DefinePropertyById(cx, proto_obj, iteratorId, entries, 0);
+}
+
+JSObject *FormData::create(JSContext *cx, std::vector<ParsedEntry> entries) {
+  JS::RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &class_, proto_obj));
+  if (!self) {
+    return nullptr;
+  }
+  JS::RootedObject list(cx, JS::NewArrayObject(cx, entries.size()));
+  if (!list) {
+    return nullptr;
+  }
+  JS::SetReservedSlot(self, Slots::Entries, JS::ObjectValue(*list));
+
+  JS::RootedString name(cx);
+  JS::RootedValue value(cx);
+  JS::RootedString filename(cx);
+  JS::RootedString type(cx);
+  for (size_t i = 0; i < entries.size(); i++) {
+    auto &entry = entries[i];
+    name = JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(entry.name.data(), entry.name.size()));
+    if (!name) {
+      return nullptr;
+    }
+
+    if (entry.filename) {
+      filename = JS_NewStringCopyUTF8N(
+          cx, JS::UTF8Chars(entry.filename->data(), entry.filename->size()));
+      type = filename ? Blob::normalize_type(cx, entry.type) : nullptr;
+      if (!type) {
+        return nullptr;
+      }
+      JSObject *file = File::create(cx, std::move(entry.contents), type, filename);
+      if (!file) {
+        return nullptr;
+      }
+      value.setObject(*file);
+    } else {
+      JSString *str =
+          JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(entry.value.data(), entry.value.size()));
+      if (!str) {
+        return nullptr;
+      }
+      value.setString(str);
+    }
+
+    JS::RootedObject pair(cx, new_entry(cx, name, value));
+    if (!pair || !JS_SetElement(cx, list, i, pair)) {
+      return nullptr;
+    }
+  }
+
+  return self;
+}
+
+JSObject *FormData::parse(JSContext *cx, std::string_view content_type, JS::UniqueChars buf,
+                          size_t len) {
+  if (auto boundary = multipart_boundary(content_type)) {
+    MultipartParser parser(*boundary);
+    bool ok = true;
+    if (len > 0) {
+      // The buffer becomes the only segment of all Files in the body.
+      auto *data = reinterpret_cast<uint8_t *>(buf.release());
+      ok = parser.feed(std::make_shared<const blob::BlobSegment>(data, len));
+    }
+    if (!ok || !parser.finish()) {
+      JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_FORM_DATA_MALFORMED_BODY);
+      return nullptr;
+    }
+    return create(cx, parser.take_entries());
+  }
+
+  if (is_urlencoded(content_type)) {
+    return create(cx, parse_urlencoded(std::string_view(buf.get(), buf ? len : 0)));
+  }
+
+  JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr, JSMSG_FORM_DATA_INVALID_CONTENT_TYPE);
+  return nullptr;
+}
+
+bool FormData::make_boundary(JSContext *cx, std::string *boundary) {
+  auto res = host_api::Random::get_bytes(16);
+  if (auto *err = res.to_err()) {
+    HANDLE_ERROR(cx, *err);
+    return false;
+  }
+
+  auto bytes = std::move(res.unwrap());
+  *boundary = "----StarlingMonkeyFormBoundary";
+  char hex[3];
+  for (size_t i = 0; i < 16; i++) {
+    snprintf(hex, sizeof(hex), "%02x", bytes.begin()[i]);
+    boundary->append(hex, 2);
+  }
+  return true;
+}
+
+bool FormData::write_multipart(JSContext *cx, JS::HandleObject self,
+                               host_api::HttpOutgoingBody *body, std::string_view boundary) {
+  JS::RootedObject list(cx, entry_list(self));
+  uint32_t length;
+  if (!JS::GetArrayLength(cx, list, &length)) {
+    return false;
+  }
+
+  // Headers and string values are collected, and only written before the contents of a File, or
+  // at the end.
+  std::string buf;
+  auto flush = [&]() {
+    auto res = body->write_all(reinterpret_cast<const uint8_t *>(buf.data()), buf.size());
+    buf.clear();
+    if (auto *err = res.to_err()) {
+      HANDLE_ERROR(cx, *err);
+      return false;
+    }
+    return true;
+  };
+
+  JS::RootedString name(cx);
+  JS::RootedValue value(cx);
+  for (uint32_t i = 0; i < length; i++) {
+    if (!get_entry(cx, list, i, &name, &value)) {
+      return false;
+    }
+    auto name_chars = core::encode(cx, name);
+    if (!name_chars) {
+      return false;
+    }
+    buf.append("--").append(boundary).append("\r\nContent-Disposition: form-data; name=\"");
+    append_field(&buf, name_chars, true, true);
+    buf.push_back('"');
+
+    if (value.isString()) {
+      auto value_chars = core::encode(cx, value);
+      if (!value_chars) {
+        return false;
+      }
+      buf.append("\r\n\r\n");
+      append_field(&buf, value_chars, true, false);
+      buf.append("\r\n");
+      continue;
+    }
+
+    JS::RootedObject file(cx, &value.toObject());
+    JS::RootedString filename(cx, File::name(file));
+    auto filename_chars = core::encode(cx, filename);
+    if (!filename_chars) {
+      return false;
+    }
+    JS::RootedString type(cx, Blob::type(file));
+    auto type_chars = core::encode(cx, type);
+    if (!type_chars) {
+      return false;
+    }
+    buf.append("; filename=\"");
+    append_field(&buf, filename_chars, false, true);
+    buf.append("\"\r\nContent-Type: ");
+    buf.append(type_chars.len > 0 ? std::string_view(type_chars) : "application/octet-stream");
+    buf.append("\r\n\r\n");
+    if (!flush()) {
+      return false;
+    }
+
+    for (const auto &part : Blob::parts(file)) {
+      auto res = body->write_all(part.data(), part.length);
+      if (auto *err = res.to_err()) {
+        HANDLE_ERROR(cx, *err);
+        return false;
+      }
+    }
+    buf.append("\r\n");
+  }
+
+  buf.append("--").append(boundary).append("--\r\n");
+  return flush();
+}
+
+bool install(api::Engine *engine) {
+  if (!FormData::init_class(engine->cx(), engine->global()))
+    return false;
+  if (!FormDataIterator::init_class(engine->cx(), engine->global()))
+    return false;
+  return true;
+}
+
+} // namespace builtins::web::form_data
@@ -0,0 +1,96 @@
+#ifndef BUILTINS_WEB_FORM_DATA_H
+#define BUILTINS_WEB_FORM_DATA_H
+
+#include "builtin.h"
+#include "form-data-parser.h"
+#include "host_api.h"
+
+namespace builtins::web::form_data {
+
+class FormDataIterator final : public BuiltinNoConstructor<FormDataIterator> {
+public:
+  static constexpr const char *class_name = "FormDataIterator";
+
+  enum Slots { Form, Type, Index, Count };
+
+  static bool next(JSContext *cx, unsigned argc, JS::Value *vp);
+
+  static const JSFunctionSpec static_methods[];
+  static const JSPropertySpec static_properties[];
+  static const JSFunctionSpec methods[];
+  static const JSPropertySpec properties[];
+
+  static const unsigned ctor_length = 0;
+
+  static JSObject *create(JSContext *cx, JS::HandleObject form, uint8_t type);
+  static bool init_class(JSContext *cx, JS::HandleObject global);
+  static bool constructor(JSContext *cx, unsigned argc, JS::Value *vp);
+};
+
+/**
+ * https://xhr.spec.whatwg.org/#interface-formdata
+ *
+ * The entry list is an array of `[name, value]` pairs, where values are either strings or Files.
+ */
+class FormData final : public BuiltinImpl<FormData> {
+  static bool append(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool delete_(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool get(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool getAll(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool has(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool set(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool forEach(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool entries(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool keys(JSContext *cx, unsigned argc, JS::Value *vp);
+  static bool values(JSContext *cx, unsigned argc, JS::Value *vp);
+
+public:
+  static constexpr const char *class_name = "FormData";
+
+  enum Slots {
+    /// The entry list, as an array of `[name, value]` pairs.
+    Entries,
+    Count
+  };
+
+  static const JSFunctionSpec static_methods[];
+  static const JSPropertySpec static_properties[];
+  static const JSFunctionSpec methods[];
+  static const JSPropertySpec properties[];
+
+  static const unsigned ctor_length = 0;
+
+  static bool init_class(JSContext *cx, JS::HandleObject global);
+  static bool constructor(JSContext *cx, unsigned argc, JS::Value *vp);
+
+  static JSObject *entry_list(JSObject *self);
+
+  /// Create a FormData from entries parsed from a body. File contents are moved into the Files.
+  static JSObject *create(JSContext *cx, std::vector<ParsedEntry> entries);
+
+  /**
+   * Parse the complete body `buf` according to `content_type`, which has to be either a
+   * `multipart/form-data` or an `application/x-www-form-urlencoded` MIME type. Throws a TypeError
+   * if it's neither, or if the body is malformed.
+   */
+  static JSObject *parse(JSContext *cx, std::string_view content_type, JS::UniqueChars buf,
+                         size_t len);
+
+  /// Generate a random boundary for serializing a FormData as `multipart/form-data`.
+  static bool make_boundary(JSContext *cx, std::string *boundary);
+
+  /**
+   * https://html.spec.whatwg.org/#multipart/form-data-encoding-algorithm
+   *
+   * Write `self`'s entries to `body`, delimited by `boundary`. The contents of Files are written
+   * straight from their segments.
+   */
+  static bool write_multipart(JSContext *cx, JS::HandleObject self,
+                              host_api::HttpOutgoingBody *body, std::string_view boundary);
+};
+
+bool install(api::Engine *engine);
+
+} // namespace builtins::web::form_data
+
+#endif
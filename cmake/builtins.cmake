@@ -1,5 +1,23 @@
 include("add_builtin")
 
+# The largest number of bytes to read from an incoming body at a time, see
+# `MAX_HANDLE_READ_CHUNK_SIZE` in builtins/web/fetch/request-response.h.
+if (DEFINED ENV{MAX_BODY_READ_CHUNK_SIZE})
+    add_compile_definitions(MAX_BODY_READ_CHUNK_SIZE=$ENV{MAX_BODY_READ_CHUNK_SIZE})
+endif()
+
+# Read the bodies of incoming requests with a `Content-Length` of at most this many bytes before
+# the handler asks for them, see `RequestOrResponse::maybe_prefetch_body`.
+if (DEFINED ENV{BODY_PREFETCH_LIMIT})
+    add_compile_definitions(BODY_PREFETCH_LIMIT=$ENV{BODY_PREFETCH_LIMIT})
+endif()
+
+# The number of bytes a branch of a body tee, as used by `Response#clone` and `Request#clone`, can
+# have queued before reading pauses until it has caught up, see `BodyTee`.
+if (DEFINED ENV{BODY_TEE_BUFFER_LIMIT})
+    add_compile_definitions(BODY_TEE_BUFFER_LIMIT=$ENV{BODY_TEE_BUFFER_LIMIT})
+endif()
+
 set(INSTALL_BUILTINS ${CMAKE_CURRENT_BINARY_DIR}/builtins.incl CACHE INTERNAL "Path to the builtins.incl file" FORCE)
 file(WRITE ${INSTALL_BUILTINS} "// This file is generated by CMake\n")
 
@@ -19,6 +37,13 @@ add_builtin(builtins/web/console.cpp)
 add_builtin(builtins/web/dom-exception.cpp)
 target_include_directories(builtins_web_dom_exception PRIVATE runtime)
 
+add_builtin(
+        builtins::web::abort
+        SRC
+            builtins/web/abort/abort-controller.cpp
+            builtins/web/abort/abort-signal.cpp)
+target_include_directories(builtins_web_abort PRIVATE runtime)
+
 add_builtin(builtins/web/performance.cpp)
 add_builtin(builtins/web/queue-microtask.cpp)
 add_builtin(builtins/web/structured-clone.cpp)
@@ -48,12 +73,26 @@ add_builtin(
             builtins/web/streams/transform-stream-default-controller.cpp)
 target_include_directories(builtins_web_streams PRIVATE runtime)
 
+add_builtin(builtins/web/blob.cpp)
+target_include_directories(builtins_web_blob PRIVATE runtime)
+
+add_builtin(builtins/web/file.cpp)
+
+add_builtin(
+        builtins::web::form-data
+        SRC
+            builtins/web/form-data/form-data.cpp
+            builtins/web/form-data/form-data-parser.cpp)
+target_include_directories(builtins_web_form_data PRIVATE runtime)
+
 add_builtin(
         builtins::web::fetch
         SRC
+        builtins/web/fetch/body-tee.cpp
         builtins/web/fetch/fetch-api.cpp
         builtins/web/fetch/headers.cpp
-        builtins/web/fetch/request-response.cpp)
+        builtins/web/fetch/request-response.cpp
+        builtins/web/fetch/response-template.cpp)
 
 add_builtin(builtins/web/fetch/fetch_event.cpp)
 target_link_libraries(builtins_web_fetch_fetch_event PRIVATE host_api)
@@ -71,3 +110,11 @@ add_builtin(
         builtins/web/crypto/subtle-crypto.cpp)
 target_link_libraries(builtins_web_crypto PRIVATE OpenSSL::Crypto fmt)
 target_include_directories(builtins_web_crypto PRIVATE runtime)
+
+add_builtin(
+        builtins::web::cache
+        SRC
+        builtins/web/cache/cache.cpp
+        builtins/web/cache/cache-storage.cpp
+        builtins/web/cache/cache-store.cpp)
+target_include_directories(builtins_web_cache PRIVATE runtime)
@@ -1,14 +1,25 @@
-add_library(host_api STATIC
-        ${HOST_API}/host_api.cpp
-        ${HOST_API}/host_call.cpp
-        ${HOST_API}/bindings/bindings.c
-        ${HOST_API}/bindings/bindings_component_type.o
-        ${CMAKE_CURRENT_SOURCE_DIR}/include/host_api.h
-)
+# Host APIs that aren't based on wit-bindgen generated bindings provide their own build setup.
+if (EXISTS ${HOST_API}/host_api.cmake)
+    include(${HOST_API}/host_api.cmake)
+else()
+    add_library(host_api STATIC
+            ${HOST_API}/host_api.cpp
+            ${HOST_API}/host_call.cpp
+            ${HOST_API}/bindings/bindings.c
+            ${HOST_API}/bindings/bindings_component_type.o
+            ${CMAKE_CURRENT_SOURCE_DIR}/include/host_api.h
+    )
+
+    target_link_libraries(host_api PRIVATE spidermonkey)
+    target_include_directories(host_api PRIVATE include runtime)
+    target_include_directories(host_api PUBLIC ${HOST_API}/include)
+endif()
 
-target_link_libraries(host_api PRIVATE spidermonkey)
-target_include_directories(host_api PRIVATE include)
-target_include_directories(host_api PUBLIC ${HOST_API}/include)
+# Route all host calls through the profiler in runtime/host_call_profiler.h, and print a table of
+# the calls made after each request.
+if (DEFINED ENV{HOST_CALL_PROFILING})
+    add_compile_definitions(HOST_CALL_PROFILING)
+endif()
 
 if (CMAKE_BUILD_TYPE STREQUAL "Debug")
     set(ADAPTER "debug")
@@ -0,0 +1,13 @@
+# Flags for building natively for the host, see `host-apis/native`.
+set(CMAKE_CXX_STANDARD 20)
+add_compile_definitions("$<$<CONFIG:DEBUG>:DEBUG=1>")
+add_compile_definitions(STARLING_NATIVE)
+
+list(APPEND CMAKE_CXX_FLAGS
+        -Wall -Wno-unknown-attributes -fno-sized-deallocation -fno-aligned-new
+        -fno-rtti -fno-exceptions -fno-math-errno -pipe -fno-omit-frame-pointer -funwind-tables
+)
+list(JOIN CMAKE_CXX_FLAGS " " CMAKE_CXX_FLAGS)
+
+list(APPEND CMAKE_C_FLAGS -Wall -Wno-unknown-attributes)
+list(JOIN CMAKE_C_FLAGS " " CMAKE_C_FLAGS)
@@ -1,3 +1,8 @@
+if (NATIVE)
+    find_package(OpenSSL REQUIRED COMPONENTS Crypto)
+    return()
+endif()
+
 # Based on https://stackoverflow.com/a/72187533
 set(OPENSSL_VERSION 3.0.7)
 set(OPENSSL_SOURCE_DIR ${CMAKE_CURRENT_BINARY_DIR}/openssl-src) # default path by CMake
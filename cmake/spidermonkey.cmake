@@ -6,12 +6,23 @@ else()
     set(SM_BUILD_TYPE release)
 endif()
 
-CPMAddPackage(NAME spidermonkey-${SM_BUILD_TYPE}
-        URL https://github.com/tschneidereit/spidermonkey-wasi-embedding/releases/download/rev_${SM_REV}/spidermonkey-wasm-static-lib_${SM_BUILD_TYPE}.tar.gz
-        DOWNLOAD_ONLY YES
-)
+if (NATIVE)
+    # There are no prebuilt native SpiderMonkey libraries, so one built from the same revision has
+    # to be provided, with the same layout as the wasm one.
+    if (NOT DEFINED ENV{SPIDERMONKEY_NATIVE_DIR})
+        message(FATAL_ERROR "Native builds require the SPIDERMONKEY_NATIVE_DIR environment variable \
+            to point to a native SpiderMonkey build of revision ${SM_REV}, containing `include` \
+            and `lib` folders.")
+    endif()
+    set(SM_SOURCE_DIR $ENV{SPIDERMONKEY_NATIVE_DIR} CACHE STRING "Path to spidermonkey ${SM_BUILD_TYPE} build" FORCE)
+else()
+    CPMAddPackage(NAME spidermonkey-${SM_BUILD_TYPE}
+            URL https://github.com/tschneidereit/spidermonkey-wasi-embedding/releases/download/rev_${SM_REV}/spidermonkey-wasm-static-lib_${SM_BUILD_TYPE}.tar.gz
+            DOWNLOAD_ONLY YES
+    )
 
-set(SM_SOURCE_DIR ${CPM_PACKAGE_spidermonkey-${SM_BUILD_TYPE}_SOURCE_DIR} CACHE STRING "Path to spidermonkey ${SM_BUILD_TYPE} build" FORCE)
+    set(SM_SOURCE_DIR ${CPM_PACKAGE_spidermonkey-${SM_BUILD_TYPE}_SOURCE_DIR} CACHE STRING "Path to spidermonkey ${SM_BUILD_TYPE} build" FORCE)
+endif()
 set(SM_INCLUDE_DIR ${SM_SOURCE_DIR}/include)
 
 file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/null.cpp "")
@@ -21,5 +32,9 @@ add_library(spidermonkey STATIC)
 target_sources(spidermonkey PRIVATE ${SM_OBJS} ${CMAKE_CURRENT_BINARY_DIR}/null.cpp)
 set_property(TARGET spidermonkey PROPERTY INTERFACE_INCLUDE_DIRECTORIES ${SM_INCLUDE_DIR})
 target_link_libraries(spidermonkey PUBLIC ${SM_SOURCE_DIR}/lib/libjs_static.a ${SM_SOURCE_DIR}/lib/libjsrust.a)
+if (NATIVE)
+    find_package(Threads REQUIRED)
+    target_link_libraries(spidermonkey PUBLIC Threads::Threads ${CMAKE_DL_LIBS} m)
+endif()
 
 add_compile_definitions("MOZ_JS_STREAMS")
@@ -4,5 +4,9 @@ if (${HOST_OS} STREQUAL "darwin")
     set(HOST_OS "macos")
 endif()
 
-include("compile-flags")
-include("wasi-sdk")
+if (NATIVE)
+    include("native-flags")
+else()
+    include("compile-flags")
+    include("wasi-sdk")
+endif()
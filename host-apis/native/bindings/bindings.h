@@ -0,0 +1,27 @@
+#ifndef NATIVE_BINDINGS_H
+#define NATIVE_BINDINGS_H
+
+// The native host API's stand-ins for the types and exports wit-bindgen generates for WASI hosts.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct native_incoming_request_t {
+  int32_t __handle;
+} native_incoming_request_t;
+
+typedef struct native_response_outparam_t {
+  int32_t __handle;
+} native_response_outparam_t;
+
+void native_incoming_handler_handle(native_incoming_request_t request,
+                                    native_response_outparam_t response_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
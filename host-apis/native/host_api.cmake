@@ -0,0 +1,11 @@
+add_library(host_api STATIC
+        ${HOST_API}/host_api.cpp
+        ${HOST_API}/host_call.cpp
+        ${HOST_API}/native.cpp
+        ${HOST_API}/recording.cpp
+        ${CMAKE_CURRENT_SOURCE_DIR}/include/host_api.h
+)
+
+target_link_libraries(host_api PRIVATE spidermonkey)
+target_include_directories(host_api PRIVATE include runtime ${HOST_API})
+target_include_directories(host_api PUBLIC ${HOST_API}/include)
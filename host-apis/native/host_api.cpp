@@ -0,0 +1,901 @@
+#include "host_api.h"
+#include "bindings/bindings.h"
+#include "exports.h"
+#include "native.h"
+#include "recording.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <strings.h>
+
+using std::optional;
+using std::string_view;
+using std::tuple;
+using std::unique_ptr;
+using std::vector;
+
+size_t api::AsyncTask::select(std::vector<api::AsyncTask *> *tasks) {
+  vector<native::Pollable *> pollables;
+  pollables.reserve(tasks->size());
+  for (const auto task : *tasks) {
+    pollables.push_back(native::get<native::Pollable>(task->id()));
+  }
+  return native::poll(pollables);
+}
+
+namespace {
+
+void handle_incoming_request(native::Handle request, native::Handle response_out) {
+  exports_wasi_http_incoming_handler({request}, {response_out});
+}
+
+} // namespace
+
+bool native_serve(const char *address) {
+  // Replay requests recorded with `STARLING_RECORD` instead of serving live ones.
+  if (auto *path = getenv("STARLING_REPLAY")) {
+    native::RecordingOptions options;
+    if (auto *iterations = getenv("STARLING_REPLAY_ITERATIONS")) {
+      options.iterations = std::max(atoi(iterations), 1);
+    }
+    options.emulate_latency = getenv("STARLING_REPLAY_LATENCY") != nullptr;
+    return native::replay(path, handle_incoming_request, options);
+  }
+
+  if (auto *path = getenv("STARLING_RECORD")) {
+    if (!native::start_recording(path)) {
+      return false;
+    }
+  }
+
+  return native::serve(address, handle_incoming_request);
+}
+
+namespace host_api {
+
+HostString::HostString(const char *c_str) {
+  len = strlen(c_str);
+  ptr = JS::UniqueChars(static_cast<char *>(malloc(len + 1)));
+  std::memcpy(ptr.get(), c_str, len);
+  ptr[len] = '\0';
+}
+
+namespace {
+
+HostString to_host_string(string_view str) {
+  auto ptr = JS::UniqueChars(static_cast<char *>(malloc(str.size() + 1)));
+  std::memcpy(ptr.get(), str.data(), str.size());
+  ptr[str.size()] = '\0';
+  return {std::move(ptr), str.size()};
+}
+
+native::Fields *get_fields(const HandleState *state) {
+  return native::get<native::Fields>(state->handle);
+}
+
+} // namespace
+
+Result<HostBytes> Random::get_bytes(size_t num_bytes) {
+  auto bytes = HostBytes::with_capacity(num_bytes);
+  if (!native::random_bytes({bytes.ptr.get(), num_bytes})) {
+    return Result<HostBytes>::err(154);
+  }
+  return Result<HostBytes>::ok(std::move(bytes));
+}
+
+Result<uint32_t> Random::get_u32() {
+  uint32_t value;
+  if (!native::random_bytes({reinterpret_cast<uint8_t *>(&value), sizeof(value)})) {
+    return Result<uint32_t>::err(154);
+  }
+  return Result<uint32_t>::ok(value);
+}
+
+uint64_t MonotonicClock::now() { return native::clock_now(); }
+
+uint64_t MonotonicClock::resolution() {
+  timespec resolution{};
+  clock_getres(CLOCK_MONOTONIC, &resolution);
+  return static_cast<uint64_t>(resolution.tv_sec) * 1000000000 + resolution.tv_nsec;
+}
+
+int32_t MonotonicClock::subscribe(const uint64_t when, const bool absolute) {
+  auto pollable = std::make_unique<native::Pollable>();
+  pollable->deadline = absolute ? when : native::monotonic_now() + when;
+  return native::insert(std::move(pollable));
+}
+
+void MonotonicClock::unsubscribe(const int32_t handle_id) {
+  native::take<native::Pollable>(handle_id);
+}
+
+HttpHeaders::HttpHeaders() {
+  this->handle_state_ = new HandleState(native::insert(std::make_unique<native::Fields>()));
+}
+HttpHeaders::HttpHeaders(Handle handle) { handle_state_ = new HandleState(handle); }
+
+HttpHeaders::HttpHeaders(const HttpHeaders &headers) {
+  auto fields = std::make_unique<native::Fields>(*get_fields(headers.handle_state_));
+  this->handle_state_ = new HandleState(native::insert(std::move(fields)));
+}
+
+Result<HttpHeaders *> HttpHeaders::from_list(const vector<tuple<string_view, string_view>> &entries) {
+  auto fields = std::make_unique<native::Fields>();
+  fields->entries.reserve(entries.size());
+  for (const auto &[name, value] : entries) {
+    fields->append(name, value);
+  }
+  return Result<HttpHeaders *>::ok(new HttpHeaders(native::insert(std::move(fields))));
+}
+
+Result<vector<tuple<HostString, HostString>>> HttpHeaders::entries() const {
+  MOZ_ASSERT(valid());
+  vector<tuple<HostString, HostString>> entries;
+  for (const auto &[name, value] : get_fields(handle_state_)->entries) {
+    entries.emplace_back(to_host_string(name), to_host_string(value));
+  }
+  return Result<vector<tuple<HostString, HostString>>>::ok(std::move(entries));
+}
+
+Result<const HttpHeadersTable *> HttpHeaders::table() {
+  if (table_) {
+    return Result<const HttpHeadersTable *>::ok(table_.get());
+  }
+  MOZ_ASSERT(valid());
+
+  auto &entries = get_fields(handle_state_)->entries;
+  size_t bytes = 0;
+  for (const auto &[name, value] : entries) {
+    bytes += name.size() + value.size();
+  }
+  table_ = std::make_unique<HttpHeadersTable>(entries.size(), bytes);
+  for (const auto &[name, value] : entries) {
+    table_->add(name, value);
+  }
+
+  return Result<const HttpHeadersTable *>::ok(table_.get());
+}
+
+Result<vector<HostString>> HttpHeaders::names() const {
+  MOZ_ASSERT(valid());
+  vector<HostString> names;
+  for (const auto &[name, _] : get_fields(handle_state_)->entries) {
+    names.emplace_back(to_host_string(name));
+  }
+  return Result<vector<HostString>>::ok(std::move(names));
+}
+
+Result<optional<vector<HostString>>> HttpHeaders::get(string_view name) const {
+  Result<optional<vector<HostString>>> res;
+  MOZ_ASSERT(valid());
+
+  std::vector<HostString> values;
+  for (const auto &[entry_name, value] : get_fields(handle_state_)->entries) {
+    if (entry_name.size() == name.size() &&
+        strncasecmp(entry_name.data(), name.data(), name.size()) == 0) {
+      values.emplace_back(to_host_string(value));
+    }
+  }
+
+  if (values.empty()) {
+    res.emplace(std::nullopt);
+  } else {
+    res.emplace(std::move(values));
+  }
+  return res;
+}
+
+Result<Void> HttpHeaders::set(string_view name, string_view value) {
+  MOZ_ASSERT(valid());
+  table_.reset();
+  auto fields = get_fields(handle_state_);
+  fields->remove(name);
+  fields->append(name, value);
+  return {};
+}
+
+Result<Void> HttpHeaders::append(string_view name, string_view value) {
+  MOZ_ASSERT(valid());
+  table_.reset();
+  get_fields(handle_state_)->append(name, value);
+  return {};
+}
+
+Result<Void> HttpHeaders::remove(string_view name) {
+  MOZ_ASSERT(valid());
+  table_.reset();
+  get_fields(handle_state_)->remove(name);
+  return {};
+}
+
+string_view HttpRequestResponseBase::url() {
+  if (_url) {
+    return string_view(*_url);
+  }
+  return {};
+}
+
+class OutgoingBodyHandleState final : HandleState {
+  std::shared_ptr<native::BodyWriter> writer_;
+  PollableHandle pollable_handle_;
+
+  friend HttpOutgoingBody;
+
+public:
+  explicit OutgoingBodyHandleState(const Handle handle)
+      : HandleState(handle), writer_(native::get<native::OutgoingBody>(handle)->writer),
+        pollable_handle_(INVALID_POLLABLE_HANDLE) {}
+};
+
+HttpOutgoingBody::HttpOutgoingBody(Handle handle) : Pollable() {
+  handle_state_ = new OutgoingBodyHandleState(handle);
+}
+
+Result<uint64_t> HttpOutgoingBody::capacity() {
+  if (!valid()) {
+    return Result<uint64_t>::err(154);
+  }
+  auto *state = static_cast<OutgoingBodyHandleState *>(this->handle_state_);
+  if (state->writer_->failed()) {
+    return Result<uint64_t>::err(154);
+  }
+  // Writes block until the connection has accepted all data, so there's no limit to how much can
+  // be written at once.
+  return Result<uint64_t>::ok(std::numeric_limits<uint32_t>::max());
+}
+
+Result<uint32_t> HttpOutgoingBody::write(const uint8_t *bytes, size_t len) {
+  if (!valid()) {
+    return Result<uint32_t>::err(154);
+  }
+  auto bytes_to_write = std::min<size_t>(len, std::numeric_limits<uint32_t>::max());
+  auto *state = static_cast<OutgoingBodyHandleState *>(this->handle_state_);
+  if (!state->writer_->write({bytes, bytes_to_write})) {
+    return Result<uint32_t>::err(154);
+  }
+  return Result<uint32_t>::ok(bytes_to_write);
+}
+
+Result<Void> HttpOutgoingBody::write_all(const uint8_t *bytes, size_t len) {
+  if (!valid()) {
+    return Result<Void>::err(154);
+  }
+  auto *state = static_cast<OutgoingBodyHandleState *>(this->handle_state_);
+  if (!state->writer_->write({bytes, len})) {
+    return Result<Void>::err(154);
+  }
+  return {};
+}
+
+class BodyAppendTask final : public api::AsyncTask {
+  enum class State {
+    BlockedOnBoth,
+    BlockedOnIncoming,
+    BlockedOnOutgoing,
+    Ready,
+    Done,
+  };
+
+  HttpIncomingBody *incoming_body_;
+  HttpOutgoingBody *outgoing_body_;
+  PollableHandle incoming_pollable_;
+  PollableHandle outgoing_pollable_;
+  State state_;
+
+  // Scratch buffer reused for all chunks copied from the incoming to the outgoing body.
+  static constexpr size_t BUFFER_SIZE = 64 * 1024;
+  unique_ptr<uint8_t[]> buffer_;
+
+  void set_state(const State state) {
+    MOZ_ASSERT(state_ != State::Done);
+    state_ = state;
+  }
+
+public:
+  explicit BodyAppendTask(HttpIncomingBody *incoming_body, HttpOutgoingBody *outgoing_body)
+      : incoming_body_(incoming_body), outgoing_body_(outgoing_body),
+        buffer_(new uint8_t[BUFFER_SIZE]) {
+    auto res = incoming_body_->subscribe();
+    MOZ_ASSERT(!res.is_err());
+    incoming_pollable_ = res.unwrap();
+
+    res = outgoing_body_->subscribe();
+    MOZ_ASSERT(!res.is_err());
+    outgoing_pollable_ = res.unwrap();
+
+    state_ = State::BlockedOnBoth;
+  }
+
+  [[nodiscard]] bool run(api::Engine *engine) override {
+    // If run is called while we're blocked on the incoming stream, that means that stream's
+    // pollable has resolved, so the stream must be ready.
+    if (state_ == State::BlockedOnBoth || state_ == State::BlockedOnIncoming) {
+      auto res = incoming_body_->read_into({});
+      MOZ_ASSERT(!res.is_err());
+      auto [done, _] = res.unwrap();
+      if (done) {
+        set_state(State::Done);
+        return true;
+      }
+      set_state(State::BlockedOnOutgoing);
+    }
+
+    uint64_t capacity = 0;
+    if (state_ == State::BlockedOnOutgoing) {
+      auto res = outgoing_body_->capacity();
+      if (res.is_err()) {
+        return false;
+      }
+      capacity = res.unwrap();
+      if (capacity > 0) {
+        set_state(State::Ready);
+      } else {
+        engine->queue_async_task(this);
+        return true;
+      }
+    }
+
+    MOZ_ASSERT(state_ == State::Ready);
+
+    do {
+      auto chunk_size = std::min<uint64_t>(capacity, BUFFER_SIZE);
+      auto res = incoming_body_->read_into({buffer_.get(), static_cast<size_t>(chunk_size)});
+      if (res.is_err()) {
+        // TODO: proper error handling.
+        return false;
+      }
+      auto [done, len] = res.unwrap();
+      if (len == 0 && !done) {
+        set_state(State::BlockedOnIncoming);
+        engine->queue_async_task(this);
+        return true;
+      }
+
+      size_t offset = 0;
+      while (len - offset > 0) {
+        auto write_res = outgoing_body_->write(buffer_.get() + offset, len - offset);
+        if (write_res.is_err()) {
+          // TODO: proper error handling.
+          return false;
+        }
+        offset += write_res.unwrap();
+      }
+
+      if (done) {
+        set_state(State::Done);
+        return true;
+      }
+
+      auto capacity_res = outgoing_body_->capacity();
+      if (capacity_res.is_err()) {
+        // TODO: proper error handling.
+        return false;
+      }
+      capacity = capacity_res.unwrap();
+    } while (capacity > 0);
+
+    set_state(State::BlockedOnOutgoing);
+    engine->queue_async_task(this);
+    return true;
+  }
+
+  [[nodiscard]] bool cancel(api::Engine *engine) override {
+    MOZ_ASSERT_UNREACHABLE("BodyAppendTask's semantics don't allow for cancellation");
+    return true;
+  }
+
+  bool ready() override { return state_ == State::Ready; }
+
+  [[nodiscard]] int32_t id() override {
+    if (state_ == State::BlockedOnBoth || state_ == State::BlockedOnIncoming) {
+      return incoming_pollable_;
+    }
+
+    MOZ_ASSERT(state_ == State::BlockedOnOutgoing,
+               "BodyAppendTask should only be queued if it's not known to be ready");
+    return outgoing_pollable_;
+  }
+
+  void trace(JSTracer *trc) override {
+    // Nothing to trace.
+  }
+};
+
+Result<Void> HttpOutgoingBody::append(api::Engine *engine, HttpIncomingBody *other) {
+  MOZ_ASSERT(valid());
+  engine->queue_async_task(new BodyAppendTask(other, this));
+  return {};
+}
+
+Result<Void> HttpOutgoingBody::close() {
+  MOZ_ASSERT(valid());
+
+  auto state = static_cast<OutgoingBodyHandleState *>(handle_state_);
+  bool success = state->writer_->finish();
+  unsubscribe();
+  native::take<native::OutgoingBody>(state->handle);
+
+  delete handle_state_;
+  handle_state_ = nullptr;
+
+  if (!success) {
+    return Result<Void>::err(154);
+  }
+  return {};
+}
+
+Result<PollableHandle> HttpOutgoingBody::subscribe() {
+  auto state = static_cast<OutgoingBodyHandleState *>(handle_state_);
+  if (state->pollable_handle_ == INVALID_POLLABLE_HANDLE) {
+    // Writes never have to wait, see `capacity`.
+    auto pollable = std::make_unique<native::Pollable>();
+    pollable->ready_check = []() { return true; };
+    state->pollable_handle_ = native::insert(std::move(pollable));
+  }
+  return Result<PollableHandle>::ok(state->pollable_handle_);
+}
+
+void HttpOutgoingBody::unsubscribe() {
+  auto state = static_cast<OutgoingBodyHandleState *>(handle_state_);
+  if (state->pollable_handle_ == INVALID_POLLABLE_HANDLE) {
+    return;
+  }
+  native::take<native::Pollable>(state->pollable_handle_);
+  state->pollable_handle_ = INVALID_POLLABLE_HANDLE;
+}
+
+HttpOutgoingRequest::HttpOutgoingRequest(HandleState *state) { this->handle_state_ = state; }
+
+HttpOutgoingRequest *HttpOutgoingRequest::make(string_view method_str, optional<HostString> url_str,
+                                               HttpHeaders *headers) {
+  auto message = std::make_unique<native::OutgoingMessage>();
+  message->method = method_str.empty() ? "GET" : method_str;
+  message->fields = headers->handle_state_->handle;
+
+  if (url_str) {
+    jsurl::SpecString val = url_str.value();
+    jsurl::JSUrl *url = new_jsurl(&val);
+    jsurl::SpecSlice protocol = jsurl::protocol(url);
+    // Strip the trailing colon.
+    message->scheme = string_view(reinterpret_cast<const char *>(protocol.data), protocol.len - 1);
+
+    jsurl::SpecSlice authority = jsurl::authority(url);
+    message->authority = string_view(reinterpret_cast<const char *>(authority.data), authority.len);
+
+    jsurl::SpecSlice path_with_query = jsurl::path_with_query(url);
+    message->path_with_query =
+        string_view(reinterpret_cast<const char *>(path_with_query.data), path_with_query.len);
+  }
+
+  auto *state = new HandleState(native::insert(std::move(message)));
+  auto *resp = new HttpOutgoingRequest(state);
+
+  resp->method_ = method_str;
+  resp->headers_ = headers;
+
+  return resp;
+}
+
+Result<string_view> HttpOutgoingRequest::method() {
+  MOZ_ASSERT(valid());
+  MOZ_ASSERT(headers_);
+  return Result<string_view>::ok(method_);
+}
+
+Result<HttpHeaders *> HttpOutgoingRequest::headers() {
+  MOZ_ASSERT(valid());
+  MOZ_ASSERT(headers_);
+  return Result<HttpHeaders *>::ok(headers_);
+}
+
+Result<HttpOutgoingBody *> HttpOutgoingRequest::body() {
+  typedef Result<HttpOutgoingBody *> Res;
+  MOZ_ASSERT(valid());
+  if (!this->body_) {
+    auto *message = native::get<native::OutgoingMessage>(handle_state_->handle);
+    message->body = std::make_shared<native::BodyWriter>();
+    auto body = std::make_unique<native::OutgoingBody>(message->body);
+    this->body_ = new HttpOutgoingBody(native::insert(std::move(body)));
+  }
+  return Res::ok(body_);
+}
+
+Result<FutureHttpIncomingResponse *> HttpOutgoingRequest::send(const OutgoingRequestOptions &options) {
+  MOZ_ASSERT(valid());
+  auto *message = native::get<native::OutgoingMessage>(handle_state_->handle);
+
+  // Like a WASI host, report failures to connect through the response future, so that they
+  // surface as network errors.
+  auto future = std::make_unique<native::FutureResponse>();
+  future->head_request = message->method == "HEAD";
+  future->between_bytes_timeout = options.between_bytes_timeout;
+  // TLS isn't supported, so requests to https URLs fail.
+  if (message->scheme == "http") {
+    future->conn = native::open_connection(message->authority, 80, options.connect_timeout,
+                                           &future->timed_out);
+  }
+  future->failed = !future->conn || !message->send_request(future->conn);
+  if (!future->failed && options.first_byte_timeout) {
+    future->first_byte_deadline = native::monotonic_now() + *options.first_byte_timeout;
+  }
+
+  auto res = new FutureHttpIncomingResponse(native::insert(std::move(future)));
+  return Result<FutureHttpIncomingResponse *>::ok(res);
+}
+
+class IncomingBodyHandleState final : HandleState {
+  native::BodyReader *reader_;
+  PollableHandle pollable_handle_;
+
+  friend HttpIncomingBody;
+
+public:
+  explicit IncomingBodyHandleState(const Handle handle)
+      : HandleState(handle), reader_(native::get<native::BodyReader>(handle)),
+        pollable_handle_(INVALID_POLLABLE_HANDLE) {}
+};
+
+HttpIncomingBody::HttpIncomingBody(const Handle handle) : Pollable() {
+  handle_state_ = new IncomingBodyHandleState(handle);
+}
+
+Result<HttpIncomingBody::ReadResult> HttpIncomingBody::read(uint32_t chunk_size) {
+  typedef Result<ReadResult> Res;
+
+  auto buffer = std::make_unique<uint8_t[]>(chunk_size);
+  auto res = read_into({buffer.get(), chunk_size});
+  if (auto *err = res.to_err()) {
+    return Res::err(*err);
+  }
+  auto [done, len] = res.unwrap();
+  if (done) {
+    return Res::ok(ReadResult(true, nullptr, 0));
+  }
+  return Res::ok(ReadResult(false, std::move(buffer), len));
+}
+
+Result<HttpIncomingBody::ReadIntoResult> HttpIncomingBody::read_into(std::span<uint8_t> buffer) {
+  typedef Result<ReadIntoResult> Res;
+
+  auto *state = static_cast<IncomingBodyHandleState *>(handle_state_);
+  bool done;
+  size_t len;
+  if (!state->reader_->read(buffer, &done, &len)) {
+    return Res::err(154);
+  }
+  return Res::ok(ReadIntoResult(done, len));
+}
+
+Result<Void> HttpIncomingBody::close() {
+  if (!valid()) {
+    return {};
+  }
+  // The rest of the body is discarded by the server once the request is done.
+  unsubscribe();
+  native::take<native::BodyReader>(handle_state_->handle);
+  delete handle_state_;
+  handle_state_ = nullptr;
+  return {};
+}
+
+Result<PollableHandle> HttpIncomingBody::subscribe() {
+  auto state = static_cast<IncomingBodyHandleState *>(handle_state_);
+  if (state->pollable_handle_ == INVALID_POLLABLE_HANDLE) {
+    state->pollable_handle_ = native::insert(state->reader_->subscribe());
+  }
+  return Result<PollableHandle>::ok(state->pollable_handle_);
+}
+
+void HttpIncomingBody::unsubscribe() {
+  auto state = static_cast<IncomingBodyHandleState *>(handle_state_);
+  if (state->pollable_handle_ == INVALID_POLLABLE_HANDLE) {
+    return;
+  }
+  native::take<native::Pollable>(state->pollable_handle_);
+  state->pollable_handle_ = INVALID_POLLABLE_HANDLE;
+}
+
+class FutureIncomingResponseHandleState final : HandleState {
+  PollableHandle pollable_handle_;
+
+  friend FutureHttpIncomingResponse;
+
+public:
+  explicit FutureIncomingResponseHandleState(const Handle handle)
+      : HandleState(handle), pollable_handle_(INVALID_POLLABLE_HANDLE) {}
+};
+
+FutureHttpIncomingResponse::FutureHttpIncomingResponse(Handle handle) {
+  handle_state_ = new FutureIncomingResponseHandleState(handle);
+}
+
+Result<optional<HttpIncomingResponse *>> FutureHttpIncomingResponse::maybe_response() {
+  typedef Result<optional<HttpIncomingResponse *>> Res;
+  auto *future = native::get<native::FutureResponse>(handle_state_->handle);
+  if (future->failed) {
+    return Res::err(future->timed_out ? TIMEOUT_ERROR : 154);
+  }
+  MOZ_ASSERT(!future->consumed,
+             "FutureHttpIncomingResponse::poll must not be called again after succeeding once");
+
+  auto &conn = *future->conn;
+  conn.fill();
+  native::ResponseHead head;
+  while (true) {
+    head = native::ResponseHead();
+    auto result = native::parse_response_head(conn, &head);
+    if (result == native::ParseResult::Incomplete) {
+      if (conn.eof() || conn.failed()) {
+        break;
+      }
+      if (future->first_byte_deadline && native::monotonic_now() >= *future->first_byte_deadline) {
+        future->failed = true;
+        future->timed_out = true;
+        return Res::err(TIMEOUT_ERROR);
+      }
+      return Res::ok(std::nullopt);
+    }
+    if (result == native::ParseResult::Invalid) {
+      break;
+    }
+    // Skip informational responses.
+    if (head.status >= 200) {
+      auto reader = native::BodyReader::for_response(future->conn, head.status,
+                                                     future->head_request, head.fields);
+      if (!reader) {
+        break;
+      }
+
+      auto message = std::make_unique<native::IncomingMessage>();
+      message->status = head.status;
+      message->fields = native::insert(std::make_unique<native::Fields>(std::move(head.fields)));
+      message->body = std::make_unique<native::BodyReader>(std::move(*reader));
+      if (future->between_bytes_timeout) {
+        message->body->set_between_bytes_timeout(*future->between_bytes_timeout);
+      }
+      future->consumed = true;
+      return Res::ok(new HttpIncomingResponse(native::insert(std::move(message))));
+    }
+  }
+
+  future->failed = true;
+  return Res::err(154);
+}
+
+Result<PollableHandle> FutureHttpIncomingResponse::subscribe() {
+  auto state = static_cast<FutureIncomingResponseHandleState *>(handle_state_);
+  if (state->pollable_handle_ == INVALID_POLLABLE_HANDLE) {
+    auto *future = native::get<native::FutureResponse>(state->handle);
+    unique_ptr<native::Pollable> pollable;
+    if (future->failed) {
+      pollable = std::make_unique<native::Pollable>();
+      pollable->ready_check = []() { return true; };
+    } else {
+      pollable = native::subscribe_to_response(future->conn, future->first_byte_deadline);
+    }
+    state->pollable_handle_ = native::insert(std::move(pollable));
+  }
+  return Result<PollableHandle>::ok(state->pollable_handle_);
+}
+
+void FutureHttpIncomingResponse::unsubscribe() {
+  auto state = static_cast<FutureIncomingResponseHandleState *>(handle_state_);
+  if (state->pollable_handle_ == INVALID_POLLABLE_HANDLE) {
+    return;
+  }
+  native::take<native::Pollable>(state->pollable_handle_);
+  state->pollable_handle_ = INVALID_POLLABLE_HANDLE;
+}
+
+void FutureHttpIncomingResponse::close() {
+  MOZ_ASSERT(valid());
+  unsubscribe();
+  native::take<native::FutureResponse>(handle_state_->handle);
+  delete handle_state_;
+  handle_state_ = nullptr;
+}
+
+Result<uint16_t> HttpIncomingResponse::status() {
+  if (status_ == UNSET_STATUS) {
+    if (!valid()) {
+      return Result<uint16_t>::err(154);
+    }
+    status_ = native::get<native::IncomingMessage>(handle_state_->handle)->status;
+  }
+  return Result<uint16_t>::ok(status_);
+}
+
+HttpIncomingResponse::HttpIncomingResponse(Handle handle) {
+  handle_state_ = new HandleState(handle);
+}
+
+Result<HttpHeaders *> HttpIncomingResponse::headers() {
+  if (!headers_) {
+    if (!valid()) {
+      return Result<HttpHeaders *>::err(154);
+    }
+    headers_ = new HttpHeaders(native::get<native::IncomingMessage>(handle_state_->handle)->fields);
+  }
+
+  return Result<HttpHeaders *>::ok(headers_);
+}
+
+namespace {
+
+/// Move the body of an incoming message into its own resource, like `consume` does.
+optional<Handle> consume_body(Handle message_handle) {
+  auto *message = native::get<native::IncomingMessage>(message_handle);
+  if (!message->body) {
+    return std::nullopt;
+  }
+  return native::insert(std::move(message->body));
+}
+
+} // namespace
+
+Result<HttpIncomingBody *> HttpIncomingResponse::body() {
+  if (!body_) {
+    if (!valid()) {
+      return Result<HttpIncomingBody *>::err(154);
+    }
+    auto body = consume_body(handle_state_->handle);
+    if (!body) {
+      return Result<HttpIncomingBody *>::err(154);
+    }
+    body_ = new HttpIncomingBody(*body);
+  }
+  return Result<HttpIncomingBody *>::ok(body_);
+}
+
+HttpOutgoingResponse::HttpOutgoingResponse(HandleState *state) { this->handle_state_ = state; }
+
+HttpOutgoingResponse *HttpOutgoingResponse::make(const uint16_t status, HttpHeaders *headers) {
+  auto message = std::make_unique<native::OutgoingMessage>();
+  message->status = status;
+  message->fields = headers->handle_state_->handle;
+
+  auto *state = new HandleState(native::insert(std::move(message)));
+  auto *resp = new HttpOutgoingResponse(state);
+
+  resp->status_ = status;
+  resp->headers_ = headers;
+
+  return resp;
+}
+
+Result<HttpHeaders *> HttpOutgoingResponse::headers() {
+  if (!valid()) {
+    return Result<HttpHeaders *>::err(154);
+  }
+  return Result<HttpHeaders *>::ok(headers_);
+}
+
+Result<HttpOutgoingBody *> HttpOutgoingResponse::body() {
+  typedef Result<HttpOutgoingBody *> Res;
+  MOZ_ASSERT(valid());
+  if (!this->body_) {
+    auto *message = native::get<native::OutgoingMessage>(handle_state_->handle);
+    message->body = std::make_shared<native::BodyWriter>();
+    auto body = std::make_unique<native::OutgoingBody>(message->body);
+    this->body_ = new HttpOutgoingBody(native::insert(std::move(body)));
+  }
+  return Res::ok(this->body_);
+}
+
+Result<uint16_t> HttpOutgoingResponse::status() { return Result<uint16_t>::ok(status_); }
+
+Result<Void> HttpOutgoingResponse::send(ResponseOutparam out_param) {
+  auto *outparam = native::get<native::ResponseOutparam>(out_param);
+  if (outparam->sent) {
+    return Result<Void>::err(154);
+  }
+  auto *message = native::get<native::OutgoingMessage>(handle_state_->handle);
+  if (!message->send_response(outparam)) {
+    return Result<Void>::err(154);
+  }
+  return {};
+}
+
+class IncomingRequestHandleState final : HandleState {
+  bool has_snapshot_ = false;
+  std::string method_;
+  // The URL is stored in a single buffer, with the offsets of its components recorded separately,
+  // so that all of them can be handed out as slices of the same string.
+  std::string url_;
+  size_t authority_start_ = 0;
+  size_t path_start_ = 0;
+
+  friend HttpIncomingRequest;
+
+public:
+  explicit IncomingRequestHandleState(const Handle handle) : HandleState(handle) {}
+
+  /// Copy the request's method and URL from the incoming message, unless that already happened.
+  void ensure_snapshot();
+};
+
+void IncomingRequestHandleState::ensure_snapshot() {
+  if (has_snapshot_) {
+    return;
+  }
+
+  auto *message = native::get<native::IncomingMessage>(handle);
+  method_ = message->method;
+
+  url_ = message->scheme;
+  url_.append("://");
+  authority_start_ = url_.size();
+  url_.append(message->authority);
+  path_start_ = url_.size();
+  url_.append(message->path_with_query);
+
+  has_snapshot_ = true;
+}
+
+HttpIncomingRequest::HttpIncomingRequest(Handle handle) {
+  handle_state_ = new IncomingRequestHandleState(handle);
+}
+
+Result<string_view> HttpIncomingRequest::method() {
+  if (!valid()) {
+    return Result<string_view>::err(154);
+  }
+  auto state = static_cast<IncomingRequestHandleState *>(handle_state_);
+  state->ensure_snapshot();
+  return Result<string_view>::ok(state->method_);
+}
+
+string_view HttpIncomingRequest::url() {
+  MOZ_ASSERT(valid());
+  auto state = static_cast<IncomingRequestHandleState *>(handle_state_);
+  state->ensure_snapshot();
+  return state->url_;
+}
+
+string_view HttpIncomingRequest::scheme() {
+  auto url = this->url();
+  auto state = static_cast<IncomingRequestHandleState *>(handle_state_);
+  // Strip the "://" separating the scheme from the authority.
+  return url.substr(0, state->authority_start_ - 3);
+}
+
+string_view HttpIncomingRequest::authority() {
+  auto url = this->url();
+  auto state = static_cast<IncomingRequestHandleState *>(handle_state_);
+  return url.substr(state->authority_start_, state->path_start_ - state->authority_start_);
+}
+
+string_view HttpIncomingRequest::path_with_query() {
+  auto url = this->url();
+  auto state = static_cast<IncomingRequestHandleState *>(handle_state_);
+  return url.substr(state->path_start_);
+}
+
+Result<HttpHeaders *> HttpIncomingRequest::headers() {
+  if (!headers_) {
+    if (!valid()) {
+      return Result<HttpHeaders *>::err(154);
+    }
+    headers_ = new HttpHeaders(native::get<native::IncomingMessage>(handle_state_->handle)->fields);
+  }
+
+  return Result<HttpHeaders *>::ok(headers_);
+}
+
+Result<HttpIncomingBody *> HttpIncomingRequest::body() {
+  if (!body_) {
+    if (!valid()) {
+      return Result<HttpIncomingBody *>::err(154);
+    }
+    auto body = consume_body(handle_state_->handle);
+    if (!body) {
+      return Result<HttpIncomingBody *>::err(154);
+    }
+    body_ = new HttpIncomingBody(*body);
+  }
+  return Result<HttpIncomingBody *>::ok(body_);
+}
+
+} // namespace host_api
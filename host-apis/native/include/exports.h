@@ -0,0 +1,11 @@
+#ifndef NATIVE_EXPORTS
+#define NATIVE_EXPORTS
+
+#define exports_wasi_http_incoming_handler native_incoming_handler_handle
+#define exports_wasi_http_incoming_request native_incoming_request_t
+#define exports_wasi_http_response_outparam native_response_outparam_t
+
+/// Serve incoming requests on `address`, e.g. "127.0.0.1:8080", until the process is terminated.
+bool native_serve(const char *address);
+
+#endif
@@ -0,0 +1,1189 @@
+#include "native.h"
+#include "recording.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace native {
+
+namespace {
+
+std::vector<void (*)()> &resource_tables() {
+  static std::vector<void (*)()> tables;
+  return tables;
+}
+
+/// The largest message head that's accepted.
+constexpr size_t MAX_HEAD_SIZE = 64 * 1024;
+
+/// How much to try to receive at once.
+constexpr size_t READ_SIZE = 64 * 1024;
+
+char to_lower(char c) { return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c; }
+
+std::string lowercase(std::string_view str) {
+  std::string result(str);
+  std::transform(result.begin(), result.end(), result.begin(), to_lower);
+  return result;
+}
+
+bool equals_ignoring_case(std::string_view a, std::string_view b) {
+  return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+           return to_lower(x) == to_lower(y);
+         });
+}
+
+std::string_view trim(std::string_view str) {
+  auto is_space = [](char c) { return c == ' ' || c == '\t'; };
+  while (!str.empty() && is_space(str.front())) {
+    str.remove_prefix(1);
+  }
+  while (!str.empty() && is_space(str.back())) {
+    str.remove_suffix(1);
+  }
+  return str;
+}
+
+/// True if the comma-separated list `value` contains `token`, like `connection: keep-alive, close`
+/// does for `close`.
+bool has_token(std::string_view value, std::string_view token) {
+  while (!value.empty()) {
+    auto end = value.find(',');
+    if (equals_ignoring_case(trim(value.substr(0, end)), token)) {
+      return true;
+    }
+    if (end == std::string_view::npos) {
+      break;
+    }
+    value.remove_prefix(end + 1);
+  }
+  return false;
+}
+
+std::string_view as_chars(std::span<const uint8_t> data) {
+  return {reinterpret_cast<const char *>(data.data()), data.size()};
+}
+
+/// Split `authority` into a host and a port, using `default_port` if it doesn't contain one.
+bool split_authority(std::string_view authority, uint16_t default_port, std::string *host,
+                     uint16_t *port) {
+  std::string_view port_str;
+  if (authority.starts_with('[')) {
+    auto end = authority.find(']');
+    if (end == std::string_view::npos) {
+      return false;
+    }
+    *host = authority.substr(1, end - 1);
+    authority.remove_prefix(end + 1);
+    if (authority.starts_with(':')) {
+      port_str = authority.substr(1);
+    }
+  } else {
+    auto colon = authority.rfind(':');
+    *host = authority.substr(0, colon);
+    if (colon != std::string_view::npos) {
+      port_str = authority.substr(colon + 1);
+    }
+  }
+
+  *port = default_port;
+  if (!port_str.empty()) {
+    auto [end, err] = std::from_chars(port_str.begin(), port_str.end(), *port);
+    if (err != std::errc() || end != port_str.end()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool parse_content_length(const Fields &fields, std::optional<uint64_t> *length) {
+  *length = std::nullopt;
+  for (const auto &[name, value] : fields.entries) {
+    if (name != "content-length") {
+      continue;
+    }
+    uint64_t parsed;
+    auto str = trim(value);
+    auto [end, err] = std::from_chars(str.begin(), str.end(), parsed);
+    if (str.empty() || err != std::errc() || end != str.end()) {
+      return false;
+    }
+    // Multiple content-length headers are only allowed if they agree.
+    if (*length && **length != parsed) {
+      return false;
+    }
+    *length = parsed;
+  }
+  return true;
+}
+
+/// Parse the header lines of a message head, which must end with the empty line.
+bool parse_fields(std::string_view lines, Fields *fields) {
+  while (true) {
+    auto end = lines.find("\r\n");
+    auto line = lines.substr(0, end);
+    lines.remove_prefix(end + 2);
+    if (line.empty()) {
+      return true;
+    }
+
+    auto colon = line.find(':');
+    // Obsolete line folding isn't supported.
+    if (colon == std::string_view::npos || colon == 0 || line[0] == ' ' || line[0] == '\t') {
+      return false;
+    }
+    auto name = line.substr(0, colon);
+    if (name.find_first_of(" \t") != std::string_view::npos) {
+      return false;
+    }
+    fields->append(name, trim(line.substr(colon + 1)));
+  }
+}
+
+/// Returns the head at the start of `conn`'s buffer, including the final empty line, if it's
+/// complete.
+ParseResult find_head(Connection &conn, std::string_view *head) {
+  auto data = as_chars(conn.buffered());
+  auto end = data.find("\r\n\r\n");
+  if (end == std::string_view::npos) {
+    return data.size() > MAX_HEAD_SIZE ? ParseResult::Invalid : ParseResult::Incomplete;
+  }
+  *head = data.substr(0, end + 4);
+  return ParseResult::Complete;
+}
+
+bool parse_http_version(std::string_view version, bool *http10) {
+  if (version == "HTTP/1.1") {
+    *http10 = false;
+    return true;
+  }
+  if (version == "HTTP/1.0") {
+    *http10 = true;
+    return true;
+  }
+  return false;
+}
+
+const char *reason_phrase(uint16_t status) {
+  switch (status) {
+  case 200:
+    return "OK";
+  case 201:
+    return "Created";
+  case 204:
+    return "No Content";
+  case 301:
+    return "Moved Permanently";
+  case 302:
+    return "Found";
+  case 304:
+    return "Not Modified";
+  case 400:
+    return "Bad Request";
+  case 404:
+    return "Not Found";
+  case 500:
+    return "Internal Server Error";
+  default:
+    return "";
+  }
+}
+
+bool status_has_body(uint16_t status) { return status >= 200 && status != 204 && status != 304; }
+
+/// Serialize the header entries of a message head, leaving out those describing the connection and
+/// framing, which are decided by the host.
+void append_fields(std::string *head, const Fields &fields) {
+  for (const auto &[name, value] : fields.entries) {
+    if (name == "connection" || name == "keep-alive" || name == "transfer-encoding") {
+      continue;
+    }
+    head->append(name);
+    head->append(": ");
+    head->append(value);
+    head->append("\r\n");
+  }
+}
+
+/// Append the headers for the framing of `body` to `head`, and start sending it once the head has
+/// been written.
+bool send_head_and_body(std::string *head, const Fields &fields,
+                        const std::shared_ptr<BodyWriter> &body,
+                        const std::shared_ptr<Connection> &conn, bool can_have_body,
+                        bool chunked_allowed, bool empty_body_needs_length) {
+  auto has_length = fields.get_first("content-length").has_value();
+  bool chunked = false;
+  if (!body) {
+    if (empty_body_needs_length && !has_length) {
+      head->append("content-length: 0\r\n");
+    }
+  } else if (!has_length && can_have_body) {
+    if (body->finished()) {
+      head->append("content-length: ");
+      head->append(std::to_string(body->pending_size()));
+      head->append("\r\n");
+    } else if (chunked_allowed) {
+      head->append("transfer-encoding: chunked\r\n");
+      chunked = true;
+    }
+  }
+  head->append("\r\n");
+
+  if (!conn->write_all(*head)) {
+    return false;
+  }
+  return !body || body->start(conn, chunked, !can_have_body);
+}
+
+} // namespace
+
+void register_resource_table(void (*clear)()) { resource_tables().push_back(clear); }
+
+void clear_resources() {
+  for (auto clear : resource_tables()) {
+    clear();
+  }
+}
+
+uint64_t monotonic_now() {
+  timespec now{};
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+size_t poll(std::span<Pollable *const> pollables) {
+  std::vector<pollfd> fds;
+  std::vector<size_t> fd_indices;
+
+  while (true) {
+    fds.clear();
+    fd_indices.clear();
+    std::optional<uint64_t> earliest_deadline;
+    auto now = monotonic_now();
+
+    for (size_t i = 0; i < pollables.size(); i++) {
+      auto *pollable = pollables[i];
+      if (pollable->ready_check && pollable->ready_check()) {
+        return i;
+      }
+      if (pollable->deadline) {
+        if (*pollable->deadline <= now) {
+          return i;
+        }
+        if (!earliest_deadline || *pollable->deadline < *earliest_deadline) {
+          earliest_deadline = pollable->deadline;
+        }
+      }
+      if (pollable->fd != -1) {
+        fds.push_back({pollable->fd, pollable->events, 0});
+        fd_indices.push_back(i);
+      }
+    }
+
+    if (fds.empty() && !earliest_deadline) {
+      fprintf(stderr, "Waiting for pollables that can never become ready\n");
+      abort();
+    }
+
+    timespec timeout{};
+    if (earliest_deadline) {
+      auto delta = *earliest_deadline - now;
+      timeout.tv_sec = static_cast<time_t>(delta / 1000000000);
+      timeout.tv_nsec = static_cast<long>(delta % 1000000000);
+    }
+    int count = ppoll(fds.data(), fds.size(), earliest_deadline ? &timeout : nullptr, nullptr);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("ppoll");
+      abort();
+    }
+
+    for (size_t i = 0; i < fds.size(); i++) {
+      if (fds[i].revents == 0) {
+        continue;
+      }
+      auto *pollable = pollables[fd_indices[i]];
+      if (pollable->on_event) {
+        pollable->on_event();
+      }
+      if (!pollable->ready_check || pollable->ready_check()) {
+        return fd_indices[i];
+      }
+    }
+    // Otherwise, a deadline has passed, or an event didn't make a pollable ready. Either way, the
+    // next iteration sorts it out.
+  }
+}
+
+Connection::Connection(int fd) : fd_(fd) {}
+
+Connection::~Connection() {
+  if (fd_ != -1) {
+    close(fd_);
+  }
+}
+
+std::shared_ptr<Connection> Connection::from_bytes(std::string data, uint64_t release_time) {
+  auto conn = std::make_shared<Connection>(-1);
+  conn->replay_data_ = std::move(data);
+  conn->release_time_ = release_time;
+  conn->fill();
+  return conn;
+}
+
+std::optional<uint64_t> Connection::pending_until() const {
+  if (fd_ != -1 || eof_) {
+    return std::nullopt;
+  }
+  return release_time_;
+}
+
+bool Connection::fill() {
+  if (eof_ || failed_) {
+    return !failed_;
+  }
+
+  if (fd_ == -1) {
+    if (monotonic_now() >= release_time_) {
+      capacity_ = end_ = replay_data_.size();
+      buffer_ = std::make_unique_for_overwrite<uint8_t[]>(capacity_);
+      memcpy(buffer_.get(), replay_data_.data(), capacity_);
+      replay_data_ = std::string();
+      eof_ = true;
+    }
+    return true;
+  }
+
+  if (start_ == end_) {
+    start_ = end_ = 0;
+  }
+  if (capacity_ - end_ < READ_SIZE) {
+    // Move the unconsumed data to the front, growing the buffer if that doesn't free enough space.
+    auto len = end_ - start_;
+    if (capacity_ - len < READ_SIZE) {
+      auto capacity = std::max(capacity_ * 2, len + READ_SIZE);
+      auto buffer = std::make_unique_for_overwrite<uint8_t[]>(capacity);
+      if (len > 0) {
+        memcpy(buffer.get(), buffer_.get() + start_, len);
+      }
+      buffer_ = std::move(buffer);
+      capacity_ = capacity;
+    } else if (len > 0) {
+      memmove(buffer_.get(), buffer_.get() + start_, len);
+    }
+    start_ = 0;
+    end_ = len;
+  }
+
+  ssize_t received;
+  do {
+    received = recv(fd_, buffer_.get() + end_, capacity_ - end_, 0);
+  } while (received < 0 && errno == EINTR);
+
+  if (received < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return true;
+    }
+    failed_ = true;
+    return false;
+  }
+  if (received == 0) {
+    eof_ = true;
+  }
+  if (tap_ && received > 0) {
+    if (tap_->first_byte_time == 0) {
+      tap_->first_byte_time = monotonic_now();
+    }
+    tap_->received.append(reinterpret_cast<char *>(buffer_.get() + end_), received);
+  }
+  end_ += received;
+  return true;
+}
+
+bool Connection::write_all(std::initializer_list<std::span<const uint8_t>> parts) {
+  if (failed_) {
+    return false;
+  }
+
+  iovec iov[8];
+  size_t count = 0;
+  for (auto part : parts) {
+    if (part.empty()) {
+      continue;
+    }
+    if (tap_) {
+      tap_->sent.append(reinterpret_cast<const char *>(part.data()), part.size());
+    }
+    assert(count < std::size(iov));
+    iov[count++] = {const_cast<uint8_t *>(part.data()), part.size()};
+  }
+  if (fd_ == -1) {
+    return true;
+  }
+
+  size_t first = 0;
+  while (first < count) {
+    msghdr msg{};
+    msg.msg_iov = iov + first;
+    msg.msg_iovlen = count - first;
+    auto sent = sendmsg(fd_, &msg, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        pollfd fd{fd_, POLLOUT, 0};
+        ::poll(&fd, 1, -1);
+        continue;
+      }
+      failed_ = true;
+      return false;
+    }
+
+    auto written = static_cast<size_t>(sent);
+    while (first < count && written >= iov[first].iov_len) {
+      written -= iov[first].iov_len;
+      first++;
+    }
+    if (first < count) {
+      iov[first].iov_base = static_cast<uint8_t *>(iov[first].iov_base) + written;
+      iov[first].iov_len -= written;
+    }
+  }
+  return true;
+}
+
+namespace {
+
+/// The earlier of two optional deadlines.
+std::optional<uint64_t> earliest(std::optional<uint64_t> a, std::optional<uint64_t> b) {
+  if (!a || (b && *b < *a)) {
+    return b;
+  }
+  return a;
+}
+
+/// Connect the non-blocking socket `fd` to `address`, waiting until `deadline` at most.
+bool connect_socket(int fd, const addrinfo *address, std::optional<uint64_t> deadline,
+                    bool *timed_out) {
+  if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+    return true;
+  }
+  if (errno != EINPROGRESS) {
+    return false;
+  }
+
+  pollfd pfd{fd, POLLOUT, 0};
+  while (true) {
+    int timeout_ms = -1;
+    if (deadline) {
+      auto now = monotonic_now();
+      if (now >= *deadline) {
+        *timed_out = true;
+        return false;
+      }
+      // Round up, so as to not wake up just before the deadline.
+      timeout_ms = static_cast<int>(std::min<uint64_t>((*deadline - now + 999999) / 1000000,
+                                                       INT32_MAX));
+    }
+    int count = ::poll(&pfd, 1, timeout_ms);
+    if (count > 0) {
+      break;
+    }
+    if (count < 0 && errno != EINTR) {
+      return false;
+    }
+  }
+
+  int error = 0;
+  socklen_t len = sizeof(error);
+  return getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) == 0 && error == 0;
+}
+
+} // namespace
+
+std::shared_ptr<Connection> connect(std::string_view authority, uint16_t default_port,
+                                    std::optional<uint64_t> timeout, bool *timed_out) {
+  bool ignored_timed_out;
+  if (!timed_out) {
+    timed_out = &ignored_timed_out;
+  }
+  *timed_out = false;
+  std::optional<uint64_t> deadline;
+  if (timeout) {
+    deadline = monotonic_now() + *timeout;
+  }
+
+  std::string host;
+  uint16_t port;
+  if (!split_authority(authority, default_port, &host, &port)) {
+    return nullptr;
+  }
+
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *addresses;
+  if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0) {
+    return nullptr;
+  }
+
+  int fd = -1;
+  for (auto *address = addresses; address; address = address->ai_next) {
+    fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK,
+                address->ai_protocol);
+    if (fd == -1) {
+      continue;
+    }
+    if (connect_socket(fd, address, deadline, timed_out)) {
+      break;
+    }
+    close(fd);
+    fd = -1;
+    if (*timed_out) {
+      break;
+    }
+  }
+  freeaddrinfo(addresses);
+  if (fd == -1) {
+    return nullptr;
+  }
+
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return std::make_shared<Connection>(fd);
+}
+
+void Fields::append(std::string_view name, std::string_view value) {
+  entries.emplace_back(lowercase(name), value);
+}
+
+void Fields::remove(std::string_view name) {
+  auto lower = lowercase(name);
+  std::erase_if(entries, [&](const auto &entry) { return entry.first == lower; });
+}
+
+std::optional<std::string_view> Fields::get_first(std::string_view name) const {
+  auto lower = lowercase(name);
+  for (const auto &[entry_name, value] : entries) {
+    if (entry_name == lower) {
+      return value;
+    }
+  }
+  return std::nullopt;
+}
+
+bool head_complete(std::span<const uint8_t> data) {
+  return as_chars(data).find("\r\n\r\n") != std::string_view::npos;
+}
+
+ParseResult parse_request_head(Connection &conn, RequestHead *head) {
+  std::string_view data;
+  auto result = find_head(conn, &data);
+  if (result != ParseResult::Complete) {
+    return result;
+  }
+  auto head_len = data.size();
+
+  // request-line = method SP request-target SP HTTP-version CRLF
+  auto line_end = data.find("\r\n");
+  auto line = data.substr(0, line_end);
+  auto method_end = line.find(' ');
+  auto target_end = line.rfind(' ');
+  if (method_end == std::string_view::npos || target_end <= method_end + 1 ||
+      !parse_http_version(line.substr(target_end + 1), &head->http10)) {
+    return ParseResult::Invalid;
+  }
+  head->method = line.substr(0, method_end);
+  head->target = line.substr(method_end + 1, target_end - method_end - 1);
+
+  if (!parse_fields(data.substr(line_end + 2), &head->fields)) {
+    return ParseResult::Invalid;
+  }
+
+  auto connection = head->fields.get_first("connection");
+  if (head->http10) {
+    head->keep_alive = connection && has_token(*connection, "keep-alive");
+  } else {
+    head->keep_alive = !connection || !has_token(*connection, "close");
+  }
+
+  conn.consume(head_len);
+  return ParseResult::Complete;
+}
+
+ParseResult parse_response_head(Connection &conn, ResponseHead *head) {
+  std::string_view data;
+  auto result = find_head(conn, &data);
+  if (result != ParseResult::Complete) {
+    return result;
+  }
+  auto head_len = data.size();
+
+  // status-line = HTTP-version SP status-code SP [ reason-phrase ] CRLF
+  auto line_end = data.find("\r\n");
+  auto line = data.substr(0, line_end);
+  bool http10;
+  if (line.size() < 12 || !parse_http_version(line.substr(0, 8), &http10) || line[8] != ' ') {
+    return ParseResult::Invalid;
+  }
+  auto status = line.substr(9, 3);
+  auto [end, err] = std::from_chars(status.begin(), status.end(), head->status);
+  if (err != std::errc() || end != status.end() || head->status < 100 || head->status > 999) {
+    return ParseResult::Invalid;
+  }
+
+  if (!parse_fields(data.substr(line_end + 2), &head->fields)) {
+    return ParseResult::Invalid;
+  }
+
+  conn.consume(head_len);
+  return ParseResult::Complete;
+}
+
+BodyReader::BodyReader(std::shared_ptr<Connection> conn, Framing framing, uint64_t length)
+    : conn_(std::move(conn)), framing_(framing), remaining_(length) {}
+
+std::optional<BodyReader> BodyReader::for_request(std::shared_ptr<Connection> conn,
+                                                  const Fields &fields) {
+  if (auto encoding = fields.get_first("transfer-encoding")) {
+    if (!has_token(*encoding, "chunked")) {
+      return std::nullopt;
+    }
+    return BodyReader(std::move(conn), Framing::Chunked);
+  }
+
+  std::optional<uint64_t> length;
+  if (!parse_content_length(fields, &length)) {
+    return std::nullopt;
+  }
+  return BodyReader(std::move(conn), Framing::Length, length.value_or(0));
+}
+
+std::optional<BodyReader> BodyReader::for_response(std::shared_ptr<Connection> conn,
+                                                   uint16_t status, bool head_request,
+                                                   const Fields &fields) {
+  if (head_request || !status_has_body(status)) {
+    return BodyReader(std::move(conn), Framing::Length, 0);
+  }
+
+  if (auto encoding = fields.get_first("transfer-encoding")) {
+    if (has_token(*encoding, "chunked")) {
+      return BodyReader(std::move(conn), Framing::Chunked);
+    }
+    return BodyReader(std::move(conn), Framing::UntilClose);
+  }
+
+  std::optional<uint64_t> length;
+  if (!parse_content_length(fields, &length)) {
+    return std::nullopt;
+  }
+  if (length) {
+    return BodyReader(std::move(conn), Framing::Length, *length);
+  }
+  return BodyReader(std::move(conn), Framing::UntilClose);
+}
+
+bool BodyReader::advance() {
+  while (!done_ && !failed_) {
+    auto data = as_chars(conn_->buffered());
+    // Whether the connection can't deliver any more data.
+    bool ended = conn_->eof() || conn_->failed();
+
+    if (framing_ == Framing::UntilClose) {
+      if (!data.empty()) {
+        return true;
+      }
+      if (conn_->failed()) {
+        failed_ = true;
+      } else if (conn_->eof()) {
+        done_ = true;
+      }
+      return done_ || failed_;
+    }
+
+    if (framing_ == Framing::Length) {
+      if (remaining_ == 0) {
+        done_ = true;
+      } else if (!data.empty()) {
+        return true;
+      } else if (ended) {
+        failed_ = true;
+      }
+      return done_ || failed_;
+    }
+
+    switch (chunk_state_) {
+    case ChunkState::Size: {
+      // chunk-size [ chunk-ext ] CRLF
+      auto line_end = data.find("\r\n");
+      if (line_end == std::string_view::npos) {
+        if (ended || data.size() > 1024) {
+          failed_ = true;
+          return true;
+        }
+        return false;
+      }
+      auto size = data.substr(0, std::min(line_end, data.find(';')));
+      size = trim(size);
+      auto [end, err] = std::from_chars(size.begin(), size.end(), remaining_, 16);
+      if (size.empty() || err != std::errc() || end != size.end()) {
+        failed_ = true;
+        return true;
+      }
+      conn_->consume(line_end + 2);
+      chunk_state_ = remaining_ == 0 ? ChunkState::Trailers : ChunkState::Data;
+      break;
+    }
+    case ChunkState::Data:
+      if (remaining_ == 0) {
+        chunk_state_ = ChunkState::DataEnd;
+        break;
+      }
+      if (!data.empty()) {
+        return true;
+      }
+      if (ended) {
+        failed_ = true;
+        return true;
+      }
+      return false;
+    case ChunkState::DataEnd:
+      if (data.size() < 2) {
+        if (ended) {
+          failed_ = true;
+          return true;
+        }
+        return false;
+      }
+      if (!data.starts_with("\r\n")) {
+        failed_ = true;
+        return true;
+      }
+      conn_->consume(2);
+      chunk_state_ = ChunkState::Size;
+      break;
+    case ChunkState::Trailers: {
+      // Trailers aren't exposed, so they're just skipped.
+      auto line_end = data.find("\r\n");
+      if (line_end == std::string_view::npos) {
+        if (ended || data.size() > MAX_HEAD_SIZE) {
+          failed_ = true;
+          return true;
+        }
+        return false;
+      }
+      conn_->consume(line_end + 2);
+      if (line_end == 0) {
+        done_ = true;
+      }
+      break;
+    }
+    }
+  }
+  return true;
+}
+
+void BodyReader::set_between_bytes_timeout(uint64_t timeout) {
+  between_bytes_timeout_ = timeout;
+  last_receive_time_ = monotonic_now();
+}
+
+void BodyReader::receive() {
+  auto buffered = conn_->buffered().size();
+  bool eof = conn_->eof();
+  conn_->fill();
+  if (between_bytes_timeout_ && (conn_->buffered().size() != buffered || conn_->eof() != eof)) {
+    last_receive_time_ = monotonic_now();
+  }
+}
+
+std::optional<uint64_t> BodyReader::receive_deadline() const {
+  if (!between_bytes_timeout_) {
+    return std::nullopt;
+  }
+  return last_receive_time_ + *between_bytes_timeout_;
+}
+
+bool BodyReader::ready() {
+  if (advance()) {
+    return true;
+  }
+  // Let `read` report the timeout.
+  auto deadline = receive_deadline();
+  return deadline && monotonic_now() >= *deadline;
+}
+
+std::unique_ptr<Pollable> BodyReader::subscribe() {
+  auto pollable = std::make_unique<Pollable>();
+  pollable->fd = conn_->fd();
+  pollable->events = POLLIN;
+  pollable->deadline = earliest(conn_->pending_until(), receive_deadline());
+  pollable->ready_check = [this]() { return ready(); };
+  // Pollables are reused for all reads, so the deadline has to move along with received data.
+  pollable->on_event = [this, pollable = pollable.get()]() {
+    receive();
+    pollable->deadline = earliest(conn_->pending_until(), receive_deadline());
+  };
+  return pollable;
+}
+
+bool BodyReader::read(std::span<uint8_t> buffer, bool *done, size_t *len) {
+  *done = false;
+  *len = 0;
+  if (!advance()) {
+    receive();
+    if (!advance()) {
+      auto deadline = receive_deadline();
+      if (deadline && monotonic_now() >= *deadline) {
+        failed_ = true;
+        return false;
+      }
+      return true;
+    }
+  }
+  if (failed_) {
+    return false;
+  }
+  if (done_) {
+    *done = true;
+    return true;
+  }
+
+  auto data = conn_->buffered();
+  auto count = std::min(buffer.size(), data.size());
+  if (framing_ != Framing::UntilClose) {
+    count = static_cast<size_t>(std::min<uint64_t>(count, remaining_));
+    remaining_ -= count;
+  }
+  if (count > 0) {
+    memcpy(buffer.data(), data.data(), count);
+    conn_->consume(count);
+    if (tap_) {
+      tap_->append(reinterpret_cast<const char *>(data.data()), count);
+    }
+  }
+  *len = count;
+  return true;
+}
+
+bool BodyReader::discard_buffered() {
+  conn_->fill();
+  while (advance()) {
+    if (failed_) {
+      return false;
+    }
+    if (done_) {
+      return true;
+    }
+    auto count = conn_->buffered().size();
+    if (framing_ != Framing::UntilClose) {
+      count = static_cast<size_t>(std::min<uint64_t>(count, remaining_));
+      remaining_ -= count;
+    }
+    conn_->consume(count);
+  }
+  return false;
+}
+
+std::unique_ptr<Pollable> subscribe_to_response(std::shared_ptr<Connection> conn,
+                                                std::optional<uint64_t> deadline) {
+  auto pollable = std::make_unique<Pollable>();
+  pollable->fd = conn->fd();
+  pollable->events = POLLIN;
+  pollable->deadline = earliest(conn->pending_until(), deadline);
+  pollable->ready_check = [conn]() {
+    return conn->eof() || conn->failed() || head_complete(conn->buffered());
+  };
+  pollable->on_event = [conn]() { conn->fill(); };
+  return pollable;
+}
+
+bool BodyWriter::start(std::shared_ptr<Connection> conn, bool chunked, bool discard) {
+  assert(!conn_);
+  conn_ = std::move(conn);
+  chunked_ = chunked;
+  discard_ = discard;
+
+  auto pending = std::move(pending_);
+  bool finished = finished_;
+  finished_ = false;
+  if (!pending.empty() && !write(pending)) {
+    return false;
+  }
+  return !finished || finish();
+}
+
+bool BodyWriter::write(std::span<const uint8_t> data) {
+  if (failed_ || finished_) {
+    return false;
+  }
+  if (!conn_) {
+    pending_.insert(pending_.end(), data.begin(), data.end());
+    return true;
+  }
+  if (discard_ || data.empty()) {
+    return true;
+  }
+
+  bool success;
+  if (chunked_) {
+    char size[20];
+    auto len = snprintf(size, sizeof(size), "%zx\r\n", data.size());
+    success = conn_->write_all({{reinterpret_cast<uint8_t *>(size), static_cast<size_t>(len)},
+                                data,
+                                {reinterpret_cast<const uint8_t *>("\r\n"), 2}});
+  } else {
+    success = conn_->write_all({data});
+  }
+  failed_ = !success;
+  return success;
+}
+
+bool BodyWriter::finish() {
+  if (finished_) {
+    return !failed_;
+  }
+  finished_ = true;
+  if (conn_ && chunked_ && !discard_) {
+    failed_ = !conn_->write_all("0\r\n\r\n");
+  }
+  return !failed_;
+}
+
+bool OutgoingMessage::send_request(const std::shared_ptr<Connection> &conn) {
+  auto &fields = *get<Fields>(this->fields);
+
+  std::string head = method;
+  head.append(" ");
+  head.append(path_with_query.empty() ? "/" : path_with_query);
+  head.append(" HTTP/1.1\r\n");
+  if (!fields.get_first("host")) {
+    head.append("host: ");
+    head.append(authority);
+    head.append("\r\n");
+  }
+  append_fields(&head, fields);
+  // Connections aren't reused, so the end of the response can always be determined.
+  head.append("connection: close\r\n");
+
+  return send_head_and_body(&head, fields, body, conn, true, true, false);
+}
+
+bool OutgoingMessage::send_response(ResponseOutparam *outparam) {
+  auto &fields = *get<Fields>(this->fields);
+
+  std::string head = "HTTP/1.1 ";
+  head.append(std::to_string(status));
+  head.append(" ");
+  head.append(reason_phrase(status));
+  head.append("\r\n");
+  append_fields(&head, fields);
+
+  // Without chunked encoding, a streaming body can only be delimited by closing the connection.
+  bool streaming = body && !body->finished() && !fields.get_first("content-length");
+  if (!outparam->chunked_allowed && streaming) {
+    outparam->keep_alive = false;
+  }
+  if (!outparam->keep_alive) {
+    head.append("connection: close\r\n");
+  }
+
+  bool can_have_body = status_has_body(status) && !outparam->head_request;
+  outparam->body = body;
+  outparam->sent = true;
+  return send_head_and_body(&head, fields, body, outparam->conn, can_have_body,
+                            outparam->chunked_allowed, status_has_body(status));
+}
+
+namespace {
+
+/// Handle the request whose head has just been parsed from `conn`.
+///
+/// @return true if the connection can be used for further requests.
+bool handle_request(const std::shared_ptr<Connection> &conn, RequestHead head,
+                    std::string_view local_authority, RequestHandler handler) {
+  auto reader = BodyReader::for_request(conn, head.fields);
+  if (!reader) {
+    conn->write_all("HTTP/1.1 400 Bad Request\r\ncontent-length: 0\r\nconnection: close\r\n\r\n");
+    return false;
+  }
+  auto *recording = begin_recorded_request(head, *conn, *reader);
+
+  auto message = std::make_unique<IncomingMessage>();
+  message->method = std::move(head.method);
+  message->scheme = "http";
+  message->authority = head.fields.get_first("host").value_or(local_authority);
+  message->path_with_query = std::move(head.target);
+  message->body = std::make_unique<BodyReader>(std::move(*reader));
+  // The body is moved to its own table once the request is consumed, but stays alive until all
+  // resources are cleared below.
+  auto *body = message->body.get();
+  message->fields = insert(std::make_unique<Fields>(std::move(head.fields)));
+
+  auto outparam = std::make_unique<ResponseOutparam>();
+  outparam->conn = conn;
+  outparam->head_request = message->method == "HEAD";
+  outparam->keep_alive = head.keep_alive;
+  outparam->chunked_allowed = !head.http10;
+  auto *response = outparam.get();
+
+  auto request_handle = insert(std::move(message));
+  auto outparam_handle = insert(std::move(outparam));
+  handler(request_handle, outparam_handle);
+
+  bool keep_alive = response->keep_alive;
+  if (!response->sent) {
+    conn->write_all(
+        "HTTP/1.1 500 Internal Server Error\r\ncontent-length: 0\r\nconnection: close\r\n\r\n");
+    keep_alive = false;
+  } else if (response->body && (!response->body->finished() || response->body->failed())) {
+    // The response is incomplete, so the connection can't be used anymore.
+    keep_alive = false;
+  }
+  if (recording) {
+    finish_recorded_request(recording, *conn, *body);
+  }
+  keep_alive = keep_alive && body->discard_buffered() && !conn->failed();
+
+  clear_resources();
+  return keep_alive;
+}
+
+} // namespace
+
+bool handle_connection(const std::shared_ptr<Connection> &conn, std::string_view local_authority,
+                       RequestHandler handler) {
+  if (!conn->fill()) {
+    return false;
+  }
+
+  while (true) {
+    RequestHead head;
+    switch (parse_request_head(*conn, &head)) {
+    case ParseResult::Incomplete:
+      return !conn->eof();
+    case ParseResult::Invalid:
+      conn->write_all("HTTP/1.1 400 Bad Request\r\ncontent-length: 0\r\nconnection: close\r\n\r\n");
+      return false;
+    case ParseResult::Complete:
+      break;
+    }
+
+    if (!handle_request(conn, std::move(head), local_authority, handler)) {
+      return false;
+    }
+    if (conn->buffered().empty()) {
+      return true;
+    }
+  }
+}
+
+bool serve(std::string_view address, RequestHandler handler) {
+  std::string host;
+  uint16_t port;
+  if (!split_authority(address, 8080, &host, &port)) {
+    fprintf(stderr, "Invalid address: %.*s\n", static_cast<int>(address.size()), address.data());
+    return false;
+  }
+
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  addrinfo *addresses;
+  if (getaddrinfo(host.empty() ? nullptr : host.c_str(), std::to_string(port).c_str(), &hints,
+                  &addresses) != 0) {
+    fprintf(stderr, "Couldn't resolve %s\n", host.c_str());
+    return false;
+  }
+
+  int listener = -1;
+  for (auto *addr = addresses; addr; addr = addr->ai_next) {
+    listener = socket(addr->ai_family, addr->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                      addr->ai_protocol);
+    if (listener == -1) {
+      continue;
+    }
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(listener, addr->ai_addr, addr->ai_addrlen) == 0 && listen(listener, SOMAXCONN) == 0) {
+      break;
+    }
+    close(listener);
+    listener = -1;
+  }
+  freeaddrinfo(addresses);
+  if (listener == -1) {
+    perror("Couldn't listen");
+    return false;
+  }
+
+  int epoll = epoll_create1(EPOLL_CLOEXEC);
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = listener;
+  epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event);
+
+  std::string local_authority = host.empty() ? "localhost" : host;
+  local_authority.append(":");
+  local_authority.append(std::to_string(port));
+  fprintf(stderr, "Listening on http://%s\n", local_authority.c_str());
+
+  std::unordered_map<int, std::shared_ptr<Connection>> connections;
+  epoll_event events[64];
+  while (true) {
+    int count = epoll_wait(epoll, events, std::size(events), -1);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("epoll_wait");
+      return false;
+    }
+
+    for (int i = 0; i < count; i++) {
+      int fd = events[i].data.fd;
+      if (fd == listener) {
+        int client;
+        while ((client = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+          int one = 1;
+          setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+          event.events = EPOLLIN | EPOLLRDHUP;
+          event.data.fd = client;
+          epoll_ctl(epoll, EPOLL_CTL_ADD, client, &event);
+          connections.emplace(client, std::make_shared<Connection>(client));
+        }
+        continue;
+      }
+
+      auto entry = connections.find(fd);
+      if (entry == connections.end()) {
+        continue;
+      }
+      if (!handle_connection(entry->second, local_authority, handler)) {
+        epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+        connections.erase(entry);
+      }
+    }
+  }
+}
+
+} // namespace native
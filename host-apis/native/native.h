@@ -0,0 +1,404 @@
+#ifndef STARLING_NATIVE_H
+#define STARLING_NATIVE_H
+
+// The primitives the native host API is built on: resource tables mirroring the component model's,
+// pollables, and HTTP/1.1 over non-blocking TCP sockets.
+//
+// Nothing in here depends on SpiderMonkey, so that the networking code can be tested in isolation.
+
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace native {
+
+using Handle = int32_t;
+
+/// Clear all resource tables. See `ResourceTable`.
+void clear_resources();
+
+void register_resource_table(void (*clear)());
+
+/// A table of resources of type `T`, handing out integer handles for them the same way a
+/// component model host does.
+///
+/// Handles are never reused, so using a handle after its resource was dropped reliably aborts
+/// instead of silently referring to another resource. All resources belong to the request that
+/// created them, and are dropped wholesale by the server once that request is done.
+template <typename T> class ResourceTable final {
+  std::unordered_map<Handle, std::unique_ptr<T>> entries_;
+  Handle next_handle_ = 1;
+
+  ResourceTable() {
+    register_resource_table([]() { instance().entries_.clear(); });
+  }
+
+public:
+  static ResourceTable &instance() {
+    static ResourceTable table;
+    return table;
+  }
+
+  Handle insert(std::unique_ptr<T> resource) {
+    Handle handle = next_handle_++;
+    entries_.emplace(handle, std::move(resource));
+    return handle;
+  }
+
+  T *get(Handle handle) {
+    auto entry = entries_.find(handle);
+    if (entry == entries_.end()) {
+      abort();
+    }
+    return entry->second.get();
+  }
+
+  std::unique_ptr<T> take(Handle handle) {
+    auto entry = entries_.find(handle);
+    if (entry == entries_.end()) {
+      abort();
+    }
+    auto resource = std::move(entry->second);
+    entries_.erase(entry);
+    return resource;
+  }
+};
+
+template <typename T> Handle insert(std::unique_ptr<T> resource) {
+  return ResourceTable<T>::instance().insert(std::move(resource));
+}
+
+template <typename T> T *get(Handle handle) { return ResourceTable<T>::instance().get(handle); }
+
+template <typename T> std::unique_ptr<T> take(Handle handle) {
+  return ResourceTable<T>::instance().take(handle);
+}
+
+/// The current time of the monotonic clock, in nanoseconds.
+uint64_t monotonic_now();
+
+/// Something the event loop can wait for: a file descriptor becoming readable or writable, a
+/// deadline passing, or both, whichever happens first.
+struct Pollable final {
+  int fd = -1;
+  short events = 0;
+  std::optional<uint64_t> deadline;
+
+  /// If set, the pollable is only ready once this returns true. It's checked before blocking, and
+  /// again after each event on `fd`. This allows waiting for e.g. a response's entire head instead
+  /// of just the first bytes of it.
+  std::function<bool()> ready_check;
+
+  /// Called on each event on `fd` before `ready_check`, e.g. to receive the available data.
+  std::function<void()> on_event;
+};
+
+/// Block until one of `pollables` is ready, and return its index.
+size_t poll(std::span<Pollable *const> pollables);
+
+/// Copies of the data sent and received on a connection, see `Connection::set_tap`.
+struct ConnectionTap final {
+  std::string sent;
+  std::string received;
+  /// When the first data was received, or 0 if none was yet.
+  uint64_t first_byte_time = 0;
+};
+
+/// A non-blocking TCP connection, with a buffer for received data.
+class Connection final {
+  int fd_;
+  std::unique_ptr<uint8_t[]> buffer_;
+  size_t capacity_ = 0;
+  size_t start_ = 0;
+  size_t end_ = 0;
+  bool eof_ = false;
+  bool failed_ = false;
+  ConnectionTap *tap_ = nullptr;
+
+  // For connections created by `from_bytes`.
+  std::string replay_data_;
+  uint64_t release_time_ = 0;
+
+public:
+  explicit Connection(int fd);
+  ~Connection();
+
+  Connection(const Connection &) = delete;
+  Connection &operator=(const Connection &) = delete;
+
+  /// A connection without a socket, which receives `data` once the monotonic clock has reached
+  /// `release_time`, followed by eof. Sent data is dropped.
+  static std::shared_ptr<Connection> from_bytes(std::string data, uint64_t release_time = 0);
+
+  int fd() const { return fd_; }
+  bool eof() const { return eof_; }
+  bool failed() const { return failed_; }
+
+  /// For connections created with `from_bytes`, the time their data becomes available, unless it
+  /// already has.
+  std::optional<uint64_t> pending_until() const;
+
+  /// Copy all data sent and received from now on to `tap`, or stop doing so if it's null.
+  void set_tap(ConnectionTap *tap) { tap_ = tap; }
+
+  /// Receive whatever data is available without blocking, and append it to the buffer.
+  ///
+  /// @return false if the connection failed.
+  bool fill();
+
+  std::span<const uint8_t> buffered() const { return {buffer_.get() + start_, end_ - start_}; }
+  void consume(size_t len) { start_ += len; }
+
+  /// Send all of `parts`, in order, blocking until the socket has accepted them.
+  bool write_all(std::initializer_list<std::span<const uint8_t>> parts);
+  bool write_all(std::string_view data) {
+    return write_all({{reinterpret_cast<const uint8_t *>(data.data()), data.size()}});
+  }
+};
+
+/// Open a connection to `authority`, using `default_port` if it doesn't contain a port.
+///
+/// Name resolution and connecting are blocking. If `timeout` is set, connecting fails once it has
+/// taken that many nanoseconds, and `timed_out` is set to true if it's not null.
+std::shared_ptr<Connection> connect(std::string_view authority, uint16_t default_port,
+                                    std::optional<uint64_t> timeout = std::nullopt,
+                                    bool *timed_out = nullptr);
+
+/// A list of header entries, the equivalent of the `fields` resource.
+///
+/// Names are stored in lowercase, like hosts based on the `http` crate do.
+struct Fields final {
+  std::vector<std::pair<std::string, std::string>> entries;
+
+  void append(std::string_view name, std::string_view value);
+  void remove(std::string_view name);
+  std::optional<std::string_view> get_first(std::string_view name) const;
+};
+
+struct RequestHead final {
+  std::string method;
+  std::string target;
+  Fields fields;
+  bool http10 = false;
+  bool keep_alive = true;
+};
+
+struct ResponseHead final {
+  uint16_t status = 0;
+  Fields fields;
+};
+
+enum class ParseResult {
+  Complete,
+  Incomplete,
+  Invalid,
+};
+
+/// True if `data` starts with a complete message head.
+bool head_complete(std::span<const uint8_t> data);
+
+/// Parse a request's head from the start of `conn`'s buffer, and consume it if it's complete.
+ParseResult parse_request_head(Connection &conn, RequestHead *head);
+
+/// Parse a response's head from the start of `conn`'s buffer, and consume it if it's complete.
+ParseResult parse_response_head(Connection &conn, ResponseHead *head);
+
+/// Reads a message's body from a connection, undoing the transfer encoding.
+class BodyReader final {
+public:
+  enum class Framing {
+    /// The body has a known length, which might be 0.
+    Length,
+    Chunked,
+    /// The body extends until the connection is closed, as used by HTTP/1.0 responses.
+    UntilClose,
+  };
+
+private:
+  enum class ChunkState {
+    Size,
+    Data,
+    DataEnd,
+    Trailers,
+  };
+
+  std::shared_ptr<Connection> conn_;
+  Framing framing_;
+  ChunkState chunk_state_ = ChunkState::Size;
+  uint64_t remaining_;
+  bool done_ = false;
+  bool failed_ = false;
+  std::string *tap_ = nullptr;
+  std::optional<uint64_t> between_bytes_timeout_;
+  uint64_t last_receive_time_ = 0;
+
+  /// Receive whatever data is available on the connection, and note when any was.
+  void receive();
+
+  /// When reading fails if no more data has been received, if there's a timeout.
+  std::optional<uint64_t> receive_deadline() const;
+
+  /// Process framing until body data is available at the front of the connection's buffer, or the
+  /// body is done. Returns false if more data needs to be received first.
+  bool advance();
+
+public:
+  BodyReader(std::shared_ptr<Connection> conn, Framing framing, uint64_t length = 0);
+
+  /// Determine the framing of a request's body from its headers.
+  static std::optional<BodyReader> for_request(std::shared_ptr<Connection> conn,
+                                               const Fields &fields);
+  /// Determine the framing of a response's body from its status and headers.
+  static std::optional<BodyReader> for_response(std::shared_ptr<Connection> conn,
+                                                uint16_t status, bool head_request,
+                                                const Fields &fields);
+
+  int fd() const { return conn_->fd(); }
+  bool done() const { return done_; }
+
+  /// Append all body data read from now on to `tap`, or stop doing so if it's null.
+  void set_tap(std::string *tap) { tap_ = tap; }
+
+  /// Fail reading once no data has been received for `timeout` nanoseconds.
+  void set_between_bytes_timeout(uint64_t timeout);
+
+  /// True if `read` can make progress without receiving more data.
+  bool ready();
+
+  /// A pollable that's ready once `read` can make progress. Must not outlive the reader.
+  std::unique_ptr<Pollable> subscribe();
+
+  /// Read up to `buffer.size()` bytes of the body without blocking.
+  ///
+  /// @return false if the body is malformed, the connection failed, or it timed out.
+  bool read(std::span<uint8_t> buffer, bool *done, size_t *len);
+
+  /// Read the rest of the body if it's already been received, and discard it.
+  ///
+  /// @return true if the body is done.
+  bool discard_buffered();
+};
+
+/// Writes a message's body to a connection.
+///
+/// Chunks written before the message's head was sent are buffered, and flushed once it has been.
+/// If the body was finished by then, it's sent with a `content-length`, otherwise with chunked
+/// encoding, unless the message has a `content-length` header of its own.
+class BodyWriter final {
+  std::shared_ptr<Connection> conn_;
+  std::vector<uint8_t> pending_;
+  bool chunked_ = false;
+  bool discard_ = false;
+  bool finished_ = false;
+  bool failed_ = false;
+
+public:
+  bool started() const { return conn_ != nullptr; }
+  bool finished() const { return finished_; }
+  bool failed() const { return failed_; }
+  size_t pending_size() const { return pending_.size(); }
+
+  /// Start sending the body on `conn`, after the message's head has been written to it.
+  ///
+  /// @param discard drop all data instead, for messages that can't have a body.
+  bool start(std::shared_ptr<Connection> conn, bool chunked, bool discard);
+
+  bool write(std::span<const uint8_t> data);
+  bool finish();
+};
+
+struct ResponseOutparam;
+
+/// An outgoing request or response, the equivalent of the `outgoing-request` and
+/// `outgoing-response` resources.
+struct OutgoingMessage final {
+  std::string method = "GET";
+  std::string scheme;
+  std::string authority;
+  std::string path_with_query;
+  uint16_t status = 200;
+
+  Handle fields;
+  std::shared_ptr<BodyWriter> body;
+
+  /// Write the request's head to `conn`, and start sending its body.
+  bool send_request(const std::shared_ptr<Connection> &conn);
+
+  /// Write the response's head to the connection of `outparam`, and start sending its body.
+  bool send_response(ResponseOutparam *outparam);
+};
+
+/// The `outgoing-body` resource, sharing its writer with the message it belongs to.
+struct OutgoingBody final {
+  std::shared_ptr<BodyWriter> writer;
+};
+
+/// An incoming request or response, the equivalent of the `incoming-request` and
+/// `incoming-response` resources.
+struct IncomingMessage final {
+  std::string method;
+  std::string scheme;
+  std::string authority;
+  std::string path_with_query;
+  uint16_t status = 0;
+
+  Handle fields;
+  std::unique_ptr<BodyReader> body;
+};
+
+/// A request sent by `outgoing-handler.handle`, waiting for its response.
+struct FutureResponse final {
+  std::shared_ptr<Connection> conn;
+  bool head_request = false;
+  bool failed = false;
+  bool timed_out = false;
+  bool consumed = false;
+  /// When to give up on receiving the response's head.
+  std::optional<uint64_t> first_byte_deadline;
+  /// Passed on to the response body's reader, see `BodyReader::set_between_bytes_timeout`.
+  std::optional<uint64_t> between_bytes_timeout;
+};
+
+/// A pollable that's ready once the entire head of a response has been received on `conn`,
+/// receiving it failed, or `deadline` has passed.
+std::unique_ptr<Pollable> subscribe_to_response(std::shared_ptr<Connection> conn,
+                                                std::optional<uint64_t> deadline = std::nullopt);
+
+/// Where the server expects the response to an incoming request to be sent.
+struct ResponseOutparam final {
+  std::shared_ptr<Connection> conn;
+  bool head_request = false;
+  bool keep_alive = true;
+  /// HTTP/1.0 clients don't support chunked encoding.
+  bool chunked_allowed = true;
+  /// The body of the response, once one has been sent.
+  std::shared_ptr<BodyWriter> body;
+  bool sent = false;
+};
+
+using RequestHandler = void (*)(Handle request, Handle response_out);
+
+/// Handle all requests that have been received on `conn`, using `local_authority` for those
+/// without a `host` header.
+///
+/// @return true if the connection should be kept open.
+bool handle_connection(const std::shared_ptr<Connection> &conn, std::string_view local_authority,
+                       RequestHandler handler);
+
+/// Accept connections on `address`, and call `handler` for each incoming request on them, until the
+/// process is terminated.
+///
+/// Requests are handled one at a time. After each request, all resources are dropped.
+bool serve(std::string_view address, RequestHandler handler);
+
+} // namespace native
+
+#endif
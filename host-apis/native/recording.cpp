@@ -0,0 +1,458 @@
+#include "recording.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <sys/random.h>
+
+namespace native {
+
+struct RecordedFetch final {
+  /// The request as sent, and its response as received.
+  ConnectionTap tap;
+  /// How long it took to receive the first bytes of the response.
+  uint64_t latency = 0;
+  /// True if connecting failed.
+  bool failed = false;
+
+  // Only used while recording.
+  uint64_t start = 0;
+  std::weak_ptr<Connection> conn;
+};
+
+struct RecordedRequest final {
+  /// The request's head, with its body appended and delimited by a `content-length`.
+  std::string request;
+  /// The response as sent.
+  std::string response;
+  /// How long handling the request took.
+  uint64_t duration = 0;
+
+  std::deque<RecordedFetch> fetches;
+  /// Clock readings, relative to the time the request was received.
+  std::vector<uint64_t> clock_readings;
+  std::vector<std::string> random;
+
+  /// When handling the request started, for the current recording or replay.
+  uint64_t start = 0;
+
+  // Only used while recording.
+  std::string body;
+  ConnectionTap tap;
+};
+
+namespace {
+
+// Recordings are stored as a sequence of requests, with all integers stored as 64 bit values in
+// the host's byte order, and all strings prefixed by their length.
+constexpr std::string_view MAGIC = "starling-recording-1\n";
+
+enum class Mode {
+  Live,
+  Record,
+  Replay,
+};
+
+Mode mode = Mode::Live;
+FILE *recording_file = nullptr;
+
+/// The request that's currently being recorded or replayed, if any.
+RecordedRequest *current = nullptr;
+
+// Replay state for the current request.
+size_t current_index = 0;
+size_t next_fetch = 0;
+size_t next_clock = 0;
+size_t next_random = 0;
+uint64_t last_reading = 0;
+bool report_divergence = false;
+bool diverged = false;
+bool emulate_latency = false;
+/// The requests sent for the current request's replayed fetches.
+std::deque<ConnectionTap> replayed_fetches;
+
+void diverge(const char *reason) {
+  if (report_divergence && !diverged) {
+    fprintf(stderr, "Request %zu diverged from the recording: %s\n", current_index + 1, reason);
+  }
+  diverged = true;
+}
+
+std::string_view first_line(std::string_view message) {
+  return message.substr(0, message.find("\r\n"));
+}
+
+void write_u64(uint64_t value) { fwrite(&value, sizeof(value), 1, recording_file); }
+
+void write_bytes(std::string_view bytes) {
+  write_u64(bytes.size());
+  fwrite(bytes.data(), 1, bytes.size(), recording_file);
+}
+
+void write_request(const RecordedRequest &request) {
+  write_bytes(request.request);
+  write_bytes(request.response);
+  write_u64(request.duration);
+  write_u64(request.fetches.size());
+  for (const auto &fetch : request.fetches) {
+    write_bytes(fetch.tap.sent);
+    write_bytes(fetch.tap.received);
+    write_u64(fetch.latency);
+    write_u64(fetch.failed);
+  }
+  write_u64(request.clock_readings.size());
+  for (auto reading : request.clock_readings) {
+    write_u64(reading);
+  }
+  write_u64(request.random.size());
+  for (const auto &bytes : request.random) {
+    write_bytes(bytes);
+  }
+  fflush(recording_file);
+}
+
+class Reader final {
+  std::string data_;
+  size_t pos_ = 0;
+  bool failed_ = false;
+
+public:
+  explicit Reader(std::string data) : data_(std::move(data)) {}
+
+  bool failed() const { return failed_; }
+  bool at_end() const { return pos_ == data_.size(); }
+
+  bool expect(std::string_view magic) {
+    if (!std::string_view(data_).substr(pos_).starts_with(magic)) {
+      failed_ = true;
+      return false;
+    }
+    pos_ += magic.size();
+    return true;
+  }
+
+  uint64_t u64() {
+    uint64_t value = 0;
+    if (data_.size() - pos_ < sizeof(value)) {
+      failed_ = true;
+      return 0;
+    }
+    memcpy(&value, data_.data() + pos_, sizeof(value));
+    pos_ += sizeof(value);
+    return value;
+  }
+
+  std::string bytes() {
+    auto len = u64();
+    if (failed_ || data_.size() - pos_ < len) {
+      failed_ = true;
+      return {};
+    }
+    std::string bytes = data_.substr(pos_, len);
+    pos_ += len;
+    return bytes;
+  }
+};
+
+std::unique_ptr<RecordedRequest> read_request(Reader &reader) {
+  auto request = std::make_unique<RecordedRequest>();
+  request->request = reader.bytes();
+  request->response = reader.bytes();
+  request->duration = reader.u64();
+  for (auto count = reader.u64(); count > 0 && !reader.failed(); count--) {
+    auto &fetch = request->fetches.emplace_back();
+    fetch.tap.sent = reader.bytes();
+    fetch.tap.received = reader.bytes();
+    fetch.latency = reader.u64();
+    fetch.failed = reader.u64() != 0;
+  }
+  for (auto count = reader.u64(); count > 0 && !reader.failed(); count--) {
+    request->clock_readings.push_back(reader.u64());
+  }
+  for (auto count = reader.u64(); count > 0 && !reader.failed(); count--) {
+    request->random.push_back(reader.bytes());
+  }
+  return reader.failed() ? nullptr : std::move(request);
+}
+
+bool read_file(const char *path, std::string *data) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return false;
+  }
+  char buffer[64 * 1024];
+  size_t len;
+  while ((len = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data->append(buffer, len);
+  }
+  bool success = !ferror(file);
+  fclose(file);
+  return success;
+}
+
+/// Compare the outgoing requests and the response of the request that was just replayed to the
+/// recorded ones. Only the first lines are compared, because headers and bodies regularly contain
+/// dates and other values that aren't replayed.
+void check_replayed_request(const ConnectionTap &response) {
+  if (next_fetch < current->fetches.size()) {
+    diverge("not all recorded outgoing requests were made");
+  }
+  for (size_t i = 0; i < replayed_fetches.size(); i++) {
+    if (first_line(replayed_fetches[i].sent) != first_line(current->fetches[i].tap.sent)) {
+      diverge("an outgoing request differs from the recorded one");
+    }
+  }
+  if (first_line(response.sent) != first_line(current->response)) {
+    diverge("the response status differs from the recorded one");
+  }
+}
+
+double percentile(const std::vector<uint64_t> &sorted, double fraction) {
+  auto index = static_cast<size_t>(fraction * (sorted.size() - 1));
+  return sorted[index] / 1000.0;
+}
+
+} // namespace
+
+bool start_recording(const char *path) {
+  recording_file = fopen(path, "wb");
+  if (!recording_file) {
+    perror("Couldn't open recording file");
+    return false;
+  }
+  fwrite(MAGIC.data(), 1, MAGIC.size(), recording_file);
+  fflush(recording_file);
+  mode = Mode::Record;
+  fprintf(stderr, "Recording requests to %s\n", path);
+  return true;
+}
+
+bool replay(const char *path, RequestHandler handler, const RecordingOptions &options) {
+  std::string data;
+  if (!read_file(path, &data)) {
+    perror("Couldn't read recording file");
+    return false;
+  }
+
+  Reader reader(std::move(data));
+  std::vector<std::unique_ptr<RecordedRequest>> requests;
+  if (reader.expect(MAGIC)) {
+    while (!reader.at_end()) {
+      auto request = read_request(reader);
+      if (!request) {
+        break;
+      }
+      requests.push_back(std::move(request));
+    }
+  }
+  if (reader.failed()) {
+    fprintf(stderr, "Invalid recording file: %s\n", path);
+    return false;
+  }
+
+  mode = Mode::Replay;
+  emulate_latency = options.emulate_latency;
+  std::vector<uint64_t> durations;
+  durations.reserve(requests.size() * options.iterations);
+  size_t diverged_count = 0;
+
+  for (unsigned iteration = 0; iteration < options.iterations; iteration++) {
+    for (size_t i = 0; i < requests.size(); i++) {
+      current = requests[i].get();
+      current_index = i;
+      next_fetch = next_clock = next_random = 0;
+      last_reading = 0;
+      report_divergence = iteration == 0;
+      diverged = false;
+      replayed_fetches.clear();
+
+      ConnectionTap response;
+      auto conn = Connection::from_bytes(current->request);
+      conn->set_tap(&response);
+      current->start = monotonic_now();
+      handle_connection(conn, "localhost", handler);
+      durations.push_back(monotonic_now() - current->start);
+      conn->set_tap(nullptr);
+
+      check_replayed_request(response);
+      if (diverged && iteration == 0) {
+        diverged_count++;
+      }
+      current = nullptr;
+    }
+  }
+
+  mode = Mode::Live;
+  if (durations.empty()) {
+    fprintf(stderr, "No requests recorded in %s\n", path);
+    return true;
+  }
+
+  uint64_t total = 0;
+  for (auto duration : durations) {
+    total += duration;
+  }
+  std::sort(durations.begin(), durations.end());
+  fprintf(stderr,
+          "Replayed %zu requests %u times (%zu diverged): mean %.1f us, median %.1f us, "
+          "p99 %.1f us, max %.1f us\n",
+          requests.size(), options.iterations, diverged_count,
+          total / 1000.0 / durations.size(), percentile(durations, 0.5),
+          percentile(durations, 0.99), durations.back() / 1000.0);
+  return true;
+}
+
+uint64_t clock_now() {
+  auto now = monotonic_now();
+  if (!current) {
+    return now;
+  }
+
+  if (mode == Mode::Record) {
+    current->clock_readings.push_back(now - current->start);
+    return now;
+  }
+
+  if (next_clock < current->clock_readings.size()) {
+    now = current->start + current->clock_readings[next_clock++];
+  } else {
+    diverge("more clock readings were taken than recorded");
+  }
+  // Falling back to the real clock must not make time go backwards.
+  last_reading = std::max(last_reading, now);
+  return last_reading;
+}
+
+bool random_bytes(std::span<uint8_t> buffer) {
+  if (mode == Mode::Replay && current) {
+    if (next_random < current->random.size() &&
+        current->random[next_random].size() == buffer.size()) {
+      memcpy(buffer.data(), current->random[next_random++].data(), buffer.size());
+      return true;
+    }
+    diverge("random bytes were requested that weren't recorded");
+  }
+
+  size_t offset = 0;
+  while (offset < buffer.size()) {
+    auto res = getrandom(buffer.data() + offset, buffer.size() - offset, 0);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    offset += res;
+  }
+
+  if (mode == Mode::Record && current) {
+    current->random.emplace_back(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+  }
+  return true;
+}
+
+std::shared_ptr<Connection> open_connection(std::string_view authority, uint16_t default_port,
+                                            std::optional<uint64_t> timeout, bool *timed_out) {
+  if (mode == Mode::Replay && current) {
+    if (next_fetch >= current->fetches.size()) {
+      diverge("an outgoing request was made that wasn't recorded");
+      return nullptr;
+    }
+    auto &fetch = current->fetches[next_fetch++];
+    if (fetch.failed) {
+      return nullptr;
+    }
+    auto release_time = emulate_latency ? monotonic_now() + fetch.latency : 0;
+    auto conn = Connection::from_bytes(fetch.tap.received, release_time);
+    conn->set_tap(&replayed_fetches.emplace_back());
+    return conn;
+  }
+
+  auto start = monotonic_now();
+  auto conn = connect(authority, default_port, timeout, timed_out);
+  if (mode == Mode::Record && current) {
+    auto &fetch = current->fetches.emplace_back();
+    fetch.start = start;
+    fetch.failed = !conn;
+    if (conn) {
+      fetch.conn = conn;
+      conn->set_tap(&fetch.tap);
+    }
+  }
+  return conn;
+}
+
+RecordedRequest *begin_recorded_request(const RequestHead &head, Connection &conn,
+                                        BodyReader &body) {
+  if (mode != Mode::Record) {
+    return nullptr;
+  }
+
+  auto *request = new RecordedRequest();
+  request->request = head.method;
+  request->request.append(" ");
+  request->request.append(head.target);
+  request->request.append(" HTTP/1.1\r\n");
+  for (const auto &[name, value] : head.fields.entries) {
+    // The body is stored with a `content-length`, and the connection isn't kept alive on replay.
+    if (name == "content-length" || name == "transfer-encoding" || name == "connection" ||
+        name == "keep-alive") {
+      continue;
+    }
+    request->request.append(name);
+    request->request.append(": ");
+    request->request.append(value);
+    request->request.append("\r\n");
+  }
+
+  request->start = monotonic_now();
+  conn.set_tap(&request->tap);
+  body.set_tap(&request->body);
+  current = request;
+  return request;
+}
+
+void finish_recorded_request(RecordedRequest *request, Connection &conn, BodyReader &body) {
+  request->duration = monotonic_now() - request->start;
+
+  // Receive the rest of the body, so that the request can be replayed regardless of how much of it
+  // the handler read.
+  uint8_t scratch[16 * 1024];
+  bool done = false;
+  size_t len;
+  while (body.read(scratch, &done, &len) && !done) {
+    if (len == 0) {
+      auto pollable = body.subscribe();
+      Pollable *pollables[] = {pollable.get()};
+      poll(pollables);
+    }
+  }
+
+  conn.set_tap(nullptr);
+  body.set_tap(nullptr);
+  for (auto &fetch : request->fetches) {
+    if (auto fetch_conn = fetch.conn.lock()) {
+      fetch_conn->set_tap(nullptr);
+    }
+    if (fetch.tap.first_byte_time != 0) {
+      fetch.latency = fetch.tap.first_byte_time - fetch.start;
+    }
+  }
+
+  request->request.append("content-length: ");
+  request->request.append(std::to_string(request->body.size()));
+  request->request.append("\r\n\r\n");
+  request->request.append(request->body);
+  request->response = std::move(request->tap.sent);
+
+  write_request(*request);
+  current = nullptr;
+  delete request;
+}
+
+} // namespace native
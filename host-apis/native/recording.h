@@ -0,0 +1,60 @@
+#ifndef STARLING_NATIVE_RECORDING_H
+#define STARLING_NATIVE_RECORDING_H
+
+// Recording and replaying of everything a request's handling depends on: the incoming request,
+// outgoing requests and their responses, monotonic clock readings and random bytes.
+//
+// Recordings are made by a live server, and replayed without network access, so that benchmarks
+// of real handlers are deterministic and reproducible. During replay, outgoing requests are served
+// from the recording in the order they were made, instead of being sent.
+
+#include "native.h"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+
+namespace native {
+
+/// Record all requests handled from now on to a file at `path`, overwriting it.
+bool start_recording(const char *path);
+
+struct RecordingOptions final {
+  /// How often to replay all requests.
+  unsigned iterations = 1;
+  /// Delay the responses to outgoing requests by the time it took to receive their first bytes
+  /// while recording, instead of serving them immediately.
+  bool emulate_latency = false;
+};
+
+/// Replay all requests recorded in the file at `path`, and print statistics on how long handling
+/// them took to stderr.
+bool replay(const char *path, RequestHandler handler, const RecordingOptions &options);
+
+/// The current time of the monotonic clock as seen by the request being handled, in nanoseconds.
+uint64_t clock_now();
+
+/// Fill `buffer` with random bytes.
+bool random_bytes(std::span<uint8_t> buffer);
+
+/// Open a connection for an outgoing request, see `connect`.
+std::shared_ptr<Connection> open_connection(std::string_view authority, uint16_t default_port,
+                                            std::optional<uint64_t> timeout = std::nullopt,
+                                            bool *timed_out = nullptr);
+
+struct RecordedRequest;
+
+/// Start recording the request with `head`, whose body is read by `body`, and whose response is
+/// sent on `conn`.
+///
+/// @return the request's recording, or null if no recording is being made.
+RecordedRequest *begin_recorded_request(const RequestHead &head, Connection &conn,
+                                        BodyReader &body);
+
+/// Finish the request's recording and write it out, after receiving the rest of its body.
+void finish_recorded_request(RecordedRequest *request, Connection &conn, BodyReader &body);
+
+} // namespace native
+
+#endif
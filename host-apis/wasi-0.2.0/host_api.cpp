@@ -1,7 +1,12 @@
 #include "host_api.h"
+#include "allocator.h"
 #include "bindings/bindings.h"
+#ifdef HOST_CALL_PROFILING
+#include "host_call_profiling.h"
+#endif
 
 #include <algorithm>
+#include <cstring>
 
 using std::optional;
 using std::string_view;
@@ -97,6 +102,8 @@ template <> struct HandleOps<Pollable> {
 } // namespace
 
 size_t api::AsyncTask::select(std::vector<api::AsyncTask *> *tasks) {
+  // The list of ready indices is only needed until the first one is read.
+  CabiArenaScope arena;
   auto count = tasks->size();
   vector<Borrow<Pollable>> handles;
   for (const auto task : *tasks) {
@@ -108,7 +115,6 @@ size_t api::AsyncTask::select(std::vector<api::AsyncTask *> *tasks) {
   wasi_io_0_2_0_poll_poll(&list, &result);
   MOZ_ASSERT(result.len > 0);
   const auto ready_index = result.ptr[0];
-  free(result.ptr);
 
   return ready_index;
 }
@@ -141,10 +147,10 @@ auto string_view_to_world_string = from_string_view<bindings_string_t>;
 
 HostString scheme_to_string(const wasi_http_0_2_0_types_scheme_t scheme) {
   if (scheme.tag == WASI_HTTP_0_2_0_TYPES_SCHEME_HTTP) {
-    return {"http:"};
+    return {"http"};
   }
   if (scheme.tag == WASI_HTTP_0_2_0_TYPES_SCHEME_HTTPS) {
-    return {"https:"};
+    return {"https"};
   }
   return to_host_string(scheme.val.other);
 }
@@ -190,30 +196,28 @@ HttpHeaders::HttpHeaders() {
 }
 HttpHeaders::HttpHeaders(Handle handle) { handle_state_ = new HandleState(handle); }
 
-// TODO: make this a factory function
-HttpHeaders::HttpHeaders(const vector<tuple<string_view, vector<string_view>>> &entries) {
-  std::vector<wasi_http_0_2_0_types_tuple2_field_key_field_value_t> pairs;
+HttpHeaders::HttpHeaders(const HttpHeaders &headers) {
+  Borrow<HttpHeaders> borrow(headers.handle_state_);
+  auto handle = wasi_http_0_2_0_types_method_fields_clone(borrow);
+  this->handle_state_ = new HandleState(handle.__handle);
+}
 
-  for (const auto &[name, values] : entries) {
-    for (const auto &value : values) {
-      pairs.emplace_back(from_string_view<field_key>(name), from_string_view<field_value>(value));
-    }
+Result<HttpHeaders *> HttpHeaders::from_list(const vector<tuple<string_view, string_view>> &entries) {
+  std::vector<wasi_http_0_2_0_types_tuple2_field_key_field_value_t> pairs;
+  pairs.reserve(entries.size());
+  for (const auto &[name, value] : entries) {
+    pairs.emplace_back(from_string_view<field_key>(name), from_string_view<field_value>(value));
   }
 
-  wasi_http_0_2_0_types_list_tuple2_field_key_field_value_t tuples{pairs.data(), entries.size()};
+  wasi_http_0_2_0_types_list_tuple2_field_key_field_value_t tuples{pairs.data(), pairs.size()};
 
   wasi_http_0_2_0_types_own_fields_t ret;
   wasi_http_0_2_0_types_header_error_t err;
-  wasi_http_0_2_0_types_static_fields_from_list(&tuples, &ret, &err);
-  // TODO: handle `err`
-
-  this->handle_state_ = new HandleState(ret.__handle);
-}
+  if (!wasi_http_0_2_0_types_static_fields_from_list(&tuples, &ret, &err)) {
+    return Result<HttpHeaders *>::err(154);
+  }
 
-HttpHeaders::HttpHeaders(const HttpHeaders &headers) {
-  Borrow<HttpHeaders> borrow(headers.handle_state_);
-  auto handle = wasi_http_0_2_0_types_method_fields_clone(borrow);
-  this->handle_state_ = new HandleState(handle.__handle);
+  return Result<HttpHeaders *>::ok(new HttpHeaders(ret.__handle));
 }
 
 Result<vector<tuple<HostString, HostString>>> HttpHeaders::entries() const {
@@ -237,6 +241,33 @@ Result<vector<tuple<HostString, HostString>>> HttpHeaders::entries() const {
   return res;
 }
 
+Result<const HttpHeadersTable *> HttpHeaders::table() {
+  if (table_) {
+    return Result<const HttpHeadersTable *>::ok(table_.get());
+  }
+  MOZ_ASSERT(valid());
+
+  // The host's result is only needed until it's copied into the table, so it's allocated in the
+  // arena instead of as individual strings.
+  CabiArenaScope arena;
+  wasi_http_0_2_0_types_list_tuple2_field_key_field_value_t entries;
+  Borrow<HttpHeaders> borrow(this->handle_state_);
+  wasi_http_0_2_0_types_method_fields_entries(borrow, &entries);
+
+  size_t bytes = 0;
+  for (size_t i = 0; i < entries.len; i++) {
+    bytes += entries.ptr[i].f0.len + entries.ptr[i].f1.len;
+  }
+  table_ = std::make_unique<HttpHeadersTable>(entries.len, bytes);
+  for (size_t i = 0; i < entries.len; i++) {
+    auto &entry = entries.ptr[i];
+    table_->add(string_view(reinterpret_cast<char *>(entry.f0.ptr), entry.f0.len),
+                string_view(reinterpret_cast<char *>(entry.f1.ptr), entry.f1.len));
+  }
+
+  return Result<const HttpHeadersTable *>::ok(table_.get());
+}
+
 Result<vector<HostString>> HttpHeaders::names() const {
   Result<vector<HostString>> res;
   MOZ_ASSERT(valid());
@@ -282,6 +313,7 @@ Result<optional<vector<HostString>>> HttpHeaders::get(string_view name) const {
 
 Result<Void> HttpHeaders::set(string_view name, string_view value) {
   MOZ_ASSERT(valid());
+  table_.reset();
   auto hdr = from_string_view<field_key>(name);
   auto val = from_string_view<field_value>(value);
   wasi_http_0_2_0_types_list_field_value_t host_values{&val, 1};
@@ -297,6 +329,7 @@ Result<Void> HttpHeaders::set(string_view name, string_view value) {
 
 Result<Void> HttpHeaders::append(string_view name, string_view value) {
   MOZ_ASSERT(valid());
+  table_.reset();
   auto hdr = from_string_view<field_key>(name);
   auto val = from_string_view<field_value>(value);
   Borrow<HttpHeaders> borrow(this->handle_state_);
@@ -311,6 +344,7 @@ Result<Void> HttpHeaders::append(string_view name, string_view value) {
 
 Result<Void> HttpHeaders::remove(string_view name) {
   MOZ_ASSERT(valid());
+  table_.reset();
   auto hdr = string_view_to_world_string(name);
   Borrow<HttpHeaders> borrow(this->handle_state_);
 
@@ -322,33 +356,11 @@ Result<Void> HttpHeaders::remove(string_view name) {
   return {};
 }
 
-// TODO: convert to `Result`
 string_view HttpRequestResponseBase::url() {
   if (_url) {
     return string_view(*_url);
   }
-
-  auto borrow = borrow_incoming_request_t{handle_state_->handle};
-
-  wasi_http_0_2_0_types_scheme_t scheme;
-  bool success;
-  success = wasi_http_0_2_0_types_method_incoming_request_scheme(borrow, &scheme);
-  MOZ_RELEASE_ASSERT(success);
-
-  bindings_string_t authority;
-  success = wasi_http_0_2_0_types_method_incoming_request_authority(borrow, &authority);
-  MOZ_RELEASE_ASSERT(success);
-
-  bindings_string_t path;
-  success = wasi_http_0_2_0_types_method_incoming_request_path_with_query(borrow, &path);
-  MOZ_RELEASE_ASSERT(success);
-
-  HostString scheme_str = scheme_to_string(scheme);
-  _url = new std::string(scheme_str.ptr.release(), scheme_str.len);
-  _url->append(string_view(bindings_string_to_host_string(authority)));
-  _url->append(string_view(bindings_string_to_host_string(path)));
-
-  return string_view(*_url);
+  return {};
 }
 
 bool write_to_outgoing_body(Borrow<OutputStream> borrow, const uint8_t *ptr, const size_t len) {
@@ -458,6 +470,10 @@ class BodyAppendTask final : public api::AsyncTask {
   PollableHandle outgoing_pollable_;
   State state_;
 
+  // Scratch buffer reused for all chunks copied from the incoming to the outgoing body.
+  static constexpr size_t BUFFER_SIZE = 64 * 1024;
+  unique_ptr<uint8_t[]> buffer_;
+
   void set_state(const State state) {
     MOZ_ASSERT(state_ != State::Done);
     state_ = state;
@@ -465,7 +481,8 @@ class BodyAppendTask final : public api::AsyncTask {
 
 public:
   explicit BodyAppendTask(HttpIncomingBody *incoming_body, HttpOutgoingBody *outgoing_body)
-      : incoming_body_(incoming_body), outgoing_body_(outgoing_body) {
+      : incoming_body_(incoming_body), outgoing_body_(outgoing_body),
+        buffer_(new uint8_t[BUFFER_SIZE]) {
     auto res = incoming_body_->subscribe();
     MOZ_ASSERT(!res.is_err());
     incoming_pollable_ = res.unwrap();
@@ -481,9 +498,9 @@ public:
     // If run is called while we're blocked on the incoming stream, that means that stream's
     // pollable has resolved, so the stream must be ready.
     if (state_ == State::BlockedOnBoth || state_ == State::BlockedOnIncoming) {
-      auto res = incoming_body_->read(0);
+      auto res = incoming_body_->read_into({});
       MOZ_ASSERT(!res.is_err());
-      auto [done, _] = std::move(res.unwrap());
+      auto [done, _] = res.unwrap();
       if (done) {
         set_state(State::Done);
         return true;
@@ -508,26 +525,26 @@ public:
 
     MOZ_ASSERT(state_ == State::Ready);
 
-    // TODO: reuse a buffer for this loop
     do {
-      auto res = incoming_body_->read(capacity);
+      auto chunk_size = std::min<uint64_t>(capacity, BUFFER_SIZE);
+      auto res = incoming_body_->read_into({buffer_.get(), static_cast<size_t>(chunk_size)});
       if (res.is_err()) {
         // TODO: proper error handling.
         return false;
       }
-      auto [done, bytes] = std::move(res.unwrap());
-      if (bytes.len == 0 && !done) {
+      auto [done, len] = res.unwrap();
+      if (len == 0 && !done) {
         set_state(State::BlockedOnIncoming);
         engine->queue_async_task(this);
         return true;
       }
 
-      auto offset = 0;
-      while (bytes.len - offset > 0) {
+      size_t offset = 0;
+      while (len - offset > 0) {
         // TODO: remove double checking of write-readiness
         // TODO: make this async by storing the remaining chunk in the task and marking it as
         // being blocked on write
-        auto write_res = outgoing_body_->write(bytes.ptr.get() + offset, bytes.len - offset);
+        auto write_res = outgoing_body_->write(buffer_.get() + offset, len - offset);
         if (write_res.is_err()) {
           // TODO: proper error handling.
           return false;
@@ -745,11 +762,51 @@ Result<HttpOutgoingBody *> HttpOutgoingRequest::body() {
   return Res::ok(body_);
 }
 
-Result<FutureHttpIncomingResponse *> HttpOutgoingRequest::send() {
+namespace {
+
+/// Create a request-options resource with the timeouts set in `options`.
+wasi_http_0_2_0_types_own_request_options_t make_request_options(const OutgoingRequestOptions &options) {
+  auto request_options = wasi_http_0_2_0_types_constructor_request_options();
+  auto borrow = wasi_http_0_2_0_types_borrow_request_options(request_options);
+  // Setting a timeout fails if the host doesn't support it, in which case its default applies.
+  if (options.connect_timeout) {
+    wasi_http_0_2_0_types_duration_t timeout = *options.connect_timeout;
+    wasi_http_0_2_0_types_method_request_options_set_connect_timeout(borrow, &timeout);
+  }
+  if (options.first_byte_timeout) {
+    wasi_http_0_2_0_types_duration_t timeout = *options.first_byte_timeout;
+    wasi_http_0_2_0_types_method_request_options_set_first_byte_timeout(borrow, &timeout);
+  }
+  if (options.between_bytes_timeout) {
+    wasi_http_0_2_0_types_duration_t timeout = *options.between_bytes_timeout;
+    wasi_http_0_2_0_types_method_request_options_set_between_bytes_timeout(borrow, &timeout);
+  }
+  return request_options;
+}
+
+bool is_timeout_error(const wasi_http_0_2_0_types_error_code_t &err) {
+  return err.tag == WASI_HTTP_0_2_0_TYPES_ERROR_CODE_CONNECTION_TIMEOUT ||
+         err.tag == WASI_HTTP_0_2_0_TYPES_ERROR_CODE_CONNECTION_READ_TIMEOUT ||
+         err.tag == WASI_HTTP_0_2_0_TYPES_ERROR_CODE_CONNECTION_WRITE_TIMEOUT ||
+         err.tag == WASI_HTTP_0_2_0_TYPES_ERROR_CODE_HTTP_RESPONSE_TIMEOUT;
+}
+
+} // namespace
+
+Result<FutureHttpIncomingResponse *> HttpOutgoingRequest::send(const OutgoingRequestOptions &options) {
   MOZ_ASSERT(valid());
+  wasi_http_0_2_0_outgoing_handler_own_request_options_t request_options;
+  wasi_http_0_2_0_outgoing_handler_own_request_options_t *maybe_options = nullptr;
+  if (!options.empty()) {
+    request_options = make_request_options(options);
+    maybe_options = &request_options;
+  }
+
   future_incoming_response_t ret;
   wasi_http_0_2_0_outgoing_handler_error_code_t err;
-  wasi_http_0_2_0_outgoing_handler_handle({handle_state_->handle}, nullptr, &ret, &err);
+  if (!wasi_http_0_2_0_outgoing_handler_handle({handle_state_->handle}, maybe_options, &ret, &err)) {
+    return Result<FutureHttpIncomingResponse *>::err(is_timeout_error(err) ? TIMEOUT_ERROR : 154);
+  }
   auto res = new FutureHttpIncomingResponse(ret.__handle);
   return Result<FutureHttpIncomingResponse *>::ok(res);
 }
@@ -793,15 +850,63 @@ Result<HttpIncomingBody::ReadResult> HttpIncomingBody::read(uint32_t chunk_size)
   return Res::ok(ReadResult(false, unique_ptr<uint8_t[]>(ret.ptr), ret.len));
 }
 
-// TODO: implement
-Result<Void> HttpIncomingBody::close() { return {}; }
+Result<HttpIncomingBody::ReadIntoResult> HttpIncomingBody::read_into(std::span<uint8_t> buffer) {
+  typedef Result<ReadIntoResult> Res;
 
-Result<PollableHandle> HttpIncomingBody::subscribe() {
+  wasi_io_0_2_0_streams_list_u8_t ret{};
+  wasi_io_0_2_0_streams_stream_error_t err{};
   auto borrow = borrow_input_stream_t(
       {static_cast<IncomingBodyHandleState *>(handle_state_)->stream_handle_});
-  auto pollable = wasi_io_0_2_0_streams_method_input_stream_subscribe(borrow);
-  return Result<PollableHandle>::ok(pollable.__handle);
+  // Have the host write the chunk straight into `buffer` instead of a fresh allocation. The host
+  // won't necessarily allocate at all for empty results, so the target is cleared afterwards.
+  cabi_realloc_into(buffer.data(), buffer.size());
+  bool success = wasi_io_0_2_0_streams_method_input_stream_read(borrow, buffer.size(), &ret, &err);
+  cabi_realloc_into(nullptr, 0);
+  if (!success) {
+    if (err.tag == WASI_IO_0_2_0_STREAMS_STREAM_ERROR_CLOSED) {
+      return Res::ok(ReadIntoResult(true, 0));
+    }
+    return Res::err(154);
+  }
+  if (ret.ptr != buffer.data()) {
+    // The host only writes into `buffer` if the chunk fits. Otherwise it was allocated separately,
+    // and a host returning more than was asked for must not overflow `buffer`.
+    size_t len = ret.len;
+    if (len > 0 && len <= buffer.size()) {
+      memcpy(buffer.data(), ret.ptr, len);
+    }
+    cabi_free(ret.ptr);
+    if (len > buffer.size()) {
+      return Res::err(154);
+    }
+  }
+  return Res::ok(ReadIntoResult(false, ret.len));
 }
+
+Result<Void> HttpIncomingBody::close() {
+  if (!valid()) {
+    return {};
+  }
+  auto state = static_cast<IncomingBodyHandleState *>(handle_state_);
+  // Child resources have to be dropped before their parents.
+  unsubscribe();
+  wasi_io_0_2_0_streams_input_stream_drop_own(own_input_stream_t{state->stream_handle_});
+  wasi_http_0_2_0_types_incoming_body_drop_own({state->handle});
+  delete handle_state_;
+  handle_state_ = nullptr;
+  return {};
+}
+
+Result<PollableHandle> HttpIncomingBody::subscribe() {
+  auto state = static_cast<IncomingBodyHandleState *>(handle_state_);
+  if (state->pollable_handle_ == INVALID_POLLABLE_HANDLE) {
+    auto borrow = borrow_input_stream_t({state->stream_handle_});
+    auto pollable = wasi_io_0_2_0_streams_method_input_stream_subscribe(borrow);
+    state->pollable_handle_ = pollable.__handle;
+  }
+  return Result<PollableHandle>::ok(state->pollable_handle_);
+}
+
 void HttpIncomingBody::unsubscribe() {
   auto state = static_cast<IncomingBodyHandleState *>(handle_state_);
   if (state->pollable_handle_ == INVALID_POLLABLE_HANDLE) {
@@ -811,8 +916,18 @@ void HttpIncomingBody::unsubscribe() {
   state->pollable_handle_ = INVALID_POLLABLE_HANDLE;
 }
 
+class FutureIncomingResponseHandleState final : HandleState {
+  PollableHandle pollable_handle_;
+
+  friend FutureHttpIncomingResponse;
+
+public:
+  explicit FutureIncomingResponseHandleState(const Handle handle)
+      : HandleState(handle), pollable_handle_(INVALID_POLLABLE_HANDLE) {}
+};
+
 FutureHttpIncomingResponse::FutureHttpIncomingResponse(Handle handle) {
-  handle_state_ = new HandleState(handle);
+  handle_state_ = new FutureIncomingResponseHandleState(handle);
 }
 
 Result<optional<HttpIncomingResponse *>> FutureHttpIncomingResponse::maybe_response() {
@@ -828,19 +943,38 @@ Result<optional<HttpIncomingResponse *>> FutureHttpIncomingResponse::maybe_respo
 
   auto [is_err, val] = res.val.ok;
   if (is_err) {
-    return Res::err(154);
+    return Res::err(is_timeout_error(val.err) ? TIMEOUT_ERROR : 154);
   }
 
   return Res::ok(new HttpIncomingResponse(val.ok.__handle));
 }
 
 Result<PollableHandle> FutureHttpIncomingResponse::subscribe() {
-  auto borrow = wasi_http_0_2_0_types_borrow_future_incoming_response({handle_state_->handle});
-  auto pollable = wasi_http_0_2_0_types_method_future_incoming_response_subscribe(borrow);
-  return Result<PollableHandle>::ok(pollable.__handle);
+  auto state = static_cast<FutureIncomingResponseHandleState *>(handle_state_);
+  if (state->pollable_handle_ == INVALID_POLLABLE_HANDLE) {
+    auto borrow = wasi_http_0_2_0_types_borrow_future_incoming_response({state->handle});
+    auto pollable = wasi_http_0_2_0_types_method_future_incoming_response_subscribe(borrow);
+    state->pollable_handle_ = pollable.__handle;
+  }
+  return Result<PollableHandle>::ok(state->pollable_handle_);
 }
+
 void FutureHttpIncomingResponse::unsubscribe() {
-  // TODO: implement
+  auto state = static_cast<FutureIncomingResponseHandleState *>(handle_state_);
+  if (state->pollable_handle_ == INVALID_POLLABLE_HANDLE) {
+    return;
+  }
+  wasi_io_0_2_0_poll_pollable_drop_own(own_pollable_t{state->pollable_handle_});
+  state->pollable_handle_ = INVALID_POLLABLE_HANDLE;
+}
+
+void FutureHttpIncomingResponse::close() {
+  MOZ_ASSERT(valid());
+  // The pollable is a child resource of the future, so it has to be dropped first.
+  unsubscribe();
+  wasi_http_0_2_0_types_future_incoming_response_drop_own({handle_state_->handle});
+  delete handle_state_;
+  handle_state_ = nullptr;
 }
 
 Result<uint16_t> HttpIncomingResponse::status() {
@@ -948,24 +1082,99 @@ Result<Void> HttpOutgoingResponse::send(ResponseOutparam out_param) {
   return {};
 }
 
-HttpIncomingRequest::HttpIncomingRequest(Handle handle) { handle_state_ = new HandleState(handle); }
+class IncomingRequestHandleState final : HandleState {
+  bool has_snapshot_ = false;
+  std::string method_;
+  // The URL is stored in a single buffer, with the offsets of its components recorded separately,
+  // so that all of them can be handed out as slices of the same string.
+  std::string url_;
+  size_t authority_start_ = 0;
+  size_t path_start_ = 0;
 
-Result<string_view> HttpIncomingRequest::method() {
-  if (method_.empty()) {
-    if (!valid()) {
-      return Result<string_view>::err(154);
-    }
+  friend HttpIncomingRequest;
+
+public:
+  explicit IncomingRequestHandleState(const Handle handle) : HandleState(handle) {}
+
+  /// Retrieve the request's method and URL from the host, unless that already happened.
+  void ensure_snapshot();
+};
+
+void IncomingRequestHandleState::ensure_snapshot() {
+  if (has_snapshot_) {
+    return;
   }
+
+  borrow_incoming_request_t borrow(handle);
+
   wasi_http_0_2_0_types_method_t method;
-  wasi_http_0_2_0_types_method_incoming_request_method(
-      borrow_incoming_request_t(handle_state_->handle), &method);
+  wasi_http_0_2_0_types_method_incoming_request_method(borrow, &method);
   if (method.tag != WASI_HTTP_0_2_0_TYPES_METHOD_OTHER) {
-    method_ = std::string(http_method_names[method.tag], strlen(http_method_names[method.tag]));
+    method_ = http_method_names[method.tag];
   } else {
     method_ = std::string(reinterpret_cast<char *>(method.val.other.ptr), method.val.other.len);
     bindings_string_free(&method.val.other);
   }
-  return Result<string_view>::ok(method_);
+
+  wasi_http_0_2_0_types_scheme_t scheme;
+  bool success = wasi_http_0_2_0_types_method_incoming_request_scheme(borrow, &scheme);
+  MOZ_RELEASE_ASSERT(success);
+
+  bindings_string_t authority;
+  success = wasi_http_0_2_0_types_method_incoming_request_authority(borrow, &authority);
+  MOZ_RELEASE_ASSERT(success);
+
+  bindings_string_t path;
+  success = wasi_http_0_2_0_types_method_incoming_request_path_with_query(borrow, &path);
+  MOZ_RELEASE_ASSERT(success);
+
+  url_ = string_view(scheme_to_string(scheme));
+  url_.append("://");
+  authority_start_ = url_.size();
+  url_.append(string_view(bindings_string_to_host_string(authority)));
+  path_start_ = url_.size();
+  url_.append(string_view(bindings_string_to_host_string(path)));
+
+  has_snapshot_ = true;
+}
+
+HttpIncomingRequest::HttpIncomingRequest(Handle handle) {
+  handle_state_ = new IncomingRequestHandleState(handle);
+}
+
+Result<string_view> HttpIncomingRequest::method() {
+  if (!valid()) {
+    return Result<string_view>::err(154);
+  }
+  auto state = static_cast<IncomingRequestHandleState *>(handle_state_);
+  state->ensure_snapshot();
+  return Result<string_view>::ok(state->method_);
+}
+
+string_view HttpIncomingRequest::url() {
+  MOZ_ASSERT(valid());
+  auto state = static_cast<IncomingRequestHandleState *>(handle_state_);
+  state->ensure_snapshot();
+  return state->url_;
+}
+
+string_view HttpIncomingRequest::scheme() {
+  auto url = this->url();
+  auto state = static_cast<IncomingRequestHandleState *>(handle_state_);
+  // Strip the "://" separating the scheme from the authority.
+  return url.substr(0, state->authority_start_ - 3);
+}
+
+string_view HttpIncomingRequest::authority() {
+  auto url = this->url();
+  auto state = static_cast<IncomingRequestHandleState *>(handle_state_);
+  return url.substr(state->authority_start_, state->path_start_ - state->authority_start_);
+}
+
+string_view HttpIncomingRequest::path_with_query() {
+  auto url = this->url();
+  auto state = static_cast<IncomingRequestHandleState *>(handle_state_);
+  return url.substr(state->path_start_);
 }
 
 Result<HttpHeaders *> HttpIncomingRequest::headers() {
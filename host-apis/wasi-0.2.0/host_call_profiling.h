@@ -0,0 +1,132 @@
+#ifndef HOST_CALL_PROFILING_H
+#define HOST_CALL_PROFILING_H
+
+// Routes all bindings used in host_api.cpp through the host call profiler. Must be included after
+// "bindings/bindings.h", so that the bindings' declarations aren't affected.
+//
+// Each entry names the binding, its interface, and the number of parameters that are inputs, as
+// opposed to outparams. Bindings that are newly used in host_api.cpp need to be added here.
+
+#include "host_call_profiler.h"
+
+#define wasi_clocks_0_2_0_monotonic_clock_now(...)                                                 \
+  HOST_CALL_PROFILED(wasi_clocks_0_2_0_monotonic_clock_now, Clocks, 0, __VA_ARGS__)
+#define wasi_clocks_0_2_0_monotonic_clock_resolution(...)                                          \
+  HOST_CALL_PROFILED(wasi_clocks_0_2_0_monotonic_clock_resolution, Clocks, 0, __VA_ARGS__)
+#define wasi_clocks_0_2_0_monotonic_clock_subscribe_duration(...)                                  \
+  HOST_CALL_PROFILED(wasi_clocks_0_2_0_monotonic_clock_subscribe_duration, Clocks, 1, __VA_ARGS__)
+#define wasi_clocks_0_2_0_monotonic_clock_subscribe_instant(...)                                   \
+  HOST_CALL_PROFILED(wasi_clocks_0_2_0_monotonic_clock_subscribe_instant, Clocks, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_outgoing_handler_handle(...)                                               \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_outgoing_handler_handle, OutgoingHandler, 2, __VA_ARGS__)
+#define wasi_http_0_2_0_types_constructor_fields(...)                                              \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_constructor_fields, HttpTypes, 0, __VA_ARGS__)
+#define wasi_http_0_2_0_types_constructor_outgoing_request(...)                                    \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_constructor_outgoing_request, HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_constructor_outgoing_response(...)                                   \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_constructor_outgoing_response, HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_fields_drop_own(...)                                                 \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_fields_drop_own, HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_fields_append(...)                                            \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_fields_append, HttpTypes, 3, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_fields_clone(...)                                             \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_fields_clone, HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_fields_delete(...)                                            \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_fields_delete, HttpTypes, 2, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_fields_entries(...)                                           \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_fields_entries, HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_fields_get(...)                                               \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_fields_get, HttpTypes, 2, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_fields_set(...)                                               \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_fields_set, HttpTypes, 3, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_future_incoming_response_get(...)                             \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_future_incoming_response_get,                    \
+                     HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_future_incoming_response_subscribe(...)                       \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_future_incoming_response_subscribe,              \
+                     HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_incoming_body_stream(...)                                     \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_incoming_body_stream, HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_incoming_request_authority(...)                               \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_incoming_request_authority,                      \
+                     HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_incoming_request_consume(...)                                 \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_incoming_request_consume,                        \
+                     HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_incoming_request_headers(...)                                 \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_incoming_request_headers,                        \
+                     HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_incoming_request_method(...)                                  \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_incoming_request_method,                         \
+                     HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_incoming_request_path_with_query(...)                         \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_incoming_request_path_with_query,                \
+                     HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_incoming_request_scheme(...)                                  \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_incoming_request_scheme,                         \
+                     HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_incoming_response_consume(...)                                \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_incoming_response_consume,                       \
+                     HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_incoming_response_headers(...)                                \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_incoming_response_headers,                       \
+                     HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_incoming_response_status(...)                                 \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_incoming_response_status,                        \
+                     HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_outgoing_body_write(...)                                      \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_outgoing_body_write, HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_outgoing_request_body(...)                                    \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_outgoing_request_body, HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_outgoing_request_set_authority(...)                           \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_outgoing_request_set_authority,                  \
+                     HttpTypes, 2, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_outgoing_request_set_method(...)                              \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_outgoing_request_set_method,                     \
+                     HttpTypes, 2, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_outgoing_request_set_path_with_query(...)                     \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_outgoing_request_set_path_with_query,            \
+                     HttpTypes, 2, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_outgoing_request_set_scheme(...)                              \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_outgoing_request_set_scheme,                     \
+                     HttpTypes, 2, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_outgoing_response_body(...)                                   \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_outgoing_response_body, HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_outgoing_response_headers(...)                                \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_outgoing_response_headers,                       \
+                     HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_method_outgoing_response_set_status_code(...)                        \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_method_outgoing_response_set_status_code,               \
+                     HttpTypes, 2, __VA_ARGS__)
+#define wasi_http_0_2_0_types_static_fields_from_list(...)                                         \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_static_fields_from_list, HttpTypes, 1, __VA_ARGS__)
+#define wasi_http_0_2_0_types_static_outgoing_body_finish(...)                                     \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_static_outgoing_body_finish, HttpTypes, 2, __VA_ARGS__)
+#define wasi_http_0_2_0_types_static_response_outparam_set(...)                                    \
+  HOST_CALL_PROFILED(wasi_http_0_2_0_types_static_response_outparam_set, HttpTypes, 2, __VA_ARGS__)
+#define wasi_io_0_2_0_poll_poll(...)                                                               \
+  HOST_CALL_PROFILED(wasi_io_0_2_0_poll_poll, Poll, 1, __VA_ARGS__)
+#define wasi_io_0_2_0_poll_pollable_drop_own(...)                                                  \
+  HOST_CALL_PROFILED(wasi_io_0_2_0_poll_pollable_drop_own, Poll, 1, __VA_ARGS__)
+#define wasi_io_0_2_0_streams_method_input_stream_read(...)                                        \
+  HOST_CALL_PROFILED(wasi_io_0_2_0_streams_method_input_stream_read, Streams, 2, __VA_ARGS__)
+#define wasi_io_0_2_0_streams_method_input_stream_subscribe(...)                                   \
+  HOST_CALL_PROFILED(wasi_io_0_2_0_streams_method_input_stream_subscribe, Streams, 1, __VA_ARGS__)
+#define wasi_io_0_2_0_streams_method_output_stream_blocking_flush(...)                             \
+  HOST_CALL_PROFILED(wasi_io_0_2_0_streams_method_output_stream_blocking_flush,                    \
+                     Streams, 1, __VA_ARGS__)
+#define wasi_io_0_2_0_streams_method_output_stream_check_write(...)                                \
+  HOST_CALL_PROFILED(wasi_io_0_2_0_streams_method_output_stream_check_write,                       \
+                     Streams, 1, __VA_ARGS__)
+#define wasi_io_0_2_0_streams_method_output_stream_subscribe(...)                                  \
+  HOST_CALL_PROFILED(wasi_io_0_2_0_streams_method_output_stream_subscribe, Streams, 1, __VA_ARGS__)
+#define wasi_io_0_2_0_streams_method_output_stream_write(...)                                      \
+  HOST_CALL_PROFILED(wasi_io_0_2_0_streams_method_output_stream_write, Streams, 2, __VA_ARGS__)
+#define wasi_io_0_2_0_streams_output_stream_drop_own(...)                                          \
+  HOST_CALL_PROFILED(wasi_io_0_2_0_streams_output_stream_drop_own, Streams, 1, __VA_ARGS__)
+#define wasi_random_0_2_0_random_get_random_bytes(...)                                             \
+  HOST_CALL_PROFILED(wasi_random_0_2_0_random_get_random_bytes, Random, 1, __VA_ARGS__)
+#define wasi_random_0_2_0_random_get_random_u64(...)                                               \
+  HOST_CALL_PROFILED(wasi_random_0_2_0_random_get_random_u64, Random, 0, __VA_ARGS__)
+
+#endif
@@ -140,15 +140,37 @@ inline bool ThrowIfNotConstructing(JSContext *cx, const CallArgs &args, const ch
 }
 namespace builtins {
 
-template <typename Impl> class BuiltinImpl {
+/// The class hooks of builtins that don't need any.
+struct DefaultClassOps {
   static constexpr JSClassOps class_ops{};
   static constexpr uint32_t class_flags = 0;
+};
+
+/// The class hooks of builtins whose instances own native resources, which `Impl::finalize`
+/// releases once an instance has been collected.
+template <typename Impl> struct FinalizableClassOps {
+  static constexpr JSClassOps class_ops{
+      nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, Impl::finalize,
+  };
+  static constexpr uint32_t class_flags = JSCLASS_FOREGROUND_FINALIZE;
+};
 
+/// The class hooks of builtins whose instances own native resources holding GC things, which
+/// `Impl::trace` traces, and `Impl::finalize` releases once an instance has been collected.
+template <typename Impl> struct TraceableClassOps {
+  static constexpr JSClassOps class_ops{
+      nullptr, nullptr, nullptr,        nullptr, nullptr,
+      nullptr, Impl::finalize, nullptr, nullptr, Impl::trace,
+  };
+  static constexpr uint32_t class_flags = JSCLASS_FOREGROUND_FINALIZE;
+};
+
+template <typename Impl, typename Ops = DefaultClassOps> class BuiltinImpl {
 public:
   static constexpr JSClass class_{
       Impl::class_name,
-      JSCLASS_HAS_RESERVED_SLOTS(static_cast<uint32_t>(Impl::Slots::Count)) | class_flags,
-      &class_ops,
+      JSCLASS_HAS_RESERVED_SLOTS(static_cast<uint32_t>(Impl::Slots::Count)) | Ops::class_flags,
+      &Ops::class_ops,
   };
 
   static JS::Result<std::tuple<CallArgs, RootedObject *>>
@@ -196,7 +218,12 @@ public:
   }
 };
 
-template <typename Impl> PersistentRooted<JSObject *> BuiltinImpl<Impl>::proto_obj{};
+template <typename Impl, typename Ops>
+PersistentRooted<JSObject *> BuiltinImpl<Impl, Ops>::proto_obj{};
+
+/// A builtin that has to release native resources when its instances are collected.
+template <typename Impl>
+using FinalizableBuiltinImpl = BuiltinImpl<Impl, FinalizableClassOps<Impl>>;
 
 template <typename Impl> class BuiltinNoConstructor : public BuiltinImpl<Impl> {
 public:
@@ -67,10 +67,15 @@ public:
 class AsyncTask {
 protected:
   PollableHandle handle_ = -1;
+  /// Set by tasks that nothing refers to anymore once they've run or been cancelled, so that the
+  /// event loop deletes them. Tasks never delete themselves, as they might still be queued.
+  bool finished_ = false;
 
 public:
   virtual ~AsyncTask() = default;
 
+  /// Run the task, which the event loop has already removed from its queue. A task that isn't done
+  /// yet has to queue itself again.
   virtual bool run(Engine *engine) = 0;
   virtual bool cancel(Engine *engine) = 0;
   virtual bool ready() = 0;
@@ -82,6 +87,15 @@ public:
 
   virtual void trace(JSTracer *trc) = 0;
 
+  /// Whether the event loop deletes the task after running or cancelling it. Otherwise, that's up
+  /// to the task's owner.
+  bool finished() const { return finished_; }
+
+  /// Whether the event loop keeps running while this task is pending. Tasks that don't still run
+  /// if they become ready while the loop is running for other tasks, but the loop doesn't wait for
+  /// them on their own.
+  virtual bool keeps_event_loop_alive() { return true; }
+
   /// Returns the first ready `AsyncTask`.
   ///
   /// TODO: as an optimization, return a vector containing the ready head of the queue.
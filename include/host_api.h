@@ -1,11 +1,14 @@
 #ifndef JS_RUNTIME_HOST_API_H
 #define JS_RUNTIME_HOST_API_H
 
+#include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <span>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
@@ -36,6 +39,10 @@ struct Void final {};
 /// The type of errors returned from the host.
 using APIError = uint8_t;
 
+/// The error returned for outgoing requests that exceeded one of their timeouts, see
+/// `OutgoingRequestOptions`.
+constexpr APIError TIMEOUT_ERROR = 155;
+
 bool error_is_generic(APIError e);
 bool error_is_invalid_argument(APIError e);
 bool error_is_optional_none(APIError e);
@@ -256,6 +263,19 @@ public:
   /// Might return an empty string if no data is available.
   Result<ReadResult> read(uint32_t chunk_size);
 
+  class ReadIntoResult final {
+  public:
+    bool done = false;
+    size_t len = 0;
+    ReadIntoResult() = default;
+    ReadIntoResult(const bool done, size_t len) : done{done}, len{len} {}
+  };
+  /// Read a chunk of up to `buffer.size()` bytes from this handle directly into `buffer`.
+  ///
+  /// Unlike `read`, this doesn't allocate a new buffer for every chunk, which makes it the better
+  /// choice for loops that read many chunks. Might read 0 bytes if no data is available.
+  Result<ReadIntoResult> read_into(std::span<uint8_t> buffer);
+
   /// Close this handle, and reset internal state to invalid.
   Result<Void> close();
 
@@ -316,10 +336,65 @@ public:
   explicit FutureHttpIncomingResponse(Handle handle);
 
   /// Returns the response if it is ready, or `nullopt` if it is not.
+  ///
+  /// Fails with `TIMEOUT_ERROR` if one of the request's timeouts was exceeded.
   Result<optional<HttpIncomingResponse *>> maybe_response();
 
   Result<PollableHandle> subscribe() override;
   void unsubscribe() override;
+
+  /// Drop the future and its pollable. The response, if one was returned, stays valid.
+  void close();
+};
+
+/// A native snapshot of all entries of an `HttpHeaders` resource, retrieved with a single host
+/// call.
+///
+/// Entries are kept in the order the host returned them in. All names and values are copied into a
+/// single buffer owned by the table, so the host's result can be released right away.
+class HttpHeadersTable final {
+  unique_ptr<char[]> buffer_;
+  size_t capacity_;
+  size_t used_ = 0;
+  vector<tuple<string_view, string_view>> entries_;
+  /// The values of each name, in order, so that looking up a name doesn't scan all entries.
+  std::unordered_map<string_view, vector<string_view>> values_;
+
+public:
+  HttpHeadersTable() = delete;
+  /// Create a table with space for `count` entries with a combined size of `bytes`.
+  HttpHeadersTable(size_t count, size_t bytes) : buffer_(new char[bytes]), capacity_(bytes) {
+    entries_.reserve(count);
+  }
+
+  HttpHeadersTable(const HttpHeadersTable &) = delete;
+  HttpHeadersTable &operator=(const HttpHeadersTable &) = delete;
+
+  /// Copy an entry into the table. Must only be used while filling the table, and the entry must
+  /// fit into the space reserved for it.
+  void add(string_view name, string_view value) {
+    MOZ_ASSERT(used_ + name.size() + value.size() <= capacity_);
+    auto *name_ptr = buffer_.get() + used_;
+    std::copy(name.begin(), name.end(), name_ptr);
+    used_ += name.size();
+    auto *value_ptr = buffer_.get() + used_;
+    std::copy(value.begin(), value.end(), value_ptr);
+    used_ += value.size();
+    string_view name_view(name_ptr, name.size());
+    string_view value_view(value_ptr, value.size());
+    entries_.emplace_back(name_view, value_view);
+    values_[name_view].push_back(value_view);
+  }
+
+  size_t size() const { return entries_.size(); }
+  const vector<tuple<string_view, string_view>> &entries() const { return entries_; }
+
+  /// Get all values for the header `name`, in order.
+  const vector<string_view> &get(string_view name) const {
+    static const vector<string_view> none;
+    auto it = values_.find(name);
+    return it == values_.end() ? none : it->second;
+  }
 };
 
 class HttpHeaders final : public Resource {
@@ -328,16 +403,29 @@ class HttpHeaders final : public Resource {
   friend HttpOutgoingResponse;
   friend HttpOutgoingRequest;
 
+  /// Cached result of `table()`, reset whenever the fields are modified through this wrapper.
+  unique_ptr<HttpHeadersTable> table_;
+
 public:
   HttpHeaders();
   explicit HttpHeaders(Handle handle);
-  explicit HttpHeaders(const vector<tuple<string_view, vector<string_view>>> &entries);
   HttpHeaders(const HttpHeaders &headers);
 
+  /// Create a new fields resource containing all of `entries` with a single host call.
+  ///
+  /// Multiple entries with the same name are all added, in order.
+  static Result<HttpHeaders *> from_list(const vector<tuple<string_view, string_view>> &entries);
+
   Result<vector<tuple<HostString, HostString>>> entries() const;
   Result<vector<HostString>> names() const;
   Result<optional<vector<HostString>>> get(string_view name) const;
 
+  /// Get a native table of all entries.
+  ///
+  /// The table is retrieved with a single host call the first time this is called, and is then
+  /// reused until the fields are modified using `set`, `append`, or `remove`.
+  Result<const HttpHeadersTable *> table();
+
   Result<Void> set(string_view name, string_view value);
   Result<Void> append(string_view name, string_view value);
   Result<Void> remove(string_view name);
@@ -399,11 +487,33 @@ public:
   bool is_incoming() override { return true; }
   bool is_request() override { return true; }
 
+  /// The request's method and URL can't change, so they're retrieved from the host together when
+  /// any of them is first used, and are returned from a cache afterwards.
   [[nodiscard]] Result<string_view> method() override;
+  string_view url() override;
+
+  /// The components of `url()`, as slices of the same cached buffer.
+  string_view scheme();
+  string_view authority();
+  string_view path_with_query();
+
   Result<HttpHeaders *> headers() override;
   Result<HttpIncomingBody *> body() override;
 };
 
+/// Timeouts for sending an outgoing request and receiving its response, in nanoseconds. Timeouts
+/// that aren't set are left to the host's defaults.
+struct OutgoingRequestOptions final {
+  /// How long to wait for the connection to be established.
+  optional<uint64_t> connect_timeout;
+  /// How long to wait for the first byte of the response.
+  optional<uint64_t> first_byte_timeout;
+  /// How long to wait between bytes of the response.
+  optional<uint64_t> between_bytes_timeout;
+
+  bool empty() const { return !connect_timeout && !first_byte_timeout && !between_bytes_timeout; }
+};
+
 class HttpOutgoingRequest final : public HttpRequest, public HttpOutgoingBodyOwner {
   HttpOutgoingRequest(HandleState *state);
 
@@ -420,7 +530,7 @@ public:
   Result<HttpHeaders *> headers() override;
   Result<HttpOutgoingBody *> body() override;
 
-  Result<FutureHttpIncomingResponse *> send();
+  Result<FutureHttpIncomingResponse *> send(const OutgoingRequestOptions &options = {});
 };
 
 class HttpResponse : public HttpRequestResponseBase {
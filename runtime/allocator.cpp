@@ -1,17 +1,144 @@
-
 #include "allocator.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
 JSContext *CONTEXT = nullptr;
 
+namespace {
+void *next_allocation_target = nullptr;
+size_t next_allocation_capacity = 0;
+
+CabiAllocatorStats stats;
+
+/// A bump allocator for short-lived host call results, see `CabiArenaScope`.
+///
+/// Memory is handed out from a list of chunks, which are all released when the arena is reset,
+/// except for the first one, which is kept around for reuse.
+class BumpArena {
+  static constexpr size_t CHUNK_SIZE = 16 * 1024;
+
+  struct Chunk {
+    uint8_t *data;
+    size_t size;
+    size_t used;
+  };
+
+  std::vector<Chunk> chunks_;
+  size_t used_ = 0;
+
+public:
+  void *alloc(size_t size, size_t align) {
+    align = std::max<size_t>(align, 1);
+    if (!chunks_.empty()) {
+      auto &chunk = chunks_.back();
+      size_t start = (chunk.used + align - 1) & ~(align - 1);
+      if (start + size <= chunk.size) {
+        used_ += start + size - chunk.used;
+        chunk.used = start + size;
+        stats.arena_high_water_mark = std::max(stats.arena_high_water_mark, used_);
+        return chunk.data + start;
+      }
+    }
+
+    // malloc's alignment is sufficient for all types used in the canonical ABI.
+    size_t chunk_size = std::max(CHUNK_SIZE, size);
+    auto *data = static_cast<uint8_t *>(malloc(chunk_size));
+    if (!data) {
+      return nullptr;
+    }
+    chunks_.push_back({data, chunk_size, size});
+    used_ += size;
+    stats.arena_high_water_mark = std::max(stats.arena_high_water_mark, used_);
+    return data;
+  }
+
+  bool contains(const void *ptr) const {
+    auto *p = static_cast<const uint8_t *>(ptr);
+    for (const auto &chunk : chunks_) {
+      if (p >= chunk.data && p < chunk.data + chunk.size) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void reset() {
+    if (chunks_.empty()) {
+      return;
+    }
+    for (size_t i = 1; i < chunks_.size(); i++) {
+      free(chunks_[i].data);
+    }
+    chunks_.resize(1);
+    if (chunks_[0].size > CHUNK_SIZE) {
+      free(chunks_[0].data);
+      chunks_.clear();
+    } else {
+      chunks_[0].used = 0;
+    }
+    used_ = 0;
+  }
+};
+
+BumpArena arena;
+size_t arena_depth = 0;
+} // namespace
+
+CabiArenaScope::CabiArenaScope() { arena_depth++; }
+
+CabiArenaScope::~CabiArenaScope() {
+  MOZ_ASSERT(arena_depth > 0);
+  if (--arena_depth == 0) {
+    arena.reset();
+  }
+}
+
 extern "C" {
 
 __attribute__((export_name("cabi_realloc"))) void *cabi_realloc(void *ptr, size_t orig_size,
-                                                                size_t _align, size_t new_size) {
+                                                                size_t align, size_t new_size) {
   if (new_size == orig_size) {
     return ptr;
   }
+  stats.count++;
+  if (new_size > orig_size) {
+    stats.bytes += new_size - orig_size;
+  }
+  if (!ptr && next_allocation_target) {
+    void *target = next_allocation_target;
+    next_allocation_target = nullptr;
+    if (new_size <= next_allocation_capacity) {
+      return target;
+    }
+  }
+  if (arena_depth > 0 && (!ptr || arena.contains(ptr))) {
+    stats.arena_count++;
+    stats.arena_bytes += new_size;
+    void *new_ptr = arena.alloc(new_size, align);
+    if (ptr && new_ptr) {
+      memcpy(new_ptr, ptr, std::min(orig_size, new_size));
+    }
+    return new_ptr;
+  }
   return JS_realloc(CONTEXT, ptr, orig_size, new_size);
 }
 
-void cabi_free(void *ptr) { JS_free(CONTEXT, ptr); }
+void cabi_free(void *ptr) {
+  if (arena_depth > 0 && arena.contains(ptr)) {
+    return;
+  }
+  JS_free(CONTEXT, ptr);
+}
+
+void cabi_realloc_into(void *buf, size_t capacity) {
+  next_allocation_target = buf;
+  next_allocation_capacity = capacity;
 }
+}
+
+const CabiAllocatorStats &cabi_allocator_stats() { return stats; }
+
+void cabi_reset_allocator_stats() { stats = CabiAllocatorStats(); }
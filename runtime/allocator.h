@@ -38,6 +38,45 @@ inline void *cabi_malloc(size_t bytes, size_t align) { return cabi_realloc(NULL,
 /// Not required by wit-bindgen generated code, but a usefully named version of
 /// JS_free that can help with identifying where memory allocated by the c-abi.
 void cabi_free(void *ptr);
+
+/// Direct the next fresh allocation made through cabi_realloc into `buf`, as long as it
+/// requests no more than `capacity` bytes.
+///
+/// This allows the host to write the result of a call like `input-stream.read` straight into a
+/// caller-owned buffer instead of a freshly allocated one. The target is consumed by the next
+/// fresh allocation, and can be cleared explicitly by passing `nullptr`.
+void cabi_realloc_into(void *buf, size_t capacity);
 }
 
+/// Serve fresh allocations made through cabi_realloc during this scope from a bump arena, which is
+/// reset wholesale when the outermost scope ends.
+///
+/// Intended for short-lived results of host calls, like header lists or poll results, that are
+/// fully consumed within the scope. Memory from the arena must neither be adopted by anything
+/// outliving the scope, nor be passed to `free`. Passing it to `cabi_free` is a no-op.
+class CabiArenaScope final {
+public:
+  CabiArenaScope();
+  ~CabiArenaScope();
+
+  CabiArenaScope(const CabiArenaScope &) = delete;
+  CabiArenaScope &operator=(const CabiArenaScope &) = delete;
+};
+
+struct CabiAllocatorStats {
+  /// The number of (re)allocations served by cabi_realloc.
+  size_t count = 0;
+  /// The total number of bytes allocated through cabi_realloc.
+  size_t bytes = 0;
+  /// The number of allocations, and the bytes allocated, in a `CabiArenaScope`.
+  size_t arena_count = 0;
+  size_t arena_bytes = 0;
+  /// The largest number of bytes in use in the arena at any one time.
+  size_t arena_high_water_mark = 0;
+};
+
+/// Stats for all allocations made through cabi_realloc since the last reset.
+const CabiAllocatorStats &cabi_allocator_stats();
+void cabi_reset_allocator_stats();
+
 #endif
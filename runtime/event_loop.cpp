@@ -4,16 +4,22 @@
 #include "jsapi.h"
 #include "jsfriendapi.h"
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
 struct TaskQueue {
   std::vector<api::AsyncTask *> tasks = {};
+  /// The task being run. It's no longer queued by then, but still has to be traced.
+  api::AsyncTask *running = nullptr;
 
   void trace(JSTracer *trc) const {
     for (const auto task : tasks) {
       task->trace(trc);
     }
+    if (running) {
+      running->trace(trc);
+    }
   }
 };
 
@@ -28,15 +34,22 @@ bool EventLoop::cancel_async_task(api::Engine *engine, const int32_t id) {
   for (auto it = tasks->begin(); it != tasks->end(); ++it) {
     const auto task = *it;
     if (task->id() == id) {
-      task->cancel(engine);
       tasks->erase(it);
+      task->cancel(engine);
+      if (task->finished()) {
+        delete task;
+      }
       return true;
     }
   }
   return false;
 }
 
-bool EventLoop::has_pending_async_tasks() { return !queue.get().tasks.empty(); }
+bool EventLoop::has_pending_async_tasks() {
+  const auto &tasks = queue.get().tasks;
+  return std::any_of(tasks.begin(), tasks.end(),
+                     [](api::AsyncTask *task) { return task->keeps_event_loop_alive(); });
+}
 
 bool EventLoop::run_event_loop(api::Engine *engine, double total_compute,
                                MutableHandleValue result) {
@@ -65,10 +78,19 @@ bool EventLoop::run_event_loop(api::Engine *engine, double total_compute,
       auto tasks = &queue.get().tasks;
       const auto index = api::AsyncTask::select(tasks);
       auto task = tasks->at(index);
-      if (!task->run(engine)) {
+      // The task leaves the queue before it runs, so that running it can't invalidate its index,
+      // and so that it can queue itself again if it isn't done yet.
+      tasks->erase(tasks->begin() + static_cast<ptrdiff_t>(index));
+      queue.get().running = task;
+      bool ok = task->run(engine);
+      queue.get().running = nullptr;
+      if (task->finished()) {
+        MOZ_ASSERT(std::find(tasks->begin(), tasks->end(), task) == tasks->end());
+        delete task;
+      }
+      if (!ok) {
         return false;
       }
-      tasks->erase(tasks->begin() + index);
     }
   } while (js::HasJobsPending(engine->cx()) || has_pending_async_tasks());
 
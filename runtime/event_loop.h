@@ -20,7 +20,8 @@ public:
   static void init(JSContext *cx);
 
   /**
-   * Check if there are any pending tasks (io requests or timers) to process.
+   * Check if there are any pending tasks (io requests or timers) to process. Tasks that don't
+   * keep the event loop alive aren't counted.
    */
   static bool has_pending_async_tasks();
 
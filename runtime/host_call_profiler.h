@@ -0,0 +1,181 @@
+#ifndef JS_RUNTIME_HOST_CALL_PROFILER_H
+#define JS_RUNTIME_HOST_CALL_PROFILER_H
+
+// A profiler for calls into the host, enabled by building with `HOST_CALL_PROFILING` set.
+//
+// Host API implementations opt in by routing their bindings through `HOST_CALL_PROFILED`, which
+// records the number of calls, their cumulative and maximum latency, and the number of bytes
+// transferred in each direction. The recorded stats are dumped and reset after each request.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <type_traits>
+#include <utility>
+
+#include "allocator.h"
+
+namespace host_call_profiler {
+
+enum class HostInterface : uint8_t {
+  Poll,
+  Streams,
+  HttpTypes,
+  OutgoingHandler,
+  Clocks,
+  Random,
+  Count,
+};
+
+inline const char *interface_name(HostInterface interface) {
+  switch (interface) {
+  case HostInterface::Poll:
+    return "poll";
+  case HostInterface::Streams:
+    return "streams";
+  case HostInterface::HttpTypes:
+    return "http types";
+  case HostInterface::OutgoingHandler:
+    return "outgoing-handler";
+  case HostInterface::Clocks:
+    return "clocks";
+  case HostInterface::Random:
+    return "random";
+  default:
+    return "unknown";
+  }
+}
+
+struct HostCallStats {
+  const char *name;
+  HostInterface interface;
+  uint64_t count = 0;
+  uint64_t total_ns = 0;
+  uint64_t max_ns = 0;
+  /// Bytes passed to the host in list or string arguments.
+  uint64_t bytes_sent = 0;
+  /// Bytes the host allocated in guest memory for the call's results.
+  uint64_t bytes_received = 0;
+
+  HostCallStats(const char *name, HostInterface interface) : name(name), interface(interface) {}
+
+  void add(const HostCallStats &other) {
+    count += other.count;
+    total_ns += other.total_ns;
+    max_ns = std::max(max_ns, other.max_ns);
+    bytes_sent += other.bytes_sent;
+    bytes_received += other.bytes_received;
+  }
+};
+
+/// Stats for all bindings that have been called at least once. A deque is used because entries
+/// are referenced from the call sites and thus must never move.
+inline std::deque<HostCallStats> all_stats;
+
+template <auto Fn> HostCallStats &stats_for(HostInterface interface, const char *name) {
+  static HostCallStats *stats = &all_stats.emplace_back(name, interface);
+  return *stats;
+}
+
+/// The payload size of a list or string argument, or 0 for all other arguments.
+///
+/// Only the top-level list is taken into account, so e.g. for a list of header tuples, the size of
+/// the tuples is counted, but not that of the names and values they point to.
+template <typename T> size_t arg_bytes(const T &arg) {
+  if constexpr (std::is_pointer_v<T>) {
+    using Pointee = std::remove_pointer_t<T>;
+    if constexpr (requires(Pointee list) {
+                    list.ptr;
+                    list.len;
+                  }) {
+      return arg ? arg->len * sizeof(*arg->ptr) : 0;
+    }
+  }
+  return 0;
+}
+
+template <size_t Inputs, typename... Args> size_t input_bytes(const Args &...args) {
+  size_t index = 0;
+  size_t bytes = 0;
+  ((bytes += index++ < Inputs ? arg_bytes(args) : 0), ...);
+  return bytes;
+}
+
+/// Call `Fn` with `args`, and record the call in its stats.
+template <auto Fn, size_t Inputs, typename... Args>
+auto call(HostInterface interface, const char *name, Args &&...args) {
+  auto &stats = stats_for<Fn>(interface, name);
+  stats.bytes_sent += input_bytes<Inputs>(args...);
+  auto allocated = cabi_allocator_stats().bytes;
+  auto start = std::chrono::steady_clock::now();
+
+  auto record = [&]() {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    stats.count++;
+    stats.total_ns += elapsed;
+    stats.max_ns = std::max<uint64_t>(stats.max_ns, elapsed);
+    stats.bytes_received += cabi_allocator_stats().bytes - allocated;
+  };
+
+  if constexpr (std::is_void_v<decltype(Fn(std::forward<Args>(args)...))>) {
+    Fn(std::forward<Args>(args)...);
+    record();
+  } else {
+    auto result = Fn(std::forward<Args>(args)...);
+    record();
+    return result;
+  }
+}
+
+/// Print a table of all host calls made since the last reset, grouped by interface, followed by
+/// the allocator's stats, to `out`.
+inline void dump(FILE *out) {
+  fprintf(out, "%-80s %8s %12s %10s %12s %12s\n", "host call", "count", "total (us)", "max (us)",
+          "bytes sent", "bytes recv");
+  for (uint8_t i = 0; i < static_cast<uint8_t>(HostInterface::Count); i++) {
+    auto interface = static_cast<HostInterface>(i);
+    HostCallStats totals(interface_name(interface), interface);
+    for (const auto &stats : all_stats) {
+      if (stats.interface != interface || stats.count == 0) {
+        continue;
+      }
+      fprintf(out, "  %-78s %8llu %12.1f %10.1f %12llu %12llu\n", stats.name,
+              (unsigned long long)stats.count, stats.total_ns / 1000.0, stats.max_ns / 1000.0,
+              (unsigned long long)stats.bytes_sent, (unsigned long long)stats.bytes_received);
+      totals.add(stats);
+    }
+    if (totals.count > 0) {
+      fprintf(out, "%-80s %8llu %12.1f %10.1f %12llu %12llu\n", totals.name,
+              (unsigned long long)totals.count, totals.total_ns / 1000.0, totals.max_ns / 1000.0,
+              (unsigned long long)totals.bytes_sent, (unsigned long long)totals.bytes_received);
+    }
+  }
+
+  auto &alloc = cabi_allocator_stats();
+  fprintf(out,
+          "cabi_realloc: %zu allocations, %zu bytes; arena: %zu allocations, %zu bytes, "
+          "%zu bytes high-water mark\n",
+          alloc.count, alloc.bytes, alloc.arena_count, alloc.arena_bytes,
+          alloc.arena_high_water_mark);
+  fflush(out);
+}
+
+/// Reset all recorded stats, e.g. to start profiling a new request.
+inline void reset() {
+  for (auto &stats : all_stats) {
+    stats = HostCallStats(stats.name, stats.interface);
+  }
+  cabi_reset_allocator_stats();
+}
+
+} // namespace host_call_profiler
+
+#define HOST_CALL_PROFILED(fn, interface, inputs, ...)                                             \
+  ::host_call_profiler::call<&fn, inputs>(::host_call_profiler::HostInterface::interface,          \
+                                          #fn __VA_OPT__(, ) __VA_ARGS__)
+
+#endif
@@ -7,13 +7,17 @@
 #include "extension-api.h"
 #include "host_api.h"
 #include "js/SourceText.h"
+#ifndef STARLING_NATIVE
 #include "wizer.h"
+#endif
 #ifdef MEM_STATS
 #include <string>
 #endif
 
+#ifndef STARLING_NATIVE
 bool WIZENED = false;
 extern "C" void __wasm_call_ctors();
+#endif
 
 api::Engine *engine;
 extern bool install_builtins(api::Engine *engine);
@@ -60,6 +64,26 @@ bool initialize(const char *filename) {
   return true;
 }
 
+#ifdef STARLING_NATIVE
+
+// Natively, there's no snapshot to resume from, so the script is initialized on startup, after
+// which requests are served until the process is terminated.
+int main(int argc, const char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <script.js> [address, default: 127.0.0.1:8080]\n", argv[0]);
+    return 1;
+  }
+
+  if (!initialize(argv[1])) {
+    return 1;
+  }
+  markWizeningAsFinished();
+
+  return native_serve(argc > 2 ? argv[2] : "127.0.0.1:8080") ? 0 : 1;
+}
+
+#else
+
 extern "C" bool exports_wasi_cli_run_run() {
   __wasm_call_ctors();
 
@@ -93,3 +117,5 @@ void wizen() {
 }
 
 WIZER_INIT(wizen);
+
+#endif
@@ -0,0 +1,52 @@
+// Microbenchmark for reading incoming request bodies.
+//
+// Reads the request body in the way given by the `mode` query parameter, and responds with a line
+// of JSON describing how many bytes were read, in how many chunks, and how long it took. Use
+// `body-ingest.sh` to send bodies of different sizes, with and without `Content-Length`.
+//
+// Modes:
+// - `arrayBuffer`, `text`, `json`: the respective Body method.
+// - `stream`: reading `request.body` with a reader, one chunk at a time.
+
+async function ingest(request, mode) {
+    switch (mode) {
+        case "arrayBuffer":
+            return { bytes: (await request.arrayBuffer()).byteLength };
+        case "text":
+            return { bytes: (await request.text()).length };
+        case "json":
+            return { bytes: JSON.stringify(await request.json()).length };
+        case "stream": {
+            const reader = request.body.getReader();
+            let bytes = 0;
+            let chunks = 0;
+            let largest = 0;
+            while (true) {
+                const { done, value } = await reader.read();
+                if (done) {
+                    return { bytes, chunks, largest };
+                }
+                bytes += value.byteLength;
+                chunks++;
+                largest = Math.max(largest, value.byteLength);
+            }
+        }
+        default:
+            throw new Error(`unknown mode ${mode}`);
+    }
+}
+
+addEventListener("fetch", (event) => {
+    event.respondWith((async () => {
+        const mode = new URL(event.request.url).searchParams.get("mode") || "arrayBuffer";
+        const length = event.request.headers.get("content-length");
+        const start = performance.now();
+        try {
+            const result = await ingest(event.request, mode);
+            result.ms = performance.now() - start;
+            return new Response(JSON.stringify({ mode, length, ...result }) + "\n");
+        } catch (e) {
+            return new Response(`${e}\n`, { status: 500 });
+        }
+    })());
+});
@@ -0,0 +1,36 @@
+#!/usr/bin/env bash
+#
+# Sends bodies from 1 KB to 100 MB to a running instance of `body-ingest.js`, once with a
+# `Content-Length` header and once chunked, for each way of reading them.
+#
+# Build the runtime with `HOST_CALL_PROFILING` set to also get the host calls and allocations made
+# for each request printed to the server's stderr.
+#
+# Usage: body-ingest.sh [url] [modes...]
+
+set -euo pipefail
+
+URL="${1:-http://127.0.0.1:8080/}"
+shift || true
+if [ $# -gt 0 ]; then
+    MODES=("$@")
+else
+    MODES=(arrayBuffer text json stream)
+fi
+SIZES=(1024 10240 102400 1048576 10485760 104857600)
+
+TMP="$(mktemp -d)"
+trap 'rm -rf "$TMP"' EXIT
+
+for size in "${SIZES[@]}"; do
+    # A JSON string literal of exactly `size` bytes, so the same body works for all modes.
+    body="$TMP/$size.json"
+    { printf '"'; head -c $((size - 2)) /dev/zero | tr '\0' 'a'; printf '"'; } > "$body"
+
+    for mode in "${MODES[@]}"; do
+        echo -n "content-length $size: "
+        curl -sS --data-binary "@$body" "$URL?mode=$mode"
+        echo -n "chunked        $size: "
+        curl -sS -H "Transfer-Encoding: chunked" --data-binary "@$body" "$URL?mode=$mode"
+    done
+done
@@ -92,6 +92,12 @@ function embeddedBody() {
 `;
 }
 
+// Created during initialization, so the body and headers are encoded once, into the snapshot.
+const notFoundTemplate = new ResponseTemplate("not found", {
+    status: 404,
+    headers: { "x-smoke-template": "1" },
+});
+
 async function main(event) {
     let resolve, reject;
 
@@ -125,6 +131,294 @@ async function main(event) {
             resolve(new Response(body));
             return;
         }
+        if (url.pathname === "/clone-after-reader") {
+            // The body stream has been reified and locked once, so the clone has to tee a byte
+            // stream instead of the host body.
+            let response = await fetch("/chained");
+            response.body.getReader({ mode: "byob" }).releaseLock();
+            let clone = response.clone();
+            let [body, clonedBody] = await Promise.all([response.text(), clone.text()]);
+            if (body !== clonedBody) {
+                console.log(`clone mismatch: ${body.length} vs ${clonedBody.length} characters`);
+                resolve(new Response("clone mismatch", { status: 500 }));
+                return;
+            }
+            resolve(new Response(body));
+            return;
+        }
+
+        if (url.pathname === "/slow") {
+            // Upstream for the routes below: only starts responding after `ms` milliseconds.
+            let ms = Number(url.searchParams.get("ms") || 0);
+            await new Promise(r => setTimeout(r, ms));
+            resolve(new Response(`waited ${ms}ms`));
+            return;
+        }
+        if (url.pathname === "/fetch-timeout") {
+            try {
+                await fetch("/slow?ms=1000", { firstByteTimeout: 50 });
+            } catch (e) {
+                if (e instanceof DOMException && e.name === "TimeoutError") {
+                    resolve(new Response("timed out"));
+                    return;
+                }
+                resolve(new Response(`expected a TimeoutError, got ${e}`, { status: 500 }));
+                return;
+            }
+            resolve(new Response("expected the fetch to time out", { status: 500 }));
+            return;
+        }
+
+        if (url.pathname === "/fetch-hedge") {
+            // The hedge is sent long before the first attempt's response arrives, and whichever
+            // response comes first wins.
+            let response = await fetch("/slow?ms=300", { hedge: { delay: 50, count: 1 } });
+            let body = await response.text();
+            if (body !== "waited 300ms") {
+                resolve(new Response(`unexpected hedged response: ${body}`, { status: 500 }));
+                return;
+            }
+            try {
+                await fetch("/slow", { method: "POST", body: "x", hedge: { delay: 50 } });
+                resolve(new Response("hedging a POST request should fail", { status: 500 }));
+                return;
+            } catch (e) {}
+            resolve(new Response("hedged"));
+            return;
+        }
+        if (url.pathname === "/fetch-retry") {
+            // Nothing listens on port 1, so every attempt fails, and the backoff doubles after each
+            // retry: the fetch can't fail before 100ms + 200ms have passed.
+            let start = Date.now();
+            try {
+                await fetch("http://127.0.0.1:1/", { retry: { count: 2, backoff: 100 } });
+                resolve(new Response("expected the fetch to fail", { status: 500 }));
+                return;
+            } catch (e) {}
+            let elapsed = Date.now() - start;
+            if (elapsed < 300) {
+                resolve(new Response(`failed after ${elapsed}ms, without retrying`, { status: 500 }));
+                return;
+            }
+            resolve(new Response(`retried for ${elapsed}ms`));
+            return;
+        }
+
+        if (url.pathname === "/token") {
+            // Upstream for the routes below: a different body for every request it gets.
+            await new Promise(r => setTimeout(r, 100));
+            resolve(new Response(String(Math.random())));
+            return;
+        }
+        if (url.pathname === "/fetch-coalesce") {
+            let sentBefore = fetch.schedulerStats().totalSent;
+            let responses = await Promise.all([
+                fetch("/token", { coalesce: true }),
+                fetch("/token", { coalesce: true }),
+            ]);
+            let sent = fetch.schedulerStats().totalSent - sentBefore;
+            let [first, second] = await Promise.all(responses.map(r => r.text()));
+            if (sent !== 1 || first !== second) {
+                resolve(new Response(`sent ${sent} requests, got ${first} and ${second}`,
+                                     { status: 500 }));
+                return;
+            }
+            resolve(new Response("coalesced"));
+            return;
+        }
+
+        if (url.pathname === "/fetch-forward-headers") {
+            // Sends itself a token, forwards the request with `x-smoke-hop: 2`, and echoes the
+            // token from there. The forwarding hop never reads the token, so it's only host-side
+            // when the request is coalesced or hedged.
+            let hop = event.request.headers.get("x-smoke-hop");
+            if (hop === "2") {
+                let token = event.request.headers.get("x-smoke-token");
+                if (!token) {
+                    resolve(new Response("token missing", { status: 500 }));
+                    return;
+                }
+                // Slow enough for a hedge without the token to answer first.
+                await new Promise(r => setTimeout(r, 200));
+                resolve(new Response(token));
+                return;
+            }
+            if (hop === "1") {
+                let forwarded = new Request(event.request);
+                forwarded.headers.set("x-smoke-hop", "2");
+                let options = url.searchParams.get("via") === "hedge"
+                    ? { hedge: { delay: 50, count: 1 } }
+                    : { coalesce: true };
+                resolve(await fetch(forwarded, options));
+                return;
+            }
+            for (let via of ["coalesce", "hedge"]) {
+                let token = String(Math.random());
+                let response = await fetch(`/fetch-forward-headers?via=${via}`, {
+                    headers: { "x-smoke-hop": "1", "x-smoke-token": token },
+                });
+                let body = await response.text();
+                if (body !== token) {
+                    resolve(new Response(`${via}: expected ${token}, got ${body}`, { status: 500 }));
+                    return;
+                }
+            }
+            resolve(new Response("forwarded"));
+            return;
+        }
+
+        if (url.pathname === "/response-template") {
+            // Sent straight from its native representation, without creating a Response.
+            resolve(notFoundTemplate);
+            return;
+        }
+        if (url.pathname === "/response-template-response") {
+            let response = notFoundTemplate.response();
+            let body = await response.text();
+            if (response.status !== 404 || response.headers.get("x-smoke-template") !== "1" ||
+                body !== "not found") {
+                resolve(new Response(`unexpected response: ${response.status} ${body}`,
+                                     { status: 500 }));
+                return;
+            }
+            // Every response gets its own body and headers.
+            let second = notFoundTemplate.response();
+            response.headers.set("x-smoke-template", "2");
+            if (second.headers.get("x-smoke-template") !== "1" || (await second.text()) !== body) {
+                resolve(new Response("responses share state", { status: 500 }));
+                return;
+            }
+            resolve(new Response("template response"));
+            return;
+        }
+        if (url.pathname === "/response-template-invalid-body") {
+            // Bodies that can only be read once, or that differ each time they're serialized,
+            // can't be templated.
+            for (let body of [new ReadableStream(), new FormData()]) {
+                try {
+                    new ResponseTemplate(body);
+                    resolve(new Response(`accepted a ${body.constructor.name} body`,
+                                         { status: 500 }));
+                    return;
+                } catch (e) {
+                    if (!(e instanceof TypeError)) {
+                        resolve(new Response(`expected a TypeError, got ${e}`, { status: 500 }));
+                        return;
+                    }
+                }
+            }
+            resolve(new Response("rejected"));
+            return;
+        }
+
+        if (url.pathname === "/fetch-priority") {
+            // With a single fetch allowed in flight, queued fetches are sent by priority, not in
+            // the order they were made in.
+            fetch.setConcurrencyLimits({ total: 1 });
+            let order = [];
+            try {
+                await Promise.all([
+                    fetch("/slow?ms=200"),
+                    fetch("/slow", { priority: "low" }).then(() => order.push("low")),
+                    fetch("/slow").then(() => order.push("auto")),
+                    fetch("/slow", { priority: "high" }).then(() => order.push("high")),
+                ]);
+            } finally {
+                fetch.setConcurrencyLimits({});
+            }
+            if (order.join() !== "high,auto,low") {
+                resolve(new Response(`fetches completed in the order ${order}`, { status: 500 }));
+                return;
+            }
+            resolve(new Response("prioritized"));
+            return;
+        }
+        if (url.pathname === "/fetch-limits") {
+            // Lifting the limit sends all queued fetches right away.
+            fetch.setConcurrencyLimits({ perAuthority: 1 });
+            let fetches = [fetch("/slow?ms=200"), fetch("/slow?ms=200"), fetch("/slow?ms=200")];
+            let queued = fetch.schedulerStats().queued;
+            fetch.setConcurrencyLimits({});
+            let stats = fetch.schedulerStats();
+            await Promise.all(fetches);
+            if (queued !== 2 || stats.queued !== 0 || stats.inFlight !== 3) {
+                resolve(new Response(`queued ${queued}, then ${JSON.stringify(stats)}`,
+                                     { status: 500 }));
+                return;
+            }
+            resolve(new Response("limits changed"));
+            return;
+        }
+        if (url.pathname === "/fetch-scheduler-stats") {
+            fetch.setConcurrencyLimits({ total: 1 });
+            let before = fetch.schedulerStats();
+            try {
+                await Promise.all([fetch("/slow?ms=100"), fetch("/slow")]);
+            } finally {
+                fetch.setConcurrencyLimits({});
+            }
+            let after = fetch.schedulerStats();
+            if (after.inFlight !== 0 || after.queued !== 0 ||
+                after.totalSent - before.totalSent !== 2 ||
+                after.totalQueued - before.totalQueued !== 1 ||
+                after.maxQueueDelay < 100 || after.totalQueueDelay < after.maxQueueDelay) {
+                resolve(new Response(`unexpected stats ${JSON.stringify(after)}`, { status: 500 }));
+                return;
+            }
+            resolve(new Response(JSON.stringify(after)));
+            return;
+        }
+
+        if (url.pathname === "/cache-eviction") {
+            // With room for two entries, storing a third evicts the least recently used one.
+            caches.setLimits({ maxEntries: 2 });
+            let cache = await caches.open("smoke-eviction");
+            try {
+                await cache.put("/a", new Response("a"));
+                await cache.put("/b", new Response("b"));
+                await cache.match("/a");
+                await cache.put("/c", new Response("c"));
+                let [a, b, c] = await Promise.all(["/a", "/b", "/c"].map(key => cache.match(key)));
+                if (!a || b || !c) {
+                    resolve(new Response(`unexpected entries: a ${!!a}, b ${!!b}, c ${!!c}`,
+                                         { status: 500 }));
+                    return;
+                }
+                // Writing to a chunk read from a cached response mustn't change the entry.
+                let { value } = await a.body.getReader().read();
+                value[0] = 0x7a;
+                let again = await (await cache.match("/a")).text();
+                if (again !== "a") {
+                    resolve(new Response(`cached body changed to ${again}`, { status: 500 }));
+                    return;
+                }
+            } finally {
+                caches.setLimits({ maxEntries: 4096 });
+                await caches.delete("smoke-eviction");
+            }
+            resolve(new Response("evicted"));
+            return;
+        }
+        if (url.pathname === "/cache-vary") {
+            let cache = await caches.open("smoke-vary");
+            try {
+                let request = new Request("/vary", { headers: { "accept-language": "en" } });
+                await cache.put(request, new Response("en", { headers: { vary: "Accept-Language" } }));
+                let en = await cache.match(new Request("/vary", { headers: { "accept-language": "en" } }));
+                let de = new Request("/vary", { headers: { "accept-language": "de" } });
+                let mismatch = await cache.match(de);
+                let ignored = await cache.match(de, { ignoreVary: true });
+                if (!en || mismatch || !ignored) {
+                    resolve(new Response(`unexpected matches: en ${!!en}, de ${!!mismatch}, ` +
+                                         `ignoreVary ${!!ignored}`, { status: 500 }));
+                    return;
+                }
+            } finally {
+                await caches.delete("smoke-vary");
+            }
+            resolve(new Response("varied"));
+            return;
+        }
 
         url.host = "example.com";
         url.protocol = "https";
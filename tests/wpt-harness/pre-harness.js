@@ -28,8 +28,6 @@ globalThis.Window={
 }
 
 globalThis.crypto.subtle.generateKey = function () {return Promise.reject(new Error('globalThis.crypto.subtle.generateKey unimplemented'))}
-globalThis.Blob = class Blob{};
-globalThis.FormData = class FormData{};
 globalThis.SharedArrayBuffer = class SharedArrayBuffer{};
 globalThis.MessageChannel = class MessageChannel{};
 ;